@@ -0,0 +1,256 @@
+#include <benchmark/benchmark.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/Endian.hpp"
+
+namespace {
+
+// Previous Address layout: every value shares a heap-allocated payload.
+struct LegacyAddressData {
+  uint64_t a6[2] {0, 0};
+  uint32_t addr {0};
+  network::LayerProtocol protocol {network::LayerProtocol::UNKNOWN};
+};
+
+class LegacyAddress {
+public:
+  explicit LegacyAddress(uint32_t _ip4) : d_(std::make_shared<LegacyAddressData>()) {
+    d_->addr     = _ip4;
+    d_->protocol = network::LayerProtocol::IPv4;
+    d_->a6[1]    = (uint64_t(__builtin_bswap32(_ip4)) << 32U) | 0xffff0000U;
+  }
+  bool operator==(const LegacyAddress &_other) const {
+    return d_ == _other.d_ || (d_->protocol == _other.d_->protocol && d_->addr == _other.d_->addr &&
+                                  d_->a6[0] == _other.d_->a6[0] && d_->a6[1] == _other.d_->a6[1]);
+  }
+
+private:
+  std::shared_ptr<LegacyAddressData> d_;
+};
+
+constexpr std::size_t C_COUNT = 1U << 16U;
+
+std::vector<uint32_t> makeIps() {
+  std::mt19937 rng(42);
+  std::vector<uint32_t> ips(C_COUNT);
+  for (auto &ip : ips) ip = rng();
+  return ips;
+}
+
+template <typename TAddress>
+void BM_Construct(benchmark::State &state) {
+  const auto ips = makeIps();
+  std::vector<TAddress> out;
+  out.reserve(C_COUNT);
+  for (auto _ : state) {
+    out.clear();
+    for (uint32_t ip : ips) out.emplace_back(ip);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+template <typename TAddress>
+void BM_Copy(benchmark::State &state) {
+  const auto ips = makeIps();
+  std::vector<TAddress> src;
+  src.reserve(C_COUNT);
+  for (uint32_t ip : ips) src.emplace_back(ip);
+  for (auto _ : state) {
+    std::vector<TAddress> dst(src);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+template <typename TAddress>
+void BM_Compare(benchmark::State &state) {
+  const auto ips = makeIps();
+  std::vector<TAddress> lhs;
+  std::vector<TAddress> rhs;
+  lhs.reserve(C_COUNT);
+  rhs.reserve(C_COUNT);
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    lhs.emplace_back(ips[i]);
+    rhs.emplace_back(ips[(i & 1U) ? i : (i + 1) % C_COUNT]);
+  }
+  for (auto _ : state) {
+    std::size_t equal = 0;
+    for (std::size_t i = 0; i < C_COUNT; ++i) equal += lhs[i] == rhs[i];
+    benchmark::DoNotOptimize(equal);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// One recvmmsg() batch on a dual-stack socket: half the peers IPv4 (v4-mapped), half IPv6
+constexpr std::size_t C_BATCH = 64;
+
+struct Batch {
+  std::vector<sockaddr_storage> names = std::vector<sockaddr_storage>(C_BATCH);
+  std::vector<mmsghdr> messages       = std::vector<mmsghdr>(C_BATCH);
+
+  Batch() {
+    std::mt19937 rng(43);
+    for (std::size_t i = 0; i < C_BATCH; ++i) {
+      auto *name        = reinterpret_cast<sockaddr_in6 *>(&names[i]);
+      name->sin6_family = AF_INET6;
+      name->sin6_port   = qToBigEndian(uint16_t(rng()));
+      for (auto &byte : name->sin6_addr.s6_addr) byte = uint8_t(rng());
+      if (i % 2 == 0) {
+        std::memset(name->sin6_addr.s6_addr, 0, 10);
+        std::memset(name->sin6_addr.s6_addr + 10, 0xff, 2);
+      }
+      messages[i]                     = {};
+      messages[i].msg_hdr.msg_name    = name;
+      messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+    }
+  }
+};
+
+void BM_FromMessagesEach(benchmark::State &state) {
+  const Batch batch;
+  std::vector<network::Address> addresses(C_BATCH);
+  std::vector<uint16_t> ports(C_BATCH);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < C_BATCH; ++i) {
+      const auto *name = static_cast<const sockaddr *>(batch.messages[i].msg_hdr.msg_name);
+      addresses[i]     = network::Address(name);
+      ports[i]         = qFromBigEndian(reinterpret_cast<const sockaddr_in6 *>(name)->sin6_port);
+    }
+    benchmark::DoNotOptimize(addresses.data());
+    benchmark::DoNotOptimize(ports.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_BATCH);
+}
+
+void BM_FromMessages(benchmark::State &state) {
+  const Batch batch;
+  std::vector<network::Address> addresses(C_BATCH);
+  std::vector<uint16_t> ports(C_BATCH);
+  for (auto _ : state) {
+    network::AddressData::fromMessages(batch.messages, addresses, ports);
+    benchmark::DoNotOptimize(addresses.data());
+    benchmark::DoNotOptimize(ports.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_BATCH);
+}
+
+void BM_ToSockaddrs(benchmark::State &state) {
+  Batch batch;
+  std::vector<network::Address> addresses(C_BATCH);
+  std::vector<uint16_t> ports(C_BATCH);
+  network::AddressData::fromMessages(batch.messages, addresses, ports);
+  std::vector<sockaddr_in6> names(C_BATCH);
+  for (auto _ : state) {
+    network::AddressData::toSockaddrs(addresses, ports, names, batch.messages);
+    benchmark::DoNotOptimize(names.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_BATCH);
+}
+
+// Dedup input: each pair is the same host seen as IPv4 and as v4-mapped IPv6, or two hosts
+struct MixedPairs {
+  std::vector<network::Address> lhs;
+  std::vector<network::Address> rhs;
+
+  MixedPairs() {
+    const auto ips = makeIps();
+    for (std::size_t i = 0; i < C_COUNT; ++i) {
+      network::IPv6Address mapped {};
+      mapped[10] = mapped[11] = 0xff;
+      qToBigEndian(ips[(i % 3 != 0) ? i : (i + 1) % C_COUNT], mapped.c + 12);
+      lhs.emplace_back(ips[i]);
+      rhs.emplace_back(mapped);
+      if (i % 2 != 0) std::swap(lhs.back(), rhs.back());
+    }
+  }
+};
+
+void BM_IsEqualEach(benchmark::State &state) {
+  const MixedPairs pairs;
+  std::vector<uint64_t> out(C_COUNT / 64);
+  for (auto _ : state) {
+    for (std::size_t w = 0; w < C_COUNT / 64; ++w) {
+      uint64_t word = 0;
+      for (std::size_t j = 0; j < 64; ++j) word |= uint64_t(pairs.lhs[w * 64 + j].isEqual(pairs.rhs[w * 64 + j])) << j;
+      out[w] = word;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_IsEqualBatch(benchmark::State &state) {
+  const MixedPairs pairs;
+  std::vector<uint64_t> out(C_COUNT / 64);
+  for (auto _ : state) {
+    network::Address::isEqual(pairs.lhs, pairs.rhs, network::Address::Conversion::TolerantConversion, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_IsEqualOneToMany(benchmark::State &state) {
+  const MixedPairs pairs;
+  std::vector<uint64_t> out(C_COUNT / 64);
+  for (auto _ : state) {
+    network::Address::isEqual(pairs.lhs[0], pairs.rhs, network::Address::Conversion::TolerantConversion, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// The conversions of toIPv4Address(), on a stream of IPv4 and v4-mapped addresses copied afresh each time
+void BM_NormalizeEach(benchmark::State &state) {
+  const MixedPairs pairs;
+  std::vector<network::Address> addresses;
+  for (auto _ : state) {
+    state.PauseTiming();
+    addresses = pairs.lhs;
+    state.ResumeTiming();
+    for (auto &address : addresses) {
+      bool ok            = false;
+      const uint32_t ip4 = address.toIPv4Address(&ok);
+      if (ok && address.getProtocol() == network::LayerProtocol::IPv6) address.setAddress(ip4);
+    }
+    benchmark::DoNotOptimize(addresses.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_Normalize(benchmark::State &state) {
+  using Conversion = network::Address::Conversion;
+  const MixedPairs pairs;
+  std::vector<network::Address> addresses;
+  for (auto _ : state) {
+    state.PauseTiming();
+    addresses = pairs.lhs;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(network::Address::normalize(
+        addresses, Conversion::ConvertV4MappedToIPv4 | Conversion::ConvertUnspecifiedAddress));
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Construct, network::Address);
+BENCHMARK_TEMPLATE(BM_Construct, LegacyAddress);
+BENCHMARK_TEMPLATE(BM_Copy, network::Address);
+BENCHMARK_TEMPLATE(BM_Copy, LegacyAddress);
+BENCHMARK_TEMPLATE(BM_Compare, network::Address);
+BENCHMARK_TEMPLATE(BM_Compare, LegacyAddress);
+BENCHMARK(BM_FromMessagesEach);
+BENCHMARK(BM_FromMessages);
+BENCHMARK(BM_ToSockaddrs);
+BENCHMARK(BM_IsEqualEach);
+BENCHMARK(BM_IsEqualBatch);
+BENCHMARK(BM_IsEqualOneToMany);
+BENCHMARK(BM_NormalizeEach);
+BENCHMARK(BM_Normalize);
@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressBlock.hpp"
+#include "../src/AddressData.hpp"
+
+namespace {
+
+constexpr std::size_t C_COUNT = 1U << 20U;
+
+// Mostly IPv4 traffic, a quarter of it in 10.0.0.0/8 and some multicast, plus 10% IPv6
+std::vector<network::Address> makeAddresses() {
+  std::mt19937_64 rng(19);
+  std::vector<network::Address> addresses;
+  addresses.reserve(C_COUNT);
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    const auto random = uint32_t(rng());
+    switch (rng() % 10) {
+      case 0: {
+        network::IPv6Address ip6 {};
+        for (auto &byte : ip6.c) byte = uint8_t(rng());
+        ip6[0] = rng() % 4 == 0 ? 0xff : 0x20;
+        addresses.emplace_back(ip6);
+        break;
+      }
+      case 1: addresses.emplace_back(0xe0000000U | (random & 0x0fffffffU)); break;
+      case 2:
+      case 3: addresses.emplace_back(0x0a000000U | (random & 0x00ffffffU)); break;
+      default: addresses.emplace_back(random); break;
+    }
+  }
+  return addresses;
+}
+
+network::Netmask prefixLength(int _length) {
+  network::Netmask netmask;
+  netmask.setPrefixLength(network::LayerProtocol::IPv4, _length);
+  return netmask;
+}
+
+// "in 10.0.0.0/8 and not multicast" over a vector of Address, one row at a time
+void BM_AddressVectorFilter(benchmark::State &state) {
+  const auto addresses = makeAddresses();
+  const network::Address prefix(uint32_t(0x0a000000U));
+  std::vector<uint8_t> selected(C_COUNT);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < C_COUNT; ++i) {
+      const network::Address &address = addresses[i];
+      selected[i] = address.getProtocol() == network::LayerProtocol::IPv4 &&
+                    (address.toIPv4Address() & 0xff000000U) == prefix.toIPv4Address() && !address.isMulticast();
+    }
+    benchmark::DoNotOptimize(selected.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// The same filter as two AddressBlock scans
+void BM_AddressBlockFilter(benchmark::State &state) {
+  const network::AddressBlock block(makeAddresses());
+  const network::Address prefix(uint32_t(0x0a000000U));
+  network::AddressSelection selected;
+  network::AddressSelection multicast;
+  for (auto _ : state) {
+    block.selectPrefix(prefix, prefixLength(8), selected);
+    block.selectClassification({network::AddressClassification::MULTICAST}, multicast);
+    selected -= multicast;
+    benchmark::DoNotOptimize(selected.words().data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_AddressBlockPrefix(benchmark::State &state) {
+  const network::AddressBlock block(makeAddresses());
+  const network::Address prefix(uint32_t(0x0a000000U));
+  network::AddressSelection selected;
+  for (auto _ : state) {
+    block.selectPrefix(prefix, prefixLength(8), selected);
+    benchmark::DoNotOptimize(selected.words().data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_AddressVectorClassify(benchmark::State &state) {
+  const auto addresses = makeAddresses();
+  std::vector<network::AddressClassification> results(C_COUNT);
+  for (auto _ : state) {
+    network::AddressData::classify(addresses, results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_AddressBlockClassify(benchmark::State &state) {
+  const network::AddressBlock block(makeAddresses());
+  std::vector<network::AddressClassification> results(C_COUNT);
+  for (auto _ : state) {
+    block.classify(results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+}  // namespace
+
+BENCHMARK(BM_AddressVectorFilter)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddressBlockFilter)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddressBlockPrefix)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddressVectorClassify)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddressBlockClassify)->Unit(benchmark::kMicrosecond);
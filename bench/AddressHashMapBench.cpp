@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressHashMap.hpp"
+
+namespace {
+
+constexpr std::size_t C_LOOKUPS = 1 << 16;
+
+// Distinct keys for every index: half IPv4, half IPv6 under 2001:db8::/32, in no particular order
+network::Address key(uint64_t _index) {
+  if ((_index & 1U) == 0) return network::Address(uint32_t(_index >> 1U) * 0x9e3779b1U);
+  uint64_t mixed = (_index >> 1U) * 0x9e3779b97f4a7c15ULL;
+  mixed ^= mixed >> 29U;
+  network::IPv6Address ip6 {};
+  ip6[0] = 0x20;
+  ip6[1] = 0x01;
+  ip6[2] = 0x0d;
+  ip6[3] = 0xb8;
+  for (int i = 0; i < 8; ++i) ip6[8 + i] = uint8_t(mixed >> (8 * i));
+  return network::Address(ip6);
+}
+
+std::vector<network::Address> lookupKeys(std::size_t _size, bool _hit) {
+  std::mt19937_64 rng(9);
+  std::vector<network::Address> keys(C_LOOKUPS);
+  for (auto &address : keys) address = key(_hit ? rng() % _size : _size + rng() % _size);
+  return keys;
+}
+
+struct StdMap {
+  std::unordered_map<network::Address, uint32_t> map;
+  void insert(const network::Address &_key, uint32_t _value) { map.emplace(_key, _value); }
+  const uint32_t *find(const network::Address &_key) const {
+    const auto it = map.find(_key);
+    return it != map.end() ? &it->second : nullptr;
+  }
+};
+
+struct FlatMap {
+  network::AddressHashMap<uint32_t> map;
+  void insert(const network::Address &_key, uint32_t _value) { map.insert(_key, _value); }
+  const uint32_t *find(const network::Address &_key) const { return map.find(_key); }
+};
+
+// One table alive at a time, whatever its type: the largest sizes take several GiB
+std::shared_ptr<const void> g_table;
+const void *g_tableType = nullptr;
+std::size_t g_tableSize = 0;
+
+template <typename Map>
+const Map &table(std::size_t _size) {
+  static const char type = 0;
+  if (g_tableType != &type || g_tableSize != _size) {
+    g_table.reset();
+    auto map = std::make_shared<Map>();
+    for (std::size_t i = 0; i < _size; ++i) map->insert(key(i), uint32_t(i));
+    g_table     = std::move(map);
+    g_tableType = &type;
+    g_tableSize = _size;
+  }
+  return *static_cast<const Map *>(g_table.get());
+}
+
+template <typename Map>
+void BM_HashMapInsert(benchmark::State &state) {
+  const auto size = std::size_t(state.range(0));
+  for (auto _ : state) {
+    Map map;
+    for (std::size_t i = 0; i < size; ++i) map.insert(key(i), uint32_t(i));
+    benchmark::DoNotOptimize(map);
+    state.PauseTiming();
+    {
+      Map released = std::move(map);  // freeing tens of millions of nodes is not insertion
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+// Lookups of present (arg 1 = 1) or absent keys in a table of arg 0 entries
+template <typename Map>
+void BM_HashMapFind(benchmark::State &state) {
+  const Map &map  = table<Map>(std::size_t(state.range(0)));
+  const auto keys = lookupKeys(std::size_t(state.range(0)), state.range(1) != 0);
+  std::size_t i   = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(keys[i++ & (C_LOOKUPS - 1)]));
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+void sizes(benchmark::internal::Benchmark *_benchmark) {
+  for (const int64_t size : {int64_t(1) << 20, int64_t(10000000), int64_t(50000000)}) {
+    _benchmark->Args({size, 1})->Args({size, 0});
+  }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_HashMapInsert, FlatMap)
+    ->Arg(1 << 20)->Arg(10000000)->Arg(50000000)->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HashMapInsert, StdMap)
+    ->Arg(1 << 20)->Arg(10000000)->Arg(50000000)->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HashMapFind, FlatMap)->Apply(sizes);
+BENCHMARK_TEMPLATE(BM_HashMapFind, StdMap)->Apply(sizes);
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressData.hpp"
+#include "../src/AddressIndex.hpp"
+
+namespace {
+
+constexpr std::size_t C_QUERIES = 1U << 16U;
+
+// Mostly IPv4 hosts plus a quarter of IPv6 ones in a few /32s
+std::vector<network::Address> makeAddresses(std::size_t _count, uint64_t _seed) {
+  std::mt19937_64 rng(_seed);
+  std::vector<network::Address> addresses;
+  addresses.reserve(_count);
+  for (std::size_t i = 0; i < _count; ++i) {
+    if (rng() % 4 != 0) {
+      addresses.emplace_back(uint32_t(rng()));
+      continue;
+    }
+    network::IPv6Address ip6 {};
+    for (auto &byte : ip6.c) byte = uint8_t(rng());
+    ip6[0] = 0x20;
+    ip6[1] = 0x01;
+    ip6[2] = 0x0d;
+    ip6[3] = uint8_t(0xb8 + rng() % 4);
+    addresses.emplace_back(ip6);
+  }
+  return addresses;
+}
+
+void BM_VectorLowerBound(benchmark::State &state) {
+  auto sorted = makeAddresses(std::size_t(state.range(0)), 21);
+  std::sort(sorted.begin(), sorted.end());
+  const auto queries = makeAddresses(C_QUERIES, 22);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (const auto &query : queries) sum += std::lower_bound(sorted.begin(), sorted.end(), query) - sorted.begin();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_QUERIES);
+}
+
+void BM_IndexLowerBound(benchmark::State &state) {
+  const network::AddressIndex index(makeAddresses(std::size_t(state.range(0)), 21));
+  const auto queries = makeAddresses(C_QUERIES, 22);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (const auto &query : queries) sum += index.lowerBound(query);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_QUERIES);
+}
+
+void BM_IndexLowerBoundBulk(benchmark::State &state) {
+  const network::AddressIndex index(makeAddresses(std::size_t(state.range(0)), 21));
+  const auto queries = makeAddresses(C_QUERIES, 22);
+  std::vector<std::size_t> positions(C_QUERIES);
+  for (auto _ : state) {
+    index.lowerBound(queries, positions);
+    benchmark::DoNotOptimize(positions.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_QUERIES);
+}
+
+}  // namespace
+
+BENCHMARK(BM_VectorLowerBound)->Arg(1 << 16)->Arg(1 << 20)->Arg(10000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IndexLowerBound)->Arg(1 << 16)->Arg(1 << 20)->Arg(10000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IndexLowerBoundBulk)->Arg(1 << 16)->Arg(1 << 20)->Arg(10000000)->Unit(benchmark::kMicrosecond);
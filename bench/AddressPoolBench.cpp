@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressPool.hpp"
+#include "../src/AddressPrefix.hpp"
+
+namespace {
+
+using namespace network::literals;
+
+// Lease churn in a /8 kept 90% full: release a random lease, allocate a new one
+void BM_PoolChurn(benchmark::State &state) {
+  network::AddressPool pool("10.0.0.0/8"_cidr);
+  std::vector<network::Address> leases;
+  leases.reserve(pool.size());
+  while (pool.available() > pool.size() / 10) leases.push_back(pool.allocate());
+  std::mt19937_64 rng(23);
+  for (auto _ : state) {
+    network::Address &lease = leases[rng() % leases.size()];
+    pool.release(lease);
+    lease = pool.allocate();
+    benchmark::DoNotOptimize(lease);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+// Filling a /16 from empty to exhausted
+void BM_PoolFill(benchmark::State &state) {
+  for (auto _ : state) {
+    network::AddressPool pool("172.16.0.0/16"_cidr);
+    while (!pool.allocate().isNull()) {
+    }
+    benchmark::DoNotOptimize(pool.available());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * 65536);
+}
+
+// Returning clients of a 4096 address IPv6 pool getting their previous lease back
+void BM_PoolSticky(benchmark::State &state) {
+  network::AddressPool pool("2001:db8::/64"_cidr, 4096);
+  std::vector<network::Address> leases;
+  for (uint64_t client = 0; client < 4000; ++client) leases.push_back(pool.allocate(client));
+  std::mt19937_64 rng(24);
+  for (auto _ : state) {
+    const uint64_t client = rng() % leases.size();
+    pool.release(leases[client]);
+    leases[client] = pool.allocate(client);
+    benchmark::DoNotOptimize(leases[client]);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_PoolChurn);
+BENCHMARK(BM_PoolFill)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PoolSticky);
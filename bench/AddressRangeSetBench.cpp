@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+#include "../src/AddressRangeSet.hpp"
+
+namespace {
+
+using Prefix = network::AddressRangeSet::Prefix;
+
+network::Netmask prefixLength(network::LayerProtocol _protocol, int _length) {
+  network::Netmask netmask;
+  netmask.setPrefixLength(_protocol, _length);
+  return netmask;
+}
+
+// A firewall-sized list: mostly /24 and /32, the rest spread over /_shortest../31, many overlapping
+std::vector<Prefix> makeIPv4Prefixes(std::size_t _count, unsigned _seed, int _shortest = 8) {
+  std::mt19937 rng(_seed);
+  std::vector<Prefix> out;
+  out.reserve(_count);
+  for (std::size_t i = 0; i < _count; ++i) {
+    const unsigned pick = rng() % 100;
+    const int length    = pick < 50 ? 24 : pick < 80 ? 32 : _shortest + int(rng() % unsigned(32 - _shortest));
+    out.emplace_back(network::Address(uint32_t(rng())), prefixLength(network::LayerProtocol::IPv4, length));
+  }
+  return out;
+}
+
+// Allocations under 2000::/4, /32 to /64
+std::vector<Prefix> makeIPv6Prefixes(std::size_t _count, unsigned _seed) {
+  std::mt19937 rng(_seed);
+  std::vector<Prefix> out;
+  out.reserve(_count);
+  for (std::size_t i = 0; i < _count; ++i) {
+    network::IPv6Address ip6 {};
+    for (auto &b : ip6.c) b = uint8_t(rng());
+    ip6[0] = uint8_t(0x20 | (ip6[0] & 0x0f));
+    out.emplace_back(network::Address(ip6), prefixLength(network::LayerProtocol::IPv6, 32 + int(rng() % 33)));
+  }
+  return out;
+}
+
+// Collapse a prefix list into the minimal CIDR list
+void BM_RangeSetAggregateIPv4(benchmark::State &state) {
+  const auto prefixes = makeIPv4Prefixes(std::size_t(state.range(0)), 3);
+  for (auto _ : state) {
+    network::AddressRangeSet set;
+    set.insert(prefixes);
+    benchmark::DoNotOptimize(set.toPrefixes());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+void BM_RangeSetAggregateIPv6(benchmark::State &state) {
+  const auto prefixes = makeIPv6Prefixes(std::size_t(state.range(0)), 4);
+  for (auto _ : state) {
+    network::AddressRangeSet set;
+    set.insert(prefixes);
+    benchmark::DoNotOptimize(set.toPrefixes());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+enum Operation : int64_t { UNION, INTERSECTION, DIFFERENCE };
+
+void BM_RangeSetOperation(benchmark::State &state) {
+  network::AddressRangeSet a;
+  network::AddressRangeSet b;
+  // Few short prefixes, so that a million of them stay about as many ranges
+  a.insert(makeIPv4Prefixes(1000000, 5, 20));
+  b.insert(makeIPv4Prefixes(1000000, 6, 20));
+  for (auto _ : state) {
+    switch (Operation(state.range(0))) {
+      case UNION: benchmark::DoNotOptimize(a | b); break;
+      case INTERSECTION: benchmark::DoNotOptimize(a & b); break;
+      case DIFFERENCE: benchmark::DoNotOptimize(a - b); break;
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(a.rangeCount() + b.rangeCount()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_RangeSetAggregateIPv4)->Arg(1 << 16)->Arg(5000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RangeSetAggregateIPv6)->Arg(1 << 16)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RangeSetOperation)->Arg(UNION)->Arg(INTERSECTION)->Arg(DIFFERENCE)->Unit(benchmark::kMillisecond);
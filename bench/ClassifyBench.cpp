@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressData.hpp"
+#include "../src/AddressPrefix.hpp"
+
+namespace {
+
+constexpr std::size_t C_COUNT = 1U << 16U;
+
+enum Mix : int64_t { IPV4, IPV6, MIXED };
+
+// Random addresses, a share of them drawn from the special-purpose ranges
+std::vector<network::Address> makeAddresses(Mix _mix) {
+  std::mt19937_64 rng(17);
+  std::vector<network::Address> addresses;
+  addresses.reserve(C_COUNT);
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    const bool ipv4 = _mix == IPV4 || (_mix == MIXED && (rng() & 1U) != 0);
+    if (ipv4) {
+      const uint32_t prefixes[] = {0x0a000000U, 0xc0a80000U, 0x7f000000U, 0xe0000000U, 0xa9fe0000U};
+      const auto random         = uint32_t(rng());
+      addresses.emplace_back(rng() % 4 == 0 ? prefixes[rng() % 5] | (random & 0xffffU) : random);
+    } else {
+      const uint8_t prefixes[] = {0x20, 0x2a, 0xfd, 0xfe, 0xff};
+      network::IPv6Address ip6 {};
+      for (auto &byte : ip6.c) byte = uint8_t(rng());
+      ip6[0] = prefixes[rng() % 5];
+      addresses.emplace_back(ip6);
+    }
+  }
+  return addresses;
+}
+
+void BM_ClassifyEach(benchmark::State &state) {
+  const auto addresses = makeAddresses(Mix(state.range(0)));
+  std::vector<network::AddressClassification> results(C_COUNT);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < C_COUNT; ++i) results[i] = addresses[i].classify();
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_ClassifyBulk(benchmark::State &state) {
+  const auto addresses = makeAddresses(Mix(state.range(0)));
+  std::vector<network::AddressClassification> results(C_COUNT);
+  for (auto _ : state) {
+    network::AddressData::classify(addresses, results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// Link-local test through the rule tables of classify()
+void BM_IsLinkLocal(benchmark::State &state) {
+  const auto addresses = makeAddresses(MIXED);
+  for (auto _ : state) {
+    std::size_t count = 0;
+    for (const auto &address : addresses) count += address.isLinkLocal();
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// The same test against constexpr prefixes, which compile to immediate masks
+void BM_PrefixLinkLocal(benchmark::State &state) {
+  using namespace network::literals;
+  static constexpr network::AddressPrefix C_LINK_LOCAL4 = "169.254.0.0/16"_cidr;
+  static constexpr network::AddressPrefix C_LINK_LOCAL6 = "fe80::/10"_cidr;
+  const auto addresses = makeAddresses(MIXED);
+  for (auto _ : state) {
+    std::size_t count = 0;
+    for (const auto &address : addresses) count += C_LINK_LOCAL4.contains(address) || C_LINK_LOCAL6.contains(address);
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ClassifyEach)->Arg(IPV4)->Arg(IPV6)->Arg(MIXED);
+BENCHMARK(BM_ClassifyBulk)->Arg(IPV4)->Arg(IPV6)->Arg(MIXED);
+BENCHMARK(BM_IsLinkLocal);
+BENCHMARK(BM_PrefixLinkLocal);
@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <vector>
+#include "../src/Endian.hpp"
+
+namespace {
+
+template <typename T>
+void BM_BswapScalarLoop(benchmark::State &state) {
+  std::vector<T> in(std::size_t(state.range(0)));
+  std::iota(in.begin(), in.end(), T(1));
+  std::vector<T> out(in.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < in.size(); ++i) out[i] = qbswap(in[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(in.size() * sizeof(T)));
+}
+
+template <typename T>
+void BM_BswapBatch(benchmark::State &state) {
+  std::vector<T> in(std::size_t(state.range(0)));
+  std::iota(in.begin(), in.end(), T(1));
+  std::vector<T> out(in.size());
+  for (auto _ : state) {
+    qbswap(std::span<const T>(in), std::span<T>(out));
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(in.size() * sizeof(T)));
+}
+
+template <typename T>
+void BM_BswapInPlace(benchmark::State &state) {
+  std::vector<T> data(std::size_t(state.range(0)));
+  std::iota(data.begin(), data.end(), T(1));
+  for (auto _ : state) {
+    qbswap(std::span<T>(data));
+    benchmark::DoNotOptimize(data.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size() * sizeof(T)));
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_BswapScalarLoop, uint16_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_BswapBatch, uint16_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_BswapScalarLoop, uint32_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_BswapBatch, uint32_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_BswapInPlace, uint32_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_BswapScalarLoop, uint64_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_BswapBatch, uint64_t)->Arg(4096);
@@ -0,0 +1,223 @@
+#include <benchmark/benchmark.h>
+
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "../src/AtomicFlags.hpp"
+#include "../src/BitFlags.hpp"
+#include "../src/Flags.hpp"
+#include "../src/FlagsNew.hpp"
+
+enum class BenchFlag : uint32_t {
+  NONE  = 0,
+  UP    = 1U << 0U,
+  RUN   = 1U << 1U,
+  LOOP  = 1U << 3U,
+  MULTI = 1U << 12U,
+  LOWER = 1U << 16U,
+};
+
+Q_DECLARE_FLAGS(BenchQFlags, BenchFlag)
+
+enum class LinkState : uint32_t {
+  NONE    = 0,
+  UP      = 1U << 0U,
+  RUNNING = 1U << 1U,
+  CARRIER = 1U << 2U,
+  PROMISC = 1U << 3U,
+};
+
+ENUM_FLAGS(LinkState)
+
+namespace {
+
+constexpr std::size_t C_COUNT  = 1U << 12U;
+constexpr BenchFlag C_VALUES[] = {BenchFlag::UP, BenchFlag::RUN, BenchFlag::LOOP, BenchFlag::MULTI, BenchFlag::LOWER};
+
+std::vector<BenchFlag> makeValues() {
+  std::mt19937 rng(23);
+  std::vector<BenchFlag> values(C_COUNT);
+  for (auto &value : values) value = C_VALUES[rng() % std::size(C_VALUES)];
+  return values;
+}
+
+template <typename TFlags>
+std::vector<TFlags> makeMasks(const std::vector<BenchFlag> &_values) {
+  std::vector<TFlags> masks;
+  masks.reserve(C_COUNT);
+  for (std::size_t i = 0; i < C_COUNT; ++i) masks.push_back(TFlags(_values[i]) | _values[(i * 7) % C_COUNT]);
+  return masks;
+}
+
+// Accumulate flags one at a time with |=
+template <typename TFlags>
+void BM_FlagsSet(benchmark::State &state) {
+  const auto values = makeValues();
+  for (auto _ : state) {
+    TFlags flags;
+    for (BenchFlag value : values) flags |= value;
+    benchmark::DoNotOptimize(flags);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+template <typename TFlags>
+bool hasFlag(const TFlags &_flags, BenchFlag _flag) {
+  if constexpr (std::is_same_v<TFlags, BenchQFlags>) {
+    return _flags.testFlag(_flag);
+  } else {
+    return _flags.isset(_flag);
+  }
+}
+
+// Test one flag in each of a set of masks
+template <typename TFlags>
+void BM_FlagsTest(benchmark::State &state) {
+  const auto values = makeValues();
+  const auto masks  = makeMasks<TFlags>(values);
+  for (auto _ : state) {
+    std::size_t count = 0;
+    for (const TFlags &mask : masks) count += hasFlag(mask, BenchFlag::LOOP);
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// Combine masks with &, ^ and ~ and compare the result
+template <typename TFlags>
+void BM_FlagsMask(benchmark::State &state) {
+  const auto values = makeValues();
+  const auto masks  = makeMasks<TFlags>(values);
+  const TFlags up   = TFlags(BenchFlag::UP) | BenchFlag::RUN;
+  for (auto _ : state) {
+    std::size_t count = 0;
+    for (const TFlags &mask : masks) count += ((mask & ~up) ^ mask) == up;
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+// The mutex-guarded Flags that AtomicFlags replaces
+class LockedLinkState {
+public:
+  void set(LinkState _flag) {
+    std::lock_guard lock(mutex_);
+    flags_ |= _flag;
+  }
+  void clear(LinkState _flag) {
+    std::lock_guard lock(mutex_);
+    flags_ &= ~Flags<LinkState>(_flag);
+  }
+  bool test(LinkState _flag) {
+    std::lock_guard lock(mutex_);
+    return flags_.isset(_flag);
+  }
+
+private:
+  std::mutex mutex_;
+  Flags<LinkState> flags_;
+};
+
+class AtomicLinkState {
+public:
+  void set(LinkState _flag) { flags_.fetch_set(_flag, std::memory_order_release); }
+  void clear(LinkState _flag) { flags_.fetch_clear(_flag, std::memory_order_release); }
+  bool test(LinkState _flag) const { return flags_.test(_flag, std::memory_order_acquire); }
+
+private:
+  AtomicFlags<LinkState> flags_;
+};
+
+// Thread 0 flips the carrier bit, as the netlink thread would, while every other thread reads it
+template <typename TState>
+void BM_FlagsContended(benchmark::State &state) {
+  static TState shared;
+  const bool writer = state.thread_index() == 0;
+  std::size_t count = 0;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < C_COUNT; ++i) {
+      if (!writer) {
+        count += shared.test(LinkState::CARRIER);
+      } else if ((i & 1U) != 0) {
+        shared.set(LinkState::CARRIER);
+      } else {
+        shared.clear(LinkState::CARRIER);
+      }
+    }
+  }
+  benchmark::DoNotOptimize(count);
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+std::vector<uint64_t> makeWords(uint32_t _seed) {
+  std::mt19937_64 rng(_seed);
+  std::vector<uint64_t> words(C_COUNT);
+  for (auto &word : words) word = rng();
+  return words;
+}
+
+// Masking the 64-bit flag words of C_COUNT objects at once, word by word or through qFlagsAnd
+void BM_FlagsBulkAndScalar(benchmark::State &state) {
+  const auto a = makeWords(1);
+  const auto b = makeWords(2);
+  std::vector<uint64_t> out(C_COUNT);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < C_COUNT; ++i) out[i] = a[i] & b[i];
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * C_COUNT * sizeof(uint64_t));
+}
+
+void BM_FlagsBulkAnd(benchmark::State &state) {
+  const auto a = makeWords(1);
+  const auto b = makeWords(2);
+  std::vector<uint64_t> out(C_COUNT);
+  for (auto _ : state) {
+    qFlagsAnd(a.data(), b.data(), out.data(), C_COUNT);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * C_COUNT * sizeof(uint64_t));
+}
+
+void BM_FlagsBulkCount(benchmark::State &state) {
+  const auto words = makeWords(3);
+  for (auto _ : state) benchmark::DoNotOptimize(qFlagsCount(words.data(), C_COUNT));
+  state.SetBytesProcessed(int64_t(state.iterations()) * C_COUNT * sizeof(uint64_t));
+}
+
+// Capability-style subset test and intersection on a 1024-flag set
+void BM_BitFlagsContains(benchmark::State &state) {
+  BitFlags<1024> supported;
+  BitFlags<1024> wanted;
+  std::mt19937 rng(29);
+  for (std::size_t i = 0; i < 1024; ++i) {
+    if (rng() % 2 != 0) supported.set(i);
+  }
+  for (std::size_t i : supported) {
+    if (rng() % 8 == 0) wanted.set(i);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(supported);
+    benchmark::DoNotOptimize(supported.contains(wanted));
+    benchmark::DoNotOptimize((supported & wanted).count());
+  }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_FlagsSet, Flags<BenchFlag>);
+BENCHMARK_TEMPLATE(BM_FlagsSet, BenchQFlags);
+BENCHMARK_TEMPLATE(BM_FlagsTest, Flags<BenchFlag>);
+BENCHMARK_TEMPLATE(BM_FlagsTest, BenchQFlags);
+BENCHMARK_TEMPLATE(BM_FlagsMask, Flags<BenchFlag>);
+BENCHMARK_TEMPLATE(BM_FlagsMask, BenchQFlags);
+BENCHMARK_TEMPLATE(BM_FlagsContended, LockedLinkState)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FlagsContended, AtomicLinkState)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FlagsBulkAndScalar);
+BENCHMARK(BM_FlagsBulkAnd);
+BENCHMARK(BM_FlagsBulkCount);
+BENCHMARK(BM_BitFlagsContains);
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/FlowTable.hpp"
+
+namespace {
+
+constexpr std::size_t C_FLOWS = 1U << 18U;
+
+struct FlowState {
+  uint64_t packets;
+  uint64_t bytes;
+};
+
+std::vector<network::FlowKey> makeFlows() {
+  std::mt19937_64 rng(22);
+  std::vector<network::FlowKey> flows;
+  flows.reserve(C_FLOWS);
+  const network::Address server(uint32_t(0xc0a80001U));
+  for (std::size_t i = 0; i < C_FLOWS; ++i) {
+    flows.emplace_back(network::Address(uint32_t(rng())), uint16_t(rng()), server, 443, 6);
+  }
+  return flows;
+}
+
+const std::vector<network::FlowKey> &flows() {
+  static const std::vector<network::FlowKey> flows = makeFlows();
+  return flows;
+}
+
+// Every thread: nine lookups per update of a packet counter, over a shared table of all flows
+void BM_FlowTableMixed(benchmark::State &state) {
+  static network::FlowTable<FlowState> table(C_FLOWS * 2, 0);
+  const auto &keys = flows();
+  std::mt19937_64 rng(uint64_t(state.thread_index()));
+  uint64_t now = 0;
+  for (auto _ : state) {
+    const network::FlowKey &key = keys[rng() % C_FLOWS];
+    if (++now % 10 == 0) {
+      table.update(key, now, [](FlowState &_state) {
+        ++_state.packets;
+        _state.bytes += 1500;
+      });
+    } else {
+      FlowState flow;
+      benchmark::DoNotOptimize(table.find(key, flow));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+// The same operations on one map behind a global lock
+void BM_LockedMapMixed(benchmark::State &state) {
+  struct Hash {
+    std::size_t operator()(const network::FlowKey &_key) const noexcept { return qHash(_key); }
+  };
+  static std::mutex mutex;
+  static std::unordered_map<network::FlowKey, FlowState, Hash> map;
+  const auto &keys = flows();
+  std::mt19937_64 rng(uint64_t(state.thread_index()));
+  uint64_t now = 0;
+  for (auto _ : state) {
+    const network::FlowKey &key = keys[rng() % C_FLOWS];
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (++now % 10 == 0) {
+      FlowState &flow = map[key];
+      ++flow.packets;
+      flow.bytes += 1500;
+    } else {
+      benchmark::DoNotOptimize(map.find(key));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_FlowTableMixed)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_LockedMapMixed)->ThreadRange(1, 32)->UseRealTime();
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressFormatter.hpp"
+
+namespace {
+
+constexpr std::size_t C_COUNT = 4096;
+
+std::vector<network::Address> makeAddresses() {
+  std::mt19937 rng(3);
+  std::vector<network::Address> out;
+  out.reserve(C_COUNT);
+  char text[INET6_ADDRSTRLEN];
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    if (i % 2 == 0) {
+      out.emplace_back(uint32_t(rng()));
+      continue;
+    }
+    uint8_t ip6[16];
+    for (auto &b : ip6) b = (rng() % 3 == 0) ? 0 : uint8_t(rng());
+    inet_ntop(AF_INET6, ip6, text, sizeof(text));
+    out.emplace_back(std::string_view(text));
+  }
+  return out;
+}
+
+void BM_ToString(benchmark::State &state) {
+  const auto addresses = makeAddresses();
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (const auto &address : addresses) total += address.toString().size();
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_ToChars(benchmark::State &state) {
+  const auto addresses = makeAddresses();
+  char buffer[64];
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (const auto &address : addresses) total += address.toChars(buffer, sizeof(buffer));
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_InetNtop(benchmark::State &state) {
+  const auto addresses = makeAddresses();
+  std::vector<in6_addr> raw(C_COUNT);
+  std::vector<int> family(C_COUNT);
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    bool ok = false;
+    const uint32_t ip4 = addresses[i].toIPv4Address(&ok);
+    family[i]          = addresses[i].getProtocol() == network::LayerProtocol::IPv4 ? AF_INET : AF_INET6;
+    if (family[i] == AF_INET) {
+      const uint32_t be = htonl(ip4);
+      std::memcpy(&raw[i], &be, sizeof(be));
+    } else {
+      inet_pton(AF_INET6, addresses[i].toString().c_str(), &raw[i]);
+    }
+  }
+  char buffer[INET6_ADDRSTRLEN];
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < C_COUNT; ++i) total += inet_ntop(family[i], &raw[i], buffer, sizeof(buffer)) != nullptr;
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_FormatAddresses(benchmark::State &state) {
+  const auto addresses = makeAddresses();
+  std::vector<char> buffer(C_COUNT * 48);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(network::formatAddresses(addresses, buffer.data(), buffer.size()));
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ToString);
+BENCHMARK(BM_ToChars);
+BENCHMARK(BM_InetNtop);
+BENCHMARK(BM_FormatAddresses);
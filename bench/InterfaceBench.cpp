@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include "../src/Interface.hpp"
+#include "../src/Netlink.hpp"
+#include "BenchNamespace.hpp"
+
+namespace {
+
+// Allocations through the global operator new, which also serves std::pmr::new_delete_resource()
+std::atomic<std::size_t> allocations {0};
+
+// Heap allocations made between construction and getCount()
+class AllocationCounter {
+public:
+  [[nodiscard]] std::size_t getCount() const noexcept { return allocations.load(std::memory_order_relaxed) - start_; }
+
+private:
+  std::size_t start_ {allocations.load(std::memory_order_relaxed)};
+};
+
+bool prepare(benchmark::State &_state) {
+  if (!BenchNamespace::instance().populate(int(_state.range(0)))) {
+    _state.SkipWithError("cannot create interfaces (needs CAP_SYS_ADMIN and iproute2)");
+    return false;
+  }
+  return true;
+}
+
+void BM_GetIfacesNetlink(benchmark::State &state) {
+  if (!prepare(state)) return;
+  const AllocationCounter heap;
+  for (auto _ : state) {
+    auto list = net::getIfacesNames();
+    benchmark::DoNotOptimize(list.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.counters["allocations"] = benchmark::Counter(double(heap.getCount()), benchmark::Counter::kAvgIterations);
+}
+
+// One arena per enumeration, its first block sized for about 512 bytes per interface and the netlink
+// receive buffer, released at once
+void BM_GetIfacesArena(benchmark::State &state) {
+  if (!prepare(state)) return;
+  const AllocationCounter heap;
+  const auto size = std::size_t(state.range(0)) * 512 + network::netlink::Socket::C_BUFFER_SIZE;
+  for (auto _ : state) {
+    std::pmr::monotonic_buffer_resource arena(size);
+    auto list = net::getIfacesNames(&arena);
+    benchmark::DoNotOptimize(list.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.counters["allocations"] = benchmark::Counter(double(heap.getCount()), benchmark::Counter::kAvgIterations);
+}
+
+// What getIfacesNames() used to do, plus collecting the addresses the netlink version returns
+void BM_GetIfaddrs(benchmark::State &state) {
+  if (!prepare(state)) return;
+  for (auto _ : state) {
+    ifaddrs *addrs = nullptr;
+    getifaddrs(&addrs);
+    std::size_t count = 0;
+    for (ifaddrs *it = addrs; it; it = it->ifa_next) {
+      if (!it->ifa_addr) continue;
+      if (it->ifa_addr->sa_family == AF_PACKET) {
+        std::string name(it->ifa_name);
+        benchmark::DoNotOptimize(name.data());
+      }
+      ++count;
+    }
+    freeifaddrs(addrs);
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+}  // namespace
+
+// Replaced for the whole benchmark binary; the count costs one relaxed increment per allocation
+void *operator new(std::size_t _size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *pointer = std::malloc(_size ? _size : 1)) return pointer;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t _size, std::align_val_t _alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  const auto alignment = std::max(std::size_t(_alignment), sizeof(void *));
+  if (void *pointer = std::aligned_alloc(alignment, (_size + alignment - 1) / alignment * alignment)) return pointer;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *_pointer) noexcept { std::free(_pointer); }
+void operator delete(void *_pointer, std::size_t) noexcept { std::free(_pointer); }
+void operator delete(void *_pointer, std::align_val_t) noexcept { std::free(_pointer); }
+void operator delete(void *_pointer, std::size_t, std::align_val_t) noexcept { std::free(_pointer); }
+
+// The namespace only grows, so both variants run at one size before moving to the next
+BENCHMARK(BM_GetIfacesNetlink)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfacesArena)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfaddrs)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfacesNetlink)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfacesArena)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfaddrs)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfacesNetlink)->Arg(4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfacesArena)->Arg(4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetIfaddrs)->Arg(4096)->Unit(benchmark::kMicrosecond);
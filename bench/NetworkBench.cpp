@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <vector>
+#include "../src/Network.hpp"
+#include "BenchNamespace.hpp"
+
+namespace {
+
+// 10.100.0.1 and up, with the /8 netmask SIOCSIFADDR assigns, so every variant leaves the kernel
+// with the same addresses: one primary and N - 1 secondaries.
+std::vector<Network::Operation> makeAdds(int _count) {
+  const int index = int(if_nametoindex("lo"));
+  network::Netmask netmask;
+  netmask.setPrefixLength(network::LayerProtocol::IPv4, 8);
+  std::vector<Network::Operation> operations;
+  for (int i = 0; i < _count; ++i) {
+    const network::Address address(uint32_t(0x0a640000U + uint32_t(i) + 1));
+    operations.push_back(Network::Operation::addAddress("lo", address, netmask));
+    operations.back().index = index;
+  }
+  return operations;
+}
+
+// Removing the primary address takes its secondaries with it
+void cleanup(benchmark::State &_state, Network &_network, const Network::Operation &_primary) {
+  Network::Operation remove = _primary;
+  remove.type               = Network::Operation::Type::REMOVE_ADDRESS;
+  Network::RetCode result {};
+  _state.PauseTiming();
+  _network.apply({&remove, 1}, {&result, 1});
+  _state.ResumeTiming();
+}
+
+bool prepare(benchmark::State &_state) {
+  if (!BenchNamespace::instance().isValid()) {
+    _state.SkipWithError("cannot enter a network namespace (needs CAP_SYS_ADMIN)");
+    return false;
+  }
+  return true;
+}
+
+// N addresses in one batch
+void BM_NetworkApplyBatch(benchmark::State &state) {
+  if (!prepare(state)) return;
+  const auto add = makeAdds(int(state.range(0)));
+  std::vector<Network::RetCode> results(add.size());
+  Network network;
+  for (auto _ : state) {
+    if (!network.apply(add, results)) {
+      state.SkipWithError("apply failed");
+      break;
+    }
+    cleanup(state, network, add.front());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+// The same requests sent one message and one ACK at a time
+void BM_NetworkApplyEach(benchmark::State &state) {
+  if (!prepare(state)) return;
+  const auto add = makeAdds(int(state.range(0)));
+  Network::RetCode result {};
+  Network network;
+  for (auto _ : state) {
+    for (const auto &operation : add) network.apply({&operation, 1}, {&result, 1});
+    cleanup(state, network, add.front());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+// What setIpV4() used to cost per address: a new socket, SIOCGIFFLAGS and SIOCSIFADDR (on an alias
+// label, so the addresses accumulate instead of replacing each other)
+void BM_SetIpV4Ioctl(benchmark::State &state) {
+  if (!prepare(state)) return;
+  const auto add = makeAdds(int(state.range(0)));
+  Network network;
+  for (auto _ : state) {
+    for (int i = 0; i < state.range(0); ++i) {
+      const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+      ifreq ifr {};
+      snprintf(ifr.ifr_name, IFNAMSIZ, "lo:%d", i);
+      ioctl(sock, SIOCGIFFLAGS, &ifr);
+      sockaddr_in sin {};
+      sin.sin_family      = AF_INET;
+      sin.sin_addr.s_addr = htonl(0x0a640000U + uint32_t(i) + 1);
+      std::memcpy(&ifr.ifr_addr, &sin, sizeof(sin));
+      ioctl(sock, SIOCSIFADDR, &ifr);
+      close(sock);
+    }
+    cleanup(state, network, add.front());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_NetworkApplyBatch)->Arg(16)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NetworkApplyEach)->Arg(16)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SetIpV4Ioctl)->Arg(16)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,31 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/NetworkManager.hpp"
+
+namespace {
+
+network::NetworkManager &manager() {
+  static network::NetworkManager instance;
+  static const bool opened = instance.open() && instance.start();
+  (void)opened;
+  return instance;
+}
+
+// Hot-path "which interface owns this address" lookups; scales with threads since readers share nothing
+void BM_NetworkManagerOwner(benchmark::State &state) {
+  network::NetworkManager &nm = manager();
+  if (!nm.isOpen()) {
+    state.SkipWithError("cannot open netlink socket");
+    return;
+  }
+  const network::Address loopback(network::Address::SpecialAddress::LOCAL_HOST);
+  for (auto _ : state) {
+    const auto snapshot = nm.snapshot();
+    benchmark::DoNotOptimize(snapshot->owner(loopback));
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_NetworkManagerOwner)->ThreadRange(1, 8);
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/AddressParser.hpp"
+
+namespace {
+
+constexpr std::size_t C_COUNT = 4096;
+
+std::vector<std::string> makeIPv4Texts() {
+  std::mt19937 rng(7);
+  std::vector<std::string> out;
+  out.reserve(C_COUNT);
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    const uint32_t ip = rng();
+    out.push_back(std::to_string(ip >> 24U) + '.' + std::to_string((ip >> 16U) & 0xffU) + '.' +
+                  std::to_string((ip >> 8U) & 0xffU) + '.' + std::to_string(ip & 0xffU));
+  }
+  return out;
+}
+
+std::vector<std::string> makeIPv6Texts() {
+  std::mt19937 rng(11);
+  std::vector<std::string> out;
+  out.reserve(C_COUNT);
+  char text[INET6_ADDRSTRLEN];
+  for (std::size_t i = 0; i < C_COUNT; ++i) {
+    uint8_t ip6[16];
+    for (auto &b : ip6) b = uint8_t(rng());
+    switch (i % 4) {
+      case 0: break;                                                    // full form
+      case 1: std::fill(ip6 + 4, ip6 + 12, 0); break;                   // compressed
+      case 2: std::fill(ip6, ip6 + 10, 0), ip6[10] = ip6[11] = 0xff; break;  // v4-mapped
+      case 3: std::fill(ip6 + 2, ip6 + 14, 0); break;
+    }
+    inet_ntop(AF_INET6, ip6, text, sizeof(text));
+    out.emplace_back(text);
+  }
+  return out;
+}
+
+void BM_ParseIPv4(benchmark::State &state) {
+  const auto texts = makeIPv4Texts();
+  for (auto _ : state) {
+    uint32_t sum = 0;
+    for (const auto &text : texts) {
+      uint32_t ip = 0;
+      network::parseIPv4(text, ip);
+      sum += ip;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_InetPtonIPv4(benchmark::State &state) {
+  const auto texts = makeIPv4Texts();
+  for (auto _ : state) {
+    uint32_t sum = 0;
+    for (const auto &text : texts) {
+      in_addr ip {};
+      inet_pton(AF_INET, text.c_str(), &ip);
+      sum += ip.s_addr;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_ParseIPv6(benchmark::State &state) {
+  const auto texts = makeIPv6Texts();
+  for (auto _ : state) {
+    uint8_t sum = 0;
+    for (const auto &text : texts) {
+      uint8_t ip6[16] = {};
+      network::parseIPv6(text, ip6);
+      sum += ip6[15];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_InetPtonIPv6(benchmark::State &state) {
+  const auto texts = makeIPv6Texts();
+  for (auto _ : state) {
+    uint8_t sum = 0;
+    for (const auto &text : texts) {
+      in6_addr ip6 {};
+      inet_pton(AF_INET6, text.c_str(), &ip6);
+      sum += ip6.s6_addr[15];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * C_COUNT);
+}
+
+void BM_AddressSetAddress(benchmark::State &state) {
+  auto texts        = makeIPv4Texts();
+  const auto texts6 = makeIPv6Texts();
+  texts.insert(texts.end(), texts6.begin(), texts6.end());
+  network::Address address;
+  for (auto _ : state) {
+    std::size_t valid = 0;
+    for (const auto &text : texts) valid += address.setAddress(text);
+    benchmark::DoNotOptimize(valid);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(texts.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ParseIPv4);
+BENCHMARK(BM_InetPtonIPv4);
+BENCHMARK(BM_ParseIPv6);
+BENCHMARK(BM_InetPtonIPv6);
+BENCHMARK(BM_AddressSetAddress);
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include <unistd.h>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/PrefixDatabase.hpp"
+
+namespace {
+
+// Same table shapes as PrefixTableBench, so lookups are comparable
+constexpr std::size_t C_IPV4_PREFIXES = 800000;
+constexpr std::size_t C_IPV6_PREFIXES = 150000;
+constexpr std::size_t C_LOOKUPS       = 1 << 16;
+
+network::Netmask prefixLength(network::LayerProtocol _protocol, int _length) {
+  network::Netmask netmask;
+  netmask.setPrefixLength(_protocol, _length);
+  return netmask;
+}
+
+// Written once per run and removed at exit; values are one of 4096 ASN-like labels
+const std::string &databasePath() {
+  static const struct File {
+    std::string path;
+
+    File() {
+      path = (std::filesystem::temp_directory_path() / ("prefixdb-bench-" + std::to_string(getpid()))).string();
+      network::PrefixDatabaseBuilder builder;
+      std::mt19937 rng(5);
+      for (uint32_t i = 0; i < C_IPV4_PREFIXES; ++i) {
+        const int length = rng() % 100 < 60 ? 24 : int(8 + rng() % 16);
+        builder.insert(network::Address(uint32_t(rng())), prefixLength(network::LayerProtocol::IPv4, length),
+                       "AS" + std::to_string(i % 4096));
+      }
+      rng.seed(6);
+      for (uint32_t i = 0; i < C_IPV6_PREFIXES; ++i) {
+        network::IPv6Address ip6 {};
+        for (auto &b : ip6.c) b = uint8_t(rng());
+        ip6[0]           = uint8_t(0x20 | (ip6[0] & 0x0f));
+        const int length = 32 + int(rng() % 17);
+        builder.insert(network::Address(ip6), prefixLength(network::LayerProtocol::IPv6, length),
+                       "AS" + std::to_string(i % 4096));
+      }
+      builder.write(path);
+    }
+    ~File() { std::filesystem::remove(path); }
+  } file;
+  return file.path;
+}
+
+std::vector<network::Address> makeAddresses(network::LayerProtocol _protocol) {
+  std::mt19937 rng(_protocol == network::LayerProtocol::IPv4 ? 7 : 8);
+  std::vector<network::Address> out;
+  out.reserve(C_LOOKUPS);
+  for (std::size_t i = 0; i < C_LOOKUPS; ++i) {
+    if (_protocol == network::LayerProtocol::IPv4) {
+      out.emplace_back(uint32_t(rng()));
+      continue;
+    }
+    network::IPv6Address ip6 {};
+    for (auto &b : ip6.c) b = uint8_t(rng());
+    ip6[0] = uint8_t(0x20 | (ip6[0] & 0x0f));
+    out.emplace_back(ip6);
+  }
+  return out;
+}
+
+// Time to the first answer: map, check the header, verify the sections the lookup touches
+void BM_PrefixDatabaseOpen(benchmark::State &_state) {
+  const std::string &path = databasePath();
+  const network::Address address(uint32_t(0x08080808));
+  for (auto _ : _state) {
+    network::PrefixDatabase database;
+    database.open(path);
+    benchmark::DoNotOptimize(database.lookup(address));
+  }
+}
+BENCHMARK(BM_PrefixDatabaseOpen)->Unit(benchmark::kMicrosecond);
+
+void BM_PrefixDatabaseOpenVerify(benchmark::State &_state) {
+  const std::string &path = databasePath();
+  for (auto _ : _state) {
+    network::PrefixDatabase database;
+    database.open(path);
+    benchmark::DoNotOptimize(database.verify());
+  }
+}
+BENCHMARK(BM_PrefixDatabaseOpenVerify)->Unit(benchmark::kMicrosecond);
+
+void BM_PrefixDatabaseLookup(benchmark::State &_state) {
+  network::PrefixDatabase database;
+  if (!database.open(databasePath())) {
+    _state.SkipWithError("cannot write the database");
+    return;
+  }
+  const auto protocol  = network::LayerProtocol(_state.range(0));
+  const auto addresses = makeAddresses(protocol);
+  for (auto _ : _state) {
+    std::size_t sum = 0;
+    for (const auto &address : addresses) {
+      const auto value = database.lookup(address);
+      sum += value ? value->size() : 0;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  _state.SetItemsProcessed(int64_t(_state.iterations() * addresses.size()));
+  _state.SetLabel(protocol == network::LayerProtocol::IPv4 ? "IPv4" : "IPv6");
+}
+BENCHMARK(BM_PrefixDatabaseLookup)
+    ->Arg(int(network::LayerProtocol::IPv4))
+    ->Arg(int(network::LayerProtocol::IPv6))
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
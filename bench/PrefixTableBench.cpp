@@ -0,0 +1,195 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <random>
+#include <vector>
+#include "../src/Address.hpp"
+#include "../src/PrefixTable.hpp"
+
+namespace {
+
+constexpr std::size_t C_IPV4_PREFIXES = 800000;
+constexpr std::size_t C_IPV6_PREFIXES = 150000;
+constexpr std::size_t C_LOOKUPS       = 1 << 16;
+// Most of a real IPv6 table sits under a few RIR /16s
+constexpr std::array<uint16_t, 8> C_DENSE_TOPS = {0x2001, 0x2400, 0x2600, 0x2804, 0x2a00, 0x2a01, 0x2a02, 0x2a03};
+
+network::Netmask prefixLength(network::LayerProtocol _protocol, int _length) {
+  network::Netmask netmask;
+  netmask.setPrefixLength(_protocol, _length);
+  return netmask;
+}
+
+// Roughly the shape of a full BGP table: mostly /24, the rest spread over /8../23
+const network::PrefixTable<uint32_t> &ipv4Table() {
+  static const network::PrefixTable<uint32_t> table = [] {
+    network::PrefixTable<uint32_t> out;
+    std::mt19937 rng(5);
+    for (uint32_t i = 0; i < C_IPV4_PREFIXES; ++i) {
+      const int length = rng() % 100 < 60 ? 24 : int(8 + rng() % 16);
+      out.insert(network::Address(uint32_t(rng())), prefixLength(network::LayerProtocol::IPv4, length), i);
+    }
+    return out;
+  }();
+  return table;
+}
+
+// Allocations under 2000::/4, /32 to /48
+const network::PrefixTable<uint32_t> &ipv6Table() {
+  static const network::PrefixTable<uint32_t> table = [] {
+    network::PrefixTable<uint32_t> out;
+    std::mt19937 rng(6);
+    for (uint32_t i = 0; i < C_IPV6_PREFIXES; ++i) {
+      network::IPv6Address ip6 {};
+      for (auto &b : ip6.c) b = uint8_t(rng());
+      ip6[0] = uint8_t(0x20 | (ip6[0] & 0x0f));
+      const int length = 32 + int(rng() % 17);
+      out.insert(network::Address(ip6), prefixLength(network::LayerProtocol::IPv6, length), i);
+    }
+    return out;
+  }();
+  return table;
+}
+
+network::Address denseIPv6(std::mt19937 &_rng, uint16_t _top) {
+  network::IPv6Address ip6 {};
+  for (auto &b : ip6.c) b = uint8_t(_rng());
+  ip6[0] = uint8_t(_top >> 8U);
+  ip6[1] = uint8_t(_top);
+  return network::Address(ip6);
+}
+
+// Allocations under the /16s of C_DENSE_TOPS, /29 to /48
+const network::PrefixTable<uint32_t> &ipv6DenseTable() {
+  static const network::PrefixTable<uint32_t> table = [] {
+    network::PrefixTable<uint32_t> out;
+    std::mt19937 rng(10);
+    for (uint32_t i = 0; i < C_IPV6_PREFIXES; ++i) {
+      const int length = 29 + int(rng() % 20);
+      out.insert(denseIPv6(rng, C_DENSE_TOPS[rng() % C_DENSE_TOPS.size()]),
+                 prefixLength(network::LayerProtocol::IPv6, length), i);
+    }
+    return out;
+  }();
+  return table;
+}
+
+std::vector<network::Address> makeIPv4Addresses() {
+  std::mt19937 rng(7);
+  std::vector<network::Address> out;
+  out.reserve(C_LOOKUPS);
+  for (std::size_t i = 0; i < C_LOOKUPS; ++i) out.emplace_back(uint32_t(rng()));
+  return out;
+}
+
+std::vector<network::Address> makeIPv6Addresses() {
+  std::mt19937 rng(8);
+  std::vector<network::Address> out;
+  out.reserve(C_LOOKUPS);
+  for (std::size_t i = 0; i < C_LOOKUPS; ++i) {
+    network::IPv6Address ip6 {};
+    for (auto &b : ip6.c) b = uint8_t(rng());
+    ip6[0] = uint8_t(0x20 | (ip6[0] & 0x0f));
+    out.emplace_back(ip6);
+  }
+  return out;
+}
+
+std::vector<network::Address> makeDenseIPv6Addresses() {
+  std::mt19937 rng(11);
+  std::vector<network::Address> out;
+  out.reserve(C_LOOKUPS);
+  for (std::size_t i = 0; i < C_LOOKUPS; ++i) out.push_back(denseIPv6(rng, C_DENSE_TOPS[rng() % C_DENSE_TOPS.size()]));
+  return out;
+}
+
+void lookupSingle(benchmark::State &_state, const network::PrefixTable<uint32_t> &_table,
+    const std::vector<network::Address> &_addresses) {
+  for (auto _ : _state) {
+    uint32_t sum = 0;
+    for (const auto &address : _addresses) {
+      const uint32_t *value = _table.lookup(address);
+      sum += value ? *value : 0;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  _state.SetItemsProcessed(int64_t(_state.iterations()) * int64_t(_addresses.size()));
+}
+
+void lookupBatch(benchmark::State &_state, const network::PrefixTable<uint32_t> &_table,
+    const std::vector<network::Address> &_addresses) {
+  std::vector<const uint32_t *> results(_addresses.size());
+  for (auto _ : _state) {
+    _table.lookup(_addresses, results);
+    benchmark::DoNotOptimize(results.data());
+    benchmark::ClobberMemory();
+  }
+  _state.SetItemsProcessed(int64_t(_state.iterations()) * int64_t(_addresses.size()));
+}
+
+void BM_PrefixTableLookupIPv4(benchmark::State &state) {
+  lookupSingle(state, ipv4Table(), makeIPv4Addresses());
+}
+
+void BM_PrefixTableLookupIPv4Batch(benchmark::State &state) {
+  lookupBatch(state, ipv4Table(), makeIPv4Addresses());
+}
+
+void BM_PrefixTableLookupIPv6(benchmark::State &state) {
+  lookupSingle(state, ipv6Table(), makeIPv6Addresses());
+}
+
+void BM_PrefixTableLookupIPv6Batch(benchmark::State &state) {
+  lookupBatch(state, ipv6Table(), makeIPv6Addresses());
+}
+
+void BM_PrefixTableLookupIPv6Dense(benchmark::State &state) {
+  lookupSingle(state, ipv6DenseTable(), makeDenseIPv6Addresses());
+}
+
+void BM_PrefixTableLookupIPv6DenseBatch(benchmark::State &state) {
+  lookupBatch(state, ipv6DenseTable(), makeDenseIPv6Addresses());
+}
+
+void BM_PrefixTableInsertIPv6(benchmark::State &state) {
+  std::mt19937 rng(9);
+  for (auto _ : state) {
+    state.PauseTiming();
+    network::PrefixTable<uint32_t> table;
+    state.ResumeTiming();
+    for (uint32_t i = 0; i < 10000; ++i) {
+      network::IPv6Address ip6 {};
+      for (auto &b : ip6.c) b = uint8_t(rng());
+      table.insert(network::Address(ip6), prefixLength(network::LayerProtocol::IPv6, 32 + int(rng() % 17)), i);
+    }
+    benchmark::DoNotOptimize(table.size());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * 10000);
+}
+
+// All prefixes under one /16, so every insert updates the same subtree
+void BM_PrefixTableInsertIPv6Dense(benchmark::State &state) {
+  const auto count = uint32_t(state.range(0));
+  std::mt19937 rng(12);
+  for (auto _ : state) {
+    state.PauseTiming();
+    network::PrefixTable<uint32_t> table;
+    state.ResumeTiming();
+    for (uint32_t i = 0; i < count; ++i) {
+      table.insert(denseIPv6(rng, 0x2a02), prefixLength(network::LayerProtocol::IPv6, 32 + int(rng() % 17)), i);
+    }
+    benchmark::DoNotOptimize(table.size());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * count);
+}
+
+}  // namespace
+
+BENCHMARK(BM_PrefixTableLookupIPv4);
+BENCHMARK(BM_PrefixTableLookupIPv4Batch);
+BENCHMARK(BM_PrefixTableLookupIPv6);
+BENCHMARK(BM_PrefixTableLookupIPv6Batch);
+BENCHMARK(BM_PrefixTableLookupIPv6Dense);
+BENCHMARK(BM_PrefixTableLookupIPv6DenseBatch);
+BENCHMARK(BM_PrefixTableInsertIPv6);
+BENCHMARK(BM_PrefixTableInsertIPv6Dense)->Arg(5000)->Arg(20000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,37 @@
+# Runs the benchmark executable and writes its JSON report to <OUTPUT_PREFIX>-<git revision>.json
+#
+#   cmake -DBENCH=<lib_bench> -DOUTPUT_PREFIX=<dir/name> -DSOURCE_DIR=<repo>
+#         [-DFILTER=<regex>] [-DREPETITIONS=<n>] -P RunBench.cmake
+#
+# The revision is read when the benchmarks run, not when the build is configured; a dirty
+# working tree gets a "-dirty" suffix so its results are not mistaken for the commit's.
+
+execute_process(COMMAND git describe --always --dirty --abbrev=12
+  WORKING_DIRECTORY "${SOURCE_DIR}"
+  OUTPUT_VARIABLE revision OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+if(NOT revision)
+  set(revision "unknown")
+endif()
+
+if(NOT DEFINED FILTER OR FILTER STREQUAL "")
+  set(FILTER ".")
+endif()
+if(NOT DEFINED REPETITIONS)
+  set(REPETITIONS 1)
+endif()
+
+set(output "${OUTPUT_PREFIX}-${revision}.json")
+get_filename_component(directory "${output}" DIRECTORY)
+file(MAKE_DIRECTORY "${directory}")
+message(STATUS "Writing ${output}")
+
+execute_process(COMMAND "${BENCH}"
+  "--benchmark_filter=${FILTER}"
+  "--benchmark_repetitions=${REPETITIONS}"
+  --benchmark_report_aggregates_only=true
+  "--benchmark_out=${output}"
+  --benchmark_out_format=json
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${BENCH} failed: ${result}")
+endif()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Compare two JSON reports written by the bench_json target.
+
+    bench/compare.py <baseline.json> <contender.json> [--threshold PERCENT] [--metric cpu_time|real_time]
+
+Reports are matched by benchmark name. With repetitions the median is compared, otherwise the
+single run. Prints one line per benchmark and exits with status 1 if any benchmark got slower by
+more than the threshold, so it can gate a CI step. Compare reports from the same kit (the file
+names start with the compiler id and version) and the same machine; the script warns otherwise.
+"""
+
+import argparse
+import json
+import statistics
+import sys
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    with open(path, encoding="utf-8") as file:
+        report = json.load(file)
+
+    medians = {}
+    runs = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        value = entry[metric] * TIME_UNITS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = value
+        else:
+            runs.setdefault(name, []).append(value)
+
+    results = {name: statistics.median(values) for name, values in runs.items()}
+    results.update(medians)
+    return report.get("context", {}), results
+
+
+def format_time(nanoseconds):
+    for unit in ("s", "ms", "us"):
+        if nanoseconds >= TIME_UNITS[unit]:
+            return f"{nanoseconds / TIME_UNITS[unit]:.3g} {unit}"
+    return f"{nanoseconds:.3g} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0, help="regression threshold in percent (default 5)")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"), default="cpu_time")
+    args = parser.parse_args()
+
+    base_context, base = load(args.baseline, args.metric)
+    new_context, new = load(args.contender, args.metric)
+    for key in ("host_name", "num_cpus", "mhz_per_cpu"):
+        if base_context.get(key) != new_context.get(key):
+            print(f"warning: {key} differs: {base_context.get(key)} vs {new_context.get(key)}", file=sys.stderr)
+
+    names = [name for name in base if name in new]
+    width = max((len(name) for name in names), default=10)
+    regressions = 0
+    print(f"{'Benchmark':<{width}}  {'Baseline':>10}  {'Contender':>10}  {'Change':>8}")
+    for name in names:
+        change = (new[name] - base[name]) / base[name] * 100.0 if base[name] else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improved"
+        print(f"{name:<{width}}  {format_time(base[name]):>10}  {format_time(new[name]):>10}  {change:>+7.1f}%{flag}")
+
+    for name in sorted(set(base) - set(new)):
+        print(f"{name}: only in {args.baseline}")
+    for name in sorted(set(new) - set(base)):
+        print(f"{name}: only in {args.contender}")
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower by more than {args.threshold:g}%", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
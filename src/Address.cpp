@@ -1,19 +1,166 @@
 #include "Address.hpp"
 #include "AddressData.hpp"
+#include "AddressFormatter.hpp"
+#include "AddressParser.hpp"
+#include "Endian.hpp"
 
 namespace network {
-void AddressData::setAddress(uint32_t _addr) {
-  addr_     = _addr;
-  protocol_ = Address::LayerProtocol::IPv4;
-
-  //create mapped address, except for a_ == 0 (any)
-  a6_64.c[0] = 0;
-  if (addr_) {
-    a6_32.c[2] = qToBigEndian(0xffff);
-    a6_32.c[3] = qToBigEndian(addr_);
-  } else {
-    a6_64.c[1] = 0;
+
+namespace {
+using detail::C_INADDR_ANY;
+using detail::C_INADDR_BROADCAST;
+using detail::C_INADDR_LOOPBACK;
+
+bool convertToIpv4(uint32_t &_addr, const uint8_t *_addr6, Flags<Address::Conversion> _mode) {
+  if (!_mode) return false;
+
+  uint64_t high = 0;
+  std::memcpy(&high, _addr6, sizeof(high));
+  if (high != 0) return false;
+
+  uint32_t mid = 0;
+  std::memcpy(&mid, _addr6 + 8, sizeof(mid));
+  mid = qFromBigEndian(mid);
+  uint32_t low = 0;
+  std::memcpy(&low, _addr6 + 12, sizeof(low));
+  low = qFromBigEndian(low);
+
+  if (mid == 0xffff && _mode.isset(Address::Conversion::ConvertV4MappedToIPv4)) {
+    _addr = low;
+    return true;
+  }
+  if (mid != 0) return false;
+
+  if (low == 0 && _mode.isset(Address::Conversion::ConvertUnspecifiedAddress)) {
+    _addr = 0;
+    return true;
+  }
+  if (low == 1 && _mode.isset(Address::Conversion::ConvertLocalHost)) {
+    _addr = C_INADDR_LOOPBACK;
+    return true;
+  }
+  if (low != 1 && _mode.isset(Address::Conversion::ConvertV4CompatToIPv4)) {
+    _addr = low;
+    return true;
+  }
+  return false;
+}
+}  // namespace
+
+bool AddressData::parse(std::string_view _ipString) {
+  clear();
+  if (_ipString.find(':') != std::string_view::npos) {
+    uint8_t ip6[16];
+    if (!parseIPv6(_ipString, ip6)) return false;
+    setAddress(ip6);
+    return true;
+  }
+
+  uint32_t ip4 = 0;
+  if (!parseIPv4(_ipString, ip4)) return false;
+  setAddress(ip4);
+  return true;
+}
+
+Address::Address(std::string_view _address) { d_.parse(_address); }
+
+//! Parses an IPv4 or IPv6 text address. On failure the address is cleared and false is returned.
+bool Address::setAddress(std::string_view _address) { return d_.parse(_address); }
+
+std::string Address::toString() const {
+  char buffer[48];
+  return {buffer, toChars(buffer, sizeof(buffer))};
+}
+
+std::size_t Address::toChars(char *_buffer, std::size_t _size) const {
+  // The formatters need slack past the text, so short buffers go through a scratch copy
+  char scratch[48];
+  char *out        = _size >= sizeof(scratch) ? _buffer : scratch;
+  std::size_t size = 0;
+  switch (d_.protocol_) {
+    case LayerProtocol::IPv4: size = formatIPv4(d_.addr_, out); break;
+    case LayerProtocol::IPv6:
+    case LayerProtocol::ANY_IP: size = formatIPv6(d_.a6.c, out); break;
+    default: return 0;
+  }
+  if (size > _size) return 0;
+  if (out != _buffer) std::memcpy(_buffer, out, size);
+  return size;
+}
+
+uint32_t Address::toIPv4Address(bool *_ok) const {
+  if (_ok) {
+    uint32_t dummy = 0;
+    *_ok = d_.protocol_ == LayerProtocol::IPv4 || d_.protocol_ == LayerProtocol::ANY_IP ||
+           (d_.protocol_ == LayerProtocol::IPv6 &&
+               convertToIpv4(dummy, d_.a6.c,
+                   Conversion::ConvertV4MappedToIPv4 | Conversion::ConvertUnspecifiedAddress));
+  }
+  return d_.addr_;
+}
+
+bool Address::isEqual(const Address &_address, Flags<Conversion> _mode) const {
+  if (d_.protocol_ == _address.d_.protocol_) return *this == _address;
+  const bool unspecified = _mode.isset(Conversion::ConvertUnspecifiedAddress);
+  const bool zero        = (d_.a6_64.c[0] | d_.a6_64.c[1] | _address.d_.a6_64.c[0] | _address.d_.a6_64.c[1]) == 0;
+  uint32_t ip4           = 0;
+  switch (d_.protocol_) {
+    case LayerProtocol::IPv4:
+      if (_address.d_.protocol_ == LayerProtocol::IPv6) {
+        return convertToIpv4(ip4, _address.d_.a6.c, _mode) && ip4 == d_.addr_;
+      }
+      return _address.d_.protocol_ == LayerProtocol::ANY_IP && unspecified && zero;
+    case LayerProtocol::IPv6:
+      if (_address.d_.protocol_ == LayerProtocol::IPv4) {
+        return convertToIpv4(ip4, d_.a6.c, _mode) && ip4 == _address.d_.addr_;
+      }
+      return _address.d_.protocol_ == LayerProtocol::ANY_IP && unspecified && zero;
+    case LayerProtocol::ANY_IP: return _address.d_.protocol_ != LayerProtocol::UNKNOWN && unspecified && zero;
+    default: return false;
+  }
+}
+
+bool Address::operator==(SpecialAddress _address) const {
+  uint32_t ip4 = C_INADDR_ANY;
+  switch (_address) {
+    case SpecialAddress::EMPTY: return d_.protocol_ == LayerProtocol::UNKNOWN;
+    case SpecialAddress::BROADCAST: ip4 = C_INADDR_BROADCAST; break;
+    case SpecialAddress::LOCAL_HOST: ip4 = C_INADDR_LOOPBACK; break;
+    case SpecialAddress::ANY: return d_.protocol_ == LayerProtocol::ANY_IP;
+    case SpecialAddress::ANY_IPv4: break;
+    case SpecialAddress::LOCAL_HOST_IPv6:
+    case SpecialAddress::ANY_IPv6:
+      if (d_.protocol_ == LayerProtocol::IPv6) {
+        // 1 for localhost, 0 for any
+        const uint64_t second = uint8_t(_address == SpecialAddress::LOCAL_HOST_IPv6);
+        return d_.a6_64.c[0] == 0 && d_.a6_64.c[1] == qToBigEndian(second);
+      }
+      return false;
   }
+  // common IPv4 part
+  return d_.protocol_ == LayerProtocol::IPv4 && d_.addr_ == ip4;
+}
+
+bool Address::isLoopback() const { return classify() == AddressClassification::LOOP_BACK; }
+
+// Unicast beyond the local link, private and unique local ranges included
+bool Address::isGlobal() const { return (int(classify()) & int(AddressClassification::GLOBAL)) != 0; }
+
+bool Address::isLinkLocal() const { return classify() == AddressClassification::LINK_LOCAL; }
+
+bool Address::isSiteLocal() const { return classify() == AddressClassification::SITE_LOCAL; }
+
+bool Address::isUniqueLocalUnicast() const { return classify() == AddressClassification::UNIQUE_LOCAL; }
+
+bool Address::isMulticast() const { return classify() == AddressClassification::MULTICAST; }
+
+bool Address::isBroadcast() const { return classify() == AddressClassification::BROADCAST; }
+
+// RFC 1918 and RFC 6598 IPv4 ranges, IPv6 unique local addresses
+bool Address::isPrivateUse() const {
+  const AddressClassification classification = classify();
+  return classification == AddressClassification::PRIVATE_NETWORK ||
+         classification == AddressClassification::UNIQUE_LOCAL;
 }
 
 }  // namespace network
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <compare>
 #include <cstdint>
-#include <memory>
+#include <cstring>
+#include <functional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "AddressData.hpp"
 #include "Flags.hpp"
+#include "Uint128.hpp"
+
+struct sockaddr;
 
 namespace network {
 
-struct sockaddr;
-class AddressData;
+namespace detail {
+constexpr uint32_t C_INADDR_ANY       = 0x00000000U;
+constexpr uint32_t C_INADDR_BROADCAST = 0xffffffffU;
+constexpr uint32_t C_INADDR_LOOPBACK  = 0x7f000001U;
+}  // namespace detail
 
 class Address {
 public:
@@ -32,41 +45,119 @@ public:
     StrictConversion = 0
   };
 
-  enum class LayerProtocol { UNKNOWN = -1, IPv4, IPv6, ANY_IP };
-
-  Address() = default;
-  explicit Address(uint32_t _ip4);
-  explicit Address(const sockaddr *_address);
-  Address(const Address &copy);
-  explicit Address(SpecialAddress _address);
-  ~Address();
-  Address &operator=(Address &&_other) noexcept {
-    swap(_other);
+  using LayerProtocol = network::LayerProtocol;
+
+  // The constructors and setters taking numeric forms are constexpr; text literals are parsed at
+  // compile time by the _ip and _cidr literals of AddressPrefix.hpp
+  constexpr Address() = default;
+  constexpr explicit Address(uint32_t _ip4) { d_.setAddress(_ip4); }
+  constexpr explicit Address(const uint8_t *_ip6) { d_.setAddress(_ip6); }
+  constexpr explicit Address(const IPv6Address &_ip6) { d_.setAddress(_ip6.c); }
+  explicit Address(std::string_view _address);
+  //! From an AF_INET or AF_INET6 socket address; any other family gives a null address
+  explicit Address(const ::sockaddr *_address);
+  constexpr Address(const Address &copy) = default;
+  constexpr Address(Address &&_other)    = default;
+  constexpr explicit Address(SpecialAddress _address) { setAddress(_address); }
+  constexpr ~Address() = default;
+  constexpr Address &operator=(Address &&_other) noexcept = default;
+  constexpr Address &operator=(const Address &_other)     = default;
+  constexpr Address &operator=(const SpecialAddress &_other) {
+    setAddress(_other);
     return *this;
   }
-  Address &operator=(const Address &_other);
-  Address &operator=(const SpecialAddress &_other);
-  void swap(Address &other) noexcept { d_.swap(other.d_); }
-
-  void setAddress(uint32_t _ip4);
-  void setAddress(const std::string _ip6);
-  void setAddress(const sockaddr *_address);
-  void setAddress(SpecialAddress address);
+  void swap(Address &other) noexcept { std::swap(d_, other.d_); }
+
+  constexpr void setAddress(uint32_t _ip4) { d_.setAddress(_ip4); }
+  constexpr void setAddress(const uint8_t *_ip6) { d_.setAddress(_ip6); }
+  constexpr void setAddress(const IPv6Address &_ip6) { d_.setAddress(_ip6.c); }
+  bool setAddress(std::string_view _address);
+  //! Returns false, clearing the address, unless \a _address is AF_INET or AF_INET6
+  bool setAddress(const ::sockaddr *_address);
+  constexpr void setAddress(SpecialAddress _address) {
+    d_.clear();
+
+    uint8_t ip6[16] = {};
+    uint32_t ip4    = detail::C_INADDR_ANY;
+    switch (_address) {
+      case SpecialAddress::EMPTY: return;
+      case SpecialAddress::BROADCAST: ip4 = detail::C_INADDR_BROADCAST; break;
+      case SpecialAddress::LOCAL_HOST: ip4 = detail::C_INADDR_LOOPBACK; break;
+      case SpecialAddress::ANY_IPv4: break;
+      case SpecialAddress::LOCAL_HOST_IPv6: ip6[15] = 1; [[fallthrough]];
+      case SpecialAddress::ANY_IPv6: d_.setAddress(ip6); return;
+      case SpecialAddress::ANY: d_.protocol_ = LayerProtocol::ANY_IP; return;
+    }
+    // common IPv4 part
+    d_.setAddress(ip4);
+  }
 
-  [[nodiscard]] LayerProtocol getProtocol() const;
+  [[nodiscard]] constexpr LayerProtocol getProtocol() const { return d_.protocol_; }
   [[nodiscard]] std::string toString() const;
+  //! Writes the text form (dotted IPv4, RFC 5952 IPv6) to \a _buffer without allocating.
+  //! Returns the number of characters written (no terminating null), 0 if null or if it does not fit.
+  std::size_t toChars(char *_buffer, std::size_t _size) const;
   uint32_t toIPv4Address(bool *_ok = nullptr) const;
-  // TODO(44444): toIPv6Address;
-
-  bool isEqual(const Address &_address, Conversion mode = Conversion::TolerantConversion);
+  //! IPv6 form in network byte order; IPv4 addresses are returned v4-mapped (0.0.0.0 as "::")
+  [[nodiscard]] IPv6Address toIPv6Address() const {
+    IPv6Address ip6;
+    std::memcpy(ip6.c, d_.a6.c, sizeof(ip6.c));
+    return ip6;
+  }
 
-  bool operator==(const Address &_address) const;
+  //! Equality up to the IPv4/IPv6 conversions of \a _mode
+  /*!
+      Addresses of the same protocol compare as operator== does. An IPv4 address equals an IPv6
+      one that \a _mode converts to it: v4-mapped, v4-compatible, "::" to 0.0.0.0 or "::1" to
+      127.0.0.1. With ConvertUnspecifiedAddress, ANY_IP also equals 0.0.0.0 and "::".
+  */
+  [[nodiscard]] bool isEqual(const Address &_address, Flags<Conversion> _mode = Conversion::TolerantConversion) const;
+  //! Bit i of \a _out, row 0 in the lowest bit of the first word: _a[i].isEqual(_b[i], _mode)
+  /*!
+      \a _b is at least as long as \a _a, and \a _out has a word per 64 pairs; bits past the last
+      pair are cleared. Each combination of conversions has its own kernel, vectorised for the
+      running CPU (see qSimdLevel()), with no branch per pair.
+  */
+  static void isEqual(std::span<const Address> _a, std::span<const Address> _b, Flags<Conversion> _mode,
+      std::span<uint64_t> _out) noexcept;
+  //! Bit i of \a _out: _address.isEqual(_others[i], _mode), as the pairwise variant
+  static void isEqual(const Address &_address, std::span<const Address> _others, Flags<Conversion> _mode,
+      std::span<uint64_t> _out) noexcept;
+  //! Converts in place every IPv6 address of \a _addresses that \a _mode turns into IPv4
+  /*!
+      A converted address becomes Address(uint32_t) of its IPv4 form, as isEqual() matches them:
+      v4-mapped, v4-compatible, "::" to 0.0.0.0 or "::1" to 127.0.0.1. Other addresses are left as
+      they are. Returns the number converted. Meant as a stage of an address stream: the kernel for
+      the running CPU tests the prefixes of four or eight addresses per step and rewrites them
+      without a branch per address.
+  */
+  static std::size_t normalize(std::span<Address> _addresses,
+      Flags<Conversion> _mode = Conversion::TolerantConversion) noexcept;
+
+  // Strict comparison: AddressData keeps unused fields zeroed, so member-wise equality
+  // is equivalent to the per-protocol comparison and needs no branches.
+  constexpr bool operator==(const Address &_address) const {
+    return d_.protocol_ == _address.d_.protocol_ && d_.addr_ == _address.d_.addr_ &&
+           ((d_.a6_64.c[0] ^ _address.d_.a6_64.c[0]) | (d_.a6_64.c[1] ^ _address.d_.a6_64.c[1])) == 0;
+  }
   bool operator==(SpecialAddress _address) const;
+  //! Total order, consistent with operator==
+  /*!
+      Addresses compare by their 128-bit IPv6 form, IPv4 ones by their v4-mapped form (0.0.0.0
+      included), then by protocol. The IPv4 space is thus the contiguous range ::ffff:0.0.0.0/96,
+      each IPv4 address just before its v4-mapped IPv6 twin; null addresses come first.
+  */
+  constexpr std::strong_ordering operator<=>(const Address &_address) const {
+    if (const auto order = orderKey() <=> _address.orderKey(); order != 0) return order;
+    return d_.protocol_ <=> _address.d_.protocol_;
+  }
 
-  inline bool operator!=(const Address &_address) const { return !operator==(_address); }
+  constexpr bool operator!=(const Address &_address) const { return !operator==(_address); }
   inline bool operator!=(SpecialAddress _address) const { return !operator==(_address); }
-  [[nodiscard]] bool isNull() const;
+  [[nodiscard]] constexpr bool isNull() const { return d_.protocol_ == LayerProtocol::UNKNOWN; }
 
+  //! Special-purpose range of the address; see AddressClassification
+  [[nodiscard]] AddressClassification classify() const { return d_.classify(); }
   [[nodiscard]] bool isLoopback() const;
   [[nodiscard]] bool isGlobal() const;
   [[nodiscard]] bool isLinkLocal() const;
@@ -81,9 +172,60 @@ public:
 
 protected:
   friend class AddressData;
-  std::shared_ptr<AddressData> d_;
+  friend class AddressIndex;
+  friend class AddressPrefix;
+
+  // The 128-bit number operator<=> orders by, before the protocol
+  [[nodiscard]] constexpr detail::Uint128 orderKey() const {
+    if (d_.protocol_ == LayerProtocol::IPv4) return {0, 0xffff00000000ULL | d_.addr_};
+    return {qFromBigEndian(d_.a6_64.c[0]), qFromBigEndian(d_.a6_64.c[1])};
+  }
+
+  AddressData d_;
 };
 
+static_assert(std::is_trivially_copyable_v<Address>, "Address must stay a plain value type");
+
+inline AddressClassification AddressData::classify(const Address &_addr) { return _addr.d_.classify(); }
+
+namespace detail {
+
+// 64x64 -> 128-bit multiply folded back to 64 bits (the wyhash "mum" mix)
+inline uint64_t foldedMultiply(uint64_t _a, uint64_t _b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  const unsigned __int128 product = static_cast<unsigned __int128>(_a) * _b;
+  return uint64_t(product) ^ uint64_t(product >> 64U);
+#else
+  const uint64_t aLo = uint32_t(_a), aHi = _a >> 32U, bLo = uint32_t(_b), bHi = _b >> 32U;
+  const uint64_t lo = aLo * bLo, mid1 = aHi * bLo, mid2 = aLo * bHi, hi = aHi * bHi;
+  const uint64_t carry = ((lo >> 32U) + uint32_t(mid1) + uint32_t(mid2)) >> 32U;
+  return (lo + (mid1 << 32U) + (mid2 << 32U)) ^ (hi + (mid1 >> 32U) + (mid2 >> 32U) + carry);
+#endif
+}
+
+}  // namespace detail
+
+//! 64-bit hash of the address; equal addresses hash equally for a given \a _seed
+/*!
+    Two multiply rounds: the first folds both halves of the 128-bit form together, the second
+    spreads the result and the protocol over all 64 bits, so any bit range of the hash is usable
+    as a bucket index or tag even for keys that differ only in their last byte.
+*/
+inline std::size_t qHash(const Address &_address, std::size_t _seed = 0) noexcept {
+  const IPv6Address ip6 = _address.toIPv6Address();
+  uint64_t words[2];
+  std::memcpy(words, ip6.c, sizeof(words));
+  const uint64_t mixed =
+      detail::foldedMultiply(words[0] ^ 0xa0761d6478bd642fULL ^ _seed, words[1] ^ 0xe7037ed1a0b428dbULL);
+  return std::size_t(detail::foldedMultiply(mixed ^ 0x8ebc6af09c88c6e3ULL,
+                                            uint64_t(_address.getProtocol()) ^ 0x589965cc75374cc3ULL));
+}
+
 }  // namespace network
 
 ENUM_FLAGS(network::Address::Conversion);
+
+template <>
+struct std::hash<network::Address> {
+  std::size_t operator()(const network::Address &_address) const noexcept { return qHash(_address); }
+};
@@ -0,0 +1,429 @@
+#include "AddressBlock.hpp"
+
+#include <sys/socket.h>
+#include <algorithm>
+#include <bit>
+#include <initializer_list>
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "Uint128.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+using detail::Uint128;
+
+// Rows classified per step by selectClassification(), a multiple of 64
+constexpr std::size_t C_CLASSIFY_ROWS = 1024;
+// Addresses converted per step by append(std::span<const mmsghdr>), one recvmmsg() batch
+constexpr std::size_t C_MESSAGE_ROWS = 64;
+// Above this many keys of a family, selectEqual() binary-searches them instead of one scan per key
+constexpr std::size_t C_SCAN_KEYS = 8;
+
+constexpr std::size_t wordCount(std::size_t _rows) { return (_rows + 63) / 64; }
+
+// The scans compare whole bitmap words of 64 rows; the word of the last rows is built here
+inline uint64_t word4(const uint32_t *_ip4, std::size_t _rows, uint32_t _mask, uint32_t _value) {
+  uint64_t word = 0;
+  for (std::size_t j = 0; j < _rows; ++j) word |= uint64_t((_ip4[j] & _mask) == _value) << j;
+  return word;
+}
+
+inline uint64_t word6(const uint64_t *_high, const uint64_t *_low, std::size_t _rows, Uint128 _mask, Uint128 _value) {
+  uint64_t word = 0;
+  for (std::size_t j = 0; j < _rows; ++j) {
+    word |= uint64_t((_high[j] & _mask.hi) == _value.hi && (_low[j] & _mask.lo) == _value.lo) << j;
+  }
+  return word;
+}
+
+inline void scan4Tail(const uint32_t *_ip4, std::size_t _count, uint32_t _mask, uint32_t _value, uint64_t *_out) {
+  if (_count % 64 != 0) _out[_count / 64] = word4(_ip4 + _count / 64 * 64, _count % 64, _mask, _value);
+}
+
+inline void scan6Tail(const uint64_t *_high, const uint64_t *_low, std::size_t _count, Uint128 _mask, Uint128 _value,
+    uint64_t *_out) {
+  const std::size_t first = _count / 64 * 64;
+  if (_count % 64 != 0) _out[_count / 64] = word6(_high + first, _low + first, _count % 64, _mask, _value);
+}
+
+#if defined(KT_COMPILER_SUPPORTS_SSE2)
+// Four rows per compare
+inline uint64_t word4x4(const uint32_t *_ip4, __m128i _mask, __m128i _value) {
+  uint64_t word = 0;
+  for (unsigned j = 0; j < 64; j += 4) {
+    const __m128i ip4  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_ip4 + j));
+    const __m128i same = _mm_cmpeq_epi32(_mm_and_si128(ip4, _mask), _value);
+    word |= uint64_t(unsigned(_mm_movemask_ps(_mm_castsi128_ps(same)))) << j;
+  }
+  return word;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+// Eight IPv4 or four IPv6 rows per compare
+KT_TARGET_AVX2 inline uint64_t word4x8(const uint32_t *_ip4, __m256i _mask, __m256i _value) {
+  uint64_t word = 0;
+  for (unsigned j = 0; j < 64; j += 8) {
+    const __m256i ip4  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_ip4 + j));
+    const __m256i same = _mm256_cmpeq_epi32(_mm256_and_si256(ip4, _mask), _value);
+    word |= uint64_t(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(same)))) << j;
+  }
+  return word;
+}
+
+KT_TARGET_AVX2 inline uint64_t word6x4(const uint64_t *_high, const uint64_t *_low, const __m256i (&_mask)[2],
+    const __m256i (&_value)[2]) {
+  uint64_t word = 0;
+  for (unsigned j = 0; j < 64; j += 4) {
+    const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_high + j));
+    const __m256i low  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_low + j));
+    const __m256i same = _mm256_and_si256(_mm256_cmpeq_epi64(_mm256_and_si256(high, _mask[0]), _value[0]),
+                                          _mm256_cmpeq_epi64(_mm256_and_si256(low, _mask[1]), _value[1]));
+    word |= uint64_t(unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(same)))) << j;
+  }
+  return word;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+// Sixteen IPv4 or eight IPv6 rows per compare, straight into mask registers
+KT_TARGET_AVX512 inline uint64_t word4x16(const uint32_t *_ip4, __m512i _mask, __m512i _value) {
+  uint64_t word = 0;
+  for (unsigned j = 0; j < 64; j += 16) {
+    const __m512i ip4 = _mm512_loadu_si512(_ip4 + j);
+    word |= uint64_t(_mm512_cmpeq_epi32_mask(_mm512_and_si512(ip4, _mask), _value)) << j;
+  }
+  return word;
+}
+
+KT_TARGET_AVX512 inline uint64_t word6x8(const uint64_t *_high, const uint64_t *_low, const __m512i (&_mask)[2],
+    const __m512i (&_value)[2]) {
+  uint64_t word = 0;
+  for (unsigned j = 0; j < 64; j += 8) {
+    const __m512i high  = _mm512_loadu_si512(_high + j);
+    const __m512i low   = _mm512_loadu_si512(_low + j);
+    const __mmask8 same = _mm512_mask_cmpeq_epi64_mask(
+        _mm512_cmpeq_epi64_mask(_mm512_and_si512(high, _mask[0]), _value[0]), _mm512_and_si512(low, _mask[1]),
+        _value[1]);
+    word |= uint64_t(same) << j;
+  }
+  return word;
+}
+#endif
+
+// Whatever the build targets
+void scan4Baseline(const uint32_t *_ip4, std::size_t _count, uint32_t _mask, uint32_t _value, uint64_t *_out) {
+#if defined(KT_COMPILER_SUPPORTS_SSE2)
+  const __m128i mask  = _mm_set1_epi32(int(_mask));
+  const __m128i value = _mm_set1_epi32(int(_value));
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word4x4(_ip4 + w * 64, mask, value);
+#else
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word4(_ip4 + w * 64, 64, _mask, _value);
+#endif
+  scan4Tail(_ip4, _count, _mask, _value, _out);
+}
+
+void scan6Baseline(const uint64_t *_high, const uint64_t *_low, std::size_t _count, Uint128 _mask, Uint128 _value,
+    uint64_t *_out) {
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word6(_high + w * 64, _low + w * 64, 64, _mask, _value);
+  scan6Tail(_high, _low, _count, _mask, _value, _out);
+}
+
+#if defined(KT_KERNELS_AVX2)
+KT_TARGET_AVX2 void scan4Avx2(const uint32_t *_ip4, std::size_t _count, uint32_t _mask, uint32_t _value,
+    uint64_t *_out) {
+  const __m256i mask  = _mm256_set1_epi32(int(_mask));
+  const __m256i value = _mm256_set1_epi32(int(_value));
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word4x8(_ip4 + w * 64, mask, value);
+  scan4Tail(_ip4, _count, _mask, _value, _out);
+}
+
+KT_TARGET_AVX2 void scan6Avx2(const uint64_t *_high, const uint64_t *_low, std::size_t _count, Uint128 _mask,
+    Uint128 _value, uint64_t *_out) {
+  const __m256i mask[2]  = {_mm256_set1_epi64x(int64_t(_mask.hi)), _mm256_set1_epi64x(int64_t(_mask.lo))};
+  const __m256i value[2] = {_mm256_set1_epi64x(int64_t(_value.hi)), _mm256_set1_epi64x(int64_t(_value.lo))};
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word6x4(_high + w * 64, _low + w * 64, mask, value);
+  scan6Tail(_high, _low, _count, _mask, _value, _out);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+KT_TARGET_AVX512 void scan4Avx512(const uint32_t *_ip4, std::size_t _count, uint32_t _mask, uint32_t _value,
+    uint64_t *_out) {
+  const __m512i mask  = _mm512_set1_epi32(int(_mask));
+  const __m512i value = _mm512_set1_epi32(int(_value));
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word4x16(_ip4 + w * 64, mask, value);
+  scan4Tail(_ip4, _count, _mask, _value, _out);
+}
+
+KT_TARGET_AVX512 void scan6Avx512(const uint64_t *_high, const uint64_t *_low, std::size_t _count, Uint128 _mask,
+    Uint128 _value, uint64_t *_out) {
+  const __m512i mask[2]  = {_mm512_set1_epi64(int64_t(_mask.hi)), _mm512_set1_epi64(int64_t(_mask.lo))};
+  const __m512i value[2] = {_mm512_set1_epi64(int64_t(_value.hi)), _mm512_set1_epi64(int64_t(_value.lo))};
+  for (std::size_t w = 0; w < _count / 64; ++w) _out[w] = word6x8(_high + w * 64, _low + w * 64, mask, value);
+  scan6Tail(_high, _low, _count, _mask, _value, _out);
+}
+#endif
+
+// _out[w] bit j: (_ip4[w * 64 + j] & _mask) == _value; bits past _count are cleared
+void scan4(const uint32_t *_ip4, std::size_t _count, uint32_t _mask, uint32_t _value, uint64_t *_out) {
+  using Kernel = void (*)(const uint32_t *, std::size_t, uint32_t, uint32_t, uint64_t *);
+#if defined(KT_RUNTIME_DISPATCH)
+  static const Kernel kernel = qResolveKernel<Kernel>(scan4Baseline, nullptr, scan4Avx2, scan4Avx512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  static const Kernel kernel = scan4Avx512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  static const Kernel kernel = scan4Avx2;
+#else
+  static const Kernel kernel = scan4Baseline;
+#endif
+  kernel(_ip4, _count, _mask, _value, _out);
+}
+
+void scan6(const uint64_t *_high, const uint64_t *_low, std::size_t _count, Uint128 _mask, Uint128 _value,
+    uint64_t *_out) {
+  using Kernel = void (*)(const uint64_t *, const uint64_t *, std::size_t, Uint128, Uint128, uint64_t *);
+#if defined(KT_RUNTIME_DISPATCH)
+  static const Kernel kernel = qResolveKernel<Kernel>(scan6Baseline, nullptr, scan6Avx2, scan6Avx512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  static const Kernel kernel = scan6Avx512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  static const Kernel kernel = scan6Avx2;
+#else
+  static const Kernel kernel = scan6Baseline;
+#endif
+  kernel(_high, _low, _count, _mask, _value, _out);
+}
+
+// Host-order halves of the IPv6 form
+Uint128 key6(const Address &_address) {
+  const IPv6Address ip6 = _address.toIPv6Address();
+  return {qFromBigEndian<uint64_t>(ip6.c), qFromBigEndian<uint64_t>(ip6.c + 8)};
+}
+
+Uint128 mask6(int _length) {
+  if (_length == 0) return {0, 0};
+  if (_length <= 64) return {~uint64_t(0) << unsigned(64 - _length), 0};
+  return {~uint64_t(0), _length == 128 ? ~uint64_t(0) : ~uint64_t(0) << unsigned(128 - _length)};
+}
+
+}  // namespace
+
+void AddressSelection::assign(std::size_t _size, bool _value) {
+  words_.assign(wordCount(_size), _value ? ~uint64_t(0) : 0);
+  size_ = _size;
+  if (_value && _size % 64 != 0) words_.back() &= (uint64_t(1) << (_size % 64)) - 1;
+}
+
+bool AddressSelection::any() const noexcept {
+  return std::any_of(words_.begin(), words_.end(), [](uint64_t _word) { return _word != 0; });
+}
+
+std::size_t AddressSelection::findFrom(std::size_t _row) const noexcept {
+  if (_row >= size_) return size_;
+  std::size_t word = _row / 64;
+  uint64_t bits    = words_[word] & (~uint64_t(0) << (_row % 64));
+  while (bits == 0) {
+    if (++word == words_.size()) return size_;
+    bits = words_[word];
+  }
+  return word * 64 + std::size_t(std::countr_zero(bits));
+}
+
+AddressSelection &AddressSelection::flip() noexcept {
+  for (uint64_t &word : words_) word = ~word;
+  if (size_ % 64 != 0) words_.back() &= (uint64_t(1) << (size_ % 64)) - 1;
+  return *this;
+}
+
+AddressSelection &AddressSelection::operator&=(const AddressSelection &_other) noexcept {
+  qFlagsAnd(words_.data(), _other.words_.data(), words_.data(), words_.size());
+  return *this;
+}
+
+AddressSelection &AddressSelection::operator|=(const AddressSelection &_other) noexcept {
+  qFlagsOr(words_.data(), _other.words_.data(), words_.data(), words_.size());
+  return *this;
+}
+
+AddressSelection &AddressSelection::operator^=(const AddressSelection &_other) noexcept {
+  qFlagsXor(words_.data(), _other.words_.data(), words_.data(), words_.size());
+  return *this;
+}
+
+AddressSelection &AddressSelection::operator-=(const AddressSelection &_other) noexcept {
+  for (std::size_t i = 0; i < words_.size(); ++i) words_[i] &= ~_other.words_[i];
+  return *this;
+}
+
+void AddressBlock::reserve(std::size_t _rows) {
+  ip4_.reserve(_rows);
+  high_.reserve(_rows);
+  low_.reserve(_rows);
+  for (AddressSelection *rows : {&ipv4_, &ipv6_, &any_}) rows->words_.reserve(wordCount(_rows));
+}
+
+void AddressBlock::push_back(const Address &_address) {
+  const Uint128 key           = key6(_address);
+  const LayerProtocol protocol = _address.getProtocol();
+  ip4_.push_back(_address.toIPv4Address());
+  high_.push_back(key.hi);
+  low_.push_back(key.lo);
+  ipv4_.push_back(protocol == LayerProtocol::IPv4);
+  ipv6_.push_back(protocol == LayerProtocol::IPv6);
+  any_.push_back(protocol == LayerProtocol::ANY_IP);
+}
+
+void AddressBlock::append(std::span<const Address> _addresses) {
+  reserve(size() + _addresses.size());
+  for (const Address &address : _addresses) push_back(address);
+}
+
+void AddressBlock::append(std::span<const ::mmsghdr> _messages) {
+  reserve(size() + _messages.size());
+  Address addresses[C_MESSAGE_ROWS];
+  for (std::size_t first = 0; first < _messages.size(); first += C_MESSAGE_ROWS) {
+    const std::size_t count = std::min(C_MESSAGE_ROWS, _messages.size() - first);
+    AddressData::fromMessages(_messages.subspan(first, count), addresses);
+    append(std::span<const Address>(addresses, count));
+  }
+}
+
+void AddressBlock::clear() noexcept {
+  ip4_.clear();
+  high_.clear();
+  low_.clear();
+  ipv4_.clear();
+  ipv6_.clear();
+  any_.clear();
+}
+
+LayerProtocol AddressBlock::getProtocol(std::size_t _row) const noexcept {
+  if (ipv4_.isset(_row)) return LayerProtocol::IPv4;
+  if (ipv6_.isset(_row)) return LayerProtocol::IPv6;
+  if (any_.isset(_row)) return LayerProtocol::ANY_IP;
+  return LayerProtocol::UNKNOWN;
+}
+
+Address AddressBlock::operator[](std::size_t _row) const {
+  switch (getProtocol(_row)) {
+    case LayerProtocol::IPv4: return Address(ip4_[_row]);
+    case LayerProtocol::IPv6: {
+      IPv6Address ip6;
+      qToBigEndian(high_[_row], ip6.c);
+      qToBigEndian(low_[_row], ip6.c + 8);
+      return Address(ip6);
+    }
+    case LayerProtocol::ANY_IP: return Address(Address::SpecialAddress::ANY);
+    default: return {};
+  }
+}
+
+const AddressSelection &AddressBlock::protocolRows(LayerProtocol _protocol) const noexcept {
+  static const AddressSelection C_EMPTY;
+  switch (_protocol) {
+    case LayerProtocol::IPv4: return ipv4_;
+    case LayerProtocol::IPv6: return ipv6_;
+    case LayerProtocol::ANY_IP: return any_;
+    default: return C_EMPTY;
+  }
+}
+
+void AddressBlock::selectProtocol(LayerProtocol _protocol, AddressSelection &_out) const {
+  if (_protocol != LayerProtocol::UNKNOWN) {
+    _out = protocolRows(_protocol);
+    return;
+  }
+  _out = ipv4_;
+  _out |= ipv6_;
+  _out |= any_;
+  _out.flip();
+}
+
+bool AddressBlock::selectPrefix(const Address &_address, Netmask _netmask, AddressSelection &_out) const {
+  _out.assign(size());
+  const int length = _netmask.getPrefixLength();
+  if (length < 0) return false;
+  if (_address.getProtocol() == LayerProtocol::IPv4 && length <= 32) {
+    const uint32_t mask = length == 0 ? 0U : ~0U << unsigned(32 - length);
+    scan4(ip4_.data(), size(), mask, _address.toIPv4Address() & mask, _out.words_.data());
+    _out &= ipv4_;
+    return true;
+  }
+  if (_address.getProtocol() == LayerProtocol::IPv6 && length <= 128) {
+    const Uint128 mask = mask6(length);
+    scan6(high_.data(), low_.data(), size(), mask, key6(_address) & mask, _out.words_.data());
+    _out &= ipv6_;
+    return true;
+  }
+  return false;
+}
+
+void AddressBlock::selectClassification(AddressClassificationSet _classes, AddressSelection &_out) const {
+  _out.assign(size());
+  const uint64_t classes = _classes.words()[0];
+  AddressClassification results[C_CLASSIFY_ROWS];
+  for (std::size_t first = 0; first < size(); first += C_CLASSIFY_ROWS) {
+    const std::size_t count = std::min(C_CLASSIFY_ROWS, size() - first);
+    classifyRows(first, count, results);
+    uint64_t *words = _out.words_.data() + first / 64;
+    for (std::size_t j = 0; j < count; j += 64) {
+      uint64_t word = 0;
+      for (std::size_t k = 0; k < 64 && j + k < count; ++k) word |= ((classes >> unsigned(results[j + k])) & 1U) << k;
+      words[j / 64] = word;
+    }
+  }
+}
+
+void AddressBlock::selectEqual(std::span<const Address> _addresses, AddressSelection &_out) const {
+  std::vector<uint32_t> keys4;
+  std::vector<Uint128> keys6;
+  bool any   = false;
+  bool unset = false;
+  for (const Address &address : _addresses) {
+    switch (address.getProtocol()) {
+      case LayerProtocol::IPv4: keys4.push_back(address.toIPv4Address()); break;
+      case LayerProtocol::IPv6: keys6.push_back(key6(address)); break;
+      case LayerProtocol::ANY_IP: any = true; break;
+      default: unset = true; break;
+    }
+  }
+  std::sort(keys4.begin(), keys4.end());
+  keys4.erase(std::unique(keys4.begin(), keys4.end()), keys4.end());
+  std::sort(keys6.begin(), keys6.end());
+  keys6.erase(std::unique(keys6.begin(), keys6.end()), keys6.end());
+
+  _out.assign(size());
+  if (unset) selectProtocol(LayerProtocol::UNKNOWN, _out);
+  if (any) _out |= any_;
+
+  // Few keys: one vector scan per key; many: a binary search per row of the family
+  AddressSelection matches(size());
+  if (!keys4.empty() && keys4.size() <= C_SCAN_KEYS) {
+    for (const uint32_t key : keys4) {
+      scan4(ip4_.data(), size(), ~0U, key, matches.words_.data());
+      matches &= ipv4_;
+      _out |= matches;
+    }
+  } else if (!keys4.empty()) {
+    for (const std::size_t row : ipv4_) {
+      if (std::binary_search(keys4.begin(), keys4.end(), ip4_[row])) _out.set(row);
+    }
+  }
+  if (!keys6.empty() && keys6.size() <= C_SCAN_KEYS) {
+    for (const Uint128 &key : keys6) {
+      scan6(high_.data(), low_.data(), size(), {~uint64_t(0), ~uint64_t(0)}, key, matches.words_.data());
+      matches &= ipv6_;
+      _out |= matches;
+    }
+  } else if (!keys6.empty()) {
+    for (const std::size_t row : ipv6_) {
+      if (std::binary_search(keys6.begin(), keys6.end(), Uint128 {high_[row], low_[row]})) _out.set(row);
+    }
+  }
+}
+
+}  // namespace network
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "BitFlags.hpp"
+
+namespace network {
+
+//! Set of AddressClassification values, for AddressBlock::selectClassification()
+using AddressClassificationSet = BitFlags<32, AddressClassification>;
+
+//! One bit per row of an AddressBlock, as filled by its scans
+/*!
+    Selections of the same block combine with the bitwise operators, e.g. "in 10.0.0.0/8 and
+    not multicast" is a prefix selection minus a classification selection. Bits past size() are
+    always zero.
+*/
+class AddressSelection {
+public:
+  AddressSelection() = default;
+  explicit AddressSelection(std::size_t _size, bool _value = false) { assign(_size, _value); }
+
+  //! Resize to \a _size rows, all set to \a _value
+  void assign(std::size_t _size, bool _value = false);
+  void push_back(bool _value) {
+    if (size_ % 64 == 0) words_.push_back(0);
+    words_.back() |= uint64_t(_value) << (size_ % 64);
+    ++size_;
+  }
+  void clear() noexcept {
+    words_.clear();
+    size_ = 0;
+  }
+
+  //! Number of rows, selected or not
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool isset(std::size_t _row) const noexcept { return ((words_[_row / 64] >> (_row % 64)) & 1U) != 0; }
+  void set(std::size_t _row, bool _value = true) noexcept {
+    const uint64_t bit = uint64_t(1) << (_row % 64);
+    words_[_row / 64]  = _value ? words_[_row / 64] | bit : words_[_row / 64] & ~bit;
+  }
+  //! Number of rows selected
+  [[nodiscard]] std::size_t count() const noexcept { return qFlagsCount(words_.data(), words_.size()); }
+  [[nodiscard]] bool any() const noexcept;
+  [[nodiscard]] bool none() const noexcept { return !any(); }
+  //! First selected row from \a _row on, or size()
+  [[nodiscard]] std::size_t findFrom(std::size_t _row) const noexcept;
+
+  //! Iterates over the selected rows, lowest first
+  class iterator {
+  public:
+    using value_type        = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    iterator() = default;
+    iterator(const AddressSelection *_selection, std::size_t _row) : selection_(_selection), row_(_row) {}
+    std::size_t operator*() const noexcept { return row_; }
+    iterator &operator++() noexcept {
+      row_ = selection_->findFrom(row_ + 1);
+      return *this;
+    }
+    iterator operator++(int) noexcept {
+      iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    friend bool operator==(const iterator &_a, const iterator &_b) noexcept { return _a.row_ == _b.row_; }
+
+  private:
+    const AddressSelection *selection_ {nullptr};
+    std::size_t row_ {0};
+  };
+  [[nodiscard]] iterator begin() const noexcept { return iterator(this, findFrom(0)); }
+  [[nodiscard]] iterator end() const noexcept { return iterator(this, size_); }
+
+  //! Select the rows that are not selected
+  AddressSelection &flip() noexcept;
+  //! The operators expect selections of the same size
+  AddressSelection &operator&=(const AddressSelection &_other) noexcept;
+  AddressSelection &operator|=(const AddressSelection &_other) noexcept;
+  AddressSelection &operator^=(const AddressSelection &_other) noexcept;
+  //! Rows selected here and not in \a _other
+  AddressSelection &operator-=(const AddressSelection &_other) noexcept;
+  friend AddressSelection operator&(AddressSelection _a, const AddressSelection &_b) { return _a &= _b; }
+  friend AddressSelection operator|(AddressSelection _a, const AddressSelection &_b) { return _a |= _b; }
+  friend AddressSelection operator^(AddressSelection _a, const AddressSelection &_b) { return _a ^= _b; }
+  friend AddressSelection operator-(AddressSelection _a, const AddressSelection &_b) { return _a -= _b; }
+  AddressSelection operator~() const {
+    AddressSelection out = *this;
+    return out.flip();
+  }
+  friend bool operator==(const AddressSelection &, const AddressSelection &) = default;
+
+  //! Bitmap words, row 0 in the lowest bit of the first one
+  [[nodiscard]] std::span<const uint64_t> words() const noexcept { return words_; }
+
+private:
+  friend class AddressBlock;
+
+  std::vector<uint64_t> words_;
+  std::size_t size_ {0};
+};
+
+//! Column-oriented container of addresses for analytical scans
+/*!
+    Stores each address as a row of parallel columns instead of a 24-byte Address:
+    - the host-order IPv4 address, as Address::toIPv4Address() returns it
+    - the upper and lower halves of the IPv6 form, host order, as Address::toIPv6Address()
+      returns it (v4-mapped for IPv4 rows)
+    - one bitmap per protocol: IPv4, IPv6 and ANY_IP. Rows in none of them are unset addresses.
+
+    Scans read only the columns they need, e.g. 4 bytes per row for an IPv4 prefix, and are
+    vectorised for the running CPU like the other bulk kernels (see qSimdLevel()). They fill an
+    AddressSelection with one bit per row; passing the same selection again reuses its storage.
+
+    \code{.cpp}
+    AddressSelection rows, multicast;
+    block.selectPrefix(Address("10.0.0.0"), netmask8, rows);
+    block.selectClassification({AddressClassification::MULTICAST}, multicast);
+    rows -= multicast;
+    for (const Address address : block.rows(rows)) { ... }
+    \endcode
+
+    Rows are read back as Address values built from the columns, a few register moves with no
+    allocation. Equality is strict, as Address::operator==: an IPv4 row never equals an IPv6 one.
+*/
+class AddressBlock {
+public:
+  AddressBlock() = default;
+  explicit AddressBlock(std::span<const Address> _addresses) { append(_addresses); }
+
+  void reserve(std::size_t _rows);
+  void push_back(const Address &_address);
+  void append(std::span<const Address> _addresses);
+  //! Append the source addresses of datagrams received with recvmmsg(), see AddressData::fromMessages()
+  void append(std::span<const ::mmsghdr> _messages);
+  void clear() noexcept;
+
+  [[nodiscard]] std::size_t size() const noexcept { return ip4_.size(); }
+  [[nodiscard]] bool empty() const noexcept { return ip4_.empty(); }
+  [[nodiscard]] LayerProtocol getProtocol(std::size_t _row) const noexcept;
+  //! Address of a row
+  [[nodiscard]] Address operator[](std::size_t _row) const;
+
+  //! Random-access iterator over the rows, yielding Address values
+  class const_iterator {
+  public:
+    using value_type        = Address;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = Address;
+    using iterator_category = std::random_access_iterator_tag;
+
+    const_iterator() = default;
+    const_iterator(const AddressBlock *_block, std::size_t _row) : block_(_block), row_(_row) {}
+    Address operator*() const { return (*block_)[row_]; }
+    Address operator[](difference_type _offset) const { return *(*this + _offset); }
+    const_iterator &operator++() noexcept {
+      ++row_;
+      return *this;
+    }
+    const_iterator operator++(int) noexcept { return {block_, row_++}; }
+    const_iterator &operator--() noexcept {
+      --row_;
+      return *this;
+    }
+    const_iterator operator--(int) noexcept { return {block_, row_--}; }
+    const_iterator &operator+=(difference_type _offset) noexcept {
+      row_ = std::size_t(difference_type(row_) + _offset);
+      return *this;
+    }
+    const_iterator &operator-=(difference_type _offset) noexcept { return *this += -_offset; }
+    friend const_iterator operator+(const_iterator _it, difference_type _offset) noexcept { return _it += _offset; }
+    friend const_iterator operator+(difference_type _offset, const_iterator _it) noexcept { return _it += _offset; }
+    friend const_iterator operator-(const_iterator _it, difference_type _offset) noexcept { return _it -= _offset; }
+    friend difference_type operator-(const const_iterator &_a, const const_iterator &_b) noexcept {
+      return difference_type(_a.row_) - difference_type(_b.row_);
+    }
+    friend bool operator==(const const_iterator &_a, const const_iterator &_b) noexcept { return _a.row_ == _b.row_; }
+    friend auto operator<=>(const const_iterator &_a, const const_iterator &_b) noexcept { return _a.row_ <=> _b.row_; }
+
+  private:
+    const AddressBlock *block_ {nullptr};
+    std::size_t row_ {0};
+  };
+  [[nodiscard]] const_iterator begin() const noexcept { return {this, 0}; }
+  [[nodiscard]] const_iterator end() const noexcept { return {this, size()}; }
+
+  //! Selected rows of a block, yielding Address values
+  class Rows {
+  public:
+    class iterator {
+    public:
+      using value_type        = Address;
+      using difference_type   = std::ptrdiff_t;
+      using iterator_category = std::forward_iterator_tag;
+
+      iterator() = default;
+      iterator(const AddressBlock *_block, AddressSelection::iterator _row) : block_(_block), row_(_row) {}
+      Address operator*() const { return (*block_)[*row_]; }
+      //! Row of the current address
+      [[nodiscard]] std::size_t row() const noexcept { return *row_; }
+      iterator &operator++() noexcept {
+        ++row_;
+        return *this;
+      }
+      iterator operator++(int) noexcept {
+        iterator previous = *this;
+        ++row_;
+        return previous;
+      }
+      friend bool operator==(const iterator &_a, const iterator &_b) noexcept { return _a.row_ == _b.row_; }
+
+    private:
+      const AddressBlock *block_ {nullptr};
+      AddressSelection::iterator row_;
+    };
+
+    Rows(const AddressBlock *_block, const AddressSelection *_selection) : block_(_block), selection_(_selection) {}
+    [[nodiscard]] iterator begin() const { return {block_, selection_->begin()}; }
+    [[nodiscard]] iterator end() const { return {block_, selection_->end()}; }
+
+  private:
+    const AddressBlock *block_;
+    const AddressSelection *selection_;
+  };
+  //! The rows of \a _selection, which must outlive the returned range
+  [[nodiscard]] Rows rows(const AddressSelection &_selection) const { return {this, &_selection}; }
+
+  //! \name Columns
+  //! One entry per row, for scans not provided here
+  //! @{
+  [[nodiscard]] std::span<const uint32_t> ip4Column() const noexcept { return ip4_; }
+  [[nodiscard]] std::span<const uint64_t> highColumn() const noexcept { return high_; }
+  [[nodiscard]] std::span<const uint64_t> lowColumn() const noexcept { return low_; }
+  //! Rows of a protocol; empty for UNKNOWN, use selectProtocol()
+  [[nodiscard]] const AddressSelection &protocolRows(LayerProtocol _protocol) const noexcept;
+  //! @}
+
+  //! \name Scans
+  //! Each one resizes \a _out to size() and selects the matching rows
+  //! @{
+  void selectProtocol(LayerProtocol _protocol, AddressSelection &_out) const;
+  //! Rows in a prefix of the same protocol as \a _address. Returns false, selecting nothing, if
+  //! the netmask does not fit the protocol.
+  bool selectPrefix(const Address &_address, Netmask _netmask, AddressSelection &_out) const;
+  //! Rows whose classify() is in \a _classes
+  void selectClassification(AddressClassificationSet _classes, AddressSelection &_out) const;
+  //! Rows equal to any of \a _addresses
+  void selectEqual(std::span<const Address> _addresses, AddressSelection &_out) const;
+  //! @}
+
+  //! Classify every row into \a _results, which must be at least size() long
+  /*!
+      Same result as Address::classify() for every row; the vector kernels of
+      AddressData::classify() read the columns directly, without gathers or byte swaps.
+  */
+  void classify(std::span<AddressClassification> _results) const { classifyRows(0, size(), _results.data()); }
+
+private:
+  // Defined in AddressClassification.cpp, next to the rules; _first is a multiple of 64
+  void classifyRows(std::size_t _first, std::size_t _count, AddressClassification *_results) const;
+
+  std::vector<uint32_t> ip4_;
+  std::vector<uint64_t> high_;
+  std::vector<uint64_t> low_;
+  AddressSelection ipv4_;
+  AddressSelection ipv6_;
+  AddressSelection any_;
+};
+
+}  // namespace network
@@ -0,0 +1,528 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include "Address.hpp"
+#include "AddressBlock.hpp"
+#include "AddressData.hpp"
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+using Class = AddressClassification;
+
+struct Rule4 {
+  uint32_t mask;
+  uint32_t value;
+  Class classification;
+  int length;
+};
+
+struct Rule6 {
+  uint64_t mask;  // over the upper 64 bits: 64:ff9b::/96, the one longer range, is as GLOBAL as its /64
+  uint64_t value;
+  Class classification;
+  int length;
+};
+
+constexpr Rule4 rule4(uint32_t _prefix, int _length, Class _classification) {
+  return {_length == 0 ? 0U : ~0U << unsigned(32 - _length), _prefix, _classification, _length};
+}
+
+constexpr Rule6 rule6(uint64_t _prefix, int _length, Class _classification) {
+  return {_length == 0 ? 0ULL : ~0ULL << unsigned(64 - _length), _prefix, _classification, _length};
+}
+
+// Special-purpose ranges, shortest prefix first: every matching rule overrides the previous
+// ones, so the most specific range wins. Anything else is GLOBAL; the GLOBAL rows are registry
+// entries that are globally reachable, listed so the tables cover RFC 6890 and its updates.
+constexpr Rule4 C_RULES4[] = {
+    rule4(0xe0000000U, 4, Class::MULTICAST),         // 224.0.0.0/4
+    rule4(0xf0000000U, 4, Class::UNKNOWN),           // 240.0.0.0/4 reserved
+    rule4(0x00000000U, 8, Class::LOCAL_NET),         // 0.0.0.0/8 "this network"
+    rule4(0x0a000000U, 8, Class::PRIVATE_NETWORK),   // 10.0.0.0/8
+    rule4(0x7f000000U, 8, Class::LOOP_BACK),         // 127.0.0.0/8
+    rule4(0x64400000U, 10, Class::PRIVATE_NETWORK),  // 100.64.0.0/10 shared address space
+    rule4(0xac100000U, 12, Class::PRIVATE_NETWORK),  // 172.16.0.0/12
+    rule4(0xc6120000U, 15, Class::TEST_NETWORK),     // 198.18.0.0/15 benchmarking
+    rule4(0xa9fe0000U, 16, Class::LINK_LOCAL),       // 169.254.0.0/16
+    rule4(0xc0a80000U, 16, Class::PRIVATE_NETWORK),  // 192.168.0.0/16
+    rule4(0xc0000000U, 24, Class::UNKNOWN),          // 192.0.0.0/24 protocol assignments
+    rule4(0xc0586300U, 24, Class::GLOBAL),           // 192.88.99.0/24 6to4 relay anycast, deprecated
+    rule4(0xc0000200U, 24, Class::TEST_NETWORK),     // 192.0.2.0/24 TEST-NET-1
+    rule4(0xc6336400U, 24, Class::TEST_NETWORK),     // 198.51.100.0/24 TEST-NET-2
+    rule4(0xcb007100U, 24, Class::TEST_NETWORK),     // 203.0.113.0/24 TEST-NET-3
+    rule4(0xffffffffU, 32, Class::BROADCAST),        // 255.255.255.255
+};
+
+// ::, ::1 and ::ffff:0:0/96 are handled separately: their upper 64 bits are all zero
+constexpr Rule6 C_RULES6[] = {
+    rule6(0xfc00000000000000ULL, 7, Class::UNIQUE_LOCAL),      // fc00::/7
+    rule6(0xff00000000000000ULL, 8, Class::MULTICAST),         // ff00::/8
+    rule6(0xfe00000000000000ULL, 9, Class::UNKNOWN),           // fe00::/9 reserved
+    rule6(0xfe80000000000000ULL, 10, Class::LINK_LOCAL),       // fe80::/10
+    rule6(0xfec0000000000000ULL, 10, Class::SITE_LOCAL),       // fec0::/10
+    rule6(0x2002000000000000ULL, 16, Class::GLOBAL),           // 2002::/16 6to4
+    rule6(0x2001000000000000ULL, 23, Class::UNKNOWN),          // 2001::/23 IETF protocol assignments
+    rule6(0x2001001000000000ULL, 28, Class::UNKNOWN),          // 2001:10::/28 ORCHID, deprecated
+    rule6(0x2001002000000000ULL, 28, Class::GLOBAL),           // 2001:20::/28 ORCHIDv2
+    rule6(0x2001000300000000ULL, 32, Class::GLOBAL),           // 2001:3::/32 AMT
+    rule6(0x20010db800000000ULL, 32, Class::TEST_NETWORK),     // 2001:db8::/32 documentation
+    rule6(0x2001000200000000ULL, 48, Class::TEST_NETWORK),     // 2001:2::/48 benchmarking
+    rule6(0x2001000401120000ULL, 48, Class::GLOBAL),           // 2001:4:112::/48 AS112-v6
+    rule6(0x0064ff9b00010000ULL, 48, Class::PRIVATE_NETWORK),  // 64:ff9b:1::/48 local-use NAT64
+    rule6(0x0064ff9b00000000ULL, 64, Class::GLOBAL),           // 64:ff9b::/96 NAT64 well-known prefix
+    rule6(0x0100000000000000ULL, 64, Class::UNKNOWN),          // 100::/64 discard-only
+};
+
+static_assert(std::is_sorted(std::begin(C_RULES4), std::end(C_RULES4),
+                             [](const Rule4 &_a, const Rule4 &_b) { return _a.length < _b.length; }));
+static_assert(std::is_sorted(std::begin(C_RULES6), std::end(C_RULES6),
+                             [](const Rule6 &_a, const Rule6 &_b) { return _a.length < _b.length; }));
+static_assert(sizeof(Class) == sizeof(uint32_t) && sizeof(Address) == 24, "kernels store and gather 32-bit lanes");
+
+inline Class classify4(uint32_t _ip4) {
+  Class result = Class::GLOBAL;
+  for (const Rule4 &rule : C_RULES4) result = (_ip4 & rule.mask) == rule.value ? rule.classification : result;
+  return result;
+}
+
+// Host-order halves of the IPv6 form
+inline Class classify6(uint64_t _high, uint64_t _low) {
+  if (_high == 0) {
+    if ((_low >> 32U) == 0xffffU) return classify4(uint32_t(_low));
+    if (_low == 0) return Class::LOCAL_NET;
+    if (_low == 1) return Class::LOOP_BACK;
+  }
+  Class result = Class::GLOBAL;
+  for (const Rule6 &rule : C_RULES6) result = (_high & rule.mask) == rule.value ? rule.classification : result;
+  return result;
+}
+
+// Layout the vector kernels load from, checked in AddressData::classify(): Address is 24 bytes,
+// the IPv6 form at byte 0, the host-order IPv4 address at 16 and the protocol at 20
+constexpr std::size_t C_IP4_OFFSET      = 16;
+constexpr std::size_t C_PROTOCOL_OFFSET = 20;
+
+inline uint32_t ip4At(const Address &_address) {
+  uint32_t ip4;
+  std::memcpy(&ip4, reinterpret_cast<const char *>(&_address) + C_IP4_OFFSET, sizeof(ip4));
+  return ip4;
+}
+
+// The vector kernels see an unset address as the all-zero form of "::"
+inline void fixUnknown(const Address *_addresses, std::size_t _count, Class *_results) {
+  for (std::size_t k = 0; k < _count; ++k) {
+    if (_addresses[k].getProtocol() == LayerProtocol::UNKNOWN) _results[k] = Class::UNKNOWN;
+  }
+}
+
+void classifyScalar(const Address *_addresses, std::size_t _count, Class *_results) {
+  for (std::size_t i = 0; i < _count; ++i) _results[i] = _addresses[i].classify();
+}
+
+#if defined(KT_KERNELS_SSE4_2)
+// Four IPv4 addresses, host order, one per 32-bit lane
+KT_TARGET_SSE4_2 inline __m128i classify4x4(__m128i _ip4) {
+  __m128i result = _mm_set1_epi32(int(Class::GLOBAL));
+  for (const Rule4 &rule : C_RULES4) {
+    const __m128i match =
+        _mm_cmpeq_epi32(_mm_and_si128(_ip4, _mm_set1_epi32(int(rule.mask))), _mm_set1_epi32(int(rule.value)));
+    result = _mm_blendv_epi8(result, _mm_set1_epi32(int(rule.classification)), match);
+  }
+  return result;
+}
+
+// Two addresses of any protocol, host-order halves of the IPv6 form in 64-bit lanes
+KT_TARGET_SSE4_2 inline __m128i classify6x2(__m128i _high, __m128i _low) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i result     = _mm_set1_epi64x(int64_t(Class::GLOBAL));
+  for (const Rule6 &rule : C_RULES6) {
+    const __m128i match = _mm_cmpeq_epi64(_mm_and_si128(_high, _mm_set1_epi64x(int64_t(rule.mask))),
+                                          _mm_set1_epi64x(int64_t(rule.value)));
+    result = _mm_blendv_epi8(result, _mm_set1_epi64x(int64_t(rule.classification)), match);
+  }
+
+  const __m128i highZero = _mm_cmpeq_epi64(_high, zero);
+  const __m128i mapped = _mm_and_si128(highZero, _mm_cmpeq_epi64(_mm_srli_epi64(_low, 32), _mm_set1_epi64x(0xffff)));
+  if (!_mm_testz_si128(mapped, mapped)) {
+    // The IPv4 rules on the low 32 bits; the masks clear the ::ffff part
+    __m128i result4 = _mm_set1_epi64x(int64_t(Class::GLOBAL));
+    for (const Rule4 &rule : C_RULES4) {
+      const __m128i match = _mm_cmpeq_epi64(_mm_and_si128(_low, _mm_set1_epi64x(int64_t(rule.mask))),
+                                            _mm_set1_epi64x(int64_t(rule.value)));
+      result4 = _mm_blendv_epi8(result4, _mm_set1_epi64x(int64_t(rule.classification)), match);
+    }
+    result = _mm_blendv_epi8(result, result4, mapped);
+  }
+  const __m128i any      = _mm_and_si128(highZero, _mm_cmpeq_epi64(_low, zero));
+  const __m128i loopback = _mm_and_si128(highZero, _mm_cmpeq_epi64(_low, _mm_set1_epi64x(1)));
+  result                 = _mm_blendv_epi8(result, _mm_set1_epi64x(int64_t(Class::LOCAL_NET)), any);
+  return _mm_blendv_epi8(result, _mm_set1_epi64x(int64_t(Class::LOOP_BACK)), loopback);
+}
+
+// No gathers: the four IPv4 words are inserted one by one, IPv6 forms loaded two at a time
+KT_TARGET_SSE4_2 void classifySse42(const Address *_addresses, std::size_t _count, Class *_results) {
+  const __m128i swap64 = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  auto *out            = reinterpret_cast<int *>(_results);
+  std::size_t i        = 0;
+
+  for (; i + 4 <= _count; i += 4) {
+    const Address *block = _addresses + i;
+    if (block[0].getProtocol() == LayerProtocol::IPv4 && block[1].getProtocol() == LayerProtocol::IPv4 &&
+        block[2].getProtocol() == LayerProtocol::IPv4 && block[3].getProtocol() == LayerProtocol::IPv4) {
+      const __m128i ip4 = _mm_setr_epi32(
+          int(ip4At(block[0])), int(ip4At(block[1])), int(ip4At(block[2])), int(ip4At(block[3])));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), classify4x4(ip4));
+      continue;
+    }
+    for (std::size_t half = 0; half < 4; half += 2) {
+      const auto *first  = reinterpret_cast<const __m128i *>(block + half);
+      const auto *second = reinterpret_cast<const __m128i *>(block + half + 1);
+      const __m128i a    = _mm_shuffle_epi8(_mm_loadu_si128(first), swap64);
+      const __m128i b    = _mm_shuffle_epi8(_mm_loadu_si128(second), swap64);
+      const __m128i two  = classify6x2(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i + half), _mm_shuffle_epi32(two, 0x08));
+    }
+    fixUnknown(block, 4, _results + i);
+  }
+  classifyScalar(_addresses + i, _count - i, _results + i);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+// Eight IPv4 addresses, host order, one per 32-bit lane
+KT_TARGET_AVX2 inline __m256i classify4x8(__m256i _ip4) {
+  __m256i result = _mm256_set1_epi32(int(Class::GLOBAL));
+  for (const Rule4 &rule : C_RULES4) {
+    const __m256i match = _mm256_cmpeq_epi32(_mm256_and_si256(_ip4, _mm256_set1_epi32(int(rule.mask))),
+                                             _mm256_set1_epi32(int(rule.value)));
+    result = _mm256_blendv_epi8(result, _mm256_set1_epi32(int(rule.classification)), match);
+  }
+  return result;
+}
+
+// Four addresses of any protocol, host-order halves of the IPv6 form in 64-bit lanes
+KT_TARGET_AVX2 inline __m256i classify6x4(__m256i _high, __m256i _low) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i result     = _mm256_set1_epi64x(int64_t(Class::GLOBAL));
+  for (const Rule6 &rule : C_RULES6) {
+    const __m256i match = _mm256_cmpeq_epi64(_mm256_and_si256(_high, _mm256_set1_epi64x(int64_t(rule.mask))),
+                                             _mm256_set1_epi64x(int64_t(rule.value)));
+    result = _mm256_blendv_epi8(result, _mm256_set1_epi64x(int64_t(rule.classification)), match);
+  }
+
+  const __m256i highZero = _mm256_cmpeq_epi64(_high, zero);
+  const __m256i mapped =
+      _mm256_and_si256(highZero, _mm256_cmpeq_epi64(_mm256_srli_epi64(_low, 32), _mm256_set1_epi64x(0xffff)));
+  if (!_mm256_testz_si256(mapped, mapped)) {
+    // The IPv4 rules on the low 32 bits; the masks clear the ::ffff part
+    __m256i result4 = _mm256_set1_epi64x(int64_t(Class::GLOBAL));
+    for (const Rule4 &rule : C_RULES4) {
+      const __m256i match = _mm256_cmpeq_epi64(_mm256_and_si256(_low, _mm256_set1_epi64x(int64_t(rule.mask))),
+                                               _mm256_set1_epi64x(int64_t(rule.value)));
+      result4 = _mm256_blendv_epi8(result4, _mm256_set1_epi64x(int64_t(rule.classification)), match);
+    }
+    result = _mm256_blendv_epi8(result, result4, mapped);
+  }
+  const __m256i any      = _mm256_and_si256(highZero, _mm256_cmpeq_epi64(_low, zero));
+  const __m256i loopback = _mm256_and_si256(highZero, _mm256_cmpeq_epi64(_low, _mm256_set1_epi64x(1)));
+  result = _mm256_blendv_epi8(result, _mm256_set1_epi64x(int64_t(Class::LOCAL_NET)), any);
+  return _mm256_blendv_epi8(result, _mm256_set1_epi64x(int64_t(Class::LOOP_BACK)), loopback);
+}
+
+KT_TARGET_AVX2 void classifyAvx2(const Address *_addresses, std::size_t _count, Class *_results) {
+  // Gather indexes in 32- and 64-bit units of the 24-byte Address
+  const __m256i index32 = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+  const __m256i index64 = _mm256_setr_epi64x(0, 3, 6, 9);
+  const __m256i swap64 =
+      _mm256_broadcastsi128_si256(_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+  const __m256i pack     = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  const __m256i byteMask = _mm256_set1_epi32(0xff);
+  const __m256i ipv4     = _mm256_set1_epi32(int(uint8_t(LayerProtocol::IPv4)));
+  auto *out              = reinterpret_cast<int *>(_results);
+  std::size_t i          = 0;
+
+  for (; i + 8 <= _count; i += 8) {
+    const auto *base     = reinterpret_cast<const char *>(_addresses + i);
+    const auto *ip4      = reinterpret_cast<const int *>(base + C_IP4_OFFSET);
+    const auto *protocol = reinterpret_cast<const int *>(base + C_PROTOCOL_OFFSET);
+    const __m256i tags   = _mm256_and_si256(_mm256_i32gather_epi32(protocol, index32, 4), byteMask);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(tags, ipv4)) == -1) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                          classify4x8(_mm256_i32gather_epi32(ip4, index32, 4)));
+      continue;
+    }
+    for (std::size_t half = 0; half < 8; half += 4) {
+      const auto *words  = reinterpret_cast<const long long *>(_addresses + i + half);
+      const __m256i high = _mm256_shuffle_epi8(_mm256_i64gather_epi64(words, index64, 8), swap64);
+      const __m256i low  = _mm256_shuffle_epi8(_mm256_i64gather_epi64(words + 1, index64, 8), swap64);
+      const __m256i four = _mm256_permutevar8x32_epi32(classify6x4(high, low), pack);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + half), _mm256_castsi256_si128(four));
+    }
+    fixUnknown(_addresses + i, 8, _results + i);
+  }
+  classifyScalar(_addresses + i, _count - i, _results + i);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+// Sixteen IPv4 addresses, host order, one per 32-bit lane
+KT_TARGET_AVX512 inline __m512i classify4x16(__m512i _ip4) {
+  __m512i result = _mm512_set1_epi32(int(Class::GLOBAL));
+  for (const Rule4 &rule : C_RULES4) {
+    const __mmask16 match = _mm512_cmpeq_epi32_mask(_mm512_and_si512(_ip4, _mm512_set1_epi32(int(rule.mask))),
+                                                    _mm512_set1_epi32(int(rule.value)));
+    result = _mm512_mask_mov_epi32(result, match, _mm512_set1_epi32(int(rule.classification)));
+  }
+  return result;
+}
+
+// Eight addresses of any protocol, host-order halves of the IPv6 form in 64-bit lanes
+KT_TARGET_AVX512 inline __m512i classify6x8(__m512i _high, __m512i _low) {
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i result     = _mm512_set1_epi64(int64_t(Class::GLOBAL));
+  for (const Rule6 &rule : C_RULES6) {
+    const __mmask8 match = _mm512_cmpeq_epi64_mask(_mm512_and_si512(_high, _mm512_set1_epi64(int64_t(rule.mask))),
+                                                   _mm512_set1_epi64(int64_t(rule.value)));
+    result = _mm512_mask_mov_epi64(result, match, _mm512_set1_epi64(int64_t(rule.classification)));
+  }
+
+  const __mmask8 highZero = _mm512_cmpeq_epi64_mask(_high, zero);
+  const __mmask8 mapped =
+      _mm512_mask_cmpeq_epi64_mask(highZero, _mm512_srli_epi64(_low, 32), _mm512_set1_epi64(0xffff));
+  if (mapped) {
+    // The IPv4 rules on the low 32 bits of the mapped lanes only; no IPv6 rule matched there
+    for (const Rule4 &rule : C_RULES4) {
+      const __m512i masked = _mm512_and_si512(_low, _mm512_set1_epi64(int64_t(rule.mask)));
+      const __mmask8 match = _mm512_mask_cmpeq_epi64_mask(mapped, masked, _mm512_set1_epi64(int64_t(rule.value)));
+      result = _mm512_mask_mov_epi64(result, match, _mm512_set1_epi64(int64_t(rule.classification)));
+    }
+  }
+  result = _mm512_mask_mov_epi64(result, _mm512_mask_cmpeq_epi64_mask(highZero, _low, zero),
+                                 _mm512_set1_epi64(int64_t(Class::LOCAL_NET)));
+  return _mm512_mask_mov_epi64(result, _mm512_mask_cmpeq_epi64_mask(highZero, _low, _mm512_set1_epi64(1)),
+                               _mm512_set1_epi64(int64_t(Class::LOOP_BACK)));
+}
+
+KT_TARGET_AVX512 void classifyAvx512(const Address *_addresses, std::size_t _count, Class *_results) {
+  const __m512i index32 = _mm512_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42, 48, 54, 60, 66, 72, 78, 84, 90);
+  const __m512i index64 = _mm512_setr_epi64(0, 3, 6, 9, 12, 15, 18, 21);
+  const __m512i swap64  = _mm512_broadcast_i32x4(_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+  const __m512i byteMask = _mm512_set1_epi32(0xff);
+  const __m512i ipv4     = _mm512_set1_epi32(int(uint8_t(LayerProtocol::IPv4)));
+  auto *out              = reinterpret_cast<int *>(_results);
+  std::size_t i          = 0;
+
+  for (; i + 16 <= _count; i += 16) {
+    const auto *base     = reinterpret_cast<const char *>(_addresses + i);
+    const auto *ip4      = reinterpret_cast<const int *>(base + C_IP4_OFFSET);
+    const auto *protocol = reinterpret_cast<const int *>(base + C_PROTOCOL_OFFSET);
+    const __m512i tags   = _mm512_and_si512(_mm512_i32gather_epi32(index32, protocol, 4), byteMask);
+    if (_mm512_cmpeq_epi32_mask(tags, ipv4) == 0xffff) {
+      _mm512_storeu_si512(out + i, classify4x16(_mm512_i32gather_epi32(index32, ip4, 4)));
+      continue;
+    }
+    for (std::size_t half = 0; half < 16; half += 8) {
+      const auto *words  = reinterpret_cast<const long long *>(_addresses + i + half);
+      const __m512i high = _mm512_shuffle_epi8(_mm512_i64gather_epi64(index64, words, 8), swap64);
+      const __m512i low  = _mm512_shuffle_epi8(_mm512_i64gather_epi64(index64, words + 1, 8), swap64);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + half), _mm512_cvtepi64_epi32(classify6x8(high, low)));
+    }
+    fixUnknown(_addresses + i, 16, _results + i);
+  }
+  classifyScalar(_addresses + i, _count - i, _results + i);
+}
+#endif
+
+// Columns of an AddressBlock. Kernels start at a row that is a multiple of 64, so every group
+// of 4, 8 or 16 rows has its protocol bits in a single bitmap word.
+struct Columns {
+  const uint32_t *ip4;
+  const uint64_t *high;
+  const uint64_t *low;
+  const uint64_t *ipv4;
+  const uint64_t *ipv6;
+  const uint64_t *any;
+};
+
+inline uint32_t bitsAt(const uint64_t *_words, std::size_t _row, unsigned _width) {
+  return uint32_t(_words[_row / 64] >> (_row % 64)) & ((1U << _width) - 1);
+}
+
+void classifyRowsScalar(const Columns &_columns, std::size_t _first, std::size_t _count, Class *_results) {
+  for (std::size_t i = 0; i < _count; ++i) {
+    const std::size_t row = _first + i;
+    if (bitsAt(_columns.ipv4, row, 1) != 0) {
+      _results[i] = classify4(_columns.ip4[row]);
+    } else if ((bitsAt(_columns.ipv6, row, 1) | bitsAt(_columns.any, row, 1)) != 0) {
+      _results[i] = classify6(_columns.high[row], _columns.low[row]);
+    } else {
+      _results[i] = Class::UNKNOWN;
+    }
+  }
+}
+
+// Unset rows have an all-zero IPv6 form, which the vector kernels see as "::"
+inline void fixUnknownRows(const Columns &_columns, std::size_t _row, unsigned _width, Class *_results) {
+  uint32_t unset = ~(bitsAt(_columns.ipv4, _row, _width) | bitsAt(_columns.ipv6, _row, _width) |
+                     bitsAt(_columns.any, _row, _width)) &
+                   ((1U << _width) - 1);
+  for (; unset != 0; unset &= unset - 1) _results[std::countr_zero(unset)] = Class::UNKNOWN;
+}
+
+// The vector kernels run the IPv4 rules on the IPv4 column of every row: that is the answer for
+// IPv4 rows and for v4-mapped IPv6 ones, whose IPv4 column holds the embedded address. The IPv6
+// rules only run where a group has IPv6 or ANY_IP rows, with the other rows zeroed so that the
+// mapped IPv4 forms do not pull in the second rule pass of classify6x*().
+#if defined(KT_KERNELS_SSE4_2)
+KT_TARGET_SSE4_2 void classifyRowsSse42(const Columns &_columns, std::size_t _first, std::size_t _count,
+    Class *_results) {
+  const __m128i lane64 = _mm_setr_epi32(1, 0, 2, 0);
+  auto *out            = reinterpret_cast<int *>(_results);
+  std::size_t i        = 0;
+  for (; i + 4 <= _count; i += 4) {
+    const std::size_t row = _first + i;
+    const __m128i ip4     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_columns.ip4 + row));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), classify4x4(ip4));
+    if (bitsAt(_columns.ipv4, row, 4) == 0xfU) continue;
+
+    const uint32_t other = bitsAt(_columns.ipv6, row, 4) | bitsAt(_columns.any, row, 4);
+    for (unsigned half = 0; half < 4; half += 2) {
+      const uint32_t lanes = (other >> half) & 0x3U;
+      if (lanes == 0) continue;
+      const __m128i keep = _mm_cmpeq_epi64(_mm_and_si128(_mm_set1_epi64x(lanes), lane64), lane64);
+      const auto *highs  = reinterpret_cast<const __m128i *>(_columns.high + row + half);
+      const auto *lows   = reinterpret_cast<const __m128i *>(_columns.low + row + half);
+      const __m128i high = _mm_and_si128(_mm_loadu_si128(highs), keep);
+      const __m128i low  = _mm_and_si128(_mm_loadu_si128(lows), keep);
+      const __m128i two  = _mm_shuffle_epi32(classify6x2(high, low), 0x08);
+      const __m128i old  = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(out + i + half));
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i + half),
+                       _mm_blendv_epi8(old, two, _mm_shuffle_epi32(keep, 0x08)));
+    }
+    fixUnknownRows(_columns, row, 4, _results + i);
+  }
+  classifyRowsScalar(_columns, _first + i, _count - i, _results + i);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+KT_TARGET_AVX2 void classifyRowsAvx2(const Columns &_columns, std::size_t _first, std::size_t _count,
+    Class *_results) {
+  const __m256i pack   = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  const __m256i lane64 = _mm256_setr_epi64x(1, 2, 4, 8);
+  auto *out            = reinterpret_cast<int *>(_results);
+  std::size_t i        = 0;
+  for (; i + 8 <= _count; i += 8) {
+    const std::size_t row = _first + i;
+    const __m256i ip4     = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_columns.ip4 + row));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), classify4x8(ip4));
+    if (bitsAt(_columns.ipv4, row, 8) == 0xffU) continue;
+
+    const uint32_t other = bitsAt(_columns.ipv6, row, 8) | bitsAt(_columns.any, row, 8);
+    for (unsigned half = 0; half < 8; half += 4) {
+      const uint32_t lanes = (other >> half) & 0xfU;
+      if (lanes == 0) continue;
+      const __m256i keep = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(lanes), lane64), lane64);
+      const __m256i high =
+          _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(_columns.high + row + half)), keep);
+      const __m256i low =
+          _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(_columns.low + row + half)), keep);
+      const __m256i four = _mm256_permutevar8x32_epi32(classify6x4(high, low), pack);
+      const __m256i mask = _mm256_permutevar8x32_epi32(keep, pack);
+      _mm_maskstore_epi32(out + i + half, _mm256_castsi256_si128(mask), _mm256_castsi256_si128(four));
+    }
+    fixUnknownRows(_columns, row, 8, _results + i);
+  }
+  classifyRowsScalar(_columns, _first + i, _count - i, _results + i);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+KT_TARGET_AVX512 void classifyRowsAvx512(const Columns &_columns, std::size_t _first, std::size_t _count,
+    Class *_results) {
+  auto *out     = reinterpret_cast<int *>(_results);
+  std::size_t i = 0;
+  for (; i + 16 <= _count; i += 16) {
+    const std::size_t row = _first + i;
+    _mm512_storeu_si512(out + i, classify4x16(_mm512_loadu_si512(_columns.ip4 + row)));
+    if (bitsAt(_columns.ipv4, row, 16) == 0xffffU) continue;
+
+    const uint32_t other = bitsAt(_columns.ipv6, row, 16) | bitsAt(_columns.any, row, 16);
+    for (unsigned half = 0; half < 16; half += 8) {
+      const auto lanes = __mmask8(other >> half);
+      if (lanes == 0) continue;
+      const __m512i high = _mm512_maskz_loadu_epi64(lanes, _columns.high + row + half);
+      const __m512i low  = _mm512_maskz_loadu_epi64(lanes, _columns.low + row + half);
+      _mm256_mask_storeu_epi32(out + i + half, lanes, _mm512_cvtepi64_epi32(classify6x8(high, low)));
+    }
+    fixUnknownRows(_columns, row, 16, _results + i);
+  }
+  classifyRowsScalar(_columns, _first + i, _count - i, _results + i);
+}
+#endif
+
+using ClassifyKernel = void (*)(const Address *, std::size_t, Class *);
+
+ClassifyKernel resolveClassify() {
+#if defined(KT_RUNTIME_DISPATCH)
+  return qResolveKernel<ClassifyKernel>(classifyScalar, classifySse42, classifyAvx2, classifyAvx512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  return classifyAvx512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  return classifyAvx2;
+#elif defined(KT_KERNELS_SSE4_2)
+  return classifySse42;
+#else
+  return classifyScalar;
+#endif
+}
+
+using ClassifyRowsKernel = void (*)(const Columns &, std::size_t, std::size_t, Class *);
+
+ClassifyRowsKernel resolveClassifyRows() {
+#if defined(KT_RUNTIME_DISPATCH)
+  return qResolveKernel<ClassifyRowsKernel>(classifyRowsScalar, classifyRowsSse42, classifyRowsAvx2,
+                                            classifyRowsAvx512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  return classifyRowsAvx512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  return classifyRowsAvx2;
+#elif defined(KT_KERNELS_SSE4_2)
+  return classifyRowsSse42;
+#else
+  return classifyRowsScalar;
+#endif
+}
+
+}  // namespace
+
+AddressClassification AddressData::classify() const {
+  switch (protocol_) {
+    case LayerProtocol::UNKNOWN: return Class::UNKNOWN;
+    case LayerProtocol::IPv4: return classify4(addr_);
+    default: return classify6(qFromBigEndian(a6_64.c[0]), qFromBigEndian(a6_64.c[1]));
+  }
+}
+
+void AddressData::classify(std::span<const Address> _addresses, std::span<AddressClassification> _results) {
+  static_assert(offsetof(AddressData, addr_) == C_IP4_OFFSET && offsetof(AddressData, protocol_) == C_PROTOCOL_OFFSET);
+  static const ClassifyKernel kernel = resolveClassify();
+  kernel(_addresses.data(), _addresses.size(), _results.data());
+}
+
+void AddressBlock::classifyRows(std::size_t _first, std::size_t _count, AddressClassification *_results) const {
+  static const ClassifyRowsKernel kernel = resolveClassifyRows();
+  const Columns columns = {ip4_.data(),          high_.data(),         low_.data(),
+                           ipv4_.words_.data(), ipv6_.words_.data(), any_.words_.data()};
+  kernel(columns, _first, _count, _results);
+}
+
+}  // namespace network
@@ -1,34 +1,63 @@
 #pragma once
 
-#include "Address.hpp"
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include "Endian.hpp"
+
+struct mmsghdr;
+struct sockaddr;
+struct sockaddr_in;
+struct sockaddr_in6;
 
 namespace network {
 
+class Address;
+
+enum class LayerProtocol : std::int8_t { UNKNOWN = -1, IPv4, IPv6, ANY_IP };
+
+//! IPv6 address in network byte order
+struct IPv6Address {
+  uint8_t c[16];
+
+  uint8_t &operator[](int _index) { return c[_index]; }
+  uint8_t operator[](int _index) const { return c[_index]; }
+};
+
+//! Special-purpose range an address belongs to (RFC 6890 and the IPv6 address space registry)
+/*!
+    Values from GLOBAL on have the GLOBAL bit set: they are unicast addresses usable beyond the
+    local link, including private (RFC 1918) and unique local ones. UNKNOWN is also used for
+    reserved ranges such as 240.0.0.0/4.
+*/
 enum class AddressClassification {
   UNKNOWN   = 0,
   LOOP_BACK = 1,
-  LOCAL_NET,
-  LINK_LOCAL,
-  MULTICAST,
-  BROADCAST,
+  LOCAL_NET,   // 0.0.0.0/8, ::, ::ffff:0.0.0.0
+  LINK_LOCAL,  // 169.254.0.0/16, fe80::/10
+  MULTICAST,   // 224.0.0.0/4, ff00::/8
+  BROADCAST,   // 255.255.255.255
 
   GLOBAL = 16,
-  TEST_NETWORK,
-  PRIVATE_NETWORK,
-  UNIQUE_LOCAL,
+  TEST_NETWORK,     // documentation and benchmarking ranges
+  PRIVATE_NETWORK,  // RFC 1918 and the RFC 6598 shared address space
+  UNIQUE_LOCAL,     // fc00::/7
+  SITE_LOCAL,       // fec0::/10, deprecated
 };
 
 class Netmask {
 public:
   constexpr Netmask() : length_(255) {}
   bool setAddress(const Address &_address);
-  Address address(Address::LayerProtocol protocol);
-  int getPrefixLength() const { return length_ == 255 ? -1 : length_; }
-  void setPrefixLength(Address::LayerProtocol _proto, int _len) {
+  Address address(LayerProtocol protocol);
+  constexpr int getPrefixLength() const { return length_ == 255 ? -1 : length_; }
+  constexpr void setPrefixLength(LayerProtocol _proto, int _len) {
     int maxLen = -1;
-    if (_proto == Address::LayerProtocol::IPv4) {
+    if (_proto == LayerProtocol::IPv4) {
       maxLen = 32;
-    } else if (_proto == Address::LayerProtocol::IPv6) {
+    } else if (_proto == LayerProtocol::IPv6) {
       maxLen = 128;
     }
 
@@ -39,34 +68,110 @@ public:
     }
   }
 
-  friend bool operator==(Netmask _n1, Netmask _n2) { return _n1.length_ == _n2.length_; }
+  friend constexpr bool operator==(Netmask _n1, Netmask _n2) { return _n1.length_ == _n2.length_; }
 
 private:
   uint8_t length_;
 };
 
+//! Address storage
+/*!
+    Plain value kept inline in every Address: the IPv6 (or IPv4-mapped) form in network
+    byte order, the IPv4 address in host byte order and the protocol tag.
+    Trivially copyable, so copying an Address is a 24-byte move with no allocation.
+
+    The setters only write a6_64, the member operator== reads, so addresses can be built and
+    compared in constant expressions (see AddressPrefix.hpp).
+*/
 class AddressData {
-  AddressData();
-  void setAddress(uint32_t _addr = 0);
-  void setAddress(const std::string &_addr);
+  constexpr AddressData() noexcept : a6_64 {{0, 0}} {}
+  constexpr void setAddress(uint32_t _addr = 0) {
+    addr_     = _addr;
+    protocol_ = LayerProtocol::IPv4;
 
-  bool parse(const std::string &_ipString);
-  void clear();
+    // create mapped address, except for addr_ == 0 (any)
+    a6_64.c[0] = 0;
+    a6_64.c[1] = _addr ? qToBigEndian(uint64_t(0xffff00000000ULL) | _addr) : 0;
+  }
+  // Same IPv4 form as Address::toIPv4Address() without branches: the embedded address of
+  // ::ffff:a.b.c.d, 0 for anything else
+  constexpr void setAddress(const uint8_t *_addr6) {
+    protocol_ = LayerProtocol::IPv6;
+    if (std::is_constant_evaluated()) {
+      for (int i = 0; i < 2; ++i) {
+        uint64_t word = 0;
+        for (int j = 0; j < 8; ++j) word = word << 8U | _addr6[i * 8 + j];
+        a6_64.c[i] = qToBigEndian(word);
+      }
+    } else {
+      std::memcpy(a6_64.c, _addr6, sizeof(a6_64.c));
+    }
+    const uint64_t low = qFromBigEndian(a6_64.c[1]);
+    const bool mapped  = a6_64.c[0] == 0 && low >> 32U == 0xffffU;
+    addr_              = uint32_t(low) & (0U - uint32_t(mapped));
+  }
+  bool setAddress(const ::sockaddr *_address);
+
+  bool parse(std::string_view _ipString);
+  constexpr void clear() {
+    addr_      = 0;
+    protocol_  = LayerProtocol::UNKNOWN;
+    a6_64.c[0] = 0;
+    a6_64.c[1] = 0;
+  }
 
   union {
     struct {
       uint64_t c[2];
     } a6_64;
     struct {
-      uint64_t c[4];
+      uint32_t c[4];
     } a6_32;
+    struct {
+      uint8_t c[16];
+    } a6;
   };
   uint32_t addr_ {0};  // IPv4 address
-  Address::LayerProtocol protocol_ {Address::LayerProtocol::UNKNOWN};
+  LayerProtocol protocol_ {LayerProtocol::UNKNOWN};
 
   [[nodiscard]] AddressClassification classify() const;
-  static AddressClassification classify(const Address &_addr) { return _addr.d_->classify(); }
+  static AddressClassification classify(const Address &_addr);
 
   friend class Address;
+  friend class AddressPrefix;
+
+public:
+  //! Classify \a _addresses into \a _results, which must be at least as long
+  /*!
+      Same result as Address::classify() for every element. The kernel is picked for the running
+      CPU (see qSimdLevel()): up to sixteen IPv4 addresses, or eight of any protocol, are matched
+      against all ranges per step without branches.
+  */
+  static void classify(std::span<const Address> _addresses, std::span<AddressClassification> _results);
+
+  //! Source addresses of datagrams received with recvmmsg()
+  /*!
+      Fills \a _addresses[i], and \a _ports[i] (host order) unless \a _ports is empty, from the
+      msg_name of \a _messages[i], as Address(const sockaddr *) would. Messages without an AF_INET
+      or AF_INET6 name give a null address and port 0. Returns the number of messages converted,
+      the smallest of the sizes.
+  */
+  static std::size_t fromMessages(std::span<const ::mmsghdr> _messages, std::span<Address> _addresses,
+      std::span<uint16_t> _ports = {});
+  //! Destination names for sendmmsg() on a dual-stack AF_INET6 socket
+  /*!
+      Writes \a _addresses[i] and \a _ports[i] (host order) to \a _names[i], IPv4 addresses in
+      v4-mapped form and null ones as "::", and points the msg_name of \a _messages[i] at it
+      unless \a _messages is empty. Returns the number of names written, the smallest of the sizes.
+  */
+  static std::size_t toSockaddrs(std::span<const Address> _addresses, std::span<const uint16_t> _ports,
+      std::span<::sockaddr_in6> _names, std::span<::mmsghdr> _messages = {});
+  //! Destination names for sendmmsg() on an AF_INET socket
+  /*!
+      As above, for addresses with an IPv4 form (see Address::toIPv4Address()). Stops at the
+      first one without, setting errno to EAFNOSUPPORT.
+  */
+  static std::size_t toSockaddrs(std::span<const Address> _addresses, std::span<const uint16_t> _ports,
+      std::span<::sockaddr_in> _names, std::span<::mmsghdr> _messages = {});
 };
 }  // namespace network
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+#include "Address.hpp"
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+using Conversion = Address::Conversion;
+
+constexpr unsigned C_MAPPED      = unsigned(Conversion::ConvertV4MappedToIPv4);
+constexpr unsigned C_COMPAT      = unsigned(Conversion::ConvertV4CompatToIPv4);
+constexpr unsigned C_UNSPECIFIED = unsigned(Conversion::ConvertUnspecifiedAddress);
+constexpr unsigned C_LOCAL_HOST  = unsigned(Conversion::ConvertLocalHost);
+// Combinations of the four conversions; TolerantConversion is all of them
+constexpr unsigned C_MODES = 16;
+
+// The second half of the IPv6 form as loaded from memory (bytes 8 to 15), and fields of it
+constexpr uint64_t C_MID_MASK    = qToBigEndian(uint64_t(0xffffffff00000000ULL));  // bytes 8 to 11
+constexpr uint64_t C_MID_MAPPED  = qToBigEndian(uint64_t(0x0000ffff00000000ULL));
+constexpr uint64_t C_IP4_MASK    = qToBigEndian(uint64_t(0x00000000ffffffffULL));  // bytes 12 to 15
+constexpr uint64_t C_LOOPBACK6   = qToBigEndian(uint64_t(1));
+constexpr uint64_t C_LOOPBACK4   = qToBigEndian(uint64_t(0x7f000001U));
+constexpr unsigned C_PROTO_IPv4  = unsigned(uint8_t(LayerProtocol::IPv4));
+constexpr unsigned C_PROTO_IPv6  = unsigned(uint8_t(LayerProtocol::IPv6));
+constexpr unsigned C_PROTO_ANY   = unsigned(uint8_t(LayerProtocol::ANY_IP));
+constexpr unsigned C_PROTO_UNSET = unsigned(uint8_t(LayerProtocol::UNKNOWN));
+
+// The vector kernels load Address values as three words: the IPv6 form, then the IPv4 address
+// with the protocol in the low byte of the upper half (little-endian x86 layout)
+static_assert(sizeof(Address) == 24, "The vector kernels expect 24-byte addresses");
+
+// Conversion key of an address under a mode: its IPv4 value where bytes 12 to 15 of the second
+// word are, and flags in place of bytes 8 to 11. An IPv4 address equals an IPv6 one exactly when
+// the keys differ in the two first flags and not in the value.
+constexpr uint64_t C_KEY_IPv4       = qToBigEndian(uint64_t(1) << 32U);  // an IPv4 address
+constexpr uint64_t C_KEY_CONVERTED  = qToBigEndian(uint64_t(2) << 32U);  // an IPv6 address the mode converts
+constexpr uint64_t C_KEY_ZERO       = qToBigEndian(uint64_t(4) << 32U);  // 0.0.0.0, "::" or ANY_IP
+constexpr uint64_t C_KEY_ANY        = qToBigEndian(uint64_t(8) << 32U);  // ANY_IP
+static_assert(C_KEY_ANY == C_KEY_IPv4 * 8, "The key flags are consecutive bits");
+constexpr uint64_t C_KEY_MIXED      = C_KEY_IPv4 | C_KEY_CONVERTED;
+constexpr uint64_t C_KEY_MIXED_MASK = C_KEY_MIXED | C_IP4_MASK;
+
+// One address as the kernels see it
+struct Words {
+  uint64_t high;
+  uint64_t low;
+  unsigned protocol;
+};
+
+inline Words words(const Address &_address) {
+  const IPv6Address ip6 = _address.toIPv6Address();
+  Words words {0, 0, unsigned(uint8_t(_address.getProtocol()))};
+  std::memcpy(&words.high, ip6.c, sizeof(words.high));
+  std::memcpy(&words.low, ip6.c + 8, sizeof(words.low));
+  return words;
+}
+
+// The terms of the conversions in Mode only, combined with bitwise operators so that the
+// compiler emits no branch; the vector kernels follow the same steps
+template <unsigned Mode>
+inline uint64_t key(const Words &_words) {
+  const bool high0     = _words.high == 0;
+  const uint64_t mid   = _words.low & C_MID_MASK;
+  const bool loopback6 = _words.low == C_LOOPBACK6;
+  bool converted       = false;
+  if constexpr ((Mode & C_MAPPED) != 0) converted |= mid == C_MID_MAPPED;
+  if constexpr ((Mode & C_COMPAT) != 0) converted |= (mid == 0) & !loopback6;
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) converted |= _words.low == 0;
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) converted |= loopback6;
+  converted &= high0 & (_words.protocol == C_PROTO_IPv6);
+
+  // The flags are consecutive bits from C_KEY_IPv4 on, in either byte order
+  unsigned flags = unsigned(_words.protocol == C_PROTO_IPv4) | (unsigned(converted) << 1U);
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) {
+    const bool zero = high0 & (_words.low == 0) & (_words.protocol != C_PROTO_UNSET);
+    flags |= (unsigned(zero) << 2U) | (unsigned(_words.protocol == C_PROTO_ANY) << 3U);
+  }
+  uint64_t value = _words.low & C_IP4_MASK;
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) value = loopback6 ? C_LOOPBACK4 : value;
+  return value | flags * C_KEY_IPv4;
+}
+
+// Address::isEqual() from the words and keys of both addresses
+template <unsigned Mode>
+inline bool equalPair(const Words &_a, uint64_t _keyA, const Words &_b, uint64_t _keyB) {
+  bool equal = (_a.protocol == _b.protocol) & (((_a.high ^ _b.high) | (_a.low ^ _b.low)) == 0);
+  if constexpr (Mode != 0) equal |= ((_keyA ^ _keyB) & C_KEY_MIXED_MASK) == C_KEY_MIXED;
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) {
+    equal |= ((_keyA & _keyB & C_KEY_ZERO) != 0) & (((_keyA | _keyB) & C_KEY_ANY) != 0);
+  }
+  return equal;
+}
+
+// Words from _first on, one pair at a time; One compares every address of _b to _a[0]
+template <unsigned Mode, bool One>
+inline void equalTail(const Address *_a, const Address *_b, std::size_t _first, std::size_t _count, uint64_t *_out) {
+  const Words one       = words(_a[0]);
+  const uint64_t oneKey = key<Mode>(one);
+  for (std::size_t w = _first / 64; w < (_count + 63) / 64; ++w) {
+    uint64_t word = 0;
+    for (std::size_t i = w * 64; i < std::min(_count, w * 64 + 64); ++i) {
+      const Words a = One ? one : words(_a[i]);
+      const Words b = words(_b[i]);
+      word |= uint64_t(equalPair<Mode>(a, One ? oneKey : key<Mode>(a), b, key<Mode>(b))) << (i % 64);
+    }
+    _out[w] = word;
+  }
+}
+
+// Whatever the build targets: one pair at a time
+template <unsigned Mode, bool One>
+void equalBaseline(const Address *_a, const Address *_b, std::size_t _count, uint64_t *_out) {
+  equalTail<Mode, One>(_a, _b, 0, _count, _out);
+}
+
+#if defined(KT_KERNELS_AVX2)
+// Four addresses as columns of their three words; the protocol is extracted from the third one
+struct Columns4 {
+  __m256i high;
+  __m256i low;
+  __m256i protocol;
+};
+
+KT_TARGET_AVX2 inline Columns4 columns4(const Address *_addresses) {
+  // Words a0 b0 c0 a1 | b1 c1 a2 b2 | c2 a3 b3 c3: blend each column's words in, then put them in order
+  const auto *words = reinterpret_cast<const __m256i *>(_addresses);
+  const __m256i r0  = _mm256_loadu_si256(words);
+  const __m256i r1  = _mm256_loadu_si256(words + 1);
+  const __m256i r2  = _mm256_loadu_si256(words + 2);
+  const __m256i a   = _mm256_blend_epi32(_mm256_blend_epi32(r0, r1, 0x30), r2, 0x0c);
+  const __m256i b   = _mm256_blend_epi32(_mm256_blend_epi32(r0, r1, 0xc3), r2, 0x30);
+  const __m256i c   = _mm256_blend_epi32(_mm256_blend_epi32(r0, r1, 0x0c), r2, 0xc3);
+  return {_mm256_permute4x64_epi64(a, _MM_SHUFFLE(1, 2, 3, 0)), _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 3, 0, 1)),
+          _mm256_and_si256(_mm256_srli_epi64(_mm256_permute4x64_epi64(c, _MM_SHUFFLE(3, 0, 1, 2)), 32),
+                           _mm256_set1_epi64x(0xff))};
+}
+
+KT_TARGET_AVX2 inline Columns4 broadcast4(const Words &_words) {
+  return {_mm256_set1_epi64x(int64_t(_words.high)), _mm256_set1_epi64x(int64_t(_words.low)),
+          _mm256_set1_epi64x(int64_t(_words.protocol))};
+}
+
+KT_TARGET_AVX2 inline __m256i equal4(__m256i _a, uint64_t _value) {
+  return _mm256_cmpeq_epi64(_a, _mm256_set1_epi64x(int64_t(_value)));
+}
+
+KT_TARGET_AVX2 inline __m256i masked4(__m256i _a, uint64_t _mask, uint64_t _value) {
+  return equal4(_mm256_and_si256(_a, _mm256_set1_epi64x(int64_t(_mask))), _value);
+}
+
+// key() of four addresses, lanes of all ones standing for true
+template <unsigned Mode>
+KT_TARGET_AVX2 inline __m256i key4(const Columns4 &_columns) {
+  const __m256i high0     = equal4(_columns.high, 0);
+  const __m256i loopback6 = equal4(_columns.low, C_LOOPBACK6);
+  __m256i converted       = _mm256_setzero_si256();
+  if constexpr ((Mode & C_MAPPED) != 0) {
+    converted = _mm256_or_si256(converted, masked4(_columns.low, C_MID_MASK, C_MID_MAPPED));
+  }
+  if constexpr ((Mode & C_COMPAT) != 0) {
+    converted = _mm256_or_si256(converted, _mm256_andnot_si256(loopback6, masked4(_columns.low, C_MID_MASK, 0)));
+  }
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) converted = _mm256_or_si256(converted, equal4(_columns.low, 0));
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) converted = _mm256_or_si256(converted, loopback6);
+  converted = _mm256_and_si256(converted, _mm256_and_si256(high0, equal4(_columns.protocol, C_PROTO_IPv6)));
+
+  __m256i key = _mm256_and_si256(_columns.low, _mm256_set1_epi64x(int64_t(C_IP4_MASK)));
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) {
+    key = _mm256_blendv_epi8(key, _mm256_set1_epi64x(int64_t(C_LOOPBACK4)), loopback6);
+  }
+  key = _mm256_or_si256(key, _mm256_and_si256(equal4(_columns.protocol, C_PROTO_IPv4),
+                                              _mm256_set1_epi64x(int64_t(C_KEY_IPv4))));
+  key = _mm256_or_si256(key, _mm256_and_si256(converted, _mm256_set1_epi64x(int64_t(C_KEY_CONVERTED))));
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) {
+    const __m256i zero = _mm256_andnot_si256(equal4(_columns.protocol, C_PROTO_UNSET),
+                                             _mm256_and_si256(high0, equal4(_columns.low, 0)));
+    key = _mm256_or_si256(key, _mm256_and_si256(zero, _mm256_set1_epi64x(int64_t(C_KEY_ZERO))));
+    key = _mm256_or_si256(key, _mm256_and_si256(equal4(_columns.protocol, C_PROTO_ANY),
+                                                _mm256_set1_epi64x(int64_t(C_KEY_ANY))));
+  }
+  return key;
+}
+
+template <unsigned Mode>
+KT_TARGET_AVX2 inline unsigned equalPair4(const Columns4 &_a, __m256i _keyA, const Columns4 &_b, __m256i _keyB) {
+  __m256i equal = _mm256_and_si256(_mm256_cmpeq_epi64(_a.protocol, _b.protocol),
+      _mm256_and_si256(_mm256_cmpeq_epi64(_a.high, _b.high), _mm256_cmpeq_epi64(_a.low, _b.low)));
+  if constexpr (Mode != 0) {
+    equal = _mm256_or_si256(equal, masked4(_mm256_xor_si256(_keyA, _keyB), C_KEY_MIXED_MASK, C_KEY_MIXED));
+  }
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) {
+    const __m256i zero = masked4(_mm256_and_si256(_keyA, _keyB), C_KEY_ZERO, C_KEY_ZERO);
+    const __m256i any  = masked4(_mm256_or_si256(_keyA, _keyB), C_KEY_ANY, C_KEY_ANY);
+    equal              = _mm256_or_si256(equal, _mm256_and_si256(zero, any));
+  }
+  return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(equal)));
+}
+
+template <unsigned Mode, bool One>
+KT_TARGET_AVX2 KT_FLATTEN void equalAvx2(const Address *_a, const Address *_b, std::size_t _count, uint64_t *_out) {
+  const Columns4 one   = broadcast4(words(_a[0]));
+  const __m256i oneKey = key4<Mode>(one);
+  for (std::size_t w = 0; w < _count / 64; ++w) {
+    uint64_t word = 0;
+    for (std::size_t j = 0; j < 64; j += 4) {
+      const Columns4 a = One ? one : columns4(_a + w * 64 + j);
+      const Columns4 b = columns4(_b + w * 64 + j);
+      word |= uint64_t(equalPair4<Mode>(a, One ? oneKey : key4<Mode>(a), b, key4<Mode>(b))) << j;
+    }
+    _out[w] = word;
+  }
+  equalTail<Mode, One>(_a, _b, _count / 64 * 64, _count, _out);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+// Eight addresses as columns, conditions in mask registers
+struct Columns8 {
+  __m512i high;
+  __m512i low;
+  __m512i protocol;
+};
+
+KT_TARGET_AVX512 inline Columns8 columns8(const Address *_addresses) {
+  // Words a0 b0 c0 a1 b1 c1 a2 b2 | c2 a3 b3 c3 a4 b4 c4 a5 | b5 c5 a6 b6 c6 a7 b7 c7: the first
+  // permute takes five or six words of a column from the first two vectors, the second the rest
+  const auto *words   = reinterpret_cast<const __m512i *>(_addresses);
+  const __m512i r0    = _mm512_loadu_si512(words);
+  const __m512i r1    = _mm512_loadu_si512(words + 1);
+  const __m512i r2    = _mm512_loadu_si512(words + 2);
+  const __m512i a     = _mm512_permutex2var_epi64(r0, _mm512_set_epi64(0, 0, 15, 12, 9, 6, 3, 0), r1);
+  const __m512i b     = _mm512_permutex2var_epi64(r0, _mm512_set_epi64(0, 0, 0, 13, 10, 7, 4, 1), r1);
+  const __m512i c     = _mm512_permutex2var_epi64(r0, _mm512_set_epi64(0, 0, 0, 14, 11, 8, 5, 2), r1);
+  const __m512i third = _mm512_permutex2var_epi64(c, _mm512_set_epi64(15, 12, 9, 4, 3, 2, 1, 0), r2);
+  // The zero-masking shift: GCC 12 warns about the undefined pass-through of the unmasked one
+  return {_mm512_permutex2var_epi64(a, _mm512_set_epi64(13, 10, 5, 4, 3, 2, 1, 0), r2),
+          _mm512_permutex2var_epi64(b, _mm512_set_epi64(14, 11, 8, 4, 3, 2, 1, 0), r2),
+          _mm512_and_si512(_mm512_maskz_srli_epi64(0xff, third, 32), _mm512_set1_epi64(0xff))};
+}
+
+KT_TARGET_AVX512 inline Columns8 broadcast8(const Words &_words) {
+  return {_mm512_set1_epi64(int64_t(_words.high)), _mm512_set1_epi64(int64_t(_words.low)),
+          _mm512_set1_epi64(int64_t(_words.protocol))};
+}
+
+KT_TARGET_AVX512 inline __mmask8 equal8(__m512i _a, uint64_t _value) {
+  return _mm512_cmpeq_epi64_mask(_a, _mm512_set1_epi64(int64_t(_value)));
+}
+
+KT_TARGET_AVX512 inline __mmask8 masked8(__m512i _a, uint64_t _mask, uint64_t _value) {
+  return equal8(_mm512_and_si512(_a, _mm512_set1_epi64(int64_t(_mask))), _value);
+}
+
+KT_TARGET_AVX512 inline __m512i setBits8(__m512i _key, __mmask8 _lanes, uint64_t _bits) {
+  return _mm512_mask_or_epi64(_key, _lanes, _key, _mm512_set1_epi64(int64_t(_bits)));
+}
+
+template <unsigned Mode>
+KT_TARGET_AVX512 inline __m512i key8(const Columns8 &_columns) {
+  const __mmask8 high0     = _mm512_testn_epi64_mask(_columns.high, _columns.high);
+  const __mmask8 loopback6 = equal8(_columns.low, C_LOOPBACK6);
+  __mmask8 converted       = 0;
+  if constexpr ((Mode & C_MAPPED) != 0) converted |= masked8(_columns.low, C_MID_MASK, C_MID_MAPPED);
+  if constexpr ((Mode & C_COMPAT) != 0) {
+    converted |= __mmask8(~loopback6 & _mm512_testn_epi64_mask(_columns.low, _mm512_set1_epi64(int64_t(C_MID_MASK))));
+  }
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) converted |= _mm512_testn_epi64_mask(_columns.low, _columns.low);
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) converted |= loopback6;
+  converted &= high0 & equal8(_columns.protocol, C_PROTO_IPv6);
+
+  __m512i key = _mm512_and_si512(_columns.low, _mm512_set1_epi64(int64_t(C_IP4_MASK)));
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) {
+    key = _mm512_mask_mov_epi64(key, loopback6, _mm512_set1_epi64(int64_t(C_LOOPBACK4)));
+  }
+  key = setBits8(key, equal8(_columns.protocol, C_PROTO_IPv4), C_KEY_IPv4);
+  key = setBits8(key, converted, C_KEY_CONVERTED);
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) {
+    const __mmask8 zero = __mmask8(~equal8(_columns.protocol, C_PROTO_UNSET) & high0 &
+                                   _mm512_testn_epi64_mask(_columns.low, _columns.low));
+    key = setBits8(setBits8(key, zero, C_KEY_ZERO), equal8(_columns.protocol, C_PROTO_ANY), C_KEY_ANY);
+  }
+  return key;
+}
+
+template <unsigned Mode>
+KT_TARGET_AVX512 inline unsigned equalPair8(const Columns8 &_a, __m512i _keyA, const Columns8 &_b, __m512i _keyB) {
+  const __mmask8 protocol = _mm512_cmpeq_epi64_mask(_a.protocol, _b.protocol);
+  const __mmask8 high     = _mm512_mask_cmpeq_epi64_mask(protocol, _a.high, _b.high);
+  __mmask8 equal          = _mm512_mask_cmpeq_epi64_mask(high, _a.low, _b.low);
+  if constexpr (Mode != 0) equal |= masked8(_mm512_xor_si512(_keyA, _keyB), C_KEY_MIXED_MASK, C_KEY_MIXED);
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) {
+    const __mmask8 zero =
+        _mm512_test_epi64_mask(_mm512_and_si512(_keyA, _keyB), _mm512_set1_epi64(int64_t(C_KEY_ZERO)));
+    equal |= _mm512_mask_test_epi64_mask(zero, _mm512_or_si512(_keyA, _keyB), _mm512_set1_epi64(int64_t(C_KEY_ANY)));
+  }
+  return equal;
+}
+
+template <unsigned Mode, bool One>
+KT_TARGET_AVX512 KT_FLATTEN void equalAvx512(const Address *_a, const Address *_b, std::size_t _count,
+    uint64_t *_out) {
+  const Columns8 one   = broadcast8(words(_a[0]));
+  const __m512i oneKey = key8<Mode>(one);
+  for (std::size_t w = 0; w < _count / 64; ++w) {
+    uint64_t word = 0;
+    for (std::size_t j = 0; j < 64; j += 8) {
+      const Columns8 a = One ? one : columns8(_a + w * 64 + j);
+      const Columns8 b = columns8(_b + w * 64 + j);
+      word |= uint64_t(equalPair8<Mode>(a, One ? oneKey : key8<Mode>(a), b, key8<Mode>(b))) << j;
+    }
+    _out[w] = word;
+  }
+  equalTail<Mode, One>(_a, _b, _count / 64 * 64, _count, _out);
+}
+#endif
+
+using Kernel = void (*)(const Address *, const Address *, std::size_t, uint64_t *);
+// Kernels of a level, the pairwise ones for each mode, then the one-to-many ones
+using KernelTable = std::array<Kernel, C_MODES * 2>;
+
+template <template <unsigned, bool> class Level, std::size_t... Indices>
+constexpr KernelTable makeTable(std::index_sequence<Indices...>) {
+  return {Level<Indices % C_MODES, (Indices >= C_MODES)>::kernel...};
+}
+
+template <unsigned Mode, bool One>
+struct Baseline {
+  static constexpr Kernel kernel = equalBaseline<Mode, One>;
+};
+constexpr KernelTable C_BASELINE = makeTable<Baseline>(std::make_index_sequence<C_MODES * 2>());
+
+#if defined(KT_KERNELS_AVX2)
+template <unsigned Mode, bool One>
+struct Avx2 {
+  static constexpr Kernel kernel = equalAvx2<Mode, One>;
+};
+constexpr KernelTable C_AVX2 = makeTable<Avx2>(std::make_index_sequence<C_MODES * 2>());
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+template <unsigned Mode, bool One>
+struct Avx512 {
+  static constexpr Kernel kernel = equalAvx512<Mode, One>;
+};
+constexpr KernelTable C_AVX512 = makeTable<Avx512>(std::make_index_sequence<C_MODES * 2>());
+#endif
+
+void equal(const Address *_a, const Address *_b, std::size_t _count, Flags<Conversion> _mode, bool _one,
+    uint64_t *_out) {
+#if defined(KT_RUNTIME_DISPATCH)
+  static const KernelTable *const kernels =
+      qResolveKernel<const KernelTable *>(&C_BASELINE, nullptr, &C_AVX2, &C_AVX512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  static const KernelTable *const kernels = &C_AVX512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  static const KernelTable *const kernels = &C_AVX2;
+#else
+  static const KernelTable *const kernels = &C_BASELINE;
+#endif
+  (*kernels)[(_mode.underlying() % C_MODES) + (_one ? C_MODES : 0)](_a, _b, _count, _out);
+}
+
+}  // namespace
+
+void Address::isEqual(std::span<const Address> _a, std::span<const Address> _b, Flags<Conversion> _mode,
+    std::span<uint64_t> _out) noexcept {
+  if (_a.empty()) return;
+  equal(_a.data(), _b.data(), _a.size(), _mode, false, _out.data());
+}
+
+void Address::isEqual(const Address &_address, std::span<const Address> _others, Flags<Conversion> _mode,
+    std::span<uint64_t> _out) noexcept {
+  if (_others.empty()) return;
+  equal(&_address, _others.data(), _others.size(), _mode, true, _out.data());
+}
+
+}  // namespace network
@@ -0,0 +1,133 @@
+#include "AddressFormatter.hpp"
+
+#include <cstring>
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+// Decimal text of every octet followed by a '.', stored with a fixed 4-byte stride
+// so an octet is emitted with one unconditional 4-byte copy.
+struct DecimalOctets {
+  char text[256][4];
+  uint8_t size[256];  // digits + '.'
+};
+
+constexpr DecimalOctets makeDecimalOctets() {
+  DecimalOctets table {};
+  for (unsigned value = 0; value < 256; ++value) {
+    char *text = table.text[value];
+    unsigned n = 0;
+    if (value >= 100) text[n++] = char('0' + value / 100);
+    if (value >= 10) text[n++] = char('0' + value / 10 % 10);
+    text[n++]         = char('0' + value % 10);
+    text[n++]         = '.';
+    table.size[value] = uint8_t(n);
+  }
+  return table;
+}
+
+constexpr DecimalOctets C_DECIMAL_OCTETS = makeDecimalOctets();
+
+constexpr char C_HEX_DIGITS[] = "0123456789abcdef";
+
+// Writes the 32 hex digits of the address, group i at _hex[4 * i]
+inline void hexDigits(const uint8_t *_ip6, char *_hex) {
+#if defined(KT_COMPILER_SUPPORTS_SSSE3)
+  const __m128i bytes  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_ip6));
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i lo     = _mm_and_si128(bytes, nibble);
+  const __m128i hi     = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+  const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(C_HEX_DIGITS));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(_hex), _mm_shuffle_epi8(digits, _mm_unpacklo_epi8(hi, lo)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(_hex + 16), _mm_shuffle_epi8(digits, _mm_unpackhi_epi8(hi, lo)));
+#else
+  for (unsigned i = 0; i < 16; ++i) {
+    _hex[2 * i]     = C_HEX_DIGITS[_ip6[i] >> 4U];
+    _hex[2 * i + 1] = C_HEX_DIGITS[_ip6[i] & 0xfU];
+  }
+#endif
+}
+
+}  // namespace
+
+std::size_t formatIPv4(uint32_t _ip4, char *_out) {
+  char *out = _out;
+  for (unsigned shift = 32; shift != 0;) {
+    shift -= 8;
+    const unsigned octet = (_ip4 >> shift) & 0xffU;
+    std::memcpy(out, C_DECIMAL_OCTETS.text[octet], 4);
+    out += C_DECIMAL_OCTETS.size[octet];
+  }
+  // drop the trailing '.'
+  return std::size_t(out - _out) - 1;
+}
+
+std::size_t formatIPv6(const uint8_t *_ip6, char *_out) {
+  static constexpr uint8_t C_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+  if (std::memcmp(_ip6, C_MAPPED_PREFIX, sizeof(C_MAPPED_PREFIX)) == 0) {
+    std::memcpy(_out, "::ffff:", 7);
+    const uint32_t ip4 = uint32_t(_ip6[12]) << 24U | uint32_t(_ip6[13]) << 16U | uint32_t(_ip6[14]) << 8U | _ip6[15];
+    return 7 + formatIPv4(ip4, _out + 7);
+  }
+
+  // Leading zeros are trimmed by copying the group text from an offset, which may read
+  // a few bytes past the last group.
+  char hex[40] = {};
+  hexDigits(_ip6, hex);
+
+  unsigned digits[8];
+  int best       = -1;
+  int bestLength = 1;  // only runs of two or more groups are compressed
+  int runStart   = -1;
+  for (int i = 0; i <= 8; ++i) {
+    const unsigned group = i < 8 ? unsigned(_ip6[2 * i]) << 8U | _ip6[2 * i + 1] : 1U;
+    if (i < 8) digits[i] = 1U + (group > 0xfU) + (group > 0xffU) + (group > 0xfffU);
+    if (group == 0) {
+      if (runStart < 0) runStart = i;
+    } else if (runStart >= 0) {
+      if (i - runStart > bestLength) {
+        best       = runStart;
+        bestLength = i - runStart;
+      }
+      runStart = -1;
+    }
+  }
+
+  char *out = _out;
+  for (int i = 0; i < 8; ++i) {
+    if (i == best) {
+      if (i == 0) *out++ = ':';
+      *out++ = ':';
+      i += bestLength - 1;
+      continue;
+    }
+    std::memcpy(out, hex + 4 * i + 4 - digits[i], 4);
+    out += digits[i];
+    *out++ = ':';
+  }
+  // A trailing "::" is part of the text, a trailing single ':' is not
+  if (best < 0 || best + bestLength != 8) --out;
+  return std::size_t(out - _out);
+}
+
+std::size_t formatAddresses(std::span<const Address> _addresses, char *_buffer, std::size_t _size, char _separator,
+    std::size_t *_formatted) {
+  char *out             = _buffer;
+  std::size_t remaining = _size;
+  std::size_t count     = 0;
+  for (const Address &address : _addresses) {
+    if (remaining == 0) break;
+    const std::size_t size = address.toChars(out, remaining - 1);
+    if (size == 0 && !address.isNull()) break;
+    out[size] = _separator;
+    out += size + 1;
+    remaining -= size + 1;
+    ++count;
+  }
+  if (_formatted) *_formatted = count;
+  return std::size_t(out - _buffer);
+}
+
+}  // namespace network
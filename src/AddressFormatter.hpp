@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include "Address.hpp"
+
+namespace network {
+
+//! Format an IPv4 address in dotted-quad notation
+/*!
+    \param _ip4 - Address in host byte order
+    \param _out - Destination, must have room for 16 characters (15 are used at most)
+    \return number of characters written, no terminating null
+*/
+std::size_t formatIPv4(uint32_t _ip4, char *_out);
+
+//! Format an IPv6 address in RFC 5952 canonical form
+/*!
+    Lower-case hex, no leading zeros, the longest run of two or more zero groups compressed to "::"
+    and IPv4-mapped addresses written as "::ffff:a.b.c.d".
+
+    \param _ip6 - 16 bytes in network byte order
+    \param _out - Destination, must have room for 48 characters (45 are used at most)
+    \return number of characters written, no terminating null
+*/
+std::size_t formatIPv6(const uint8_t *_ip6, char *_out);
+
+//! Format a batch of addresses back to back into one buffer
+/*!
+    Every address is followed by \a _separator. Null addresses produce an empty field.
+    Formatting stops at the first address that does not fit, so the buffer always ends on a separator.
+
+    \param _addresses - Addresses to format
+    \param _buffer - Destination buffer
+    \param _size - Size of the destination buffer
+    \param _separator - Character written after every address
+    \param _formatted - Receives the number of addresses written (optional)
+    \return number of characters written
+*/
+std::size_t formatAddresses(std::span<const Address> _addresses, char *_buffer, std::size_t _size,
+    char _separator = '\n', std::size_t *_formatted = nullptr);
+
+}  // namespace network
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Address.hpp"
+#include "Endian.hpp"
+#include "global/CompilerDetection.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace detail {
+
+// Control byte of a slot: empty, deleted, or the 7 low hash bits of the stored key (high bit clear)
+using Control                       = int8_t;
+constexpr Control C_CONTROL_EMPTY   = -128;  // 0b10000000
+constexpr Control C_CONTROL_DELETED = -2;    // 0b11111110
+
+//! Slots of a control group selected by a match, one bit group per slot
+template <typename Word, unsigned Shift, std::size_t Width>
+class GroupMask {
+public:
+  explicit GroupMask(Word _mask) : mask_(_mask) {}
+  explicit operator bool() const { return mask_ != 0; }
+  //! Offset of the first selected slot in the group
+  [[nodiscard]] unsigned lowest() const { return unsigned(std::countr_zero(mask_)) >> Shift; }
+  //! Unselected slots after the last selected one
+  [[nodiscard]] unsigned trailing() const {
+    return unsigned(std::countl_zero(mask_) - int(sizeof(Word) * 8 - (Width << Shift))) >> Shift;
+  }
+  void next() { mask_ &= mask_ - 1; }
+
+private:
+  Word mask_;
+};
+
+#if defined(KT_COMPILER_SUPPORTS_SSE2)
+// 16 control bytes compared at once
+class ControlGroup {
+public:
+  static constexpr std::size_t C_WIDTH = 16;
+  using Mask                           = GroupMask<uint32_t, 0, C_WIDTH>;
+
+  explicit ControlGroup(const Control *_control)
+      : control_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(_control))) {}
+
+  [[nodiscard]] Mask match(Control _h2) const {
+    return Mask(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(_h2), control_))));
+  }
+  [[nodiscard]] Mask matchEmpty() const { return match(C_CONTROL_EMPTY); }
+  //! Empty or deleted slots: the only control values below -1
+  [[nodiscard]] Mask matchFree() const {
+    return Mask(uint32_t(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), control_))));
+  }
+
+private:
+  __m128i control_;
+};
+#else
+// 8 control bytes compared in a 64-bit word. match() may report a false positive in the byte
+// following a true match; callers compare the keys anyway.
+class ControlGroup {
+public:
+  static constexpr std::size_t C_WIDTH = 8;
+  using Mask                           = GroupMask<uint64_t, 3, C_WIDTH>;
+
+  explicit ControlGroup(const Control *_control) : control_(qFromLittleEndian<uint64_t>(_control)) {}
+
+  [[nodiscard]] Mask match(Control _h2) const {
+    const uint64_t x = control_ ^ (C_LSBS * uint8_t(_h2));
+    return Mask((x - C_LSBS) & ~x & C_MSBS);
+  }
+  [[nodiscard]] Mask matchEmpty() const { return Mask(control_ & ~(control_ << 6U) & C_MSBS); }
+  [[nodiscard]] Mask matchFree() const { return Mask(control_ & ~(control_ << 7U) & C_MSBS); }
+
+private:
+  static constexpr uint64_t C_LSBS = 0x0101010101010101ULL;
+  static constexpr uint64_t C_MSBS = 0x8080808080808080ULL;
+
+  uint64_t control_;
+};
+#endif
+
+struct NoValue {};
+
+}  // namespace detail
+
+//! Open-addressing hash map keyed by Address
+/*!
+    A flat SwissTable-style table: keys and values are stored inline in one slot array, next
+    to an array of one control byte per slot holding 7 bits of the key's hash. A lookup hashes
+    the key once with qHash(), then compares a whole group of control bytes against the tag with
+    one SIMD compare (SSE2, or a 64-bit word elsewhere) and only touches slots whose tag matches,
+    so most lookups read one control group and one slot.
+
+    Capacity is a power of two, at most 7/8 full. Erased slots become tombstones unless no probe
+    can have passed them; tombstones are dropped when the table is rehashed.
+
+    Pointers to values and iterators are invalidated by any insertion that grows or rehashes the
+    table, and by clear(). Not thread-safe for modification; concurrent lookups are safe.
+*/
+template <typename V>
+class AddressHashMap {
+public:
+  struct value_type {
+    Address first;
+    [[no_unique_address]] V second;
+  };
+
+  template <bool Const>
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = AddressHashMap::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = std::conditional_t<Const, const value_type *, value_type *>;
+    using reference         = std::conditional_t<Const, const value_type &, value_type &>;
+
+    Iterator() = default;
+    operator Iterator<true>() const
+      requires(!Const)
+    {
+      return Iterator<true>(control_, slot_, end_);
+    }
+
+    reference operator*() const { return *slot_; }
+    pointer operator->() const { return slot_; }
+    Iterator &operator++() {
+      ++control_;
+      ++slot_;
+      skipFree();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+    bool operator==(const Iterator &_other) const { return control_ == _other.control_; }
+
+  private:
+    friend class AddressHashMap;
+    template <bool>
+    friend class Iterator;
+    Iterator(const detail::Control *_control, pointer _slot, const detail::Control *_end)
+        : control_(_control), slot_(_slot), end_(_end) {}
+    void skipFree() {
+      while (control_ != end_ && *control_ < 0) {
+        ++control_;
+        ++slot_;
+      }
+    }
+
+    const detail::Control *control_ {nullptr};
+    pointer slot_ {nullptr};
+    const detail::Control *end_ {nullptr};
+  };
+
+  using iterator       = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  AddressHashMap() = default;
+  AddressHashMap(const AddressHashMap &_other) { *this = _other; }
+  AddressHashMap(AddressHashMap &&_other) noexcept { swap(_other); }
+  ~AddressHashMap() { release(); }
+  AddressHashMap &operator=(const AddressHashMap &_other);
+  AddressHashMap &operator=(AddressHashMap &&_other) noexcept {
+    AddressHashMap(std::move(_other)).swap(*this);
+    return *this;
+  }
+  void swap(AddressHashMap &_other) noexcept {
+    std::swap(control_, _other.control_);
+    std::swap(slots_, _other.slots_);
+    std::swap(capacity_, _other.capacity_);
+    std::swap(size_, _other.size_);
+    std::swap(growthLeft_, _other.growthLeft_);
+  }
+
+  //! Value stored for \a _key, or nullptr
+  [[nodiscard]] V *find(const Address &_key) {
+    const std::size_t index = findIndex(_key, qHash(_key));
+    return index != C_NOT_FOUND ? &slots_[index].second : nullptr;
+  }
+  [[nodiscard]] const V *find(const Address &_key) const { return const_cast<AddressHashMap *>(this)->find(_key); }
+  [[nodiscard]] bool contains(const Address &_key) const { return find(_key) != nullptr; }
+
+  //! Insert \a _key with a value built from \a _args unless it is already present
+  /*!
+      \return the value stored for \a _key, and whether it was inserted
+  */
+  template <typename... Args>
+  std::pair<V *, bool> emplace(const Address &_key, Args &&..._args);
+  std::pair<V *, bool> insert(const Address &_key, V _value) { return emplace(_key, std::move(_value)); }
+  //! Insert or replace
+  V &insertOrAssign(const Address &_key, V _value) {
+    auto [value, inserted] = emplace(_key, std::move(_value));
+    if (!inserted) *value = std::move(_value);
+    return *value;
+  }
+  V &operator[](const Address &_key) { return *emplace(_key).first; }
+
+  //! Remove \a _key. Returns false if it was not present.
+  bool erase(const Address &_key);
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+  //! Remove every entry and keep the allocation
+  void clear();
+  //! Make room for \a _count entries without rehashing
+  void reserve(std::size_t _count);
+
+  iterator begin() { return makeIterator<false>(0); }
+  iterator end() { return makeIterator<false>(capacity_); }
+  const_iterator begin() const { return const_cast<AddressHashMap *>(this)->makeIterator<true>(0); }
+  const_iterator end() const { return const_cast<AddressHashMap *>(this)->makeIterator<true>(capacity_); }
+
+private:
+  using Group                              = detail::ControlGroup;
+  static constexpr std::size_t C_WIDTH     = Group::C_WIDTH;
+  static constexpr std::size_t C_NOT_FOUND = ~std::size_t(0);
+
+  static std::size_t maxLoad(std::size_t _capacity) { return _capacity - _capacity / 8; }
+  static detail::Control tag(std::size_t _hash) { return detail::Control(_hash & 0x7fU); }
+  // Start of the probe sequence; the tag uses the low bits, so the position uses the rest
+  std::size_t start(std::size_t _hash) const { return (_hash >> 7U) & (capacity_ - 1); }
+
+  template <bool Const>
+  Iterator<Const> makeIterator(std::size_t _index) {
+    Iterator<Const> it(control_ + _index, slots_ + _index, control_ + capacity_);
+    it.skipFree();
+    return it;
+  }
+
+  std::size_t findIndex(const Address &_key, std::size_t _hash) const;
+  // First empty or deleted slot on the probe sequence of \a _hash
+  std::size_t findFree(std::size_t _hash) const;
+  std::size_t prepareInsert(std::size_t _hash);
+  // Control bytes [capacity, capacity + C_WIDTH) mirror the first group, so a group load
+  // starting anywhere in the table needs no wrap-around
+  void setControl(std::size_t _index, detail::Control _value) {
+    control_[_index]                                           = _value;
+    control_[((_index - C_WIDTH) & (capacity_ - 1)) + C_WIDTH] = _value;
+  }
+  void rehash(std::size_t _capacity);
+  void destroySlots();
+  void release();
+
+  detail::Control *control_ {nullptr};
+  value_type *slots_ {nullptr};
+  std::size_t capacity_ {0};
+  std::size_t size_ {0};
+  std::size_t growthLeft_ {0};  // empty slots that may still be filled before a rehash
+};
+
+//! Open-addressing hash set of Address; see AddressHashMap
+class AddressHashSet {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Address;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const Address *;
+    using reference         = const Address &;
+
+    const_iterator() = default;
+    reference operator*() const { return it_->first; }
+    pointer operator->() const { return &it_->first; }
+    const_iterator &operator++() {
+      ++it_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++it_;
+      return copy;
+    }
+    bool operator==(const const_iterator &_other) const { return it_ == _other.it_; }
+
+  private:
+    friend class AddressHashSet;
+    explicit const_iterator(AddressHashMap<detail::NoValue>::const_iterator _it) : it_(_it) {}
+
+    AddressHashMap<detail::NoValue>::const_iterator it_;
+  };
+  using iterator = const_iterator;
+
+  //! Returns false if \a _key was already present
+  bool insert(const Address &_key) { return map_.emplace(_key).second; }
+  bool erase(const Address &_key) { return map_.erase(_key); }
+  [[nodiscard]] bool contains(const Address &_key) const { return map_.contains(_key); }
+
+  [[nodiscard]] std::size_t size() const noexcept { return map_.size(); }
+  [[nodiscard]] bool empty() const noexcept { return map_.empty(); }
+  [[nodiscard]] std::size_t capacity() const noexcept { return map_.capacity(); }
+  void clear() { map_.clear(); }
+  void reserve(std::size_t _count) { map_.reserve(_count); }
+
+  const_iterator begin() const { return const_iterator(map_.begin()); }
+  const_iterator end() const { return const_iterator(map_.end()); }
+
+private:
+  AddressHashMap<detail::NoValue> map_;
+};
+
+template <typename V>
+AddressHashMap<V> &AddressHashMap<V>::operator=(const AddressHashMap &_other) {
+  if (this == &_other) return *this;
+  clear();
+  reserve(_other.size_);
+  for (const value_type &entry : _other) emplace(entry.first, entry.second);
+  return *this;
+}
+
+template <typename V>
+std::size_t AddressHashMap<V>::findIndex(const Address &_key, std::size_t _hash) const {
+  if (Q_UNLIKELY(capacity_ == 0)) return C_NOT_FOUND;
+  const detail::Control h2 = tag(_hash);
+  const std::size_t mask   = capacity_ - 1;
+  std::size_t position     = start(_hash);
+  // Triangular probing over groups visits every group once when the capacity is a power of two
+  for (std::size_t step = C_WIDTH;; step += C_WIDTH) {
+    const Group group(control_ + position);
+    for (auto match = group.match(h2); match; match.next()) {
+      const std::size_t index = (position + match.lowest()) & mask;
+      if (Q_LIKELY(slots_[index].first == _key)) return index;
+    }
+    if (Q_LIKELY(group.matchEmpty())) return C_NOT_FOUND;
+    position = (position + step) & mask;
+  }
+}
+
+template <typename V>
+std::size_t AddressHashMap<V>::findFree(std::size_t _hash) const {
+  const std::size_t mask = capacity_ - 1;
+  std::size_t position   = start(_hash);
+  for (std::size_t step = C_WIDTH;; step += C_WIDTH) {
+    const auto free = Group(control_ + position).matchFree();
+    if (free) return (position + free.lowest()) & mask;
+    position = (position + step) & mask;
+  }
+}
+
+template <typename V>
+template <typename... Args>
+std::pair<V *, bool> AddressHashMap<V>::emplace(const Address &_key, Args &&..._args) {
+  const std::size_t hash = qHash(_key);
+  if (const std::size_t found = findIndex(_key, hash); found != C_NOT_FOUND) return {&slots_[found].second, false};
+  const std::size_t index = prepareInsert(hash);
+  ::new (static_cast<void *>(slots_ + index)) value_type {_key, V(std::forward<Args>(_args)...)};
+  return {&slots_[index].second, true};
+}
+
+template <typename V>
+std::size_t AddressHashMap<V>::prepareInsert(std::size_t _hash) {
+  std::size_t index = capacity_ != 0 ? findFree(_hash) : 0;
+  // Reusing a tombstone does not consume growth
+  if (Q_UNLIKELY(growthLeft_ == 0 && (capacity_ == 0 || control_[index] != detail::C_CONTROL_DELETED))) {
+    // Mostly tombstones: clean them up in place rather than doubling
+    rehash(capacity_ != 0 && size_ < maxLoad(capacity_) / 2 ? capacity_ : std::max(capacity_ * 2, C_WIDTH));
+    index = findFree(_hash);
+  }
+  growthLeft_ -= control_[index] == detail::C_CONTROL_EMPTY;
+  setControl(index, tag(_hash));
+  ++size_;
+  return index;
+}
+
+template <typename V>
+bool AddressHashMap<V>::erase(const Address &_key) {
+  const std::size_t index = findIndex(_key, qHash(_key));
+  if (index == C_NOT_FOUND) return false;
+  slots_[index].~value_type();
+  --size_;
+
+  // A slot can go back to empty if no group containing it was ever full, since then no probe
+  // sequence can have continued past it
+  const std::size_t before = (index - C_WIDTH) & (capacity_ - 1);
+  const auto emptyAfter    = Group(control_ + index).matchEmpty();
+  const auto emptyBefore   = Group(control_ + before).matchEmpty();
+  if (emptyBefore && emptyAfter && emptyAfter.lowest() + emptyBefore.trailing() < C_WIDTH) {
+    setControl(index, detail::C_CONTROL_EMPTY);
+    ++growthLeft_;
+  } else {
+    setControl(index, detail::C_CONTROL_DELETED);
+  }
+  return true;
+}
+
+template <typename V>
+void AddressHashMap<V>::clear() {
+  if (capacity_ == 0) return;
+  destroySlots();
+  std::memset(control_, detail::C_CONTROL_EMPTY, capacity_ + C_WIDTH);
+  size_       = 0;
+  growthLeft_ = maxLoad(capacity_);
+}
+
+template <typename V>
+void AddressHashMap<V>::reserve(std::size_t _count) {
+  std::size_t capacity = C_WIDTH;
+  while (maxLoad(capacity) < _count) capacity *= 2;
+  if (capacity > capacity_) rehash(capacity);
+}
+
+template <typename V>
+void AddressHashMap<V>::rehash(std::size_t _capacity) {
+  // One allocation: the slots, then the control bytes with their mirrored first group
+  auto *memory = static_cast<std::byte *>(::operator new(
+      _capacity * sizeof(value_type) + _capacity + C_WIDTH, std::align_val_t(alignof(value_type))));
+  AddressHashMap table;
+  table.slots_      = reinterpret_cast<value_type *>(memory);
+  table.control_    = reinterpret_cast<detail::Control *>(memory + _capacity * sizeof(value_type));
+  table.capacity_   = _capacity;
+  table.growthLeft_ = maxLoad(_capacity) - size_;
+  table.size_       = size_;
+  std::memset(table.control_, detail::C_CONTROL_EMPTY, _capacity + C_WIDTH);
+
+  for (std::size_t i = 0; i < capacity_; ++i) {
+    if (control_[i] < 0) continue;
+    const std::size_t hash  = qHash(slots_[i].first);
+    const std::size_t index = table.findFree(hash);
+    table.setControl(index, tag(hash));
+    ::new (static_cast<void *>(table.slots_ + index)) value_type(std::move(slots_[i]));
+  }
+  destroySlots();
+  swap(table);
+  if (table.capacity_ != 0) ::operator delete(table.slots_, std::align_val_t(alignof(value_type)));
+  table.capacity_ = 0;
+}
+
+template <typename V>
+void AddressHashMap<V>::destroySlots() {
+  if constexpr (!std::is_trivially_destructible_v<value_type>) {
+    for (std::size_t i = 0; i < capacity_; ++i) {
+      if (control_[i] >= 0) slots_[i].~value_type();
+    }
+  }
+}
+
+template <typename V>
+void AddressHashMap<V>::release() {
+  if (capacity_ == 0) return;
+  destroySlots();
+  ::operator delete(slots_, std::align_val_t(alignof(value_type)));
+  control_  = nullptr;
+  slots_    = nullptr;
+  capacity_ = size_ = growthLeft_ = 0;
+}
+
+}  // namespace network
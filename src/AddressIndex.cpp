@@ -0,0 +1,296 @@
+#include "AddressIndex.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "Uint128.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+using detail::Uint128;
+using Node = detail::AddressIndexNode;
+
+// Keys per node; an internal node has one child more
+constexpr std::size_t C_NODE_KEYS = 8;
+constexpr std::size_t C_FANOUT    = C_NODE_KEYS + 1;
+// Queries walked down the tree in step by the bulk search
+constexpr std::size_t C_SEARCH_STEP = 8;
+// Queries converted to keys per step by the bulk lowerBound()
+constexpr std::size_t C_BULK_KEYS = 64;
+
+constexpr uint64_t C_BIAS = uint64_t(1) << 63U;
+// Largest key, biased: what the padding slots of the last nodes hold
+constexpr uint64_t C_PADDING = ~uint64_t(0) ^ C_BIAS;
+
+constexpr Uint128 biased(Uint128 _key) { return {_key.hi ^ C_BIAS, _key.lo ^ C_BIAS}; }
+
+// Number of keys of _node less than _key, biased, i.e. the child to descend to
+inline unsigned rankBaseline(const Node &_node, Uint128 _key) {
+  unsigned rank = 0;
+  for (std::size_t i = 0; i < C_NODE_KEYS; ++i) {
+    const auto high = int64_t(_node.high[i]);
+    const bool less = high < int64_t(_key.hi) || (high == int64_t(_key.hi) && int64_t(_node.low[i]) < int64_t(_key.lo));
+    rank += unsigned(less);
+  }
+  return rank;
+}
+
+#if defined(KT_KERNELS_SSE4_2)
+KT_TARGET_SSE4_2 inline unsigned rankSse42(const Node &_node, Uint128 _key) {
+  const __m128i high = _mm_set1_epi64x(int64_t(_key.hi));
+  const __m128i low  = _mm_set1_epi64x(int64_t(_key.lo));
+  unsigned mask      = 0;
+  for (unsigned i = 0; i < C_NODE_KEYS; i += 2) {
+    const __m128i nodeHigh = _mm_load_si128(reinterpret_cast<const __m128i *>(_node.high + i));
+    const __m128i nodeLow  = _mm_load_si128(reinterpret_cast<const __m128i *>(_node.low + i));
+    const __m128i less     = _mm_or_si128(_mm_cmpgt_epi64(high, nodeHigh),
+            _mm_and_si128(_mm_cmpeq_epi64(high, nodeHigh), _mm_cmpgt_epi64(low, nodeLow)));
+    mask |= unsigned(_mm_movemask_pd(_mm_castsi128_pd(less))) << i;
+  }
+  return unsigned(std::popcount(mask));
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+KT_TARGET_AVX2 inline unsigned rankAvx2(const Node &_node, Uint128 _key) {
+  const __m256i high = _mm256_set1_epi64x(int64_t(_key.hi));
+  const __m256i low  = _mm256_set1_epi64x(int64_t(_key.lo));
+  unsigned mask      = 0;
+  for (unsigned i = 0; i < C_NODE_KEYS; i += 4) {
+    const __m256i nodeHigh = _mm256_load_si256(reinterpret_cast<const __m256i *>(_node.high + i));
+    const __m256i nodeLow  = _mm256_load_si256(reinterpret_cast<const __m256i *>(_node.low + i));
+    const __m256i less     = _mm256_or_si256(_mm256_cmpgt_epi64(high, nodeHigh),
+            _mm256_and_si256(_mm256_cmpeq_epi64(high, nodeHigh), _mm256_cmpgt_epi64(low, nodeLow)));
+    mask |= unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(less))) << i;
+  }
+  return unsigned(std::popcount(mask));
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+KT_TARGET_AVX512 inline unsigned rankAvx512(const Node &_node, Uint128 _key) {
+  const __m512i high     = _mm512_set1_epi64(int64_t(_key.hi));
+  const __m512i nodeHigh = _mm512_load_si512(_node.high);
+  const __mmask8 equal   = _mm512_cmpeq_epi64_mask(high, nodeHigh);
+  const __m512i low      = _mm512_set1_epi64(int64_t(_key.lo));
+  const __mmask8 less =
+      _mm512_cmpgt_epi64_mask(high, nodeHigh) | _mm512_mask_cmpgt_epi64_mask(equal, low, _mm512_load_si512(_node.low));
+  return unsigned(std::popcount(unsigned(less)));
+}
+#endif
+
+// Leaf position of the first key not less than each of _keys (biased); inlined into the
+// KT_TARGET_* entry points below with the rank of their level
+template <unsigned (*Rank)(const Node &, Uint128)>
+inline void searchWith(const Node *_nodes, const std::size_t *_levels, std::size_t _height, const Uint128 *_keys,
+    std::size_t _count, std::size_t *_positions) {
+  std::size_t q = 0;
+  for (; q + C_SEARCH_STEP <= _count; q += C_SEARCH_STEP) {
+    std::size_t node[C_SEARCH_STEP] = {};
+    for (std::size_t level = _height; level-- > 1;) {
+      const Node *nodes = _nodes + _levels[level];
+      for (std::size_t j = 0; j < C_SEARCH_STEP; ++j) node[j] = node[j] * C_FANOUT + Rank(nodes[node[j]], _keys[q + j]);
+    }
+    for (std::size_t j = 0; j < C_SEARCH_STEP; ++j) {
+      _positions[q + j] = node[j] * C_NODE_KEYS + Rank(_nodes[node[j]], _keys[q + j]);
+    }
+  }
+  for (; q < _count; ++q) {
+    std::size_t node = 0;
+    for (std::size_t level = _height; level-- > 1;) {
+      node = node * C_FANOUT + Rank(_nodes[_levels[level] + node], _keys[q]);
+    }
+    _positions[q] = node * C_NODE_KEYS + Rank(_nodes[node], _keys[q]);
+  }
+}
+
+void searchBaseline(const Node *_nodes, const std::size_t *_levels, std::size_t _height, const Uint128 *_keys,
+    std::size_t _count, std::size_t *_positions) {
+  searchWith<rankBaseline>(_nodes, _levels, _height, _keys, _count, _positions);
+}
+
+#if defined(KT_KERNELS_SSE4_2)
+KT_TARGET_SSE4_2 KT_FLATTEN void searchSse42(const Node *_nodes, const std::size_t *_levels, std::size_t _height,
+    const Uint128 *_keys, std::size_t _count, std::size_t *_positions) {
+  searchWith<rankSse42>(_nodes, _levels, _height, _keys, _count, _positions);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+KT_TARGET_AVX2 KT_FLATTEN void searchAvx2(const Node *_nodes, const std::size_t *_levels, std::size_t _height,
+    const Uint128 *_keys, std::size_t _count, std::size_t *_positions) {
+  searchWith<rankAvx2>(_nodes, _levels, _height, _keys, _count, _positions);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+KT_TARGET_AVX512 KT_FLATTEN void searchAvx512(const Node *_nodes, const std::size_t *_levels, std::size_t _height,
+    const Uint128 *_keys, std::size_t _count, std::size_t *_positions) {
+  searchWith<rankAvx512>(_nodes, _levels, _height, _keys, _count, _positions);
+}
+#endif
+
+void search(const Node *_nodes, const std::size_t *_levels, std::size_t _height, const Uint128 *_keys,
+    std::size_t _count, std::size_t *_positions) {
+  using Kernel = void (*)(const Node *, const std::size_t *, std::size_t, const Uint128 *, std::size_t, std::size_t *);
+#if defined(KT_RUNTIME_DISPATCH)
+  static const Kernel kernel = qResolveKernel<Kernel>(searchBaseline, searchSse42, searchAvx2, searchAvx512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  static const Kernel kernel = searchAvx512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  static const Kernel kernel = searchAvx2;
+#elif defined(KT_COMPILER_SUPPORTS_SSE4_2)
+  static const Kernel kernel = searchSse42;
+#else
+  static const Kernel kernel = searchBaseline;
+#endif
+  kernel(_nodes, _levels, _height, _keys, _count, _positions);
+}
+
+}  // namespace
+
+void AddressIndex::assign(std::span<const Address> _addresses) {
+  struct Row {
+    Uint128 key;
+    LayerProtocol protocol;
+
+    auto operator<=>(const Row &) const = default;
+  };
+  std::vector<Row> rows;
+  rows.reserve(_addresses.size());
+  for (const Address &address : _addresses) rows.push_back({address.orderKey(), address.getProtocol()});
+  std::sort(rows.begin(), rows.end());
+
+  // Level sizes: the leaves hold the keys, each level above one node per C_FANOUT below
+  const std::size_t leaves = std::max<std::size_t>(1, (rows.size() + C_NODE_KEYS - 1) / C_NODE_KEYS);
+  levels_.assign(1, 0);
+  std::size_t total = leaves;
+  for (std::size_t count = leaves; count > 1;) {
+    count = (count + C_FANOUT - 1) / C_FANOUT;
+    levels_.push_back(total);
+    total += count;
+  }
+
+  Node padding;
+  std::fill(std::begin(padding.high), std::end(padding.high), C_PADDING);
+  std::fill(std::begin(padding.low), std::end(padding.low), C_PADDING);
+  nodes_.assign(total, padding);
+  protocols_.resize(rows.size());
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    Node &leaf                 = nodes_[i / C_NODE_KEYS];
+    leaf.high[i % C_NODE_KEYS] = rows[i].key.hi ^ C_BIAS;
+    leaf.low[i % C_NODE_KEYS]  = rows[i].key.lo ^ C_BIAS;
+    protocols_[i]              = rows[i].protocol;
+  }
+
+  // Key i of an internal node is the first key of its child i + 1, found at the leftmost leaf
+  // below that child; children past the last leaf keep the padding
+  std::size_t span = 1;  // leaves below one node of the level underneath
+  for (std::size_t level = 1; level < levels_.size(); ++level) {
+    const std::size_t end = level + 1 < levels_.size() ? levels_[level + 1] : total;
+    for (std::size_t node = 0; levels_[level] + node < end; ++node) {
+      Node &parent = nodes_[levels_[level] + node];
+      for (std::size_t i = 0; i < C_NODE_KEYS; ++i) {
+        const std::size_t leaf = (node * C_FANOUT + i + 1) * span;
+        if (leaf >= leaves) break;
+        parent.high[i] = nodes_[leaf].high[0];
+        parent.low[i]  = nodes_[leaf].low[0];
+      }
+    }
+    span *= C_FANOUT;
+  }
+}
+
+void AddressIndex::clear() noexcept {
+  nodes_.clear();
+  levels_.clear();
+  protocols_.clear();
+}
+
+Address AddressIndex::operator[](std::size_t _position) const {
+  const Node &leaf    = nodes_[_position / C_NODE_KEYS];
+  const uint64_t high = leaf.high[_position % C_NODE_KEYS] ^ C_BIAS;
+  const uint64_t low  = leaf.low[_position % C_NODE_KEYS] ^ C_BIAS;
+  switch (protocols_[_position]) {
+    case LayerProtocol::IPv4: return Address(uint32_t(low));
+    case LayerProtocol::IPv6: {
+      IPv6Address ip6;
+      qToBigEndian(high, ip6.c);
+      qToBigEndian(low, ip6.c + 8);
+      return Address(ip6);
+    }
+    case LayerProtocol::ANY_IP: return Address(Address::SpecialAddress::ANY);
+    case LayerProtocol::UNKNOWN: break;
+  }
+  return {};
+}
+
+std::size_t AddressIndex::skipEqualKeys(std::size_t _position, const Address &_address, bool _inclusive) const {
+  const Uint128 key = _address.orderKey();
+  if (_position == size()) return _position;
+  const Node &leaf = nodes_[_position / C_NODE_KEYS];
+  const uint64_t high = leaf.high[_position % C_NODE_KEYS] ^ C_BIAS;
+  const uint64_t low  = leaf.low[_position % C_NODE_KEYS] ^ C_BIAS;
+  if (high != key.hi || low != key.lo) return _position;
+
+  // The run of equal keys ends where the next key starts, and is sorted by protocol
+  std::size_t end = size();
+  if (key.hi != ~uint64_t(0) || key.lo != ~uint64_t(0)) {
+    const Uint128 next = biased(key + Uint128 {0, 1});
+    search(nodes_.data(), levels_.data(), levels_.size(), &next, 1, &end);
+  }
+  const auto first = protocols_.begin() + std::ptrdiff_t(_position);
+  const auto last  = protocols_.begin() + std::ptrdiff_t(end);
+  const auto found = _inclusive ? std::upper_bound(first, last, _address.getProtocol())
+                                : std::lower_bound(first, last, _address.getProtocol());
+  return std::size_t(found - protocols_.begin());
+}
+
+std::size_t AddressIndex::lowerBound(const Address &_address) const {
+  if (empty()) return 0;
+  const Uint128 key = biased(_address.orderKey());
+  std::size_t position;
+  search(nodes_.data(), levels_.data(), levels_.size(), &key, 1, &position);
+  return skipEqualKeys(position, _address, false);
+}
+
+std::size_t AddressIndex::upperBound(const Address &_address) const {
+  if (empty()) return 0;
+  const Uint128 key = biased(_address.orderKey());
+  std::size_t position;
+  search(nodes_.data(), levels_.data(), levels_.size(), &key, 1, &position);
+  return skipEqualKeys(position, _address, true);
+}
+
+void AddressIndex::lowerBound(std::span<const Address> _addresses, std::span<std::size_t> _positions) const {
+  if (empty()) {
+    std::fill_n(_positions.begin(), _addresses.size(), 0);
+    return;
+  }
+  Uint128 keys[C_BULK_KEYS];
+  for (std::size_t first = 0; first < _addresses.size(); first += C_BULK_KEYS) {
+    const std::size_t count = std::min(C_BULK_KEYS, _addresses.size() - first);
+    for (std::size_t i = 0; i < count; ++i) keys[i] = biased(_addresses[first + i].orderKey());
+    search(nodes_.data(), levels_.data(), levels_.size(), keys, count, _positions.data() + first);
+    for (std::size_t i = first; i < first + count; ++i) {
+      _positions[i] = skipEqualKeys(_positions[i], _addresses[i], false);
+    }
+  }
+}
+
+bool AddressIndex::contains(const Address &_address) const {
+  const std::size_t position = lowerBound(_address);
+  return position < size() && (*this)[position] == _address;
+}
+
+std::pair<std::size_t, std::size_t> AddressIndex::range(const Address &_low, const Address &_high) const {
+  const std::size_t first = lowerBound(_low);
+  return {first, std::max(first, upperBound(_high))};
+}
+
+}  // namespace network
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+
+namespace network {
+
+namespace detail {
+
+//! Node of an AddressIndex: eight keys, upper halves first, each half biased by 2^63 so signed
+//! compares order them as unsigned. One node fills two cache lines.
+struct alignas(64) AddressIndexNode {
+  uint64_t high[8];
+  uint64_t low[8];
+};
+
+}  // namespace detail
+
+//! Read-only sorted multiset of addresses for order and range queries
+/*!
+    Built once from a span of addresses, sorted by Address::operator<=>. The keys are laid out as
+    a static B+ tree: nodes of eight keys, the sorted keys themselves as the leaves and every
+    internal key the smallest key of the subtree after it, each level stored contiguously. A
+    lookup reads one node per level and ranks the query against all eight keys at once with
+    SIMD compares, without branches. For 10M addresses that is 8 nodes where a binary search
+    touches 24 cache lines.
+
+    \code{.cpp}
+    const AddressIndex index(hosts);
+    const auto [first, last] = index.range(Address("10.0.0.0"), Address("10.0.255.255"));
+    for (std::size_t i = first; i < last; ++i) use(index[i]);
+    \endcode
+
+    The bulk lowerBound() walks several queries down the tree in step, so their cache misses
+    overlap.
+*/
+class AddressIndex {
+public:
+  AddressIndex() = default;
+  explicit AddressIndex(std::span<const Address> _addresses) { assign(_addresses); }
+
+  //! Replace the contents by \a _addresses; duplicates are kept
+  void assign(std::span<const Address> _addresses);
+  void clear() noexcept;
+
+  [[nodiscard]] std::size_t size() const noexcept { return protocols_.size(); }
+  [[nodiscard]] bool empty() const noexcept { return protocols_.empty(); }
+  //! Address at \a _position in sorted order
+  [[nodiscard]] Address operator[](std::size_t _position) const;
+
+  //! Position of the first address not less than \a _address, or size()
+  [[nodiscard]] std::size_t lowerBound(const Address &_address) const;
+  //! Position of the first address greater than \a _address, or size()
+  [[nodiscard]] std::size_t upperBound(const Address &_address) const;
+  //! lowerBound() of every address of \a _addresses into \a _positions, which must be as long
+  void lowerBound(std::span<const Address> _addresses, std::span<std::size_t> _positions) const;
+  [[nodiscard]] bool contains(const Address &_address) const;
+  //! Positions [first, last) of the addresses from \a _low to \a _high, both included
+  [[nodiscard]] std::pair<std::size_t, std::size_t> range(const Address &_low, const Address &_high) const;
+
+private:
+  using Node = detail::AddressIndexNode;
+
+  // Moves _position past the addresses with the key of _address ordered before it, or up to it
+  // if _inclusive; the tree search only compares keys, so a second one for the next key bounds
+  // the equal keys and their protocols are binary searched, however many duplicates there are
+  std::size_t skipEqualKeys(std::size_t _position, const Address &_address, bool _inclusive) const;
+
+  std::vector<Node> nodes_;           // leaves, then each level up to the root
+  std::vector<std::size_t> levels_;   // first node of each level, leaves first
+  std::vector<LayerProtocol> protocols_;
+};
+
+}  // namespace network
@@ -0,0 +1,280 @@
+#include <array>
+#include <bit>
+#include <cstring>
+#include <utility>
+#include "Address.hpp"
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+using Conversion = Address::Conversion;
+
+constexpr unsigned C_MAPPED      = unsigned(Conversion::ConvertV4MappedToIPv4);
+constexpr unsigned C_COMPAT      = unsigned(Conversion::ConvertV4CompatToIPv4);
+constexpr unsigned C_UNSPECIFIED = unsigned(Conversion::ConvertUnspecifiedAddress);
+constexpr unsigned C_LOCAL_HOST  = unsigned(Conversion::ConvertLocalHost);
+// Combinations of the four conversions; TolerantConversion is all of them
+constexpr unsigned C_MODES = 16;
+
+// The second half of the IPv6 form as loaded from memory (bytes 8 to 15), and fields of it
+constexpr uint64_t C_MID_MASK   = qToBigEndian(uint64_t(0xffffffff00000000ULL));  // bytes 8 to 11
+constexpr uint64_t C_MID_MAPPED = qToBigEndian(uint64_t(0x0000ffff00000000ULL));
+constexpr uint64_t C_IP4_MASK   = qToBigEndian(uint64_t(0x00000000ffffffffULL));  // bytes 12 to 15
+constexpr uint64_t C_LOOPBACK6  = qToBigEndian(uint64_t(1));
+constexpr uint64_t C_LOOPBACK4  = qToBigEndian(uint64_t(0x7f000001U));
+constexpr unsigned C_PROTO_IPv6 = unsigned(uint8_t(LayerProtocol::IPv6));
+
+// The kernels rewrite an address as three words: the IPv6 form, then the IPv4 address, the
+// protocol and padding. A converted address gets the words of Address(uint32_t): its v4-mapped
+// form ("::" for 0.0.0.0), and the IPv4 address in host order with protocol IPv4 (0). The vector
+// kernels also read the protocol from the low byte of the upper half (little-endian x86 layout).
+static_assert(sizeof(Address) == 24, "The vector kernels expect 24-byte addresses");
+
+// One address, as convertToIpv4() in Address.cpp but with bitwise operators, so that the compiler
+// emits no branch; the words are selected rather than the address assigned
+template <unsigned Mode>
+inline bool normalizeOne(Address &_address) {
+  // Word by word: copying all three at once goes through the stack in 16-byte pieces
+  auto *bytes    = reinterpret_cast<unsigned char *>(&_address);
+  uint64_t high  = 0;
+  uint64_t low   = 0;
+  uint64_t third = 0;
+  std::memcpy(&high, bytes, sizeof(high));
+  std::memcpy(&low, bytes + 8, sizeof(low));
+  std::memcpy(&third, bytes + 16, sizeof(third));
+  const uint64_t mid   = low & C_MID_MASK;
+  const bool loopback6 = low == C_LOOPBACK6;
+  bool converted       = false;
+  if constexpr ((Mode & C_MAPPED) != 0) converted |= mid == C_MID_MAPPED;
+  if constexpr ((Mode & C_COMPAT) != 0) converted |= (mid == 0) & !loopback6;
+  if constexpr ((Mode & C_UNSPECIFIED) != 0) converted |= low == 0;
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) converted |= loopback6;
+  converted &= (high == 0) & (_address.getProtocol() == LayerProtocol::IPv6);
+
+  uint64_t ip4 = low & C_IP4_MASK;
+  if constexpr ((Mode & C_LOCAL_HOST) != 0) ip4 = loopback6 ? C_LOOPBACK4 : ip4;
+  // v4-mapped, "::" for 0.0.0.0; the IPv4 address in the first four bytes, then protocol IPv4 (0) and zero padding
+  const uint64_t mapped = (ip4 | C_MID_MAPPED) & (0 - uint64_t(ip4 != 0));
+  const uint64_t host   = uint32_t(qFromBigEndian(ip4));
+  const uint64_t keep   = uint64_t(converted) - 1;
+  low                   = (low & keep) | (mapped & ~keep);
+  third = (third & keep) | ((std::endian::native == std::endian::little ? host : host << 32U) & ~keep);
+  std::memcpy(bytes + 8, &low, sizeof(low));
+  std::memcpy(bytes + 16, &third, sizeof(third));
+  return converted;
+}
+
+template <unsigned Mode>
+std::size_t normalizeBaseline(Address *_addresses, std::size_t _count) {
+  std::size_t converted = 0;
+  for (std::size_t i = 0; i < _count; ++i) converted += std::size_t(normalizeOne<Mode>(_addresses[i]));
+  return converted;
+}
+
+#if defined(KT_KERNELS_AVX2)
+// Four addresses as columns of their three words
+struct Columns4 {
+  __m256i high;
+  __m256i low;
+  __m256i third;
+};
+
+KT_TARGET_AVX2 inline Columns4 columns4(const Address *_addresses) {
+  // Words a0 b0 c0 a1 | b1 c1 a2 b2 | c2 a3 b3 c3: blend each column's words in, then put them in order
+  const auto *words = reinterpret_cast<const __m256i *>(_addresses);
+  const __m256i r0  = _mm256_loadu_si256(words);
+  const __m256i r1  = _mm256_loadu_si256(words + 1);
+  const __m256i r2  = _mm256_loadu_si256(words + 2);
+  const __m256i a   = _mm256_blend_epi32(_mm256_blend_epi32(r0, r1, 0x30), r2, 0x0c);
+  const __m256i b   = _mm256_blend_epi32(_mm256_blend_epi32(r0, r1, 0xc3), r2, 0x30);
+  const __m256i c   = _mm256_blend_epi32(_mm256_blend_epi32(r0, r1, 0x0c), r2, 0xc3);
+  return {_mm256_permute4x64_epi64(a, _MM_SHUFFLE(1, 2, 3, 0)), _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 3, 0, 1)),
+          _mm256_permute4x64_epi64(c, _MM_SHUFFLE(3, 0, 1, 2))};
+}
+
+// The inverse of columns4(): the permutations swap words in pairs, so they undo themselves
+KT_TARGET_AVX2 inline void storeColumns4(Address *_addresses, const Columns4 &_columns) {
+  auto *words     = reinterpret_cast<__m256i *>(_addresses);
+  const __m256i a = _mm256_permute4x64_epi64(_columns.high, _MM_SHUFFLE(1, 2, 3, 0));
+  const __m256i b = _mm256_permute4x64_epi64(_columns.low, _MM_SHUFFLE(2, 3, 0, 1));
+  const __m256i c = _mm256_permute4x64_epi64(_columns.third, _MM_SHUFFLE(3, 0, 1, 2));
+  _mm256_storeu_si256(words, _mm256_blend_epi32(_mm256_blend_epi32(a, b, 0x0c), c, 0x30));
+  _mm256_storeu_si256(words + 1, _mm256_blend_epi32(_mm256_blend_epi32(b, c, 0x0c), a, 0x30));
+  _mm256_storeu_si256(words + 2, _mm256_blend_epi32(_mm256_blend_epi32(c, a, 0x0c), b, 0x30));
+}
+
+KT_TARGET_AVX2 inline __m256i equal4(__m256i _a, uint64_t _value) {
+  return _mm256_cmpeq_epi64(_a, _mm256_set1_epi64x(int64_t(_value)));
+}
+
+KT_TARGET_AVX2 inline __m256i masked4(__m256i _a, uint64_t _mask, uint64_t _value) {
+  return equal4(_mm256_and_si256(_a, _mm256_set1_epi64x(int64_t(_mask))), _value);
+}
+
+template <unsigned Mode>
+KT_TARGET_AVX2 KT_FLATTEN std::size_t normalizeAvx2(Address *_addresses, std::size_t _count) {
+  // Bytes 12 to 15 of the IPv6 form to the IPv4 address in host order, the upper half cleared
+  const __m256i swap = _mm256_setr_epi8(7, 6, 5, 4, -1, -1, -1, -1, 15, 14, 13, 12, -1, -1, -1, -1, 7, 6, 5, 4, -1, -1,
+      -1, -1, 15, 14, 13, 12, -1, -1, -1, -1);
+  std::size_t converted = 0;
+  std::size_t i         = 0;
+  for (; i + 4 <= _count; i += 4) {
+    Columns4 columns        = columns4(_addresses + i);
+    const __m256i protocol  = _mm256_and_si256(_mm256_srli_epi64(columns.third, 32), _mm256_set1_epi64x(0xff));
+    const __m256i loopback6 = equal4(columns.low, C_LOOPBACK6);
+    __m256i lanes           = _mm256_setzero_si256();
+    if constexpr ((Mode & C_MAPPED) != 0) {
+      lanes = _mm256_or_si256(lanes, masked4(columns.low, C_MID_MASK, C_MID_MAPPED));
+    }
+    if constexpr ((Mode & C_COMPAT) != 0) {
+      lanes = _mm256_or_si256(lanes, _mm256_andnot_si256(loopback6, masked4(columns.low, C_MID_MASK, 0)));
+    }
+    if constexpr ((Mode & C_UNSPECIFIED) != 0) lanes = _mm256_or_si256(lanes, equal4(columns.low, 0));
+    if constexpr ((Mode & C_LOCAL_HOST) != 0) lanes = _mm256_or_si256(lanes, loopback6);
+    lanes = _mm256_and_si256(lanes, _mm256_and_si256(equal4(columns.high, 0), equal4(protocol, C_PROTO_IPv6)));
+
+    __m256i ip4 = _mm256_and_si256(columns.low, _mm256_set1_epi64x(int64_t(C_IP4_MASK)));
+    if constexpr ((Mode & C_LOCAL_HOST) != 0) {
+      ip4 = _mm256_blendv_epi8(ip4, _mm256_set1_epi64x(int64_t(C_LOOPBACK4)), loopback6);
+    }
+    // v4-mapped, except 0.0.0.0 which is "::"
+    const __m256i mapped =
+        _mm256_andnot_si256(equal4(ip4, 0), _mm256_or_si256(ip4, _mm256_set1_epi64x(int64_t(C_MID_MAPPED))));
+    columns.low   = _mm256_blendv_epi8(columns.low, mapped, lanes);
+    columns.third = _mm256_blendv_epi8(columns.third, _mm256_shuffle_epi8(ip4, swap), lanes);
+    storeColumns4(_addresses + i, columns);
+    converted += std::size_t(std::popcount(unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(lanes)))));
+  }
+  return converted + normalizeBaseline<Mode>(_addresses + i, _count - i);
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+// Eight addresses as columns, conditions in mask registers
+struct Columns8 {
+  __m512i high;
+  __m512i low;
+  __m512i third;
+};
+
+KT_TARGET_AVX512 inline Columns8 columns8(const Address *_addresses) {
+  // Words a0 b0 c0 a1 b1 c1 a2 b2 | c2 a3 b3 c3 a4 b4 c4 a5 | b5 c5 a6 b6 c6 a7 b7 c7: the first
+  // permute takes five or six words of a column from the first two vectors, the second the rest
+  const auto *words = reinterpret_cast<const __m512i *>(_addresses);
+  const __m512i r0  = _mm512_loadu_si512(words);
+  const __m512i r1  = _mm512_loadu_si512(words + 1);
+  const __m512i r2  = _mm512_loadu_si512(words + 2);
+  const __m512i a   = _mm512_permutex2var_epi64(r0, _mm512_set_epi64(0, 0, 15, 12, 9, 6, 3, 0), r1);
+  const __m512i b   = _mm512_permutex2var_epi64(r0, _mm512_set_epi64(0, 0, 0, 13, 10, 7, 4, 1), r1);
+  const __m512i c   = _mm512_permutex2var_epi64(r0, _mm512_set_epi64(0, 0, 0, 14, 11, 8, 5, 2), r1);
+  return {_mm512_permutex2var_epi64(a, _mm512_set_epi64(13, 10, 5, 4, 3, 2, 1, 0), r2),
+          _mm512_permutex2var_epi64(b, _mm512_set_epi64(14, 11, 8, 4, 3, 2, 1, 0), r2),
+          _mm512_permutex2var_epi64(c, _mm512_set_epi64(15, 12, 9, 4, 3, 2, 1, 0), r2)};
+}
+
+// Writes the second and third words of the addresses in _lanes back; the first word of a
+// converted address is zero already
+KT_TARGET_AVX512 inline void storeColumns8(Address *_addresses, __m512i _low, __m512i _third, __mmask8 _lanes) {
+  // Words 3 * i + 1 and 3 * i + 2 of every lane i, over the three vectors of rows
+  uint32_t words = _pdep_u32(_lanes, 0x492492U);
+  words |= words << 1U;
+  auto *rows = reinterpret_cast<__m512i *>(_addresses);
+  // Second words are indices 0 to 7 of the permutes, third words 8 to 15; first words are left out
+  _mm512_mask_storeu_epi64(rows, __mmask8(words),
+      _mm512_permutex2var_epi64(_low, _mm512_set_epi64(2, 0, 9, 1, 0, 8, 0, 0), _third));
+  _mm512_mask_storeu_epi64(rows + 1, __mmask8(words >> 8U),
+      _mm512_permutex2var_epi64(_low, _mm512_set_epi64(0, 12, 4, 0, 11, 3, 0, 10), _third));
+  _mm512_mask_storeu_epi64(rows + 2, __mmask8(words >> 16U),
+      _mm512_permutex2var_epi64(_low, _mm512_set_epi64(15, 7, 0, 14, 6, 0, 13, 5), _third));
+}
+
+KT_TARGET_AVX512 inline __mmask8 equal8(__m512i _a, uint64_t _value) {
+  return _mm512_cmpeq_epi64_mask(_a, _mm512_set1_epi64(int64_t(_value)));
+}
+
+KT_TARGET_AVX512 inline __mmask8 masked8(__m512i _a, uint64_t _mask, uint64_t _value) {
+  return equal8(_mm512_and_si512(_a, _mm512_set1_epi64(int64_t(_mask))), _value);
+}
+
+template <unsigned Mode>
+KT_TARGET_AVX512 KT_FLATTEN std::size_t normalizeAvx512(Address *_addresses, std::size_t _count) {
+  const __m512i swap = _mm512_set4_epi32(-1, 0x0c0d0e0f, -1, 0x04050607);
+  std::size_t converted = 0;
+  std::size_t i         = 0;
+  for (; i + 8 <= _count; i += 8) {
+    const Columns8 columns   = columns8(_addresses + i);
+    const __mmask8 loopback6 = equal8(columns.low, C_LOOPBACK6);
+    __mmask8 lanes           = 0;
+    if constexpr ((Mode & C_MAPPED) != 0) lanes |= masked8(columns.low, C_MID_MASK, C_MID_MAPPED);
+    if constexpr ((Mode & C_COMPAT) != 0) {
+      lanes |= __mmask8(~loopback6 & _mm512_testn_epi64_mask(columns.low, _mm512_set1_epi64(int64_t(C_MID_MASK))));
+    }
+    if constexpr ((Mode & C_UNSPECIFIED) != 0) lanes |= _mm512_testn_epi64_mask(columns.low, columns.low);
+    if constexpr ((Mode & C_LOCAL_HOST) != 0) lanes |= loopback6;
+    lanes &= _mm512_testn_epi64_mask(columns.high, columns.high) &
+             masked8(columns.third, uint64_t(0xff) << 32U, uint64_t(C_PROTO_IPv6) << 32U);
+
+    __m512i ip4 = _mm512_and_si512(columns.low, _mm512_set1_epi64(int64_t(C_IP4_MASK)));
+    if constexpr ((Mode & C_LOCAL_HOST) != 0) {
+      ip4 = _mm512_mask_mov_epi64(ip4, loopback6, _mm512_set1_epi64(int64_t(C_LOOPBACK4)));
+    }
+    const __m512i mapped = _mm512_maskz_or_epi64(_mm512_test_epi64_mask(ip4, ip4), ip4,
+        _mm512_set1_epi64(int64_t(C_MID_MAPPED)));
+    storeColumns8(_addresses + i, mapped, _mm512_shuffle_epi8(ip4, swap), lanes);
+    converted += std::size_t(std::popcount(unsigned(lanes)));
+  }
+  return converted + normalizeBaseline<Mode>(_addresses + i, _count - i);
+}
+#endif
+
+using Kernel      = std::size_t (*)(Address *, std::size_t);
+using KernelTable = std::array<Kernel, C_MODES>;
+
+template <template <unsigned> class Level, std::size_t... Modes>
+constexpr KernelTable makeTable(std::index_sequence<Modes...>) {
+  return {Level<Modes>::kernel...};
+}
+
+template <unsigned Mode>
+struct Baseline {
+  static constexpr Kernel kernel = normalizeBaseline<Mode>;
+};
+constexpr KernelTable C_BASELINE = makeTable<Baseline>(std::make_index_sequence<C_MODES>());
+
+#if defined(KT_KERNELS_AVX2)
+template <unsigned Mode>
+struct Avx2 {
+  static constexpr Kernel kernel = normalizeAvx2<Mode>;
+};
+constexpr KernelTable C_AVX2 = makeTable<Avx2>(std::make_index_sequence<C_MODES>());
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+template <unsigned Mode>
+struct Avx512 {
+  static constexpr Kernel kernel = normalizeAvx512<Mode>;
+};
+constexpr KernelTable C_AVX512 = makeTable<Avx512>(std::make_index_sequence<C_MODES>());
+#endif
+
+}  // namespace
+
+std::size_t Address::normalize(std::span<Address> _addresses, Flags<Conversion> _mode) noexcept {
+#if defined(KT_RUNTIME_DISPATCH)
+  static const KernelTable *const kernels =
+      qResolveKernel<const KernelTable *>(&C_BASELINE, nullptr, &C_AVX2, &C_AVX512);
+#elif defined(KT_COMPILER_SUPPORTS_AVX512)
+  static const KernelTable *const kernels = &C_AVX512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+  static const KernelTable *const kernels = &C_AVX2;
+#else
+  static const KernelTable *const kernels = &C_BASELINE;
+#endif
+  return (*kernels)[_mode.underlying() % C_MODES](_addresses.data(), _addresses.size());
+}
+
+}  // namespace network
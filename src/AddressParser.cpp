@@ -0,0 +1,361 @@
+#include "AddressParser.hpp"
+
+#include <bit>
+#include <cstring>
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+// Bit i of every mask describes character i of the text
+struct CharMasks {
+  uint64_t digit;
+  uint64_t hex;
+  uint64_t colon;
+  uint64_t dot;
+};
+
+template <std::size_t N>
+struct PaddedText {
+  alignas(64) char c[N];
+};
+
+// Copies the text into the zero-filled block, from which the kernels load N bytes. Loading them
+// from the text itself would read past its end, which memory checkers (ASan, HWASan, MSan,
+// valgrind) report and AArch64 memory tagging faults on, even within the page; the copy is at most
+// 64 bytes. Kernels mask everything past the text length.
+template <std::size_t N>
+inline const char *paddedText(std::string_view _text, PaddedText<N> &_buf) {
+  if (_text.size() > N) return nullptr;
+  std::memset(_buf.c, 0, N);
+  std::memcpy(_buf.c, _text.data(), _text.size());
+  return _buf.c;
+}
+
+constexpr uint64_t lowBits(std::size_t _count) { return _count >= 64 ? ~uint64_t(0) : (uint64_t(1) << _count) - 1; }
+
+#if defined(KT_COMPILER_SUPPORTS_SSE2)
+inline void classify16(const char *_data, CharMasks &_masks, unsigned _shift) {
+  const __m128i c     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_data));
+  const __m128i d     = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  const __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+  const __m128i l     = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  const __m128i alpha = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+  const __m128i colon = _mm_cmpeq_epi8(c, _mm_set1_epi8(':'));
+  const __m128i dot   = _mm_cmpeq_epi8(c, _mm_set1_epi8('.'));
+
+  _masks.digit |= uint64_t(uint16_t(_mm_movemask_epi8(digit))) << _shift;
+  _masks.hex |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_or_si128(digit, alpha)))) << _shift;
+  _masks.colon |= uint64_t(uint16_t(_mm_movemask_epi8(colon))) << _shift;
+  _masks.dot |= uint64_t(uint16_t(_mm_movemask_epi8(dot))) << _shift;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+KT_TARGET_AVX2 inline void classify32(const char *_data, CharMasks &_masks, unsigned _shift) {
+  const __m256i c     = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_data));
+  const __m256i d     = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+  const __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+  const __m256i l     = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  const __m256i alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(5)), l);
+  const __m256i colon = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(':'));
+  const __m256i dot   = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'));
+
+  _masks.digit |= uint64_t(uint32_t(_mm256_movemask_epi8(digit))) << _shift;
+  _masks.hex |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)))) << _shift;
+  _masks.colon |= uint64_t(uint32_t(_mm256_movemask_epi8(colon))) << _shift;
+  _masks.dot |= uint64_t(uint32_t(_mm256_movemask_epi8(dot))) << _shift;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+// The mask registers hold one bit per byte, the layout CharMasks wants
+KT_TARGET_AVX512 inline void classify64(const char *_data, CharMasks &_masks) {
+  const __m512i c       = _mm512_loadu_si512(_data);
+  const __m512i d       = _mm512_sub_epi8(c, _mm512_set1_epi8('0'));
+  const __m512i l       = _mm512_sub_epi8(_mm512_or_si512(c, _mm512_set1_epi8(0x20)), _mm512_set1_epi8('a'));
+  const __mmask64 digit = _mm512_cmple_epu8_mask(d, _mm512_set1_epi8(9));
+  const __mmask64 alpha = _mm512_cmple_epu8_mask(l, _mm512_set1_epi8(5));
+
+  _masks.digit = _cvtmask64_u64(digit);
+  _masks.hex   = _cvtmask64_u64(_kor_mask64(digit, alpha));
+  _masks.colon = _cvtmask64_u64(_mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8(':')));
+  _masks.dot   = _cvtmask64_u64(_mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('.')));
+}
+#endif
+
+#if defined(KT_COMPILER_SUPPORTS_NEON)
+inline uint64_t movemask16(uint8x16_t _mask) {
+  const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t t          = vandq_u8(_mask, bits);
+  t                     = vpaddq_u8(t, t);
+  t                     = vpaddq_u8(t, t);
+  t                     = vpaddq_u8(t, t);
+  return vgetq_lane_u16(vreinterpretq_u16_u8(t), 0);
+}
+
+inline void classify16(const char *_data, CharMasks &_masks, unsigned _shift) {
+  const uint8x16_t c     = vld1q_u8(reinterpret_cast<const uint8_t *>(_data));
+  const uint8x16_t digit = vcltq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(10));
+  const uint8x16_t alpha = vcltq_u8(vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a')), vdupq_n_u8(6));
+
+  _masks.digit |= movemask16(digit) << _shift;
+  _masks.hex |= movemask16(vorrq_u8(digit, alpha)) << _shift;
+  _masks.colon |= movemask16(vceqq_u8(c, vdupq_n_u8(':'))) << _shift;
+  _masks.dot |= movemask16(vceqq_u8(c, vdupq_n_u8('.'))) << _shift;
+}
+#endif
+
+// Level selects the widest kernel; it is only above the build's level inside a KT_TARGET_* entry point
+template <SimdLevel Level, std::size_t N>
+inline CharMasks classifyChars(const char *_text, std::size_t _len) {
+  static_assert(N % 16 == 0 && N <= 64, "masks are 64 bits wide");
+  CharMasks masks {0, 0, 0, 0};
+#if defined(KT_KERNELS_AVX512)
+  if constexpr (Level >= SimdLevel::AVX512 && N == 64) {
+    classify64(_text, masks);
+  } else
+#endif
+#if defined(KT_KERNELS_AVX2)
+  if constexpr (Level >= SimdLevel::AVX2 && N >= 32) {
+    for (unsigned i = 0; i < N; i += 32) classify32(_text + i, masks, i);
+  } else
+#endif
+  {
+#if defined(KT_COMPILER_SUPPORTS_SSE2) || defined(KT_COMPILER_SUPPORTS_NEON)
+    for (unsigned i = 0; i < N; i += 16) classify16(_text + i, masks, i);
+#else
+    for (unsigned i = 0; i < N; ++i) {
+      const auto c       = uint8_t(_text[i]);
+      const uint64_t bit = uint64_t(1) << i;
+      const bool digit   = uint8_t(c - '0') < 10;
+      masks.digit |= digit ? bit : 0;
+      masks.hex |= (digit || uint8_t((c | 0x20U) - 'a') < 6) ? bit : 0;
+      masks.colon |= c == ':' ? bit : 0;
+      masks.dot |= c == '.' ? bit : 0;
+    }
+#endif
+  }
+  // Bytes past the end of the text are arbitrary
+  const uint64_t valid = lowBits(_len);
+  masks.digit &= valid;
+  masks.hex &= valid;
+  masks.colon &= valid;
+  masks.dot &= valid;
+  return masks;
+}
+
+// Converts 1-4 hex digits, already validated by the masks
+inline uint16_t hexGroup(const char *_text, unsigned _len) {
+  unsigned value = 0;
+  for (unsigned i = 0; i < _len; ++i) {
+    const auto c = uint8_t(_text[i]);
+    value        = (value << 4U) | ((c & 0xfU) + 9U * (c >> 6U));
+  }
+  return uint16_t(value);
+}
+
+// Validates the shape of a dotted quad and locates its four fields
+inline bool splitIPv4(const char *_text, std::size_t _len, const CharMasks &_masks, uint64_t _fieldMask,
+    unsigned (&_start)[4], unsigned (&_size)[4]) {
+  if (((_masks.digit | _masks.dot) & _fieldMask) != _fieldMask) return false;
+  uint64_t dots = _masks.dot & _fieldMask;
+  if (std::popcount(dots) != 3) return false;
+
+  unsigned begin = std::countr_zero(_fieldMask);
+  for (unsigned i = 0; i < 4; ++i) {
+    const unsigned end = i < 3 ? unsigned(std::countr_zero(dots)) : unsigned(_len);
+    dots &= dots - 1;
+    const unsigned size = end - begin;
+    if (size - 1 > 2) return false;                     // 1..3 digits
+    if (size > 1 && _text[begin] == '0') return false;  // no leading zeros
+    _start[i] = begin;
+    _size[i]  = size;
+    begin     = end + 1;
+  }
+  return true;
+}
+
+#if defined(KT_KERNELS_SSE4_2)
+KT_TARGET_SSE4_2 inline bool convertIPv4Shuffle(
+    const char *_text, const unsigned (&_start)[4], const unsigned (&_size)[4], uint32_t &_ip4) {
+  // Gather every field right-aligned into its own 32-bit lane as [hundreds, tens, units, 0].
+  // The control vector is assembled in registers: spilling it to memory stalls the load.
+  uint32_t ctrl[4];
+  for (unsigned i = 0; i < 4; ++i) {
+    const uint32_t last = _start[i] + _size[i] - 1;
+    const uint32_t hundreds = _size[i] == 3 ? last - 2 : 0x80U;
+    const uint32_t tens     = _size[i] >= 2 ? last - 1 : 0x80U;
+    ctrl[i]                 = hundreds | (tens << 8U) | (last << 16U) | 0x80000000U;
+  }
+  const __m128i text   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_text));
+  const __m128i digits = _mm_shuffle_epi8(
+      _mm_sub_epi8(text, _mm_set1_epi8('0')), _mm_setr_epi32(int(ctrl[0]), int(ctrl[1]), int(ctrl[2]), int(ctrl[3])));
+  const __m128i weights = _mm_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0, 100, 10, 1, 0, 100, 10, 1, 0);
+  const __m128i fields  = _mm_madd_epi16(_mm_maddubs_epi16(digits, weights), _mm_set1_epi16(1));
+  if (_mm_movemask_epi8(_mm_cmpgt_epi32(fields, _mm_set1_epi32(255)))) return false;
+
+  const __m128i bytes = _mm_packus_epi16(_mm_packus_epi32(fields, fields), fields);
+  _ip4                = qFromBigEndian(uint32_t(_mm_cvtsi128_si32(bytes)));
+  return true;
+}
+#endif
+
+inline bool convertIPv4Scalar(
+    const char *_text, const unsigned (&_start)[4], const unsigned (&_size)[4], uint32_t &_ip4) {
+  uint32_t ip4 = 0;
+  for (unsigned i = 0; i < 4; ++i) {
+    unsigned value = 0;
+    for (unsigned j = 0; j < _size[i]; ++j) value = value * 10 + unsigned(_text[_start[i] + j] - '0');
+    if (value > 255) return false;
+    ip4 = (ip4 << 8U) | value;
+  }
+  _ip4 = ip4;
+  return true;
+}
+
+// Parses the IPv4 tail of an IPv6 address, located at [_begin, _len) of the padded text
+template <SimdLevel Level>
+inline bool parseEmbeddedIPv4(
+    const char *_text, std::size_t _len, const CharMasks &_masks, unsigned _begin, uint32_t &_ip4) {
+  unsigned start[4];
+  unsigned size[4];
+  if (!splitIPv4(_text, _len, _masks, lowBits(_len) & ~lowBits(_begin), start, size)) return false;
+#if defined(KT_KERNELS_SSE4_2)
+  if constexpr (Level >= SimdLevel::SSE4_2) {
+    // Rebase so the whole quad sits in one 16-byte load
+    for (unsigned i = 0; i < 4; ++i) start[i] -= _begin;
+    return convertIPv4Shuffle(_text + _begin, start, size, _ip4);
+  }
+#endif
+  return convertIPv4Scalar(_text, start, size, _ip4);
+}
+
+template <SimdLevel Level>
+inline bool parseIPv4Text(std::string_view _text, uint32_t &_ip4) {
+  PaddedText<16> buf;
+  // Shortest "0.0.0.0", longest "255.255.255.255"
+  const char *text = _text.size() < 7 ? nullptr : paddedText(_text, buf);
+  if (!text) return false;
+
+  const CharMasks masks = classifyChars<Level, 16>(text, _text.size());
+  unsigned start[4];
+  unsigned size[4];
+  if (!splitIPv4(text, _text.size(), masks, lowBits(_text.size()), start, size)) return false;
+#if defined(KT_KERNELS_SSE4_2)
+  if constexpr (Level >= SimdLevel::SSE4_2) return convertIPv4Shuffle(text, start, size, _ip4);
+#endif
+  return convertIPv4Scalar(text, start, size, _ip4);
+}
+
+template <SimdLevel Level>
+inline bool parseIPv6Text(std::string_view _text, uint8_t *_ip6) {
+  PaddedText<64> buf;
+  const std::size_t len = _text.size();
+  const char *text      = len < 2 || len > C_MAX_ADDRESS_TEXT ? nullptr : paddedText(_text, buf);
+  if (!text) return false;
+
+  const CharMasks masks = classifyChars<Level, 64>(text, len);
+  if ((masks.hex | masks.colon | masks.dot) != lowBits(len)) return false;
+  // At most one "::" and never ":::"
+  const uint64_t doubleColon = masks.colon & (masks.colon >> 1U);
+  if (std::popcount(doubleColon) > 1) return false;
+  if (text[0] == ':' && text[1] != ':') return false;
+
+  uint16_t groups[8];
+  unsigned count = 0;
+  int gap        = -1;
+  unsigned pos   = 0;
+  if (doubleColon & 1U) {
+    gap = 0;
+    pos = 2;
+  }
+
+  while (pos < len) {
+    const uint64_t colons = masks.colon & ~lowBits(pos);
+    const unsigned end    = colons ? unsigned(std::countr_zero(colons)) : unsigned(len);
+    const unsigned size   = end - pos;
+    if (masks.dot & lowBits(end) & ~lowBits(pos)) {
+      // Embedded IPv4 must be the last field and take the place of two groups
+      uint32_t ip4 = 0;
+      if (end != len || count > 6 || !parseEmbeddedIPv4<Level>(text, len, masks, pos, ip4)) return false;
+      groups[count++] = uint16_t(ip4 >> 16U);
+      groups[count++] = uint16_t(ip4);
+      break;
+    }
+    if (size - 1 > 3 || count == 8) return false;  // 1..4 hex digits
+    groups[count++] = hexGroup(text + pos, size);
+    if (end == len) break;
+
+    if (doubleColon & (uint64_t(1) << end)) {
+      gap = int(count);
+      pos = end + 2;
+    } else {
+      pos = end + 1;
+      if (pos == len) return false;  // trailing single colon
+    }
+  }
+
+  if (gap < 0 ? count != 8 : count > 7) return false;
+
+  uint16_t expanded[8] = {};
+  const unsigned head  = gap < 0 ? count : unsigned(gap);
+  const unsigned tail  = count - head;
+  std::memcpy(expanded, groups, head * sizeof(uint16_t));
+  std::memcpy(expanded + 8 - tail, groups + head, tail * sizeof(uint16_t));
+  for (auto &group : expanded) group = qToBigEndian(group);
+  std::memcpy(_ip6, expanded, sizeof(expanded));
+  return true;
+}
+
+#if defined(KT_RUNTIME_DISPATCH)
+using ParseIPv4 = bool (*)(std::string_view, uint32_t &);
+using ParseIPv6 = bool (*)(std::string_view, uint8_t *);
+
+// One entry point per level, each with the whole parser inlined and compiled for that level
+KT_TARGET_SSE4_2 KT_FLATTEN bool parseIPv4Sse42(std::string_view _text, uint32_t &_ip4) {
+  return parseIPv4Text<SimdLevel::SSE4_2>(_text, _ip4);
+}
+KT_TARGET_AVX2 KT_FLATTEN bool parseIPv4Avx2(std::string_view _text, uint32_t &_ip4) {
+  return parseIPv4Text<SimdLevel::AVX2>(_text, _ip4);
+}
+KT_TARGET_AVX512 KT_FLATTEN bool parseIPv4Avx512(std::string_view _text, uint32_t &_ip4) {
+  return parseIPv4Text<SimdLevel::AVX512>(_text, _ip4);
+}
+KT_TARGET_SSE4_2 KT_FLATTEN bool parseIPv6Sse42(std::string_view _text, uint8_t *_ip6) {
+  return parseIPv6Text<SimdLevel::SSE4_2>(_text, _ip6);
+}
+KT_TARGET_AVX2 KT_FLATTEN bool parseIPv6Avx2(std::string_view _text, uint8_t *_ip6) {
+  return parseIPv6Text<SimdLevel::AVX2>(_text, _ip6);
+}
+KT_TARGET_AVX512 KT_FLATTEN bool parseIPv6Avx512(std::string_view _text, uint8_t *_ip6) {
+  return parseIPv6Text<SimdLevel::AVX512>(_text, _ip6);
+}
+#endif
+
+}  // namespace
+
+bool parseIPv4(std::string_view _text, uint32_t &_ip4) {
+#if defined(KT_RUNTIME_DISPATCH)
+  static const ParseIPv4 kernel =
+      qResolveKernel<ParseIPv4>(parseIPv4Text<C_COMPILER_SIMD_LEVEL>, parseIPv4Sse42, parseIPv4Avx2, parseIPv4Avx512);
+  return kernel(_text, _ip4);
+#else
+  return parseIPv4Text<C_COMPILER_SIMD_LEVEL>(_text, _ip4);
+#endif
+}
+
+bool parseIPv6(std::string_view _text, uint8_t *_ip6) {
+#if defined(KT_RUNTIME_DISPATCH)
+  static const ParseIPv6 kernel =
+      qResolveKernel<ParseIPv6>(parseIPv6Text<C_COMPILER_SIMD_LEVEL>, parseIPv6Sse42, parseIPv6Avx2, parseIPv6Avx512);
+  return kernel(_text, _ip6);
+#else
+  return parseIPv6Text<C_COMPILER_SIMD_LEVEL>(_text, _ip6);
+#endif
+}
+
+}  // namespace network
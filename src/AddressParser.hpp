@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace network {
+
+//! Longest accepted textual address ("ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255")
+constexpr std::size_t C_MAX_ADDRESS_TEXT = 45;
+
+//! Parse a dotted-quad IPv4 address
+/*!
+    Accepts exactly four decimal fields of 1-3 digits in the range 0-255 separated by dots,
+    without leading zeros (the same grammar as inet_pton(AF_INET)).
+
+    \param _text - Text to parse, not required to be null-terminated
+    \param _ip4 - Result in host byte order, untouched on failure
+    \return true if \a _text is a valid IPv4 address
+*/
+bool parseIPv4(std::string_view _text, uint32_t &_ip4);
+
+//! Parse an IPv6 address in full, compressed or IPv4-embedded ("::ffff:a.b.c.d") form
+/*!
+    Accepts the RFC 4291 section 2.2 text forms, case-insensitive. Zone identifiers are not accepted.
+
+    \param _text - Text to parse, not required to be null-terminated
+    \param _ip6 - 16 bytes receiving the address in network byte order, untouched on failure
+    \return true if \a _text is a valid IPv6 address
+*/
+bool parseIPv6(std::string_view _text, uint8_t *_ip6);
+
+}  // namespace network
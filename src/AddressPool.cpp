@@ -0,0 +1,235 @@
+#include "AddressPool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include "Endian.hpp"
+#include "Uint128.hpp"
+
+namespace network {
+
+namespace {
+
+using detail::Uint128;
+
+constexpr std::size_t C_WORD_BITS = 64;
+
+Uint128 toUint128(const Address &_address) {
+  const IPv6Address ip6 = _address.toIPv6Address();
+  return {qFromBigEndian<uint64_t>(ip6.c), qFromBigEndian<uint64_t>(ip6.c + 8)};
+}
+
+// Free bits of a bitmap word from bit _first to bit _last, both included
+constexpr uint64_t bitRange(std::size_t _first, std::size_t _last) {
+  return (~uint64_t(0) >> (C_WORD_BITS - 1 - _last)) & (~uint64_t(0) << _first);
+}
+
+// Word _index of a level of _bits bits with everything free, a bit per address or word below
+uint64_t freeWord(std::size_t _bits, std::size_t _index) {
+  const std::size_t tail = _bits % C_WORD_BITS;
+  return tail != 0 && _index == _bits / C_WORD_BITS ? bitRange(0, tail - 1) : ~uint64_t(0);
+}
+
+}  // namespace
+
+AddressPool::AddressPool(const AddressPrefix &_prefix, std::size_t _size) : prefix_(_prefix) {
+  if (_prefix.isNull()) return;
+  const int hostBits = (_prefix.getProtocol() == LayerProtocol::IPv4 ? 32 : 128) - _prefix.getPrefixLength();
+  size_              = std::min(_size, C_MAX_SIZE);
+  if (hostBits < 64) size_ = std::min(size_, std::size_t(uint64_t(1) << unsigned(hostBits)));
+  available_ = size_;
+  if (size_ == 0) return;
+
+  // Every address starts free: dense words set, blocks missing
+  for (std::size_t bits = size_;; bits = (bits + C_WORD_BITS - 1) / C_WORD_BITS) {
+    const std::size_t words = (bits + C_WORD_BITS - 1) / C_WORD_BITS;
+    if (words > C_DENSE_WORDS) {
+      levels_.emplace_back();
+      blocks_.push_back({bits, {}});
+    } else {
+      std::vector<uint64_t> &level = levels_.emplace_back(words, ~uint64_t(0));
+      level.back()                 = freeWord(bits, words - 1);
+    }
+    if (words == 1) break;
+  }
+}
+
+uint64_t AddressPool::blockWord(std::size_t _level, std::size_t _index) const {
+  const BlockLevel &level = blocks_[_level];
+  const auto block        = level.blocks.find(_index / C_WORD_BITS);
+  return block != level.blocks.end() ? block->second->words[_index % C_WORD_BITS] : freeWord(level.bits, _index);
+}
+
+uint64_t AddressPool::updateBlock(std::size_t _level, std::size_t _index, uint64_t _and, uint64_t _or) {
+  BlockLevel &level      = blocks_[_level];
+  const std::size_t b    = _index / C_WORD_BITS;
+  const uint64_t allFree = freeWord(level.bits, _index);
+  auto block             = level.blocks.find(b);
+  const uint64_t old     = block != level.blocks.end() ? block->second->words[_index % C_WORD_BITS] : allFree;
+  const uint64_t word    = (old & _and) | _or;
+  if (word == old) return old;
+
+  if (block == level.blocks.end()) {
+    auto created = std::make_unique<Block>();
+    std::fill(std::begin(created->words), std::end(created->words), ~uint64_t(0));
+    const std::size_t last = (level.bits + C_WORD_BITS - 1) / C_WORD_BITS - 1;
+    if (last / C_WORD_BITS == b) created->words[last % C_WORD_BITS] = freeWord(level.bits, last);
+    block = level.blocks.emplace(b, std::move(created)).first;
+  }
+  block->second->words[_index % C_WORD_BITS] = word;
+  block->second->partial += std::size_t(word != allFree) - std::size_t(old != allFree);
+  // All free again: back to a missing block
+  if (block->second->partial == 0) level.blocks.erase(block);
+  return old;
+}
+
+std::size_t AddressPool::offsetOf(const Address &_address) const {
+  if (!prefix_.contains(_address)) return size_;
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    const std::size_t offset = _address.toIPv4Address() - prefix_.getAddress().toIPv4Address();
+    return offset < size_ ? offset : size_;
+  }
+  const Uint128 offset = toUint128(_address) - toUint128(prefix_.getAddress());
+  return offset.hi == 0 && offset.lo < size_ ? std::size_t(offset.lo) : size_;
+}
+
+Address AddressPool::addressAt(std::size_t _offset) const {
+  if (prefix_.getProtocol() == LayerProtocol::IPv4) {
+    return Address(uint32_t(prefix_.getAddress().toIPv4Address() + _offset));
+  }
+  const Uint128 value = toUint128(prefix_.getAddress()) + Uint128 {0, _offset};
+  IPv6Address ip6;
+  qToBigEndian(value.hi, ip6.c);
+  qToBigEndian(value.lo, ip6.c + 8);
+  return Address(ip6);
+}
+
+std::size_t AddressPool::markBlocks(std::size_t &_offset, bool _free) {
+  for (std::size_t level = 0; level < blocks_.size(); ++level) {
+    const uint64_t bit = uint64_t(1) << (_offset % C_WORD_BITS);
+    const uint64_t old = updateBlock(level, _offset / C_WORD_BITS, _free ? ~uint64_t(0) : ~bit, _free ? bit : 0);
+    // The summary bit above only changes when the word was, or becomes, full
+    if ((_free ? old : old & ~bit) != 0) return levels_.size();
+    _offset /= C_WORD_BITS;
+  }
+  return blocks_.size();
+}
+
+void AddressPool::use(std::size_t _offset) {
+  --available_;
+  // Clear the bit, and the summary bit above each word that became full
+  for (std::size_t level = blocks_.empty() ? 0 : markBlocks(_offset, false); level < levels_.size(); ++level) {
+    uint64_t &word = levels_[level][_offset / C_WORD_BITS];
+    word &= ~(uint64_t(1) << (_offset % C_WORD_BITS));
+    if (word != 0) return;
+    _offset /= C_WORD_BITS;
+  }
+}
+
+void AddressPool::refresh(std::size_t _first, std::size_t _last) {
+  for (std::size_t level = 1; level < levels_.size(); ++level) {
+    const std::size_t below    = level - 1;
+    const std::size_t children = below < blocks_.size() ? (blocks_[below].bits + C_WORD_BITS - 1) / C_WORD_BITS
+                                                        : levels_[below].size();
+    _first /= C_WORD_BITS;
+    _last /= C_WORD_BITS;
+    for (std::size_t i = _first; i <= _last; ++i) {
+      uint64_t word           = 0;
+      const std::size_t child = i * C_WORD_BITS;
+      const std::size_t end   = std::min(children, child + C_WORD_BITS);
+      for (std::size_t c = child; c < end; ++c) word |= uint64_t(this->word(below, c) != 0) << (c - child);
+      update(level, i, 0, word);
+    }
+  }
+}
+
+Address AddressPool::allocate() {
+  if (available_ == 0) return {};
+  std::size_t offset = 0;
+  for (std::size_t level = levels_.size(); level-- > blocks_.size();) {
+    offset = offset * C_WORD_BITS + std::size_t(std::countr_zero(levels_[level][offset]));
+  }
+  for (std::size_t level = blocks_.size(); level-- > 0;) {
+    offset = offset * C_WORD_BITS + std::size_t(std::countr_zero(blockWord(level, offset)));
+  }
+  use(offset);
+  return addressAt(offset);
+}
+
+Address AddressPool::allocate(uint64_t _client) {
+  const auto sticky = sticky_.find(_client);
+  if (sticky != sticky_.end() && isFreeAt(sticky->second)) {
+    use(sticky->second);
+    return addressAt(sticky->second);
+  }
+  const Address address = allocate();
+  if (!address.isNull()) sticky_[_client] = offsetOf(address);
+  return address;
+}
+
+bool AddressPool::claim(const Address &_address) {
+  const std::size_t offset = offsetOf(_address);
+  if (offset == size_ || !isFreeAt(offset)) return false;
+  use(offset);
+  return true;
+}
+
+bool AddressPool::release(const Address &_address) {
+  std::size_t offset = offsetOf(_address);
+  if (offset == size_ || isFreeAt(offset) || isReservedAt(offset)) return false;
+  ++available_;
+  // Set the bit, and the summary bit above each word that was full
+  for (std::size_t level = blocks_.empty() ? 0 : markBlocks(offset, true); level < levels_.size(); ++level) {
+    uint64_t &word      = levels_[level][offset / C_WORD_BITS];
+    const bool wasEmpty = word == 0;
+    word |= uint64_t(1) << (offset % C_WORD_BITS);
+    if (!wasEmpty) break;
+    offset /= C_WORD_BITS;
+  }
+  return true;
+}
+
+bool AddressPool::reserve(const Address &_first, const Address &_last) {
+  const std::size_t first = offsetOf(_first);
+  const std::size_t last  = offsetOf(_last);
+  if (first == size_ || last == size_ || first > last) return false;
+
+  for (std::size_t w = first / C_WORD_BITS; w <= last / C_WORD_BITS; ++w) {
+    const std::size_t low  = w == first / C_WORD_BITS ? first % C_WORD_BITS : 0;
+    const std::size_t high = w == last / C_WORD_BITS ? last % C_WORD_BITS : C_WORD_BITS - 1;
+    const uint64_t mask    = bitRange(low, high);
+    available_ -= std::size_t(std::popcount(update(0, w, ~mask, 0) & mask));
+  }
+  refresh(first / C_WORD_BITS, last / C_WORD_BITS);
+
+  // Insert, then merge with overlapping or adjacent ranges
+  reserved_.insert(std::upper_bound(reserved_.begin(), reserved_.end(), std::pair {first, last}), {first, last});
+  std::vector<std::pair<std::size_t, std::size_t>> merged;
+  for (const auto &range : reserved_) {
+    if (!merged.empty() && range.first <= merged.back().second + 1) {
+      merged.back().second = std::max(merged.back().second, range.second);
+    } else {
+      merged.push_back(range);
+    }
+  }
+  reserved_ = std::move(merged);
+  return true;
+}
+
+bool AddressPool::isFree(const Address &_address) const {
+  const std::size_t offset = offsetOf(_address);
+  return offset != size_ && isFreeAt(offset);
+}
+
+bool AddressPool::isReserved(const Address &_address) const {
+  const std::size_t offset = offsetOf(_address);
+  return offset != size_ && isReservedAt(offset);
+}
+
+bool AddressPool::isReservedAt(std::size_t _offset) const {
+  const auto next = std::upper_bound(reserved_.begin(), reserved_.end(), _offset,
+      [](std::size_t _value, const std::pair<std::size_t, std::size_t> &_range) { return _value < _range.first; });
+  return next != reserved_.begin() && std::prev(next)->second >= _offset;
+}
+
+}  // namespace network
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "AddressPrefix.hpp"
+#include "global/CompilerDetection.hpp"
+
+namespace network {
+
+//! Free and used addresses of a subnet, for handing out leases
+/*!
+    Manages the first size() addresses of a prefix, at most C_MAX_SIZE. Each address is one bit
+    of a bitmap, set while it is free, under a summary level with one bit per bitmap word that
+    still has a free address, and so on up to a single word. allocate() follows the lowest set
+    bit from the top word down (a tzcnt per level, at most six levels), so allocation and release
+    take constant time however full the pool is.
+
+    Levels of up to C_DENSE_WORDS words, all of them for pools of up to 2^24 addresses, are
+    plain arrays. Larger ones are stored in blocks of 64 words, allocated when one of their words
+    loses a bit and dropped when all is free again, a missing block standing for all free. A new
+    pool thus takes at most about 2 MiB whatever its size (about 130 KiB for the default 2^32
+    addresses of an IPv6 prefix), and a large one grows by about 600 bytes per block of 4096
+    addresses in use (used or reserved), plus one map entry per client of sticky allocations.
+    IPv6 prefixes are limited to the \a _size first addresses given to the constructor.
+
+    \code{.cpp}
+    using namespace network::literals;
+
+    AddressPool pool("192.168.0.0/24"_cidr);
+    pool.reserve("192.168.0.0"_ip, "192.168.0.9"_ip);  // network address and static hosts
+    pool.reserve("192.168.0.255"_ip);                  // broadcast
+    const Address lease = pool.allocate(clientId);     // the client's previous address when free
+    \endcode
+
+    Nothing is reserved implicitly, not even the network and broadcast addresses of an IPv4
+    subnet. Not thread-safe.
+*/
+class AddressPool {
+public:
+  static constexpr std::size_t C_MAX_SIZE = std::size_t(1) << 32U;
+
+  AddressPool() = default;
+  //! Pool of the first \a _size addresses of \a _prefix, all free
+  explicit AddressPool(const AddressPrefix &_prefix, std::size_t _size = C_MAX_SIZE);
+
+  [[nodiscard]] const AddressPrefix &prefix() const noexcept { return prefix_; }
+  //! Number of addresses managed
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  //! Number of free addresses
+  [[nodiscard]] std::size_t available() const noexcept { return available_; }
+
+  //! Lowest free address, now used; a null address if the pool is exhausted
+  Address allocate();
+  //! Sticky allocation: the address \a _client got last, if it is free, else as allocate()
+  /*!
+      The address is remembered for \a _client, also after release(), until it allocates another.
+  */
+  Address allocate(uint64_t _client);
+  //! Mark \a _address used; false if it is not a free address of the pool
+  bool claim(const Address &_address);
+  //! Mark \a _address free; false if it is not a used, unreserved address of the pool
+  bool release(const Address &_address);
+  //! Exclude the addresses from \a _first to \a _last of the pool, both included, from allocation
+  /*!
+      Addresses already used stay used; release() fails for all of them from now on. Returns
+      false, changing nothing, if the range is empty or not within the pool.
+  */
+  bool reserve(const Address &_first, const Address &_last);
+  bool reserve(const Address &_address) { return reserve(_address, _address); }
+
+  [[nodiscard]] bool isFree(const Address &_address) const;
+  [[nodiscard]] bool isReserved(const Address &_address) const;
+
+private:
+  // Position of _address in the pool, or size_ if it is not in it
+  [[nodiscard]] std::size_t offsetOf(const Address &_address) const;
+  [[nodiscard]] Address addressAt(std::size_t _offset) const;
+  [[nodiscard]] bool isFreeAt(std::size_t _offset) const {
+    return ((word(0, _offset / 64) >> (_offset % 64)) & 1U) != 0;
+  }
+  [[nodiscard]] bool isReservedAt(std::size_t _offset) const;
+  // Word _index of _level, the bits past the end of the level cleared
+  [[nodiscard]] uint64_t word(std::size_t _level, std::size_t _index) const {
+    return _level >= blocks_.size() ? levels_[_level][_index] : blockWord(_level, _index);
+  }
+  // Set word _index of _level to (word & _and) | _or, returning its previous value
+  uint64_t update(std::size_t _level, std::size_t _index, uint64_t _and, uint64_t _or) {
+    if (_level < blocks_.size()) return updateBlock(_level, _index, _and, _or);
+    uint64_t &word     = levels_[_level][_index];
+    const uint64_t old = word;
+    word               = (old & _and) | _or;
+    return old;
+  }
+  [[nodiscard]] uint64_t blockWord(std::size_t _level, std::size_t _index) const;
+  uint64_t updateBlock(std::size_t _level, std::size_t _index, uint64_t _and, uint64_t _or);
+  void use(std::size_t _offset);
+  // Use or free bit _offset of the levels stored in blocks, returning the dense level to go on
+  // with and setting _offset to the bit there, or levels_.size() when the summaries above stay
+  Q_DECL_COLD_FUNCTION std::size_t markBlocks(std::size_t &_offset, bool _free);
+  // Recompute the summary bits above bitmap words _first to _last
+  void refresh(std::size_t _first, std::size_t _last);
+
+  // Levels of at most this many words (2 MiB) are stored dense, larger ones in blocks
+  static constexpr std::size_t C_DENSE_WORDS = std::size_t(1) << 18;
+
+  struct Block {
+    uint64_t words[64];
+    std::size_t partial {0};  // words with a used bit
+  };
+
+  struct BlockLevel {
+    std::size_t bits {0};                                            // addresses, or words of the level below
+    std::unordered_map<std::size_t, std::unique_ptr<Block>> blocks;  // those with a used bit
+  };
+
+  AddressPrefix prefix_;
+  std::size_t size_ {0};
+  std::size_t available_ {0};
+  std::vector<std::vector<uint64_t>> levels_;                  // free bits, then the summary levels, or empty
+  std::vector<BlockLevel> blocks_;                             // the first levels_ instead, when larger
+  std::vector<std::pair<std::size_t, std::size_t>> reserved_;  // sorted, disjoint [first, last] offsets
+  std::unordered_map<uint64_t, std::size_t> sticky_;           // client -> offset
+};
+
+}  // namespace network
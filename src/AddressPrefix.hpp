@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Endian.hpp"
+
+namespace network {
+
+//! Address prefix such as 10.0.0.0/8, usable in constant expressions
+/*!
+    Keeps the network address and its mask in the stored form of Address, so contains() is one
+    mask and compare per word. With a constexpr prefix the masks become immediate operands:
+
+    \code{.cpp}
+    using namespace network::literals;
+
+    static constexpr AddressPrefix C_LINK_LOCAL[] = {"169.254.0.0/16"_cidr, "fe80::/10"_cidr};
+    static_assert(C_LINK_LOCAL[0].contains("169.254.1.2"_ip));
+
+    for (const AddressPrefix &prefix : C_LINK_LOCAL) {
+      if (prefix.contains(address)) return true;
+    }
+    \endcode
+
+    Matching is strict, as AddressBlock::selectPrefix(): an IPv4 prefix does not contain the
+    v4-mapped form of its addresses.
+*/
+class AddressPrefix {
+public:
+  constexpr AddressPrefix() = default;
+  //! First \a _length bits of \a _address, host bits cleared
+  /*!
+      A length that does not fit the protocol of \a _address, or an address that is neither IPv4
+      nor IPv6, gives a null prefix, which contains nothing.
+  */
+  constexpr AddressPrefix(const Address &_address, int _length) {
+    netmask_.setPrefixLength(_address.getProtocol(), _length);
+    if (_length < 0 || netmask_.getPrefixLength() != _length) return;
+
+    if (_address.getProtocol() == LayerProtocol::IPv4) {
+      mask4_ = _length ? ~0U << (32 - _length) : 0;
+      address_.setAddress(_address.d_.addr_ & mask4_);
+      return;
+    }
+    const uint64_t high = _length >= 64 ? ~uint64_t(0) : _length ? ~uint64_t(0) << (64 - _length) : 0;
+    const uint64_t low  = _length > 64 ? ~uint64_t(0) << (128 - _length) : 0;
+    mask6_[0]           = qToBigEndian(high);
+    mask6_[1]           = qToBigEndian(low);
+
+    IPv6Address ip6 {};
+    for (int i = 0; i < 2; ++i) {
+      const uint64_t word = qFromBigEndian(_address.d_.a6_64.c[i] & mask6_[i]);
+      for (int j = 0; j < 8; ++j) ip6.c[i * 8 + j] = uint8_t(word >> (56 - 8 * j));
+    }
+    address_.setAddress(ip6);
+  }
+  constexpr AddressPrefix(const Address &_address, Netmask _netmask)
+      : AddressPrefix(_address, _netmask.getPrefixLength()) {}
+
+  //! Network address, host bits zero
+  [[nodiscard]] constexpr const Address &getAddress() const { return address_; }
+  [[nodiscard]] constexpr Netmask getNetmask() const { return netmask_; }
+  [[nodiscard]] constexpr int getPrefixLength() const { return netmask_.getPrefixLength(); }
+  [[nodiscard]] constexpr LayerProtocol getProtocol() const { return address_.getProtocol(); }
+  [[nodiscard]] constexpr bool isNull() const { return address_.isNull(); }
+
+  //! Whether \a _address is in the prefix and of the same protocol
+  [[nodiscard]] constexpr bool contains(const Address &_address) const {
+    const AddressData &d    = _address.d_;
+    const AddressData &base = address_.d_;
+    if (d.protocol_ != base.protocol_) return false;
+    if (base.protocol_ == LayerProtocol::IPv4) return (d.addr_ & mask4_) == base.addr_;
+    return base.protocol_ == LayerProtocol::IPv6 &&
+           (((d.a6_64.c[0] & mask6_[0]) ^ base.a6_64.c[0]) | ((d.a6_64.c[1] & mask6_[1]) ^ base.a6_64.c[1])) == 0;
+  }
+
+  friend constexpr bool operator==(const AddressPrefix &, const AddressPrefix &) = default;
+
+private:
+  Address address_;
+  uint64_t mask6_[2] {0, 0};  // network byte order, as Address stores the IPv6 form
+  uint32_t mask4_ {0};        // host byte order
+  Netmask netmask_;
+};
+
+namespace detail {
+
+// Not constexpr: reaching it while evaluating a literal makes the literal a compile error
+inline void invalidAddressLiteral() {}
+
+constexpr int hexDigit(char _c) {
+  if (_c >= '0' && _c <= '9') return _c - '0';
+  if (_c >= 'a' && _c <= 'f') return _c - 'a' + 10;
+  if (_c >= 'A' && _c <= 'F') return _c - 'A' + 10;
+  return -1;
+}
+
+// Decimal field of 1-3 digits without leading zeros, no larger than _max
+constexpr bool parseDecimal(std::string_view _text, int _max, int &_value) {
+  if (_text.empty() || _text.size() > 3 || (_text.size() > 1 && _text[0] == '0')) return false;
+  int value = 0;
+  for (const char c : _text) {
+    if (c < '0' || c > '9') return false;
+    value = value * 10 + (c - '0');
+  }
+  if (value > _max) return false;
+  _value = value;
+  return true;
+}
+
+//! Constant-evaluable parseIPv4(), same grammar
+constexpr bool parseIPv4Literal(std::string_view _text, uint32_t &_ip4) {
+  uint32_t ip4 = 0;
+  for (int field = 0; field < 4; ++field) {
+    const std::size_t dot = field < 3 ? _text.find('.') : _text.size();
+    int value             = 0;
+    if (dot == std::string_view::npos || !parseDecimal(_text.substr(0, dot), 255, value)) return false;
+    ip4   = ip4 << 8U | uint32_t(value);
+    _text = _text.substr(dot == _text.size() ? dot : dot + 1);
+  }
+  _ip4 = ip4;
+  return true;
+}
+
+//! Constant-evaluable parseIPv6(), same grammar
+constexpr bool parseIPv6Literal(std::string_view _text, IPv6Address &_ip6) {
+  uint16_t groups[8] = {};
+  int count          = 0;
+  int gap            = -1;  // index of the group "::" stands before
+  std::size_t i      = 0;
+  if (_text.starts_with(':')) {
+    if (!_text.starts_with("::")) return false;
+    gap = 0;
+    i   = 2;
+  }
+  while (i < _text.size()) {
+    std::size_t end = i;
+    uint32_t value  = 0;
+    while (end < _text.size() && hexDigit(_text[end]) >= 0) value = value << 4U | uint32_t(hexDigit(_text[end++]));
+    if (end < _text.size() && _text[end] == '.') {
+      // trailing dotted quad, two groups
+      uint32_t ip4 = 0;
+      if (count > 6 || !parseIPv4Literal(_text.substr(i), ip4)) return false;
+      groups[count++] = uint16_t(ip4 >> 16U);
+      groups[count++] = uint16_t(ip4);
+      break;
+    }
+    if (end == i || end - i > 4 || count == 8) return false;
+    groups[count++] = uint16_t(value);
+    if (end == _text.size()) break;
+    if (_text[end] != ':' || ++end == _text.size()) return false;
+    if (_text[end] == ':') {
+      if (gap >= 0) return false;
+      gap = count;
+      ++end;
+    }
+    i = end;
+  }
+  if (gap < 0 ? count != 8 : count > 7) return false;
+
+  IPv6Address ip6 {};
+  for (int group = 0, out = 0; group < count; ++group, ++out) {
+    if (group == gap) out += 8 - count;
+    ip6.c[out * 2]     = uint8_t(groups[group] >> 8U);
+    ip6.c[out * 2 + 1] = uint8_t(groups[group]);
+  }
+  _ip6 = ip6;
+  return true;
+}
+
+//! Constant-evaluable Address::setAddress(std::string_view)
+constexpr bool parseAddressLiteral(std::string_view _text, Address &_address) {
+  if (_text.find(':') != std::string_view::npos) {
+    IPv6Address ip6 {};
+    if (!parseIPv6Literal(_text, ip6)) return false;
+    _address.setAddress(ip6);
+    return true;
+  }
+  uint32_t ip4 = 0;
+  if (!parseIPv4Literal(_text, ip4)) return false;
+  _address.setAddress(ip4);
+  return true;
+}
+
+//! Constant-evaluable "address/length" parser; host bits are cleared as by AddressPrefix
+constexpr bool parsePrefixLiteral(std::string_view _text, AddressPrefix &_prefix) {
+  const std::size_t slash = _text.find('/');
+  Address address;
+  int length = 0;
+  if (slash == std::string_view::npos || !parseAddressLiteral(_text.substr(0, slash), address) ||
+      !parseDecimal(_text.substr(slash + 1), address.getProtocol() == LayerProtocol::IPv4 ? 32 : 128, length)) {
+    return false;
+  }
+  _prefix = AddressPrefix(address, length);
+  return true;
+}
+
+}  // namespace detail
+
+//! Address and prefix literals, parsed at compile time
+/*!
+    "192.0.2.1"_ip and "2001:db8::1"_ip are Address values, "10.0.0.0/8"_cidr an AddressPrefix.
+    The text follows the grammar of Address::setAddress(std::string_view); a malformed literal
+    does not compile.
+*/
+namespace literals {
+
+consteval Address operator""_ip(const char *_text, std::size_t _size) {
+  Address address;
+  if (!detail::parseAddressLiteral({_text, _size}, address)) detail::invalidAddressLiteral();
+  return address;
+}
+
+consteval AddressPrefix operator""_cidr(const char *_text, std::size_t _size) {
+  AddressPrefix prefix;
+  if (!detail::parsePrefixLiteral({_text, _size}, prefix)) detail::invalidAddressLiteral();
+  return prefix;
+}
+
+}  // namespace literals
+
+}  // namespace network
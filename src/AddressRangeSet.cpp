@@ -0,0 +1,394 @@
+#include "AddressRangeSet.hpp"
+
+#include <algorithm>
+#include <bit>
+#include "Endian.hpp"
+
+namespace network {
+
+namespace {
+
+using detail::Interval;
+using detail::Uint128;
+
+template <typename Key>
+struct KeyTraits;
+
+template <>
+struct KeyTraits<uint32_t> {
+  static constexpr unsigned C_BITS = 32;
+  static constexpr uint32_t C_ONE  = 1;
+
+  static constexpr uint32_t lowMask(unsigned _bits) { return _bits >= 32 ? ~0U : (1U << _bits) - 1; }
+  static unsigned countrZero(uint32_t _key) { return unsigned(std::countr_zero(_key)); }
+  static unsigned bitWidth(uint32_t _key) { return unsigned(std::bit_width(_key)); }
+};
+
+template <>
+struct KeyTraits<Uint128> {
+  static constexpr unsigned C_BITS = 128;
+  static constexpr Uint128 C_ONE   = {0, 1};
+
+  static constexpr uint64_t lowMask64(unsigned _bits) { return _bits >= 64 ? ~0ULL : (1ULL << _bits) - 1; }
+  static constexpr Uint128 lowMask(unsigned _bits) {
+    return _bits >= 64 ? Uint128 {lowMask64(_bits - 64), ~0ULL} : Uint128 {0, lowMask64(_bits)};
+  }
+  static unsigned countrZero(Uint128 _key) {
+    return _key.lo != 0 ? unsigned(std::countr_zero(_key.lo)) : 64 + unsigned(std::countr_zero(_key.hi));
+  }
+  static unsigned bitWidth(Uint128 _key) {
+    return _key.hi != 0 ? 64 + unsigned(std::bit_width(_key.hi)) : unsigned(std::bit_width(_key.lo));
+  }
+};
+
+// IPv4 keys are host order; IPv6 keys are the 16 bytes read as one big-endian number
+uint32_t key4(const Address &_address) { return _address.toIPv4Address(); }
+
+Uint128 key6(const Address &_address) {
+  const IPv6Address ip6 = _address.toIPv6Address();
+  return {qFromBigEndian<uint64_t>(ip6.c), qFromBigEndian<uint64_t>(ip6.c + 8)};
+}
+
+Address address6(Uint128 _key) {
+  IPv6Address ip6;
+  qToBigEndian(_key.hi, ip6.c);
+  qToBigEndian(_key.lo, ip6.c + 8);
+  return Address(ip6);
+}
+
+// Prefix length that fits the protocol of _address, or -1
+int prefixLength(const Address &_address, Netmask _netmask) {
+  const int length = _netmask.getPrefixLength();
+  switch (_address.getProtocol()) {
+    case LayerProtocol::IPv4: return length <= 32 ? length : -1;
+    case LayerProtocol::IPv6: return length <= 128 ? length : -1;
+    default: return -1;
+  }
+}
+
+template <typename Key>
+Interval<Key> prefixInterval(Key _key, int _length) {
+  const Key host  = KeyTraits<Key>::lowMask(KeyTraits<Key>::C_BITS - unsigned(_length));
+  const Key first = _key & ~host;
+  return {first, first | host};
+}
+
+template <typename Key>
+bool lessFirst(const Interval<Key> &_a, const Interval<Key> &_b) {
+  return _a.first < _b.first;
+}
+
+template <typename Key>
+void sortByFirst(std::vector<Interval<Key>> &_intervals) {
+  std::sort(_intervals.begin(), _intervals.end(), lessFirst<Key>);
+}
+
+// LSD radix sort on the 32-bit start, three passes of 11 bits
+template <>
+void sortByFirst(std::vector<Interval<uint32_t>> &_intervals) {
+  constexpr std::size_t C_RADIX_MIN = 4096;
+  if (_intervals.size() < C_RADIX_MIN) {
+    std::sort(_intervals.begin(), _intervals.end(), lessFirst<uint32_t>);
+    return;
+  }
+  constexpr unsigned C_DIGIT = 11;
+  constexpr uint32_t C_MASK  = (1U << C_DIGIT) - 1;
+  std::vector<Interval<uint32_t>> scratch(_intervals.size());
+  std::vector<std::size_t> offsets(std::size_t(1) << C_DIGIT);
+  for (unsigned shift = 0; shift < 32; shift += C_DIGIT) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (const auto &interval : _intervals) ++offsets[(interval.first >> shift) & C_MASK];
+    std::size_t total = 0;
+    for (auto &offset : offsets) total += std::exchange(offset, total);
+    for (const auto &interval : _intervals) scratch[offsets[(interval.first >> shift) & C_MASK]++] = interval;
+    _intervals.swap(scratch);
+  }
+}
+
+// Merge overlapping and adjacent neighbours of a vector sorted by first
+template <typename Key>
+void coalesce(std::vector<Interval<Key>> &_intervals) {
+  if (_intervals.empty()) return;
+  std::size_t out = 0;
+  for (std::size_t i = 1; i < _intervals.size(); ++i) {
+    Interval<Key> &current    = _intervals[out];
+    const Interval<Key> &next = _intervals[i];
+    // Touching: starts inside the current range or right after it
+    if (next.first <= current.last || next.first - current.last == KeyTraits<Key>::C_ONE) {
+      current.last = std::max(current.last, next.last);
+    } else {
+      _intervals[++out] = next;
+    }
+  }
+  _intervals.resize(out + 1);
+}
+
+template <typename Key>
+void normalize(std::vector<Interval<Key>> &_intervals) {
+  sortByFirst(_intervals);
+  coalesce(_intervals);
+}
+
+template <typename Key>
+void insertInterval(std::vector<Interval<Key>> &_intervals, Interval<Key> _range) {
+  constexpr Key C_ONE = KeyTraits<Key>::C_ONE;
+  // [lo, hi) are the ranges that overlap or touch _range
+  const auto lo = std::partition_point(_intervals.begin(), _intervals.end(), [&](const Interval<Key> &_interval) {
+    return _interval.last < _range.first && _interval.last + C_ONE != _range.first;
+  });
+  const auto hi = std::partition_point(lo, _intervals.end(), [&](const Interval<Key> &_interval) {
+    return _interval.first <= _range.last || _interval.first - C_ONE == _range.last;
+  });
+  if (lo == hi) {
+    _intervals.insert(lo, _range);
+    return;
+  }
+  lo->first = std::min(lo->first, _range.first);
+  lo->last  = std::max((hi - 1)->last, _range.last);
+  _intervals.erase(lo + 1, hi);
+}
+
+template <typename Key>
+void eraseInterval(std::vector<Interval<Key>> &_intervals, Interval<Key> _range) {
+  constexpr Key C_ONE = KeyTraits<Key>::C_ONE;
+  // [lo, hi) are the ranges that overlap _range
+  const auto lo = std::partition_point(_intervals.begin(), _intervals.end(),
+                                       [&](const Interval<Key> &_interval) { return _interval.last < _range.first; });
+  const auto hi = std::partition_point(
+      lo, _intervals.end(), [&](const Interval<Key> &_interval) { return _interval.first <= _range.last; });
+  if (lo == hi) return;
+
+  Interval<Key> remnants[2];
+  std::size_t count = 0;
+  if (lo->first < _range.first) remnants[count++] = {lo->first, _range.first - C_ONE};
+  if ((hi - 1)->last > _range.last) remnants[count++] = {_range.last + C_ONE, (hi - 1)->last};
+  const auto at = _intervals.erase(lo, hi);
+  _intervals.insert(at, remnants, remnants + count);
+}
+
+template <typename Key>
+bool containsRange(const std::vector<Interval<Key>> &_intervals, Interval<Key> _range) {
+  // The last range starting at or before _range.first
+  const auto it = std::partition_point(_intervals.begin(), _intervals.end(),
+                                       [&](const Interval<Key> &_interval) { return _interval.first <= _range.first; });
+  return it != _intervals.begin() && (it - 1)->last >= _range.last;
+}
+
+template <typename Key>
+std::vector<Interval<Key>> unite(const std::vector<Interval<Key>> &_a, const std::vector<Interval<Key>> &_b) {
+  std::vector<Interval<Key>> out(_a.size() + _b.size());
+  std::merge(_a.begin(), _a.end(), _b.begin(), _b.end(), out.begin(), lessFirst<Key>);
+  coalesce(out);
+  return out;
+}
+
+// Both inputs have gaps between their ranges, so the pieces never touch and need no coalescing
+template <typename Key>
+std::vector<Interval<Key>> intersect(const std::vector<Interval<Key>> &_a, const std::vector<Interval<Key>> &_b) {
+  std::vector<Interval<Key>> out;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < _a.size() && j < _b.size()) {
+    const Key first = std::max(_a[i].first, _b[j].first);
+    const Key last  = std::min(_a[i].last, _b[j].last);
+    if (first <= last) out.push_back({first, last});
+    if (_a[i].last < _b[j].last) {
+      ++i;
+    } else {
+      ++j;
+    }
+  }
+  return out;
+}
+
+template <typename Key>
+std::vector<Interval<Key>> subtract(const std::vector<Interval<Key>> &_a, const std::vector<Interval<Key>> &_b) {
+  constexpr Key C_ONE = KeyTraits<Key>::C_ONE;
+  std::vector<Interval<Key>> out;
+  out.reserve(_a.size());
+  std::size_t j = 0;
+  for (const Interval<Key> &range : _a) {
+    while (j < _b.size() && _b[j].last < range.first) ++j;
+    Key first = range.first;
+    bool done = false;
+    for (std::size_t k = j; k < _b.size() && _b[k].first <= range.last; ++k) {
+      if (_b[k].first > first) out.push_back({first, _b[k].first - C_ONE});
+      if (_b[k].last >= range.last) {
+        done = true;
+        break;
+      }
+      first = _b[k].last + C_ONE;
+    }
+    if (!done) out.push_back({first, range.last});
+  }
+  return out;
+}
+
+template <typename Key>
+bool isSubset(const std::vector<Interval<Key>> &_a, const std::vector<Interval<Key>> &_b) {
+  std::size_t j = 0;
+  for (const Interval<Key> &range : _a) {
+    while (j < _b.size() && _b[j].last < range.first) ++j;
+    // _b is coalesced: a contiguous range has to lie within a single one of its ranges
+    if (j == _b.size() || _b[j].first > range.first || _b[j].last < range.last) return false;
+  }
+  return true;
+}
+
+template <typename Key>
+bool overlaps(const std::vector<Interval<Key>> &_a, const std::vector<Interval<Key>> &_b) {
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < _a.size() && j < _b.size()) {
+    if (std::max(_a[i].first, _b[j].first) <= std::min(_a[i].last, _b[j].last)) return true;
+    if (_a[i].last < _b[j].last) {
+      ++i;
+    } else {
+      ++j;
+    }
+  }
+  return false;
+}
+
+// Largest aligned blocks first-to-last: each block is as large as the alignment of its start
+// and the remaining size allow
+template <typename Key, typename Emit>
+void decompose(Interval<Key> _range, Emit &&_emit) {
+  using Traits = KeyTraits<Key>;
+  Key first    = _range.first;
+  for (;;) {
+    const Key size   = _range.last - first + Traits::C_ONE;  // zero for the whole key space
+    const unsigned k = size == Key {} ? Traits::C_BITS
+                                      : std::min(Traits::countrZero(first), Traits::bitWidth(size) - 1);
+    _emit(first, int(Traits::C_BITS - k));
+    const Key last = first | Traits::lowMask(k);
+    if (last == _range.last) break;
+    first = last + Traits::C_ONE;
+  }
+}
+
+}  // namespace
+
+bool AddressRangeSet::insert(const Address &_address, Netmask _netmask) {
+  const int length = prefixLength(_address, _netmask);
+  if (length < 0) return false;
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    insertInterval(v4_, prefixInterval(key4(_address), length));
+  } else {
+    insertInterval(v6_, prefixInterval(key6(_address), length));
+  }
+  return true;
+}
+
+bool AddressRangeSet::insert(const Address &_first, const Address &_last) {
+  const LayerProtocol protocol = _first.getProtocol();
+  if (protocol != _last.getProtocol()) return false;
+  if (protocol == LayerProtocol::IPv4) {
+    if (key4(_first) > key4(_last)) return false;
+    insertInterval(v4_, {key4(_first), key4(_last)});
+  } else if (protocol == LayerProtocol::IPv6) {
+    if (key6(_first) > key6(_last)) return false;
+    insertInterval(v6_, {key6(_first), key6(_last)});
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool AddressRangeSet::insert(std::span<const Prefix> _prefixes) {
+  const std::size_t size4 = v4_.size();
+  const std::size_t size6 = v6_.size();
+  bool ok                 = true;
+  for (const auto &[address, netmask] : _prefixes) {
+    const int length = prefixLength(address, netmask);
+    if (length < 0) {
+      ok = false;
+    } else if (address.getProtocol() == LayerProtocol::IPv4) {
+      v4_.push_back(prefixInterval(key4(address), length));
+    } else {
+      v6_.push_back(prefixInterval(key6(address), length));
+    }
+  }
+  if (v4_.size() != size4) normalize(v4_);
+  if (v6_.size() != size6) normalize(v6_);
+  return ok;
+}
+
+bool AddressRangeSet::erase(const Address &_address, Netmask _netmask) {
+  const int length = prefixLength(_address, _netmask);
+  if (length < 0) return false;
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    eraseInterval(v4_, prefixInterval(key4(_address), length));
+  } else {
+    eraseInterval(v6_, prefixInterval(key6(_address), length));
+  }
+  return true;
+}
+
+bool AddressRangeSet::contains(const Address &_address) const {
+  switch (_address.getProtocol()) {
+    case LayerProtocol::IPv4: return containsRange(v4_, {key4(_address), key4(_address)});
+    case LayerProtocol::IPv6: return containsRange(v6_, {key6(_address), key6(_address)});
+    default: return false;
+  }
+}
+
+bool AddressRangeSet::contains(const Address &_address, Netmask _netmask) const {
+  const int length = prefixLength(_address, _netmask);
+  if (length < 0) return false;
+  if (_address.getProtocol() == LayerProtocol::IPv4) return containsRange(v4_, prefixInterval(key4(_address), length));
+  return containsRange(v6_, prefixInterval(key6(_address), length));
+}
+
+bool AddressRangeSet::contains(const AddressRangeSet &_other) const {
+  return isSubset(_other.v4_, v4_) && isSubset(_other.v6_, v6_);
+}
+
+bool AddressRangeSet::intersects(const AddressRangeSet &_other) const {
+  return overlaps(v4_, _other.v4_) || overlaps(v6_, _other.v6_);
+}
+
+AddressRangeSet &AddressRangeSet::operator|=(const AddressRangeSet &_other) {
+  v4_ = unite(v4_, _other.v4_);
+  v6_ = unite(v6_, _other.v6_);
+  return *this;
+}
+
+AddressRangeSet &AddressRangeSet::operator&=(const AddressRangeSet &_other) {
+  v4_ = intersect(v4_, _other.v4_);
+  v6_ = intersect(v6_, _other.v6_);
+  return *this;
+}
+
+AddressRangeSet &AddressRangeSet::operator-=(const AddressRangeSet &_other) {
+  v4_ = subtract(v4_, _other.v4_);
+  v6_ = subtract(v6_, _other.v6_);
+  return *this;
+}
+
+std::vector<AddressRangeSet::Prefix> AddressRangeSet::toPrefixes() const {
+  std::vector<Prefix> out;
+  out.reserve(rangeCount());
+  const auto emit = [&out](const Address &_address, LayerProtocol _protocol, int _length) {
+    Netmask netmask;
+    netmask.setPrefixLength(_protocol, _length);
+    out.emplace_back(_address, netmask);
+  };
+  for (const auto &range : v4_) {
+    decompose(range, [&](uint32_t _first, int _length) { emit(Address(_first), LayerProtocol::IPv4, _length); });
+  }
+  for (const auto &range : v6_) {
+    decompose(range, [&](Uint128 _first, int _length) { emit(address6(_first), LayerProtocol::IPv6, _length); });
+  }
+  return out;
+}
+
+std::vector<AddressRangeSet::Range> AddressRangeSet::toRanges() const {
+  std::vector<Range> out;
+  out.reserve(rangeCount());
+  for (const auto &range : v4_) out.emplace_back(Address(range.first), Address(range.last));
+  for (const auto &range : v6_) out.emplace_back(address6(range.first), address6(range.last));
+  return out;
+}
+
+}  // namespace network
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Uint128.hpp"
+
+namespace network {
+
+namespace detail {
+
+//! Inclusive range [first, last] of an address family's key space
+template <typename Key>
+struct Interval {
+  Key first;
+  Key last;
+
+  friend constexpr bool operator==(const Interval &, const Interval &) = default;
+};
+
+}  // namespace detail
+
+//! Set of IPv4 and IPv6 addresses stored as sorted, disjoint address ranges
+/*!
+    Each family is a vector of inclusive intervals over its key space (32-bit for IPv4,
+    128-bit for IPv6), sorted and coalesced: adjacent or overlapping ranges are always merged,
+    so two sets holding the same addresses compare equal and toPrefixes() returns the minimal
+    CIDR list.
+
+    Set operations are linear merge passes over the two interval vectors. Single insertions and
+    erasures are O(ranges); to build a set from many prefixes use the span overload of insert(),
+    which sorts all of them (radix sort for IPv4) and coalesces them in one pass.
+
+    As in PrefixTable, the family is taken from Address::getProtocol(): v4-mapped IPv6 addresses
+    belong to the IPv6 space, and host bits of inserted prefixes are ignored. Addresses of other
+    protocols are never contained and are rejected by insert() and erase().
+*/
+class AddressRangeSet {
+public:
+  using Prefix = std::pair<Address, Netmask>;
+  using Range  = std::pair<Address, Address>;
+
+  AddressRangeSet() = default;
+
+  //! Add every address of a prefix. Returns false if the netmask does not fit the protocol.
+  bool insert(const Address &_address, Netmask _netmask);
+  //! Add every address from \a _first to \a _last. Returns false unless both have the same
+  //! protocol, IPv4 or IPv6, and _first <= _last.
+  bool insert(const Address &_first, const Address &_last);
+  //! Add many prefixes at once. Returns false if any was rejected; the others are still added.
+  bool insert(std::span<const Prefix> _prefixes);
+  //! Remove every address of a prefix. Returns false if the netmask does not fit the protocol.
+  bool erase(const Address &_address, Netmask _netmask);
+
+  [[nodiscard]] bool contains(const Address &_address) const;
+  //! Is every address of the prefix in the set?
+  [[nodiscard]] bool contains(const Address &_address, Netmask _netmask) const;
+  //! Is \a _other a subset of this set?
+  [[nodiscard]] bool contains(const AddressRangeSet &_other) const;
+  [[nodiscard]] bool intersects(const AddressRangeSet &_other) const;
+
+  AddressRangeSet &operator|=(const AddressRangeSet &_other);
+  AddressRangeSet &operator&=(const AddressRangeSet &_other);
+  AddressRangeSet &operator-=(const AddressRangeSet &_other);
+  friend AddressRangeSet operator|(AddressRangeSet _a, const AddressRangeSet &_b) { return _a |= _b; }
+  friend AddressRangeSet operator&(AddressRangeSet _a, const AddressRangeSet &_b) { return _a &= _b; }
+  friend AddressRangeSet operator-(AddressRangeSet _a, const AddressRangeSet &_b) { return _a -= _b; }
+  friend bool operator==(const AddressRangeSet &, const AddressRangeSet &) = default;
+
+  //! Smallest list of CIDR blocks covering exactly the set, IPv4 first, in address order
+  [[nodiscard]] std::vector<Prefix> toPrefixes() const;
+  //! The disjoint ranges, inclusive, IPv4 first, in address order
+  [[nodiscard]] std::vector<Range> toRanges() const;
+
+  //! Number of disjoint ranges
+  [[nodiscard]] std::size_t rangeCount() const noexcept { return v4_.size() + v6_.size(); }
+  [[nodiscard]] bool empty() const noexcept { return v4_.empty() && v6_.empty(); }
+  void clear() noexcept {
+    v4_.clear();
+    v6_.clear();
+  }
+
+private:
+  std::vector<detail::Interval<uint32_t>> v4_;
+  std::vector<detail::Interval<detail::Uint128>> v6_;
+};
+
+}  // namespace network
@@ -0,0 +1,100 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Endian.hpp"
+
+namespace network {
+
+namespace {
+
+// sin_port and sin6_port share their offset, so the port is read without looking at the family
+static_assert(offsetof(sockaddr_in, sin_port) == offsetof(sockaddr_in6, sin6_port));
+
+uint16_t portOf(const sockaddr *_address) {
+  return qFromBigEndian<uint16_t>(reinterpret_cast<const uint8_t *>(_address) + offsetof(sockaddr_in, sin_port));
+}
+
+}  // namespace
+
+bool AddressData::setAddress(const ::sockaddr *_address) {
+  if (_address == nullptr) {
+    clear();
+    return false;
+  }
+  const auto *bytes = reinterpret_cast<const uint8_t *>(_address);
+  switch (_address->sa_family) {
+    case AF_INET: setAddress(qFromBigEndian<uint32_t>(bytes + offsetof(sockaddr_in, sin_addr))); return true;
+    case AF_INET6: setAddress(bytes + offsetof(sockaddr_in6, sin6_addr)); return true;
+    default: clear(); return false;
+  }
+}
+
+// A socket receives a single family (IPv4 peers of a dual-stack socket arrive v4-mapped), so the
+// family switch is predicted; the IPv6 conversion itself is branch-free.
+std::size_t AddressData::fromMessages(std::span<const ::mmsghdr> _messages, std::span<Address> _addresses,
+    std::span<uint16_t> _ports) {
+  std::size_t count = std::min(_messages.size(), _addresses.size());
+  if (!_ports.empty()) count = std::min(count, _ports.size());
+  for (std::size_t i = 0; i < count; ++i) {
+    const msghdr &header = _messages[i].msg_hdr;
+    const auto *name     = header.msg_namelen != 0 ? static_cast<const sockaddr *>(header.msg_name) : nullptr;
+    const bool named     = _addresses[i].d_.setAddress(name);
+    if (!_ports.empty()) _ports[i] = named ? portOf(name) : 0;
+  }
+  return count;
+}
+
+std::size_t AddressData::toSockaddrs(std::span<const Address> _addresses, std::span<const uint16_t> _ports,
+    std::span<::sockaddr_in6> _names, std::span<::mmsghdr> _messages) {
+  std::size_t count = std::min({_addresses.size(), _ports.size(), _names.size()});
+  if (!_messages.empty()) count = std::min(count, _messages.size());
+  for (std::size_t i = 0; i < count; ++i) {
+    const AddressData &address = _addresses[i].d_;
+    sockaddr_in6 &name         = _names[i];
+    std::memset(&name, 0, sizeof(name));
+    name.sin6_family = AF_INET6;
+    name.sin6_port   = qToBigEndian(_ports[i]);
+    // The stored form is already v4-mapped, except 0.0.0.0 which is kept as "::"
+    uint32_t words[4];
+    std::memcpy(words, address.a6_32.c, sizeof(words));
+    words[2] |= qToBigEndian(0xffffU) & (0U - uint32_t(address.protocol_ == LayerProtocol::IPv4));
+    std::memcpy(&name.sin6_addr, words, sizeof(words));
+    if (_messages.empty()) continue;
+    _messages[i].msg_hdr.msg_name    = &name;
+    _messages[i].msg_hdr.msg_namelen = sizeof(name);
+  }
+  return count;
+}
+
+std::size_t AddressData::toSockaddrs(std::span<const Address> _addresses, std::span<const uint16_t> _ports,
+    std::span<::sockaddr_in> _names, std::span<::mmsghdr> _messages) {
+  std::size_t count = std::min({_addresses.size(), _ports.size(), _names.size()});
+  if (!_messages.empty()) count = std::min(count, _messages.size());
+  for (std::size_t i = 0; i < count; ++i) {
+    bool ok            = false;
+    const uint32_t ip4 = _addresses[i].toIPv4Address(&ok);
+    if (!ok) {
+      errno = EAFNOSUPPORT;
+      return i;
+    }
+    sockaddr_in &name = _names[i];
+    std::memset(&name, 0, sizeof(name));
+    name.sin_family      = AF_INET;
+    name.sin_port        = qToBigEndian(_ports[i]);
+    name.sin_addr.s_addr = qToBigEndian(ip4);
+    if (_messages.empty()) continue;
+    _messages[i].msg_hdr.msg_name    = &name;
+    _messages[i].msg_hdr.msg_namelen = sizeof(name);
+  }
+  return count;
+}
+
+Address::Address(const ::sockaddr *_address) { d_.setAddress(_address); }
+
+bool Address::setAddress(const ::sockaddr *_address) { return d_.setAddress(_address); }
+
+}  // namespace network
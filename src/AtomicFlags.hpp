@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+#include "Flags.hpp"
+
+//! Enum-based flags that can be shared between threads
+/*!
+    Lock-free counterpart of Flags for state bits written by one thread and read by many, e.g.
+    interface up/running/carrier bits kept current by the netlink thread. Every operation is a
+    single atomic instruction or a compare-exchange loop on the underlying integer, and takes a
+    std::memory_order defaulting to sequentially consistent, as std::atomic does.
+
+    Like the operators of Flags, it is only available for enums registered with ENUM_FLAGS.
+
+    Example:
+    \code{.cpp}
+    AtomicFlags<LinkState> state;
+
+    // netlink thread
+    state.fetch_set(LinkState::Up | LinkState::Running, std::memory_order_release);
+    state.notify_all();
+
+    // worker threads
+    if (state.test(LinkState::Running, std::memory_order_acquire)) { ... }
+    state.wait_any(LinkState::Carrier);  // blocks until the carrier is up
+    \endcode
+*/
+template <typename TEnum>
+class AtomicFlags {
+  static_assert(is_enum_flags_v<TEnum>, "AtomicFlags needs the enum to be registered with ENUM_FLAGS.");
+  //! Enum underlying type
+  using type = std::make_unsigned_t<std::underlying_type_t<TEnum>>;
+  static_assert(std::atomic<type>::is_always_lock_free, "AtomicFlags storage must be lock-free.");
+
+public:
+  using flags_type = Flags<TEnum>;
+
+  constexpr AtomicFlags() noexcept : _value(0) {}
+  constexpr AtomicFlags(flags_type flags) noexcept : _value(flags.underlying()) {}
+  constexpr AtomicFlags(TEnum value) noexcept : _value(type(value)) {}
+  AtomicFlags(const AtomicFlags &)            = delete;
+  AtomicFlags &operator=(const AtomicFlags &) = delete;
+
+  //! Current flags
+  [[nodiscard]] flags_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    return flags_type(_value.load(order));
+  }
+  //! Replace all flags
+  void store(flags_type flags, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    _value.store(flags.underlying(), order);
+  }
+  //! Replace all flags, returning the previous ones
+  flags_type exchange(flags_type flags, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return flags_type(_value.exchange(flags.underlying(), order));
+  }
+
+  //! Set the flags of \a mask, returning the previous flags
+  flags_type fetch_set(flags_type mask, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return flags_type(_value.fetch_or(mask.underlying(), order));
+  }
+  //! Clear the flags of \a mask, returning the previous flags
+  flags_type fetch_clear(flags_type mask, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return flags_type(_value.fetch_and(type(~mask.underlying()), order));
+  }
+  //! Toggle the flags of \a mask, returning the previous flags
+  flags_type fetch_toggle(flags_type mask, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return flags_type(_value.fetch_xor(mask.underlying(), order));
+  }
+
+  //! Is any flag of \a mask set?
+  [[nodiscard]] bool test(flags_type mask, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    return (_value.load(order) & mask.underlying()) != 0;
+  }
+  //! Set the flags of \a mask; was any of them set before?
+  bool test_and_set(flags_type mask, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return (_value.fetch_or(mask.underlying(), order) & mask.underlying()) != 0;
+  }
+  //! Clear the flags of \a mask; was any of them set before?
+  bool test_and_clear(flags_type mask, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return (_value.fetch_and(type(~mask.underlying()), order) & mask.underlying()) != 0;
+  }
+
+  //! Replace all flags if they equal \a expected, otherwise load them into \a expected
+  bool compare_exchange_weak(flags_type &expected, flags_type desired,
+      std::memory_order success = std::memory_order_seq_cst,
+      std::memory_order failure = std::memory_order_seq_cst) noexcept {
+    type current         = expected.underlying();
+    const bool exchanged = _value.compare_exchange_weak(current, desired.underlying(), success, failure);
+    expected = current;
+    return exchanged;
+  }
+  bool compare_exchange_strong(flags_type &expected, flags_type desired,
+      std::memory_order success = std::memory_order_seq_cst,
+      std::memory_order failure = std::memory_order_seq_cst) noexcept {
+    type current         = expected.underlying();
+    const bool exchanged = _value.compare_exchange_strong(current, desired.underlying(), success, failure);
+    expected = current;
+    return exchanged;
+  }
+  //! Compare and replace only the flags of \a mask, leaving the others as they are
+  /*!
+      Succeeds if the flags of \a mask equal those of \a expected, in which case they become
+      those of \a desired. Otherwise \a expected receives the current flags. Concurrent changes
+      to flags outside of \a mask never make it fail.
+
+      \code{.cpp}
+      // Up -> Up|Running, whatever Promisc is
+      auto expected = Flags(LinkState::Up);
+      state.compare_exchange_masked(LinkState::Up | LinkState::Running, expected, LinkState::Up | LinkState::Running);
+      \endcode
+  */
+  bool compare_exchange_masked(flags_type mask, flags_type &expected, flags_type desired,
+      std::memory_order success = std::memory_order_seq_cst,
+      std::memory_order failure = std::memory_order_seq_cst) noexcept {
+    const type bits = mask.underlying();
+    type current    = _value.load(failure);
+    while ((current & bits) == (expected.underlying() & bits)) {
+      const type next = type((current & ~bits) | (desired.underlying() & bits));
+      if (_value.compare_exchange_weak(current, next, success, failure)) return true;
+    }
+    expected = current;
+    return false;
+  }
+
+  //! Block until the flags differ from \a old
+  void wait(flags_type old, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    _value.wait(old.underlying(), order);
+  }
+  //! Block until any flag of \a mask is set, returning the flags seen then
+  flags_type wait_any(flags_type mask, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    type current = _value.load(order);
+    while ((current & mask.underlying()) == 0) {
+      _value.wait(current, order);
+      current = _value.load(order);
+    }
+    return flags_type(current);
+  }
+  //! Block until every flag of \a mask is cleared, returning the flags seen then
+  flags_type wait_none(flags_type mask, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    type current = _value.load(order);
+    while ((current & mask.underlying()) != 0) {
+      _value.wait(current, order);
+      current = _value.load(order);
+    }
+    return flags_type(current);
+  }
+  //! Wake one thread blocked in wait(), wait_any() or wait_none()
+  void notify_one() noexcept { _value.notify_one(); }
+  //! Wake every thread blocked in wait(), wait_any() or wait_none()
+  void notify_all() noexcept { _value.notify_all(); }
+
+private:
+  std::atomic<type> _value;
+};
@@ -0,0 +1,252 @@
+#include "BitFlags.hpp"
+
+#include <bit>
+#include "CpuFeatures.hpp"
+#include "global/Simd.hpp"
+
+namespace {
+
+enum class Op { AND, OR, XOR };
+
+template <Op O>
+constexpr uint64_t apply(uint64_t _a, uint64_t _b) {
+  if constexpr (O == Op::AND) return _a & _b;
+  if constexpr (O == Op::OR) return _a | _b;
+  return _a ^ _b;
+}
+
+// Each helper processes whole vectors from word _i on and returns where it stopped
+
+#if defined(KT_COMPILER_SUPPORTS_SSE2)
+template <Op O>
+inline __m128i apply128(__m128i _a, __m128i _b) {
+  if constexpr (O == Op::AND) return _mm_and_si128(_a, _b);
+  if constexpr (O == Op::OR) return _mm_or_si128(_a, _b);
+  return _mm_xor_si128(_a, _b);
+}
+
+template <Op O>
+inline std::size_t binary16(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count,
+    std::size_t _i) {
+  for (; _i + 2 <= _count; _i += 2) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_a + _i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_b + _i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_out + _i), apply128<O>(a, b));
+  }
+  return _i;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+template <Op O>
+KT_TARGET_AVX2 inline __m256i apply256(__m256i _a, __m256i _b) {
+  if constexpr (O == Op::AND) return _mm256_and_si256(_a, _b);
+  if constexpr (O == Op::OR) return _mm256_or_si256(_a, _b);
+  return _mm256_xor_si256(_a, _b);
+}
+
+template <Op O>
+KT_TARGET_AVX2 inline std::size_t binary32(const uint64_t *_a, const uint64_t *_b, uint64_t *_out,
+    std::size_t _count, std::size_t _i) {
+  for (; _i + 4 <= _count; _i += 4) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_a + _i));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_b + _i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(_out + _i), apply256<O>(a, b));
+  }
+  return _i;
+}
+
+// Stops at the first block of 16 words where _a & _b differs from the target: zero for any(),
+// _b for all()
+template <bool All>
+KT_TARGET_AVX2 inline bool test32(const uint64_t *_a, const uint64_t *_b, std::size_t _count, std::size_t &_i) {
+  for (; _i + 16 <= _count; _i += 16) {
+    __m256i differs = _mm256_setzero_si256();
+    for (std::size_t j = 0; j < 16; j += 4) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_a + _i + j));
+      const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_b + _i + j));
+      differs         = _mm256_or_si256(differs, All ? _mm256_andnot_si256(a, b) : _mm256_and_si256(a, b));
+    }
+    if (!_mm256_testz_si256(differs, differs)) return false;
+  }
+  return true;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+template <Op O>
+KT_TARGET_AVX512 inline __m512i apply512(__m512i _a, __m512i _b) {
+  if constexpr (O == Op::AND) return _mm512_and_si512(_a, _b);
+  if constexpr (O == Op::OR) return _mm512_or_si512(_a, _b);
+  return _mm512_xor_si512(_a, _b);
+}
+
+// Whole array, the tail through a masked load and store
+template <Op O>
+KT_TARGET_AVX512 inline void binary64(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) {
+  std::size_t i = 0;
+  for (; i + 8 <= _count; i += 8) {
+    _mm512_storeu_si512(_out + i, apply512<O>(_mm512_loadu_si512(_a + i), _mm512_loadu_si512(_b + i)));
+  }
+  if (i == _count) return;
+  const auto mask = __mmask8((1U << (_count - i)) - 1);
+  const __m512i a = _mm512_maskz_loadu_epi64(mask, _a + i);
+  const __m512i b = _mm512_maskz_loadu_epi64(mask, _b + i);
+  _mm512_mask_storeu_epi64(_out + i, mask, apply512<O>(a, b));
+}
+
+template <bool All>
+KT_TARGET_AVX512 inline bool test64(const uint64_t *_a, const uint64_t *_b, std::size_t _count) {
+  std::size_t i = 0;
+  for (; i + 32 <= _count; i += 32) {
+    __m512i differs = _mm512_setzero_si512();
+    for (std::size_t j = 0; j < 32; j += 8) {
+      const __m512i a = _mm512_loadu_si512(_a + i + j);
+      const __m512i b = _mm512_loadu_si512(_b + i + j);
+      differs         = _mm512_or_si512(differs, All ? _mm512_andnot_si512(a, b) : _mm512_and_si512(a, b));
+    }
+    if (_mm512_test_epi64_mask(differs, differs) != 0) return !All;
+  }
+  for (; i < _count; i += 8) {
+    const auto mask = __mmask8(_count - i >= 8 ? 0xffU : (1U << (_count - i)) - 1);
+    const __m512i a = _mm512_maskz_loadu_epi64(mask, _a + i);
+    const __m512i b = _mm512_maskz_loadu_epi64(mask, _b + i);
+    if (_mm512_test_epi64_mask(All ? _mm512_andnot_si512(a, b) : _mm512_and_si512(a, b), _mm512_set1_epi64(-1))) {
+      return !All;
+    }
+  }
+  return All;
+}
+#endif
+
+template <bool All>
+bool testScalar(const uint64_t *_a, const uint64_t *_b, std::size_t _count, std::size_t _i) {
+  for (; _i < _count; ++_i) {
+    const uint64_t common = _a[_i] & _b[_i];
+    if (All ? common != _b[_i] : common != 0) return !All;
+  }
+  return All;
+}
+
+std::size_t countScalar(const uint64_t *_words, std::size_t _count, std::size_t _i) {
+  std::size_t total = 0;
+  for (; _i < _count; ++_i) total += std::size_t(std::popcount(_words[_i]));
+  return total;
+}
+
+// Whatever the build targets
+template <Op O>
+void binaryBaseline(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept {
+  std::size_t i = 0;
+#if defined(KT_COMPILER_SUPPORTS_AVX2)
+  i = binary32<O>(_a, _b, _out, _count, i);
+#endif
+#if defined(KT_COMPILER_SUPPORTS_SSE2)
+  i = binary16<O>(_a, _b, _out, _count, i);
+#endif
+  for (; i < _count; ++i) _out[i] = apply<O>(_a[i], _b[i]);
+}
+
+template <bool All>
+bool testBaseline(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept {
+  std::size_t i = 0;
+#if defined(KT_COMPILER_SUPPORTS_AVX2)
+  if (!test32<All>(_a, _b, _count, i)) return !All;
+#endif
+  return testScalar<All>(_a, _b, _count, i);
+}
+
+std::size_t countBaseline(const uint64_t *_words, std::size_t _count) noexcept {
+  return countScalar(_words, _count, 0);
+}
+
+#if defined(KT_RUNTIME_DISPATCH)
+template <Op O>
+KT_TARGET_AVX2 void binaryAvx2(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept {
+  std::size_t i = binary32<O>(_a, _b, _out, _count, 0);
+  for (; i < _count; ++i) _out[i] = apply<O>(_a[i], _b[i]);
+}
+
+template <bool All>
+KT_TARGET_AVX2 bool testAvx2(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept {
+  std::size_t i = 0;
+  if (!test32<All>(_a, _b, _count, i)) return !All;
+  return testScalar<All>(_a, _b, _count, i);
+}
+
+// Four independent popcnt chains. Every dispatched level has popcnt; AVX-512 VPOPCNTDQ, which
+// would be faster, is not part of the AVX512 level.
+KT_TARGET_SSE4_2 std::size_t countPopcnt(const uint64_t *_words, std::size_t _count) noexcept {
+  std::size_t totals[4] = {};
+  std::size_t i         = 0;
+  for (; i + 4 <= _count; i += 4) {
+    for (std::size_t j = 0; j < 4; ++j) totals[j] += std::size_t(std::popcount(_words[i + j]));
+  }
+  return totals[0] + totals[1] + totals[2] + totals[3] + countScalar(_words, _count, i);
+}
+
+template <Op O>
+KT_TARGET_AVX512 void binaryAvx512(const uint64_t *_a, const uint64_t *_b, uint64_t *_out,
+    std::size_t _count) noexcept {
+  binary64<O>(_a, _b, _out, _count);
+}
+
+template <bool All>
+KT_TARGET_AVX512 bool testAvx512(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept {
+  return test64<All>(_a, _b, _count);
+}
+#endif
+
+template <Op O>
+void binaryBulk(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept {
+#if defined(KT_RUNTIME_DISPATCH)
+  using Kernel               = void (*)(const uint64_t *, const uint64_t *, uint64_t *, std::size_t) noexcept;
+  static const Kernel kernel = qResolveKernel<Kernel>(binaryBaseline<O>, nullptr, binaryAvx2<O>, binaryAvx512<O>);
+  kernel(_a, _b, _out, _count);
+#else
+  binaryBaseline<O>(_a, _b, _out, _count);
+#endif
+}
+
+template <bool All>
+bool testBulk(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept {
+#if defined(KT_RUNTIME_DISPATCH)
+  using Kernel               = bool (*)(const uint64_t *, const uint64_t *, std::size_t) noexcept;
+  static const Kernel kernel = qResolveKernel<Kernel>(testBaseline<All>, nullptr, testAvx2<All>, testAvx512<All>);
+  return kernel(_a, _b, _count);
+#else
+  return testBaseline<All>(_a, _b, _count);
+#endif
+}
+
+}  // namespace
+
+void qFlagsAnd(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept {
+  binaryBulk<Op::AND>(_a, _b, _out, _count);
+}
+
+void qFlagsOr(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept {
+  binaryBulk<Op::OR>(_a, _b, _out, _count);
+}
+
+void qFlagsXor(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept {
+  binaryBulk<Op::XOR>(_a, _b, _out, _count);
+}
+
+bool qFlagsAny(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept {
+  return testBulk<false>(_a, _b, _count);
+}
+
+bool qFlagsAll(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept {
+  return testBulk<true>(_a, _b, _count);
+}
+
+std::size_t qFlagsCount(const uint64_t *_words, std::size_t _count) noexcept {
+#if defined(KT_RUNTIME_DISPATCH)
+  using Kernel               = std::size_t (*)(const uint64_t *, std::size_t) noexcept;
+  static const Kernel kernel = qResolveKernel<Kernel>(countBaseline, countPopcnt, nullptr, nullptr);
+  return kernel(_words, _count);
+#else
+  return countBaseline(_words, _count);
+#endif
+}
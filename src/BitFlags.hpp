@@ -0,0 +1,213 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+/*
+    Bulk operations over arrays of 64-bit flag words: the storage of many Flags of a 64-bit enum,
+    or of large BitFlags. They use the widest SIMD level available (AVX-512, AVX2, else what the
+    compiler targets), picked at run time as described in CpuFeatures.hpp. _out may be one of the
+    inputs.
+*/
+
+//! _out[i] = _a[i] & _b[i]
+void qFlagsAnd(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept;
+//! _out[i] = _a[i] | _b[i]
+void qFlagsOr(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept;
+//! _out[i] = _a[i] ^ _b[i]
+void qFlagsXor(const uint64_t *_a, const uint64_t *_b, uint64_t *_out, std::size_t _count) noexcept;
+//! Does any word of _a share a bit with the same word of _b?
+[[nodiscard]] bool qFlagsAny(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept;
+//! Is every bit of _b also set in _a?
+[[nodiscard]] bool qFlagsAll(const uint64_t *_a, const uint64_t *_b, std::size_t _count) noexcept;
+//! Number of bits set
+[[nodiscard]] std::size_t qFlagsCount(const uint64_t *_words, std::size_t _count) noexcept;
+
+//! Set of N flags indexed by position, for enums with more than 64 values
+/*!
+    Where Flags stores enum values that are single-bit masks, BitFlags stores bit positions:
+    \a TIndex is an integer or an enum whose values run from 0 to N - 1.
+
+    \code{.cpp}
+    enum class Capability : uint16_t { Checksum, Tso, Gro, ..., COUNT };
+    using Capabilities = BitFlags<std::size_t(Capability::COUNT), Capability>;
+
+    constexpr Capabilities C_OFFLOADS = {Capability::Checksum, Capability::Tso, Capability::Gro};
+    for (Capability capability : supported & C_OFFLOADS) { ... }
+    \endcode
+
+    Everything is constexpr; at run time, sets of C_BULK_WORDS words or more go through the
+    qFlags* kernels. Bits past N are always zero.
+*/
+template <std::size_t N, typename TIndex = std::size_t>
+class BitFlags {
+  static_assert(N > 0, "BitFlags needs at least one flag.");
+
+public:
+  static constexpr std::size_t C_WORDS = (N + 63) / 64;
+  //! Size from which the bitwise operators use the SIMD kernels
+  static constexpr std::size_t C_BULK_WORDS = 8;
+  //! Returned by findFirst() and findNext() when no flag is left
+  static constexpr std::size_t C_NPOS = N;
+
+  constexpr BitFlags() noexcept = default;
+  constexpr BitFlags(std::initializer_list<TIndex> _indices) noexcept {
+    for (TIndex index : _indices) set(index);
+  }
+
+  [[nodiscard]] static constexpr std::size_t size() noexcept { return N; }
+
+  constexpr BitFlags &set(TIndex _index, bool _value = true) noexcept {
+    const std::size_t i = position(_index);
+    const uint64_t bit  = uint64_t(1) << (i % 64);
+    words_[i / 64]      = _value ? words_[i / 64] | bit : words_[i / 64] & ~bit;
+    return *this;
+  }
+  constexpr BitFlags &reset(TIndex _index) noexcept { return set(_index, false); }
+  constexpr BitFlags &flip(TIndex _index) noexcept {
+    const std::size_t i = position(_index);
+    words_[i / 64] ^= uint64_t(1) << (i % 64);
+    return *this;
+  }
+  constexpr void clear() noexcept { words_ = {}; }
+
+  //! Is the given flag set?
+  [[nodiscard]] constexpr bool isset(TIndex _index) const noexcept {
+    const std::size_t i = position(_index);
+    return ((words_[i / 64] >> (i % 64)) & 1U) != 0;
+  }
+  //! Is any flag set?
+  [[nodiscard]] constexpr bool isset() const noexcept { return any(); }
+  [[nodiscard]] constexpr bool any() const noexcept {
+    for (uint64_t word : words_) {
+      if (word != 0) return true;
+    }
+    return false;
+  }
+  [[nodiscard]] constexpr bool none() const noexcept { return !any(); }
+  [[nodiscard]] constexpr bool all() const noexcept { return *this == ~BitFlags(); }
+  //! Is every flag of \a _other set here?
+  [[nodiscard]] constexpr bool contains(const BitFlags &_other) const noexcept {
+    if (!std::is_constant_evaluated() && C_WORDS >= C_BULK_WORDS) {
+      return qFlagsAll(words_.data(), _other.words_.data(), C_WORDS);
+    }
+    for (std::size_t i = 0; i < C_WORDS; ++i) {
+      if ((words_[i] & _other.words_[i]) != _other.words_[i]) return false;
+    }
+    return true;
+  }
+  //! Is any flag of \a _other set here?
+  [[nodiscard]] constexpr bool intersects(const BitFlags &_other) const noexcept {
+    if (!std::is_constant_evaluated() && C_WORDS >= C_BULK_WORDS) {
+      return qFlagsAny(words_.data(), _other.words_.data(), C_WORDS);
+    }
+    for (std::size_t i = 0; i < C_WORDS; ++i) {
+      if ((words_[i] & _other.words_[i]) != 0) return true;
+    }
+    return false;
+  }
+
+  //! Number of flags set
+  [[nodiscard]] constexpr std::size_t count() const noexcept {
+    if (!std::is_constant_evaluated() && C_WORDS >= C_BULK_WORDS) return qFlagsCount(words_.data(), C_WORDS);
+    std::size_t total = 0;
+    for (uint64_t word : words_) total += std::size_t(std::popcount(word));
+    return total;
+  }
+  //! Position of the lowest flag set, or C_NPOS
+  [[nodiscard]] constexpr std::size_t findFirst() const noexcept { return scan(0); }
+  //! Position of the lowest flag set after \a _position, or C_NPOS
+  [[nodiscard]] constexpr std::size_t findNext(std::size_t _position) const noexcept { return scan(_position + 1); }
+
+  //! Iterates over the flags set, lowest first
+  class iterator {
+  public:
+    using value_type        = TIndex;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    constexpr iterator() noexcept = default;
+    constexpr iterator(const BitFlags *_flags, std::size_t _position) noexcept
+        : flags_(_flags), position_(_position) {}
+    constexpr TIndex operator*() const noexcept { return TIndex(position_); }
+    constexpr iterator &operator++() noexcept {
+      position_ = flags_->findNext(position_);
+      return *this;
+    }
+    constexpr iterator operator++(int) noexcept {
+      iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    friend constexpr bool operator==(const iterator &_a, const iterator &_b) noexcept {
+      return _a.position_ == _b.position_;
+    }
+
+  private:
+    const BitFlags *flags_ {nullptr};
+    std::size_t position_ {C_NPOS};
+  };
+  [[nodiscard]] constexpr iterator begin() const noexcept { return iterator(this, findFirst()); }
+  [[nodiscard]] constexpr iterator end() const noexcept { return iterator(this, C_NPOS); }
+
+  constexpr BitFlags &operator&=(const BitFlags &_other) noexcept {
+    if (!std::is_constant_evaluated() && C_WORDS >= C_BULK_WORDS) {
+      qFlagsAnd(words_.data(), _other.words_.data(), words_.data(), C_WORDS);
+    } else {
+      for (std::size_t i = 0; i < C_WORDS; ++i) words_[i] &= _other.words_[i];
+    }
+    return *this;
+  }
+  constexpr BitFlags &operator|=(const BitFlags &_other) noexcept {
+    if (!std::is_constant_evaluated() && C_WORDS >= C_BULK_WORDS) {
+      qFlagsOr(words_.data(), _other.words_.data(), words_.data(), C_WORDS);
+    } else {
+      for (std::size_t i = 0; i < C_WORDS; ++i) words_[i] |= _other.words_[i];
+    }
+    return *this;
+  }
+  constexpr BitFlags &operator^=(const BitFlags &_other) noexcept {
+    if (!std::is_constant_evaluated() && C_WORDS >= C_BULK_WORDS) {
+      qFlagsXor(words_.data(), _other.words_.data(), words_.data(), C_WORDS);
+    } else {
+      for (std::size_t i = 0; i < C_WORDS; ++i) words_[i] ^= _other.words_[i];
+    }
+    return *this;
+  }
+  constexpr BitFlags operator~() const noexcept {
+    BitFlags out;
+    for (std::size_t i = 0; i < C_WORDS; ++i) out.words_[i] = ~words_[i];
+    out.words_[C_WORDS - 1] &= C_TAIL_MASK;
+    return out;
+  }
+  friend constexpr BitFlags operator&(BitFlags _a, const BitFlags &_b) noexcept { return _a &= _b; }
+  friend constexpr BitFlags operator|(BitFlags _a, const BitFlags &_b) noexcept { return _a |= _b; }
+  friend constexpr BitFlags operator^(BitFlags _a, const BitFlags &_b) noexcept { return _a ^= _b; }
+  friend constexpr bool operator==(const BitFlags &, const BitFlags &) noexcept = default;
+
+  //! The storage, lowest flags in the first word
+  [[nodiscard]] constexpr const std::array<uint64_t, C_WORDS> &words() const noexcept { return words_; }
+
+private:
+  static constexpr uint64_t C_TAIL_MASK = N % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (N % 64)) - 1;
+
+  static constexpr std::size_t position(TIndex _index) noexcept { return std::size_t(_index); }
+
+  constexpr std::size_t scan(std::size_t _from) const noexcept {
+    if (_from >= N) return C_NPOS;
+    std::size_t word = _from / 64;
+    uint64_t bits    = words_[word] & (~uint64_t(0) << (_from % 64));
+    while (bits == 0) {
+      if (++word == C_WORDS) return C_NPOS;
+      bits = words_[word];
+    }
+    return word * 64 + std::size_t(std::countr_zero(bits));
+  }
+
+  std::array<uint64_t, C_WORDS> words_ {};
+};
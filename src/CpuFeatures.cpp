@@ -0,0 +1,140 @@
+#include "CpuFeatures.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include "global/SystemDetection.hpp"
+
+#if defined(K_PROCESSOR_X86_64) || defined(K_PROCESSOR_X86_32)
+  #include <cpuid.h>
+#elif defined(K_PROCESSOR_ARM_64) && defined(K_OS_LINUX)
+  #include <asm/hwcap.h>
+  #include <sys/auxv.h>
+#endif
+
+namespace {
+
+// Built on demand: kernels may resolve during static initialization of other files
+Flags<CpuFeature> featuresOf(SimdLevel _level) {
+  Flags<CpuFeature> features(CpuFeature::SSE2);
+  if (_level >= SimdLevel::SSE4_2) {
+    features |= Flags<CpuFeature>(CpuFeature::SSSE3) | CpuFeature::SSE4_1 | CpuFeature::SSE4_2 | CpuFeature::POPCNT;
+  }
+  if (_level >= SimdLevel::AVX2) {
+    features |= Flags<CpuFeature>(CpuFeature::AVX) | CpuFeature::AVX2 | CpuFeature::BMI1 | CpuFeature::BMI2;
+  }
+  if (_level >= SimdLevel::AVX512) {
+    features |=
+        Flags<CpuFeature>(CpuFeature::AVX512F) | CpuFeature::AVX512BW | CpuFeature::AVX512DQ | CpuFeature::AVX512VL;
+  }
+  return features;
+}
+
+bool hasAll(Flags<CpuFeature> _features, Flags<CpuFeature> _required) { return (_features & _required) == _required; }
+
+#if defined(K_PROCESSOR_X86_64) || defined(K_PROCESSOR_X86_32)
+// XCR0: which register state the OS saves on context switches
+uint64_t xgetbv0() {
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (uint64_t(edx) << 32U) | eax;
+}
+
+Flags<CpuFeature> probe() {
+  Flags<CpuFeature> features;
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return features;
+  const auto bit = [](unsigned _register, unsigned _bit) { return (_register & (1U << _bit)) != 0; };
+
+  if (bit(edx, 26)) features |= CpuFeature::SSE2;
+  if (bit(ecx, 9)) features |= CpuFeature::SSSE3;
+  if (bit(ecx, 19)) features |= CpuFeature::SSE4_1;
+  if (bit(ecx, 20)) features |= CpuFeature::SSE4_2;
+  if (bit(ecx, 23)) features |= CpuFeature::POPCNT;
+
+  // AVX needs the OS to save YMM state, AVX-512 additionally the opmask and ZMM state
+  const bool osxsave  = bit(ecx, 27);
+  const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+  const bool ymm      = (xcr0 & 0x06U) == 0x06U;
+  const bool zmm      = (xcr0 & 0xe6U) == 0xe6U;
+  if (ymm && bit(ecx, 28)) features |= CpuFeature::AVX;
+
+  unsigned maxLeaf = __get_cpuid_max(0, nullptr);
+  if (maxLeaf >= 7) {
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (bit(ebx, 3)) features |= CpuFeature::BMI1;
+    if (bit(ebx, 8)) features |= CpuFeature::BMI2;
+    if (ymm && bit(ebx, 5)) features |= CpuFeature::AVX2;
+    if (zmm && bit(ebx, 16)) features |= CpuFeature::AVX512F;
+    if (zmm && bit(ebx, 17)) features |= CpuFeature::AVX512DQ;
+    if (zmm && bit(ebx, 30)) features |= CpuFeature::AVX512BW;
+    if (zmm && bit(ebx, 31)) features |= CpuFeature::AVX512VL;
+  }
+  return features;
+}
+#elif defined(K_PROCESSOR_ARM_64) && defined(K_OS_LINUX)
+Flags<CpuFeature> probe() {
+  Flags<CpuFeature> features;
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  if (hwcap & HWCAP_ASIMD) features |= CpuFeature::NEON;
+  if (hwcap & HWCAP_CRC32) features |= CpuFeature::CRC32;
+  #if defined(HWCAP_SVE)
+  if (hwcap & HWCAP_SVE) features |= CpuFeature::SVE;
+  #endif
+  return features;
+}
+#else
+Flags<CpuFeature> probe() {
+  Flags<CpuFeature> features;
+  #if defined(KT_COMPILER_SUPPORTS_NEON)
+  features |= CpuFeature::NEON;
+  #endif
+  return features;
+}
+#endif
+
+SimdLevel levelOf(Flags<CpuFeature> _features) {
+  for (SimdLevel level : {SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSE4_2}) {
+    if (hasAll(_features, featuresOf(level))) return level;
+  }
+  return SimdLevel::BASELINE;
+}
+
+struct CpuState {
+  Flags<CpuFeature> features;
+  SimdLevel level;
+};
+
+CpuState detect() {
+  Flags<CpuFeature> features = probe();
+  const char *cap            = std::getenv("KT_SIMD");
+  if (cap) {
+    // Drop every feature above the requested level; an unknown name leaves the probe unchanged
+    for (SimdLevel level : {SimdLevel::BASELINE, SimdLevel::SSE4_2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+      if (std::strcmp(cap, qSimdLevelName(level)) == 0) features &= featuresOf(level) | CpuFeature::NEON;
+    }
+  }
+  return {features, levelOf(features)};
+}
+
+const CpuState &state() {
+  static const CpuState cpu = detect();
+  return cpu;
+}
+
+}  // namespace
+
+Flags<CpuFeature> qCpuFeatures() noexcept { return state().features; }
+
+SimdLevel qSimdLevel() noexcept { return state().level; }
+
+const char *qSimdLevelName(SimdLevel _level) noexcept {
+  switch (_level) {
+    case SimdLevel::BASELINE: return "baseline";
+    case SimdLevel::SSE4_2: return "sse4.2";
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+  }
+  return "baseline";
+}
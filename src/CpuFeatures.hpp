@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include "Flags.hpp"
+#include "global/Simd.hpp"
+
+//! Instruction set extensions of the running CPU
+enum class CpuFeature : uint32_t {
+  NONE     = 0,
+  SSE2     = 1U << 0U,
+  SSSE3    = 1U << 1U,
+  SSE4_1   = 1U << 2U,
+  SSE4_2   = 1U << 3U,
+  POPCNT   = 1U << 4U,
+  AVX      = 1U << 5U,  // with the OS saving YMM state
+  AVX2     = 1U << 6U,
+  BMI1     = 1U << 7U,
+  BMI2     = 1U << 8U,
+  AVX512F  = 1U << 9U,  // with the OS saving ZMM and mask state
+  AVX512BW = 1U << 10U,
+  AVX512DQ = 1U << 11U,
+  AVX512VL = 1U << 12U,
+
+  NEON  = 1U << 16U,
+  CRC32 = 1U << 17U,
+  SVE   = 1U << 18U,
+};
+
+ENUM_FLAGS(CpuFeature);
+
+//! Levels SIMD kernels are built for, each a superset of the previous one
+/*!
+    BASELINE is what the compiler targets by default (SSE2 on x86-64, NEON on AArch64).
+    SSE4_2 adds SSSE3, SSE4.1, SSE4.2 and POPCNT; AVX2 adds AVX, AVX2, BMI1 and BMI2;
+    AVX512 adds AVX-512 F, BW, DQ and VL.
+*/
+enum class SimdLevel : uint8_t { BASELINE, SSE4_2, AVX2, AVX512 };
+
+//! Level the whole build targets (-msse4.2, -mavx2, -march=...), whatever the CPU supports
+constexpr SimdLevel C_COMPILER_SIMD_LEVEL =
+#if defined(KT_COMPILER_SUPPORTS_AVX512)
+    SimdLevel::AVX512;
+#elif defined(KT_COMPILER_SUPPORTS_AVX2)
+    SimdLevel::AVX2;
+#elif defined(KT_COMPILER_SUPPORTS_SSE4_2)
+    SimdLevel::SSE4_2;
+#else
+    SimdLevel::BASELINE;
+#endif
+
+//! Features of the running CPU, probed once (CPUID on x86, getauxval(AT_HWCAP) on AArch64)
+/*!
+    The environment variable KT_SIMD ("baseline", "sse4.2", "avx2" or "avx512") caps the result
+    at that level, so every kernel variant can be exercised on one machine. It is read on the
+    first call; later changes have no effect.
+*/
+Flags<CpuFeature> qCpuFeatures() noexcept;
+
+//! Is \a _feature available (and not disabled through KT_SIMD)?
+inline bool qCpuHasFeature(CpuFeature _feature) noexcept { return qCpuFeatures().isset(_feature); }
+
+//! Highest SimdLevel whose features are all available
+SimdLevel qSimdLevel() noexcept;
+
+//! "baseline", "sse4.2", "avx2" or "avx512"
+const char *qSimdLevelName(SimdLevel _level) noexcept;
+
+//! Pick the kernel variant for the running CPU
+/*!
+    Returns the variant of the highest level the CPU supports; null variants are skipped, so
+    only the levels a kernel actually has need to be given. Kernels resolve once and keep the
+    pointer:
+
+    \code{.cpp}
+    static const Kernel kernel = qResolveKernel<Kernel>(scalar, nullptr, avx2, avx512);
+    \endcode
+*/
+template <typename Fn>
+Fn qResolveKernel(Fn _baseline, Fn _sse42, Fn _avx2, Fn _avx512) noexcept {
+  const SimdLevel level = qSimdLevel();
+  if (level >= SimdLevel::AVX512 && _avx512) return _avx512;
+  if (level >= SimdLevel::AVX2 && _avx2) return _avx2;
+  if (level >= SimdLevel::SSE4_2 && _sse42) return _sse42;
+  return _baseline;
+}
@@ -0,0 +1,178 @@
+#include "Endian.hpp"
+
+#include "CpuFeatures.hpp"
+#include "global/Simd.hpp"
+
+namespace {
+
+template <typename T>
+inline void bswapScalar(const uint8_t *_src, std::size_t _bytes, uint8_t *_dst) {
+  for (std::size_t i = 0; i < _bytes; i += sizeof(T)) qToUnaligned<T>(qbswap(qFromUnaligned<T>(_src + i)), _dst + i);
+}
+
+#if defined(KT_COMPILER_SUPPORTS_SSSE3) || defined(KT_KERNELS_SSE4_2)
+// pshufb control reversing the bytes of every Size-byte element in a 16-byte lane
+template <std::size_t Size>
+inline __m128i swapMask() {
+  if constexpr (Size == 2) {
+    return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  } else if constexpr (Size == 4) {
+    return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  } else {
+    return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  }
+}
+
+// The block helpers convert whole vectors from offset _i on and return where they stopped.
+// Every vector is loaded before the store to the same offset, so source == dest is safe.
+template <std::size_t Size>
+KT_TARGET_SSE4_2 inline std::size_t swap16(const uint8_t *_src, std::size_t _bytes, uint8_t *_dst, std::size_t _i) {
+  const __m128i mask = swapMask<Size>();
+  for (; _i + 16 <= _bytes; _i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_src + _i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_dst + _i), _mm_shuffle_epi8(v, mask));
+  }
+  return _i;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX2)
+template <std::size_t Size>
+KT_TARGET_AVX2 inline std::size_t swap32(const uint8_t *_src, std::size_t _bytes, uint8_t *_dst, std::size_t _i) {
+  const __m256i mask = _mm256_broadcastsi128_si256(swapMask<Size>());
+  for (; _i + 128 <= _bytes; _i += 128) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_src + _i));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_src + _i + 32));
+    const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_src + _i + 64));
+    const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_src + _i + 96));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(_dst + _i), _mm256_shuffle_epi8(a, mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(_dst + _i + 32), _mm256_shuffle_epi8(b, mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(_dst + _i + 64), _mm256_shuffle_epi8(c, mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(_dst + _i + 96), _mm256_shuffle_epi8(d, mask));
+  }
+  for (; _i + 32 <= _bytes; _i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_src + _i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(_dst + _i), _mm256_shuffle_epi8(v, mask));
+  }
+  return _i;
+}
+#endif
+
+#if defined(KT_KERNELS_AVX512)
+// Converts everything: the last partial vector is loaded and stored under a byte mask
+template <std::size_t Size>
+KT_TARGET_AVX512 inline void swap64(const uint8_t *_src, std::size_t _bytes, uint8_t *_dst) {
+  const __m512i mask = _mm512_broadcast_i32x4(swapMask<Size>());
+  std::size_t i      = 0;
+  for (; i + 256 <= _bytes; i += 256) {
+    const __m512i a = _mm512_loadu_si512(_src + i);
+    const __m512i b = _mm512_loadu_si512(_src + i + 64);
+    const __m512i c = _mm512_loadu_si512(_src + i + 128);
+    const __m512i d = _mm512_loadu_si512(_src + i + 192);
+    _mm512_storeu_si512(_dst + i, _mm512_shuffle_epi8(a, mask));
+    _mm512_storeu_si512(_dst + i + 64, _mm512_shuffle_epi8(b, mask));
+    _mm512_storeu_si512(_dst + i + 128, _mm512_shuffle_epi8(c, mask));
+    _mm512_storeu_si512(_dst + i + 192, _mm512_shuffle_epi8(d, mask));
+  }
+  for (; i + 64 <= _bytes; i += 64) {
+    _mm512_storeu_si512(_dst + i, _mm512_shuffle_epi8(_mm512_loadu_si512(_src + i), mask));
+  }
+  if (i < _bytes) {
+    // Whole elements only: 64 is a multiple of Size
+    const __mmask64 tail = _cvtu64_mask64((uint64_t(1) << (_bytes - i)) - 1);
+    _mm512_mask_storeu_epi8(_dst + i, tail, _mm512_shuffle_epi8(_mm512_maskz_loadu_epi8(tail, _src + i), mask));
+  }
+}
+#endif
+
+#if defined(KT_COMPILER_SUPPORTS_NEON)
+template <std::size_t Size>
+inline uint8x16_t swapBytes(uint8x16_t _v) {
+  if constexpr (Size == 2) {
+    return vrev16q_u8(_v);
+  } else if constexpr (Size == 4) {
+    return vrev32q_u8(_v);
+  } else {
+    return vrev64q_u8(_v);
+  }
+}
+#endif
+
+// Whatever the build targets
+template <std::size_t Size, typename T>
+void *bswapBaseline(const void *_source, std::size_t _count, void *_dest) noexcept {
+  const auto *src         = static_cast<const uint8_t *>(_source);
+  auto *dst               = static_cast<uint8_t *>(_dest);
+  const std::size_t bytes = _count * Size;
+  std::size_t i           = 0;
+
+#if defined(KT_COMPILER_SUPPORTS_AVX2)
+  i = swap32<Size>(src, bytes, dst, i);
+#endif
+#if defined(KT_COMPILER_SUPPORTS_SSSE3)
+  i = swap16<Size>(src, bytes, dst, i);
+#elif defined(KT_COMPILER_SUPPORTS_NEON)
+  for (; i + 16 <= bytes; i += 16) vst1q_u8(dst + i, swapBytes<Size>(vld1q_u8(src + i)));
+#endif
+
+  bswapScalar<T>(src + i, bytes - i, dst + i);
+  return dst + bytes;
+}
+
+#if defined(KT_RUNTIME_DISPATCH)
+template <std::size_t Size, typename T>
+KT_TARGET_SSE4_2 void *bswapSse42(const void *_source, std::size_t _count, void *_dest) noexcept {
+  const auto *src         = static_cast<const uint8_t *>(_source);
+  auto *dst               = static_cast<uint8_t *>(_dest);
+  const std::size_t bytes = _count * Size;
+  const std::size_t i     = swap16<Size>(src, bytes, dst, 0);
+  bswapScalar<T>(src + i, bytes - i, dst + i);
+  return dst + bytes;
+}
+
+template <std::size_t Size, typename T>
+KT_TARGET_AVX2 void *bswapAvx2(const void *_source, std::size_t _count, void *_dest) noexcept {
+  const auto *src         = static_cast<const uint8_t *>(_source);
+  auto *dst               = static_cast<uint8_t *>(_dest);
+  const std::size_t bytes = _count * Size;
+  const std::size_t i     = swap16<Size>(src, bytes, dst, swap32<Size>(src, bytes, dst, 0));
+  bswapScalar<T>(src + i, bytes - i, dst + i);
+  return dst + bytes;
+}
+
+template <std::size_t Size, typename T>
+KT_TARGET_AVX512 void *bswapAvx512(const void *_source, std::size_t _count, void *_dest) noexcept {
+  auto *dst = static_cast<uint8_t *>(_dest);
+  swap64<Size>(static_cast<const uint8_t *>(_source), _count * Size, dst);
+  return dst + _count * Size;
+}
+#endif
+
+template <std::size_t Size, typename T>
+void *bswapBulk(const void *_source, std::size_t _count, void *_dest) noexcept {
+#if defined(KT_RUNTIME_DISPATCH)
+  using Kernel               = void *(*)(const void *, std::size_t, void *) noexcept;
+  static const Kernel kernel = qResolveKernel<Kernel>(
+      bswapBaseline<Size, T>, bswapSse42<Size, T>, bswapAvx2<Size, T>, bswapAvx512<Size, T>);
+  return kernel(_source, _count, _dest);
+#else
+  return bswapBaseline<Size, T>(_source, _count, _dest);
+#endif
+}
+
+}  // namespace
+
+template <>
+void *qbswap<2>(const void *source, std::size_t count, void *dest) noexcept {
+  return bswapBulk<2, uint16_t>(source, count, dest);
+}
+
+template <>
+void *qbswap<4>(const void *source, std::size_t count, void *dest) noexcept {
+  return bswapBulk<4, uint32_t>(source, count, dest);
+}
+
+template <>
+void *qbswap<8>(const void *source, std::size_t count, void *dest) noexcept {
+  return bswapBulk<8, uint64_t>(source, count, dest);
+}
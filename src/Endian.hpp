@@ -1,9 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <span>
 #include <type_traits>
+#include "global/Global.hpp"
 
 inline constexpr uint64_t qbswap_helper(uint64_t _source) {
+#if __has_builtin(__builtin_bswap64)
+  return __builtin_bswap64(_source);
+#else
   // clang-format off
     return 0U
         | ((_source & uint64_t(0x00000000000000ff)) << 56U)
@@ -15,9 +21,13 @@ inline constexpr uint64_t qbswap_helper(uint64_t _source) {
         | ((_source & uint64_t(0x00ff000000000000)) >> 40U)
         | ((_source & uint64_t(0xff00000000000000)) >> 56U);
   // clang-format on
+#endif
 }
 
 inline constexpr uint32_t qbswap_helper(uint32_t _source) {
+#if __has_builtin(__builtin_bswap32)
+  return __builtin_bswap32(_source);
+#else
   // clang-format off
     return 0U
         | ((_source & 0x000000ff) << 24U)
@@ -25,10 +35,15 @@ inline constexpr uint32_t qbswap_helper(uint32_t _source) {
         | ((_source & 0x00ff0000) >> 8U)
         | ((_source & 0xff000000) >> 24U);
   // clang-format on
+#endif
 }
 
 inline constexpr uint16_t qbswap_helper(uint16_t _source) {
+#if __has_builtin(__builtin_bswap16)
+  return __builtin_bswap16(_source);
+#else
   return uint16_t(0U | ((_source & 0x00ff) << 8) | ((_source & 0xff00) >> 8));
+#endif
 }
 
 inline constexpr uint8_t qbswap_helper(uint8_t _source) { return _source; }
@@ -48,6 +63,19 @@ Q_ALWAYS_INLINE void qToUnaligned(const T src, void *dest) {
       (dest, &src, size);
 }
 
+template <typename T>
+Q_ALWAYS_INLINE T qFromUnaligned(const void *src) {
+  T dest;
+  const std::size_t size = sizeof(T);
+#if __has_builtin(__builtin_memcpy)
+  __builtin_memcpy
+#else
+  memcpy
+#endif
+      (&dest, src, size);
+  return dest;
+}
+
 /*
  * T qbswap(T source).
  * Changes the byte order of a value from big-endian to little-endian or vice versa.
@@ -69,3 +97,128 @@ template <typename T>
 inline void qbswap(const T src, void *dest) {
   qToUnaligned<T>(qbswap(src), dest);
 }
+
+/*
+ * void *qbswap<Size>(const void *source, std::size_t count, void *dest).
+ * Changes the byte order of \a count elements of \a Size bytes read from \a source and stores
+ * them in \a dest, returning the end of the written range. \a source and \a dest may be the same
+ * buffer (in-place swap) but must not otherwise overlap. There are no alignment requirements.
+ * Uses AVX2 / SSSE3 pshufb or NEON vrev kernels when the target supports them.
+*/
+template <int Size>
+void *qbswap(const void *source, std::size_t count, void *dest) noexcept;
+
+template <>
+inline void *qbswap<1>(const void *source, std::size_t count, void *dest) noexcept {
+  if (source != dest) std::memcpy(dest, source, count);
+  return static_cast<uint8_t *>(dest) + count;
+}
+template <>
+void *qbswap<2>(const void *source, std::size_t count, void *dest) noexcept;
+template <>
+void *qbswap<4>(const void *source, std::size_t count, void *dest) noexcept;
+template <>
+void *qbswap<8>(const void *source, std::size_t count, void *dest) noexcept;
+
+/*
+ * qbswap(std::span<const T> in, std::span<T> out) / qbswap(std::span<T> inout).
+ * Span front-ends of the bulk swap. \a out must hold at least in.size() elements.
+*/
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+inline void qbswap(std::span<const T> in, std::span<T> out) noexcept {
+  qbswap<sizeof(T)>(in.data(), in.size(), out.data());
+}
+
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+inline void qbswap(std::span<T> inout) noexcept {
+  qbswap<sizeof(T)>(inout.data(), inout.size(), inout.data());
+}
+
+/*
+ * T qToBigEndian(T src) / T qFromBigEndian(T src).
+ * Converts a value between host byte order and big-endian (network) byte order.
+ * On big-endian hosts both are no-ops. The little-endian pair behaves the same way.
+*/
+template <typename T>
+inline constexpr T qToBigEndian(T source) {
+  if constexpr (C_BYTE_ORDER == C_BIG_ENDIAN) {
+    return source;
+  } else {
+    return qbswap(source);
+  }
+}
+
+template <typename T>
+inline constexpr T qFromBigEndian(T source) {
+  return qToBigEndian(source);
+}
+
+template <typename T>
+inline constexpr T qToLittleEndian(T source) {
+  if constexpr (C_BYTE_ORDER == C_LITTLE_ENDIAN) {
+    return source;
+  } else {
+    return qbswap(source);
+  }
+}
+
+template <typename T>
+inline constexpr T qFromLittleEndian(T source) {
+  return qToLittleEndian(source);
+}
+
+/*
+ * qToBigEndian(T src, void *dest) / T qFromBigEndian<T>(const void *src).
+ * Unaligned variants: write the converted value to, or read it from, an arbitrary address.
+*/
+template <typename T>
+inline void qToBigEndian(T src, void *dest) {
+  qToUnaligned<T>(qToBigEndian(src), dest);
+}
+
+template <typename T>
+inline T qFromBigEndian(const void *src) {
+  return qFromBigEndian(qFromUnaligned<T>(src));
+}
+
+template <typename T>
+inline void qToLittleEndian(T src, void *dest) {
+  qToUnaligned<T>(qToLittleEndian(src), dest);
+}
+
+template <typename T>
+inline T qFromLittleEndian(const void *src) {
+  return qFromLittleEndian(qFromUnaligned<T>(src));
+}
+
+/*
+ * qToBigEndian(std::span<const T> in, std::span<T> out) and friends.
+ * Bulk conversions: a byte swap on hosts of the opposite byte order, otherwise a copy.
+*/
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+inline void qToBigEndian(std::span<const T> in, std::span<T> out) noexcept {
+  if constexpr (C_BYTE_ORDER == C_BIG_ENDIAN) {
+    qbswap<1>(in.data(), in.size_bytes(), out.data());
+  } else {
+    qbswap<sizeof(T)>(in.data(), in.size(), out.data());
+  }
+}
+
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+inline void qFromBigEndian(std::span<const T> in, std::span<T> out) noexcept {
+  qToBigEndian(in, out);
+}
+
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+inline void qToLittleEndian(std::span<const T> in, std::span<T> out) noexcept {
+  if constexpr (C_BYTE_ORDER == C_LITTLE_ENDIAN) {
+    qbswap<1>(in.data(), in.size_bytes(), out.data());
+  } else {
+    qbswap<sizeof(T)>(in.data(), in.size(), out.data());
+  }
+}
+
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+inline void qFromLittleEndian(std::span<const T> in, std::span<T> out) noexcept {
+  qToLittleEndian(in, out);
+}
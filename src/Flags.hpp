@@ -1,7 +1,10 @@
 #pragma once
 
+#include <bit>
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <type_traits>
 
 //! Enum-based flags false checker
@@ -47,13 +50,15 @@ constexpr inline bool is_enum_flags_v = IsEnumFlags<TEnum>::value;
     Helper class for enum based flags which wraps particular enum as a template parameter
     and provides flags manipulation operators and methods.
 
-    Not thread-safe.
+    The storage is the unsigned counterpart of the enum's underlying type, up to 64 bits, and
+    every operation is constexpr, so masks built from enum values fold at compile time. For
+    enum-indexed sets larger than 64 bits, see BitFlags.
+
+    Not thread-safe; see AtomicFlags.
 */
 template <typename TEnum>
 class Flags {
-  static_assert((sizeof(TEnum) <= sizeof(uint32_t)),
-      "Flags uses an int as storage, so an enum with underlying "
-      "long long will overflow.");
+  static_assert((sizeof(TEnum) <= sizeof(uint64_t)), "Flags supports enums of up to 64 bits, see BitFlags.");
   static_assert((std::is_enum_v<TEnum>), "Flags is only usable on enumeration types.");
   //! Enum underlying type
   using type = std::make_unsigned_t<std::underlying_type_t<TEnum>>;
@@ -62,9 +67,11 @@ public:
   constexpr inline Flags() noexcept : _value(0) {}
   constexpr inline Flags(type value) noexcept : _value(value) {}
   constexpr inline Flags(TEnum value) noexcept : _value(type(value)) {}
-  Flags(const Flags &) noexcept = default;
-  Flags(Flags &&) noexcept      = default;
-  ~Flags() noexcept             = default;
+  constexpr Flags(const Flags &) noexcept            = default;
+  constexpr Flags(Flags &&) noexcept                 = default;
+  constexpr Flags &operator=(const Flags &) noexcept = default;
+  constexpr Flags &operator=(Flags &&) noexcept      = default;
+  constexpr ~Flags() noexcept                        = default;
 
   // clang-format off
   constexpr Flags &operator=(type value) noexcept { _value = value; return *this; }
@@ -93,16 +100,26 @@ public:
   // constexpr inline Flags &operator^=(type _val) noexcept { _value ^= _val; return *this; }
 
   //! Flags logical friend operators
-  friend Flags operator&(const Flags &flags1, const Flags &flags2) noexcept { return Flags(flags1._value & flags2._value); }
-  friend Flags operator|(const Flags &flags1, const Flags &flags2) noexcept { return Flags(flags1._value | flags2._value); }
-  friend Flags operator^(const Flags &flags1, const Flags &flags2) noexcept { return Flags(flags1._value ^ flags2._value); }
+  friend constexpr Flags operator&(const Flags &flags1, const Flags &flags2) noexcept {
+    return Flags(flags1._value & flags2._value);
+  }
+  friend constexpr Flags operator|(const Flags &flags1, const Flags &flags2) noexcept {
+    return Flags(flags1._value | flags2._value);
+  }
+  friend constexpr Flags operator^(const Flags &flags1, const Flags &flags2) noexcept {
+    return Flags(flags1._value ^ flags2._value);
+  }
 
   // Flags comparison
-  friend bool operator==(const Flags &flags1, const Flags &flags2) noexcept { return flags1._value == flags2._value; }
-  friend bool operator!=(const Flags &flags1, const Flags &flags2) noexcept { return flags1._value != flags2._value; }
+  friend constexpr bool operator==(const Flags &flags1, const Flags &flags2) noexcept {
+    return flags1._value == flags2._value;
+  }
+  friend constexpr bool operator!=(const Flags &flags1, const Flags &flags2) noexcept {
+    return flags1._value != flags2._value;
+  }
 
   //! Convert to the enum value
-  explicit operator TEnum() const noexcept { return TEnum(_value); }
+  constexpr explicit operator TEnum() const noexcept { return TEnum(_value); }
 
   //! Is any flag set?
   [[nodiscard]] constexpr bool isset() const noexcept { return (_value != 0); }
@@ -112,14 +129,39 @@ public:
   [[nodiscard]] constexpr bool isset(TEnum value) const noexcept { return (_value & (type)value) != 0; }
 
   //! Get the enum value
-  [[nodiscard]] TEnum value() const noexcept { return (TEnum)_value; }
+  [[nodiscard]] constexpr TEnum value() const noexcept { return (TEnum)_value; }
   //! Get the underlying enum value
-  [[nodiscard]] type underlying() const noexcept { return _value; }
+  [[nodiscard]] constexpr type underlying() const noexcept { return _value; }
   //! Get the bitset value
-  std::bitset<sizeof(type) * 8> bitset() const noexcept { return {_value}; }
+  constexpr std::bitset<sizeof(type) * 8> bitset() const noexcept { return {_value}; }
+
+  //! Number of flags set
+  [[nodiscard]] constexpr int count() const noexcept { return std::popcount(_value); }
+  //! Lowest flag set, or NONE (0) if there is none
+  [[nodiscard]] constexpr TEnum first() const noexcept { return TEnum(_value & (~_value + 1)); }
+
+  //! Iterates over the flags set, lowest first, each as a single-bit enum value
+  class iterator {
+  public:
+    using value_type        = TEnum;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    constexpr iterator() noexcept = default;
+    constexpr explicit iterator(type bits) noexcept : _bits(bits) {}
+    constexpr TEnum operator*() const noexcept { return TEnum(_bits & (~_bits + 1)); }
+    constexpr iterator &operator++() noexcept { _bits &= type(_bits - 1); return *this; }
+    constexpr iterator operator++(int) noexcept { iterator previous = *this; ++*this; return previous; }
+    friend constexpr bool operator==(const iterator &, const iterator &) noexcept = default;
+
+  private:
+    type _bits {0};
+  };
+  [[nodiscard]] constexpr iterator begin() const noexcept { return iterator(_value); }
+  [[nodiscard]] constexpr iterator end() const noexcept { return iterator(); }
 
   //! Swap two instances
-  void swap(Flags &flags) noexcept {
+  constexpr void swap(Flags &flags) noexcept {
     using std::swap;
     swap(_value, flags._value);
   }
@@ -101,11 +101,11 @@ public:
   constexpr inline void operator-(Enum other) const noexcept   = delete;
   constexpr inline void operator-(int other) const noexcept    = delete;
 
-  constexpr inline bool testFlag(Enum flag) const noexcept { return testFlags(flag); }
+  constexpr inline bool testFlag(Enum flag) const noexcept { return testFlags(QFlags(flag)); }
   constexpr inline bool testFlags(QFlags flags) const noexcept {
     return flags.i ? ((i & flags.i) == flags.i) : i == Int(0);
   }
-  constexpr inline bool testAnyFlag(Enum flag) const noexcept { return testAnyFlags(flag); }
+  constexpr inline bool testAnyFlag(Enum flag) const noexcept { return testAnyFlags(QFlags(flag)); }
   constexpr inline bool testAnyFlags(QFlags flags) const noexcept { return (i & flags.i) != Int(0); }
   constexpr inline QFlags &setFlag(Enum flag, bool on = true) noexcept {
     return on ? (*this |= flag) : (*this &= ~QFlags(flag));
@@ -163,4 +163,4 @@ private:
   constexpr inline void operator+(int f1, Flags::enum_type f2) noexcept                      = delete; \
   constexpr inline void operator+(Flags::enum_type f1, int f2) noexcept                      = delete; \
   constexpr inline void operator-(int f1, Flags::enum_type f2) noexcept                      = delete; \
-  constexpr inline void operator-(Flags::enum_type f1, int f2) noexcept                      = delete;\
+  constexpr inline void operator-(Flags::enum_type f1, int f2) noexcept                      = delete;
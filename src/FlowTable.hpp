@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Endian.hpp"
+
+namespace network {
+
+//! Connection 5-tuple: two addresses with their ports, and the IP protocol number
+/*!
+    Five words, 40 bytes: both addresses in their IPv6 form (see Address::toIPv6Address()), then
+    the ports, the protocol number and the protocol of each Address. Trivially copyable and
+    compared word by word.
+*/
+class FlowKey {
+public:
+  static constexpr std::size_t C_WORDS = 5;
+
+  FlowKey() = default;
+  FlowKey(const Address &_source, uint16_t _sourcePort, const Address &_destination, uint16_t _destinationPort,
+      uint8_t _protocol) {
+    const IPv6Address source      = _source.toIPv6Address();
+    const IPv6Address destination = _destination.toIPv6Address();
+    std::memcpy(words_, source.c, sizeof(source.c));
+    std::memcpy(words_ + 2, destination.c, sizeof(destination.c));
+    words_[4] = uint64_t(_sourcePort) | uint64_t(_destinationPort) << 16U | uint64_t(_protocol) << 32U |
+                uint64_t(uint8_t(_source.getProtocol())) << 40U | uint64_t(uint8_t(_destination.getProtocol())) << 48U;
+  }
+
+  [[nodiscard]] Address source() const { return address(0, LayerProtocol(int8_t(words_[4] >> 40U))); }
+  [[nodiscard]] Address destination() const { return address(2, LayerProtocol(int8_t(words_[4] >> 48U))); }
+  [[nodiscard]] uint16_t sourcePort() const { return uint16_t(words_[4]); }
+  [[nodiscard]] uint16_t destinationPort() const { return uint16_t(words_[4] >> 16U); }
+  [[nodiscard]] uint8_t protocol() const { return uint8_t(words_[4] >> 32U); }
+  //! Key of the opposite direction
+  [[nodiscard]] FlowKey reversed() const {
+    return {destination(), destinationPort(), source(), sourcePort(), protocol()};
+  }
+
+  [[nodiscard]] const uint64_t *words() const noexcept { return words_; }
+  friend bool operator==(const FlowKey &, const FlowKey &) = default;
+
+private:
+  [[nodiscard]] Address address(std::size_t _word, LayerProtocol _protocol) const {
+    switch (_protocol) {
+      case LayerProtocol::IPv4: return Address(uint32_t(qFromBigEndian(words_[_word + 1])));
+      case LayerProtocol::IPv6: {
+        IPv6Address ip6;
+        std::memcpy(ip6.c, words_ + _word, sizeof(ip6.c));
+        return Address(ip6);
+      }
+      case LayerProtocol::ANY_IP: return Address(Address::SpecialAddress::ANY);
+      case LayerProtocol::UNKNOWN: break;
+    }
+    return {};
+  }
+
+  uint64_t words_[C_WORDS] {};
+};
+
+//! 64-bit hash of a flow key, mixed like qHash(const Address &)
+inline std::size_t qHash(const FlowKey &_key, std::size_t _seed = 0) noexcept {
+  const uint64_t *words = _key.words();
+  const uint64_t source =
+      detail::foldedMultiply(words[0] ^ 0xa0761d6478bd642fULL ^ _seed, words[1] ^ 0xe7037ed1a0b428dbULL);
+  const uint64_t target = detail::foldedMultiply(words[2] ^ 0x8ebc6af09c88c6e3ULL, words[3] ^ 0x589965cc75374cc3ULL);
+  return std::size_t(detail::foldedMultiply(source ^ words[4], target ^ 0x1d8e4e27c47d124fULL));
+}
+
+//! Concurrent, bounded table of per-flow state keyed by FlowKey
+/*!
+    Built for connection tracking, where every worker thread looks up and updates flows:
+    - Sharded: the hash picks one of shardCount() shards, four per hardware thread by default,
+      each with its own lock, so writers on different cores rarely meet.
+    - Lock-free reads: find() takes no lock and writes nothing shared. Every slot is guarded by a
+      sequence counter (a seqlock); a reader copies the key and value and retries if a writer
+      changed the slot meanwhile.
+    - Bounded: the capacity is fixed at construction. A flow lives in one bucket of eight slots
+      chosen by its hash; inserting into a full bucket evicts the flow of the bucket seen least
+      recently.
+    - Incremental expiry: expire() removes idle flows from a few buckets per shard per call,
+      continuing where the previous call stopped, so no call walks the whole table.
+
+    V must be trivially copyable: find() returns a copy. Timestamps are the caller's, in any
+    monotonic unit (e.g. seconds or ticks of a coarse clock), which saves reading a clock per
+    packet. Only insert() and update() refresh the last-seen time of a flow.
+
+    A find() concurrent with a modification of the same flow returns the value before or after it.
+*/
+template <typename V>
+class FlowTable {
+  static_assert(std::is_trivially_copyable_v<V> && std::is_default_constructible_v<V>,
+      "FlowTable values are copied out by lock-free readers");
+  static_assert(alignof(V) <= alignof(uint64_t), "FlowTable values are stored as 64-bit words");
+
+public:
+  //! Table of at least \a _capacity flows, idle ones expiring after \a _idleTimeout (0: never)
+  explicit FlowTable(std::size_t _capacity, uint64_t _idleTimeout = 0, std::size_t _shards = 0);
+  FlowTable(const FlowTable &)            = delete;
+  FlowTable &operator=(const FlowTable &) = delete;
+
+  //! Copy the state of \a _key into \a _value; false if the flow is not in the table
+  bool find(const FlowKey &_key, V &_value) const { return read(_key, &_value); }
+  [[nodiscard]] bool contains(const FlowKey &_key) const { return read(_key, nullptr); }
+
+  //! Set the state of \a _key, seen at \a _now. Returns true if the flow was new.
+  bool insert(const FlowKey &_key, const V &_value, uint64_t _now) {
+    return modify(_key, _now, [&_value](V &_state) { _state = _value; });
+  }
+  //! Call \a _function with the state of \a _key, V() for a new flow, and store the result.
+  //! Returns true if the flow was new. Runs under the shard lock, so keep it short.
+  template <typename F>
+  bool update(const FlowKey &_key, uint64_t _now, F &&_function) {
+    return modify(_key, _now, _function);
+  }
+  bool erase(const FlowKey &_key);
+
+  //! Remove the flows idle for longer than the timeout from the next \a _buckets buckets of each
+  //! shard. Returns the number removed.
+  std::size_t expire(uint64_t _now, std::size_t _buckets);
+  void clear();
+
+  [[nodiscard]] std::size_t size() const noexcept;
+  [[nodiscard]] std::size_t capacity() const noexcept {
+    return (shardMask_ + 1) * (bucketMask_ + 1) * C_BUCKET_SLOTS;
+  }
+  [[nodiscard]] std::size_t shardCount() const noexcept { return shardMask_ + 1; }
+  //! Flows dropped so far to make room in a full bucket
+  [[nodiscard]] std::size_t evictions() const noexcept;
+
+private:
+  static constexpr std::size_t C_BUCKET_SLOTS = 8;
+  static constexpr std::size_t C_VALUE_WORDS  = (sizeof(V) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  static constexpr uint64_t C_LSBS            = 0x0101010101010101ULL;
+  static constexpr uint64_t C_MSBS            = 0x8080808080808080ULL;
+
+  // Key and value are stored as relaxed atomic words, so the racing copies of readers are defined
+  struct Slot {
+    std::atomic<uint32_t> sequence {0};  // odd while a writer changes the slot
+    std::atomic<uint64_t> key[FlowKey::C_WORDS] {};
+    std::atomic<uint64_t> lastSeen {0};
+    std::atomic<uint64_t> value[C_VALUE_WORDS] {};
+  };
+
+  struct alignas(64) Bucket {
+    std::atomic<uint64_t> tags {0};  // byte i: 7 hash bits with the high bit set if slot i is used, else 0
+    Slot slots[C_BUCKET_SLOTS];
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t cursor {0};  // next bucket for expire()
+    std::atomic<std::size_t> size {0};
+    std::atomic<std::size_t> evictions {0};
+  };
+
+  static uint8_t tagOf(std::size_t _hash) { return uint8_t(0x80U | (_hash >> 57U)); }
+  // Bytes of _tags equal to _tag, as their high bits; may report a false positive in the byte
+  // following a true match, the keys are compared anyway
+  static uint64_t matchTags(uint64_t _tags, uint8_t _tag) {
+    const uint64_t x = _tags ^ (C_LSBS * _tag);
+    return (x - C_LSBS) & ~x & C_MSBS;
+  }
+
+  Shard &shardOf(std::size_t _hash) const { return shards_[(_hash >> 32U) & shardMask_]; }
+
+  bool read(const FlowKey &_key, V *_value) const;
+  template <typename F>
+  bool modify(const FlowKey &_key, uint64_t _now, F &&_function);
+  // Slot of _key in _bucket, or C_BUCKET_SLOTS; the caller holds the shard lock
+  static std::size_t findLocked(const Bucket &_bucket, uint64_t _tags, uint8_t _tag, const FlowKey &_key);
+  static void write(Slot &_slot, const FlowKey &_key, const V &_value, uint64_t _now);
+
+  std::unique_ptr<Shard[]> shards_;
+  std::size_t shardMask_ {0};
+  std::size_t bucketMask_ {0};
+  uint64_t idleTimeout_ {0};
+};
+
+template <typename V>
+FlowTable<V>::FlowTable(std::size_t _capacity, uint64_t _idleTimeout, std::size_t _shards)
+    : idleTimeout_(_idleTimeout) {
+  if (_shards == 0) _shards = std::size_t(std::max(1U, std::thread::hardware_concurrency())) * 4;
+  const std::size_t shards     = std::bit_ceil(_shards);
+  const std::size_t shardSlots = shards * C_BUCKET_SLOTS;
+  const std::size_t buckets    = std::bit_ceil(std::max<std::size_t>(1, (_capacity + shardSlots - 1) / shardSlots));
+  shardMask_  = shards - 1;
+  bucketMask_ = buckets - 1;
+  shards_     = std::make_unique<Shard[]>(shards);
+  for (std::size_t i = 0; i < shards; ++i) shards_[i].buckets = std::make_unique<Bucket[]>(buckets);
+}
+
+template <typename V>
+bool FlowTable<V>::read(const FlowKey &_key, V *_value) const {
+  const std::size_t hash = qHash(_key);
+  const Bucket &bucket   = shardOf(hash).buckets[hash & bucketMask_];
+  for (uint64_t match = matchTags(bucket.tags.load(std::memory_order_acquire), tagOf(hash)); match != 0;
+       match &= match - 1) {
+    const Slot &slot = bucket.slots[std::countr_zero(match) / 8];
+    uint64_t key[FlowKey::C_WORDS];
+    uint64_t value[C_VALUE_WORDS];
+    for (;;) {
+      const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+      if ((before & 1U) != 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      for (std::size_t i = 0; i < FlowKey::C_WORDS; ++i) key[i] = slot.key[i].load(std::memory_order_relaxed);
+      if (_value) {
+        for (std::size_t i = 0; i < C_VALUE_WORDS; ++i) value[i] = slot.value[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == before) break;
+    }
+    if (std::memcmp(key, _key.words(), sizeof(key)) != 0) continue;
+    if (_value) std::memcpy(static_cast<void *>(_value), value, sizeof(V));
+    return true;
+  }
+  return false;
+}
+
+template <typename V>
+std::size_t FlowTable<V>::findLocked(const Bucket &_bucket, uint64_t _tags, uint8_t _tag, const FlowKey &_key) {
+  for (uint64_t match = matchTags(_tags, _tag); match != 0; match &= match - 1) {
+    const std::size_t index = std::size_t(std::countr_zero(match)) / 8;
+    const Slot &slot        = _bucket.slots[index];
+    bool same               = true;
+    for (std::size_t i = 0; i < FlowKey::C_WORDS; ++i) {
+      same &= slot.key[i].load(std::memory_order_relaxed) == _key.words()[i];
+    }
+    if (same) return index;
+  }
+  return C_BUCKET_SLOTS;
+}
+
+template <typename V>
+void FlowTable<V>::write(Slot &_slot, const FlowKey &_key, const V &_value, uint64_t _now) {
+  uint64_t value[C_VALUE_WORDS] = {};
+  std::memcpy(value, static_cast<const void *>(&_value), sizeof(V));
+
+  const uint32_t sequence = _slot.sequence.load(std::memory_order_relaxed);
+  _slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (std::size_t i = 0; i < FlowKey::C_WORDS; ++i) _slot.key[i].store(_key.words()[i], std::memory_order_relaxed);
+  for (std::size_t i = 0; i < C_VALUE_WORDS; ++i) _slot.value[i].store(value[i], std::memory_order_relaxed);
+  _slot.lastSeen.store(_now, std::memory_order_relaxed);
+  _slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template <typename V>
+template <typename F>
+bool FlowTable<V>::modify(const FlowKey &_key, uint64_t _now, F &&_function) {
+  const std::size_t hash = qHash(_key);
+  const uint8_t tag      = tagOf(hash);
+  Shard &shard           = shardOf(hash);
+  Bucket &bucket         = shard.buckets[hash & bucketMask_];
+
+  const std::lock_guard<std::mutex> lock(shard.mutex);
+  const uint64_t tags = bucket.tags.load(std::memory_order_relaxed);
+  std::size_t index   = findLocked(bucket, tags, tag, _key);
+  V state {};
+  if (index != C_BUCKET_SLOTS) {
+    uint64_t value[C_VALUE_WORDS];
+    for (std::size_t i = 0; i < C_VALUE_WORDS; ++i) {
+      value[i] = bucket.slots[index].value[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(static_cast<void *>(&state), value, sizeof(V));
+    _function(state);
+    write(bucket.slots[index], _key, state, _now);
+    return false;
+  }
+
+  // A free slot, else the one seen least recently
+  index = 0;
+  for (std::size_t i = 0; i < C_BUCKET_SLOTS; ++i) {
+    if (uint8_t(tags >> (i * 8)) == 0) {
+      index = i;
+      break;
+    }
+    if (bucket.slots[i].lastSeen.load(std::memory_order_relaxed) <
+        bucket.slots[index].lastSeen.load(std::memory_order_relaxed)) {
+      index = i;
+    }
+  }
+  if (uint8_t(tags >> (index * 8)) != 0) {
+    shard.evictions.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    shard.size.fetch_add(1, std::memory_order_relaxed);
+  }
+  _function(state);
+  write(bucket.slots[index], _key, state, _now);
+  const uint64_t used = (tags & ~(uint64_t(0xff) << (index * 8))) | uint64_t(tag) << (index * 8);
+  bucket.tags.store(used, std::memory_order_release);
+  return true;
+}
+
+template <typename V>
+bool FlowTable<V>::erase(const FlowKey &_key) {
+  const std::size_t hash = qHash(_key);
+  Shard &shard           = shardOf(hash);
+  Bucket &bucket         = shard.buckets[hash & bucketMask_];
+
+  const std::lock_guard<std::mutex> lock(shard.mutex);
+  const uint64_t tags     = bucket.tags.load(std::memory_order_relaxed);
+  const std::size_t index = findLocked(bucket, tags, tagOf(hash), _key);
+  if (index == C_BUCKET_SLOTS) return false;
+  bucket.tags.store(tags & ~(uint64_t(0xff) << (index * 8)), std::memory_order_release);
+  shard.size.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+template <typename V>
+std::size_t FlowTable<V>::expire(uint64_t _now, std::size_t _buckets) {
+  if (idleTimeout_ == 0) return 0;
+  _buckets            = std::min(_buckets, bucketMask_ + 1);
+  std::size_t removed = 0;
+  for (std::size_t s = 0; s <= shardMask_; ++s) {
+    Shard &shard = shards_[s];
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    for (std::size_t n = 0; n < _buckets; ++n) {
+      Bucket &bucket = shard.buckets[shard.cursor];
+      shard.cursor   = (shard.cursor + 1) & bucketMask_;
+      uint64_t tags  = bucket.tags.load(std::memory_order_relaxed);
+      for (std::size_t i = 0; i < C_BUCKET_SLOTS; ++i) {
+        // lastSeen + timeout < now rather than now - lastSeen, as threads may pass slightly older times
+        if (uint8_t(tags >> (i * 8)) != 0 &&
+            bucket.slots[i].lastSeen.load(std::memory_order_relaxed) + idleTimeout_ < _now) {
+          tags &= ~(uint64_t(0xff) << (i * 8));
+          ++removed;
+          shard.size.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+      bucket.tags.store(tags, std::memory_order_release);
+    }
+  }
+  return removed;
+}
+
+template <typename V>
+void FlowTable<V>::clear() {
+  for (std::size_t s = 0; s <= shardMask_; ++s) {
+    Shard &shard = shards_[s];
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    for (std::size_t b = 0; b <= bucketMask_; ++b) shard.buckets[b].tags.store(0, std::memory_order_release);
+    shard.size.store(0, std::memory_order_relaxed);
+  }
+}
+
+template <typename V>
+std::size_t FlowTable<V>::size() const noexcept {
+  std::size_t total = 0;
+  for (std::size_t s = 0; s <= shardMask_; ++s) total += shards_[s].size.load(std::memory_order_relaxed);
+  return total;
+}
+
+template <typename V>
+std::size_t FlowTable<V>::evictions() const noexcept {
+  std::size_t total = 0;
+  for (std::size_t s = 0; s <= shardMask_; ++s) total += shards_[s].evictions.load(std::memory_order_relaxed);
+  return total;
+}
+
+}  // namespace network
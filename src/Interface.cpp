@@ -0,0 +1,258 @@
+#include "Interface.hpp"
+
+#include <net/if.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "Endian.hpp"
+#include "InterfaceLoader.hpp"
+
+namespace network {
+
+namespace {
+
+// Interface count of the last full load: the list is reserved up front instead of growing
+// through the link dump, which matters most when it is allocated from a monotonic arena
+std::atomic<std::size_t> lastLoadCount {0};
+
+}  // namespace
+
+bool InterfaceLoader::load(std::pmr::vector<Interface> &_list) {
+  if (!socket_.open()) return false;
+  list_                      = &_list;
+  const std::size_t expected = filter_ != 0 ? 1 : lastLoadCount.load(std::memory_order_relaxed);
+  for (int attempt = 1;; ++attempt) {
+    _list.clear();
+    _list.reserve(expected);
+    positions_.clear();
+    positions_.reserve(expected);
+    gateways_.clear();
+    // A dump interrupted by a concurrent change is retried a few times; on a host that keeps
+    // changing, the last one is still a usable snapshot.
+    const bool complete = dumpAll();
+    if (complete || (errno == EAGAIN && attempt == C_DUMP_RETRIES)) {
+      assignGateways();
+      if (filter_ == 0) lastLoadCount.store(_list.size(), std::memory_order_relaxed);
+      return true;
+    }
+    if (errno != EAGAIN) break;
+  }
+  _list.clear();
+  return false;
+}
+
+bool InterfaceLoader::dumpAll() {
+  // An interrupted dump is still read to the end, so every table is filled either way
+  bool interrupted    = false;
+  const auto finished = [&](bool _complete) {
+    if (!_complete && errno == EAGAIN) interrupted = true;
+    return _complete || errno == EAGAIN;
+  };
+
+  // Per-link statistics make up most of an RTM_NEWLINK message and are not needed here
+  ifinfomsg link {};
+  link.ifi_index = filter_;
+  netlink::Message request(RTM_GETLINK, filter_ != 0 ? NLM_F_REQUEST : NLM_F_REQUEST | NLM_F_DUMP, link);
+  request.addAttribute(IFLA_EXT_MASK, uint32_t(RTEXT_FILTER_SKIP_STATS));
+  if (!finished(socket_.transact(request.header(), [this](const nlmsghdr &_message) { onLink(_message); }))) {
+    return false;
+  }
+
+  ifaddrmsg address {};
+  address.ifa_index = uint32_t(filter_);
+  if (!finished(socket_.dump(RTM_GETADDR, address, [this](const nlmsghdr &_message) { onAddress(_message); }))) {
+    return false;
+  }
+
+  // With strict checking the kernel also filters routes by output interface; otherwise the routes
+  // of other interfaces find no Interface and are dropped by assignGateways()
+  rtmsg route {};
+  route.rtm_family = AF_INET;
+  route.rtm_table  = RT_TABLE_MAIN;
+  netlink::Message routes(RTM_GETROUTE, NLM_F_REQUEST | NLM_F_DUMP, route);
+  if (filter_ != 0 && socket_.isStrict()) routes.addAttribute(RTA_OIF, uint32_t(filter_));
+  if (!finished(socket_.transact(routes.header(), [this](const nlmsghdr &_message) { onRoute(_message); }))) {
+    return false;
+  }
+
+  if (interrupted) errno = EAGAIN;
+  return !interrupted;
+}
+
+Interface *InterfaceLoader::find(int _index) {
+  const auto it = positions_.find(_index);
+  return it == positions_.end() ? nullptr : &(*list_)[it->second];
+}
+
+bool InterfaceLoader::applyLink(const nlmsghdr &_message, Interface &_interface) {
+  const auto *info                       = static_cast<const ifinfomsg *>(NLMSG_DATA(&_message));
+  const rtattr *attributes[IFLA_MTU + 1] = {};
+  netlink::parseAttributes(IFLA_RTA(info), IFLA_PAYLOAD(&_message), attributes);
+  if (!attributes[IFLA_IFNAME]) return false;
+
+  _interface.name_.assign(netlink::attributeString(attributes[IFLA_IFNAME]));
+  _interface.index_ = info->ifi_index;
+  _interface.flags_ = info->ifi_flags;
+  if (attributes[IFLA_MTU]) _interface.mtu_ = netlink::attributeValue<uint32_t>(attributes[IFLA_MTU]);
+  return true;
+}
+
+void InterfaceLoader::applyAddress(const nlmsghdr &_message, Interface &_interface) {
+  const auto *info                        = static_cast<const ifaddrmsg *>(NLMSG_DATA(&_message));
+  const rtattr *attributes[IFA_LOCAL + 1] = {};
+  netlink::parseAttributes(IFA_RTA(info), IFA_PAYLOAD(&_message), attributes);
+  // On point-to-point links IFA_ADDRESS is the peer and IFA_LOCAL the local end
+  const rtattr *address = attributes[IFA_LOCAL] ? attributes[IFA_LOCAL] : attributes[IFA_ADDRESS];
+  if (!address) return;
+  const bool removed = _message.nlmsg_type == RTM_DELADDR;
+
+  if (info->ifa_family == AF_INET && RTA_PAYLOAD(address) >= 4) {
+    const uint32_t ip4  = qFromBigEndian<uint32_t>(RTA_DATA(address));
+    const uint32_t mask = info->ifa_prefixlen == 0 ? 0 : ~uint32_t(0) << (32U - info->ifa_prefixlen);
+
+    auto &rows    = _interface.rows4_;
+    const auto it = std::find_if(rows.begin(), rows.end(), [&](const Addr4Entry &_row) { return _row.ipv4_ == ip4; });
+    if (removed) {
+      if (it != rows.end()) rows.erase(it);
+    } else if (it != rows.end()) {
+      it->netmask_ = mask;
+    } else {
+      rows.push_back(Addr4Entry {ip4, 0, mask});
+    }
+  } else if (info->ifa_family == AF_INET6 && RTA_PAYLOAD(address) >= 16) {
+    Addr6Entry entry {};
+    std::memcpy(entry.ipv6_.c, RTA_DATA(address), sizeof(entry.ipv6_.c));
+    entry.netmask_.setPrefixLength(LayerProtocol::IPv6, info->ifa_prefixlen);
+
+    auto &rows    = _interface.rows6_;
+    const auto it = std::find_if(rows.begin(), rows.end(), [&](const Addr6Entry &_row) {
+      return std::memcmp(_row.ipv6_.c, entry.ipv6_.c, sizeof(entry.ipv6_.c)) == 0;
+    });
+    if (removed) {
+      if (it != rows.end()) rows.erase(it);
+    } else if (it != rows.end()) {
+      *it = entry;
+    } else {
+      rows.push_back(entry);
+    }
+  }
+}
+
+void InterfaceLoader::onLink(const nlmsghdr &_message) {
+  if (_message.nlmsg_type != RTM_NEWLINK) return;
+  const auto *info = static_cast<const ifinfomsg *>(NLMSG_DATA(&_message));
+  if (filter_ != 0 && info->ifi_index != filter_) return;
+
+  Interface interface(list_->get_allocator());
+  if (!applyLink(_message, interface)) return;
+  list_->push_back(std::move(interface));
+  positions_.emplace(info->ifi_index, list_->size() - 1);
+}
+
+void InterfaceLoader::onAddress(const nlmsghdr &_message) {
+  if (_message.nlmsg_type != RTM_NEWADDR) return;
+  const auto *info = static_cast<const ifaddrmsg *>(NLMSG_DATA(&_message));
+  if (Interface *interface = find(int(info->ifa_index))) applyAddress(_message, *interface);
+}
+
+void InterfaceLoader::onRoute(const nlmsghdr &_message) {
+  if (_message.nlmsg_type != RTM_NEWROUTE) return;
+  const auto *info = static_cast<const rtmsg *>(NLMSG_DATA(&_message));
+  if (info->rtm_family != AF_INET || info->rtm_type != RTN_UNICAST) return;
+
+  const rtattr *attributes[RTA_TABLE + 1] = {};
+  netlink::parseAttributes(RTM_RTA(info), RTM_PAYLOAD(&_message), attributes);
+  const uint32_t table =
+      attributes[RTA_TABLE] ? netlink::attributeValue<uint32_t>(attributes[RTA_TABLE]) : info->rtm_table;
+  if (table != RT_TABLE_MAIN) return;
+
+  if (attributes[RTA_GATEWAY] && attributes[RTA_OIF]) {
+    gateways_.push_back(Gateway {netlink::attributeValue<int>(attributes[RTA_OIF]),
+                                 qFromBigEndian<uint32_t>(RTA_DATA(attributes[RTA_GATEWAY])), info->rtm_dst_len});
+    return;
+  }
+  if (!attributes[RTA_MULTIPATH]) return;
+
+  // ECMP route: one rtnexthop per path, each followed by its own attributes
+  const auto *nexthop = static_cast<const rtnexthop *>(RTA_DATA(attributes[RTA_MULTIPATH]));
+  auto remaining      = int(RTA_PAYLOAD(attributes[RTA_MULTIPATH]));
+  while (RTNH_OK(nexthop, remaining)) {
+    const rtattr *nested[RTA_GATEWAY + 1] = {};
+    netlink::parseAttributes(RTNH_DATA(nexthop), nexthop->rtnh_len - sizeof(rtnexthop), nested);
+    if (nested[RTA_GATEWAY]) {
+      gateways_.push_back(
+          Gateway {nexthop->rtnh_ifindex, qFromBigEndian<uint32_t>(RTA_DATA(nested[RTA_GATEWAY])), info->rtm_dst_len});
+    }
+    remaining -= int(RTNH_ALIGN(nexthop->rtnh_len));
+    nexthop = RTNH_NEXT(nexthop);
+  }
+}
+
+void InterfaceLoader::assignGateways() {
+  // The default route wins, then the least specific route
+  std::sort(gateways_.begin(), gateways_.end(),
+            [](const Gateway &_a, const Gateway &_b) { return _a.length < _b.length; });
+  for (const Gateway &gateway : gateways_) {
+    Interface *interface = find(gateway.index);
+    if (!interface) continue;
+    for (Addr4Entry &entry : interface->rows4_) {
+      if (entry.gateway_ == 0 && (entry.ipv4_ & entry.netmask_) == (gateway.gateway & entry.netmask_)) {
+        entry.gateway_ = gateway.gateway;
+      }
+    }
+  }
+}
+
+Interface::Interface(std::string_view _name, const allocator_type &_allocator)
+    : name_(_name, _allocator), rows4_(_allocator), rows6_(_allocator) {
+  const auto index = int(if_nametoindex(name_.c_str()));
+  if (index == 0) return;
+
+  std::pmr::vector<Interface> list(_allocator);
+  InterfaceLoader loader(index, _allocator.resource());
+  if (loader.load(list) && !list.empty()) {
+    *this = std::move(list.front());
+  } else {
+    index_ = index;
+  }
+}
+
+Interface::Interface(const Interface &_other, const allocator_type &_allocator)
+    : name_(_other.name_, _allocator),
+      index_(_other.index_),
+      flags_(_other.flags_),
+      mtu_(_other.mtu_),
+      rows4_(_other.rows4_, _allocator),
+      rows6_(_other.rows6_, _allocator) {}
+
+// Moves the storage when both use the same resource, copies it otherwise
+Interface::Interface(Interface &&_other, const allocator_type &_allocator)
+    : name_(std::move(_other.name_), _allocator),
+      index_(_other.index_),
+      flags_(_other.flags_),
+      mtu_(_other.mtu_),
+      rows4_(std::move(_other.rows4_), _allocator),
+      rows6_(std::move(_other.rows6_), _allocator) {}
+
+bool Interface::isUp() const noexcept { return (flags_ & IFF_UP) != 0; }
+
+}  // namespace network
+
+namespace net {
+
+std::vector<network::Interface> getIfacesNames() {
+  std::pmr::vector<network::Interface> loaded;
+  network::InterfaceLoader loader;
+  loader.load(loaded);
+  // Same resource on both sides, so the interfaces are moved, not copied
+  return {std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end())};
+}
+
+std::pmr::vector<network::Interface> getIfacesNames(std::pmr::memory_resource *_resource) {
+  std::pmr::vector<network::Interface> list(_resource);
+  network::InterfaceLoader loader(0, _resource);
+  loader.load(list);
+  return list;
+}
+
+}  // namespace net
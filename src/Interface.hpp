@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+
+namespace network {
+
+//! One IPv4 address of an interface, all fields in host byte order
+struct Addr4Entry {
+  uint32_t ipv4_;
+  uint32_t gateway_;  // 0 if no route through this interface has a gateway in the subnet
+  uint32_t netmask_;
+};
+
+//! One IPv6 address of an interface
+struct Addr6Entry {
+  IPv6Address ipv6_;
+  Netmask netmask_;
+};
+
+//! Network interface with its addresses
+/*!
+    Filled from route netlink: link state from RTM_GETLINK, addresses from RTM_GETADDR and
+    IPv4 gateways from the main routing table.
+
+    The name and the address lists are allocated from a std::pmr::memory_resource, the default
+    resource unless one is given. Interface follows the uses-allocator convention, so the
+    elements of a std::pmr::vector<Interface> allocate from the vector's resource; copies
+    without an explicit allocator use the default resource again.
+*/
+class Interface {
+public:
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  Interface() = default;
+  explicit Interface(const allocator_type &_allocator) : name_(_allocator), rows4_(_allocator), rows6_(_allocator) {}
+  //! Look up the interface \a _name and load its addresses; isValid() is false if it does not exist
+  explicit Interface(std::string_view _name, const allocator_type &_allocator = {});
+  Interface(std::string_view _name, int _index, const allocator_type &_allocator = {})
+      : name_(_name, _allocator), index_(_index), rows4_(_allocator), rows6_(_allocator) {}
+
+  Interface(const Interface &)            = default;
+  Interface(Interface &&)                 = default;
+  Interface &operator=(const Interface &) = default;
+  Interface &operator=(Interface &&)      = default;
+  Interface(const Interface &_other, const allocator_type &_allocator);
+  Interface(Interface &&_other, const allocator_type &_allocator);
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return name_.get_allocator(); }
+
+  [[nodiscard]] bool isValid() const noexcept { return index_ > 0; }
+  [[nodiscard]] const std::pmr::string &getName() const noexcept { return name_; }
+  [[nodiscard]] int getIndex() const noexcept { return index_; }
+  [[nodiscard]] unsigned getFlags() const noexcept { return flags_; }  // IFF_* bits
+  [[nodiscard]] bool isUp() const noexcept;
+  [[nodiscard]] unsigned getMtu() const noexcept { return mtu_; }
+  [[nodiscard]] const std::pmr::vector<Addr4Entry> &getEntries4() const noexcept { return rows4_; }
+  [[nodiscard]] const std::pmr::vector<Addr6Entry> &getEntries6() const noexcept { return rows6_; }
+
+private:
+  friend class InterfaceLoader;
+
+  std::pmr::string name_;
+  int index_ {0};
+  unsigned flags_ {0};
+  unsigned mtu_ {0};
+  std::pmr::vector<Addr4Entry> rows4_;
+  std::pmr::vector<Addr6Entry> rows6_;
+};
+
+}  // namespace network
+
+namespace net {
+
+//! All interfaces of the current network namespace with their addresses, in kernel index order
+/*!
+    Reads one RTM_GETLINK, RTM_GETADDR and RTM_GETROUTE dump each, parsing the replies in place.
+    Returns an empty list if the netlink socket cannot be opened.
+*/
+std::vector<network::Interface> getIfacesNames();
+
+//! getIfacesNames() allocating the list, the interfaces and the loader's scratch tables and netlink
+//! buffers from \a _resource
+/*!
+    With a std::pmr::monotonic_buffer_resource sized for the host plus the 64 KiB netlink receive buffer,
+    a whole enumeration is served from one block and released at once with the resource:
+    \code
+    std::pmr::monotonic_buffer_resource arena(128 * 1024);
+    auto list = net::getIfacesNames(&arena);
+    \endcode
+*/
+std::pmr::vector<network::Interface> getIfacesNames(std::pmr::memory_resource *_resource);
+
+}  // namespace net
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+#include "Interface.hpp"
+#include "Netlink.hpp"
+
+namespace network {
+
+//! Builds Interface objects from link, address and route dumps
+class InterfaceLoader {
+public:
+  //! \a _index restricts loading to one interface, 0 loads all of them. The loader's own tables
+  //! and its socket's buffers allocate from \a _resource.
+  explicit InterfaceLoader(int _index = 0, std::pmr::memory_resource *_resource = std::pmr::get_default_resource())
+      : filter_(_index), socket_(_resource), positions_(_resource), gateways_(_resource) {}
+
+  //! Load the interfaces into \a _list, replacing its contents; they allocate from the list's resource
+  bool load(std::pmr::vector<Interface> &_list);
+
+  //! Update \a _interface from an RTM_NEWLINK message; false if the message has no name
+  static bool applyLink(const nlmsghdr &_message, Interface &_interface);
+  //! Add, update (RTM_NEWADDR) or remove (RTM_DELADDR) the address carried by \a _message
+  static void applyAddress(const nlmsghdr &_message, Interface &_interface);
+
+private:
+  static constexpr int C_DUMP_RETRIES = 3;
+
+  struct Gateway {
+    int index;
+    uint32_t gateway;
+    uint8_t length;
+  };
+
+  bool dumpAll();
+  void onLink(const nlmsghdr &_message);
+  void onAddress(const nlmsghdr &_message);
+  void onRoute(const nlmsghdr &_message);
+  void assignGateways();
+  Interface *find(int _index);
+
+  int filter_;
+  netlink::Socket socket_;
+  std::pmr::vector<Interface> *list_ {nullptr};
+  std::pmr::unordered_map<int, std::size_t> positions_;
+  std::pmr::vector<Gateway> gateways_;
+};
+
+}  // namespace network
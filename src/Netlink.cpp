@@ -0,0 +1,155 @@
+#include "Netlink.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace network::netlink {
+
+void parseAttributes(const rtattr *_attribute, std::size_t _length, std::span<const rtattr *> _table) {
+  auto remaining = static_cast<unsigned>(_length);
+  for (; RTA_OK(_attribute, remaining); _attribute = RTA_NEXT(_attribute, remaining)) {
+    // Nested attributes carry NLA_F_NESTED / NLA_F_NET_BYTEORDER in the type's top bits
+    const unsigned type = _attribute->rta_type & NLA_TYPE_MASK;
+    if (type < _table.size()) _table[type] = _attribute;
+  }
+}
+
+rtattr *Message::addAttribute(uint16_t _type, const void *_data, std::size_t _size) noexcept {
+  const std::size_t offset = NLMSG_ALIGN(header()->nlmsg_len);
+  if (!valid_ || offset + RTA_SPACE(_size) > C_CAPACITY) {
+    valid_ = false;
+    return nullptr;
+  }
+  auto *attribute     = reinterpret_cast<rtattr *>(buffer_ + offset);
+  attribute->rta_type = _type;
+  attribute->rta_len  = uint16_t(RTA_LENGTH(_size));
+  if (_data) std::memcpy(RTA_DATA(attribute), _data, _size);
+  header()->nlmsg_len = uint32_t(offset + RTA_SPACE(_size));
+  return attribute;
+}
+
+rtattr *Message::addAttribute(uint16_t _type, std::string_view _value) noexcept {
+  rtattr *attribute = addAttribute(_type, nullptr, _value.size() + 1);
+  if (attribute) {
+    std::memcpy(RTA_DATA(attribute), _value.data(), _value.size());
+    static_cast<char *>(RTA_DATA(attribute))[_value.size()] = '\0';
+  }
+  return attribute;
+}
+
+void Message::endNested(rtattr *_nested) noexcept {
+  if (!_nested) return;
+  _nested->rta_type |= NLA_F_NESTED;
+  _nested->rta_len = uint16_t(buffer_ + header()->nlmsg_len - reinterpret_cast<char *>(_nested));
+}
+
+Socket::~Socket() { close(); }
+
+Socket::Socket(Socket &&_other) noexcept
+    : fd_(std::exchange(_other.fd_, -1)),
+      portId_(_other.portId_),
+      sequence_(_other.sequence_),
+      strict_(_other.strict_),
+      buffer_(std::move(_other.buffer_)),
+      received_(std::exchange(_other.received_, 0)),
+      sendBuffer_(std::move(_other.sendBuffer_)) {}
+
+Socket &Socket::operator=(Socket &&_other) noexcept {
+  if (this != &_other) {
+    close();
+    fd_         = std::exchange(_other.fd_, -1);
+    portId_     = _other.portId_;
+    sequence_   = _other.sequence_;
+    strict_     = _other.strict_;
+    buffer_     = std::move(_other.buffer_);
+    received_   = std::exchange(_other.received_, 0);
+    sendBuffer_ = std::move(_other.sendBuffer_);
+  }
+  return *this;
+}
+
+bool Socket::open(uint32_t _groups) {
+  close();
+  fd_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd_ < 0) return false;
+
+  sockaddr_nl local {};
+  local.nl_family = AF_NETLINK;
+  local.nl_groups = _groups;
+  socklen_t size  = sizeof(local);
+  if (::bind(fd_, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0 ||
+      ::getsockname(fd_, reinterpret_cast<sockaddr *>(&local), &size) < 0) {
+    const int error = errno;
+    close();
+    errno = error;
+    return false;
+  }
+
+  // Large dumps arrive faster than one buffer per recv; a bigger queue avoids ENOBUFS
+  const int queue = 4 * 1024 * 1024;
+  ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &queue, sizeof(queue));
+
+  // Error acknowledgements carry only the header of the failed request, not all of it
+  const int enable = 1;
+  ::setsockopt(fd_, SOL_NETLINK, NETLINK_CAP_ACK, &enable, sizeof(enable));
+
+  // Lets dump requests filter in the kernel instead of returning every object
+  strict_ = ::setsockopt(fd_, SOL_NETLINK, NETLINK_GET_STRICT_CHK, &enable, sizeof(enable)) == 0;
+
+  portId_ = local.nl_pid;
+  buffer_.resize(C_BUFFER_SIZE);
+  return true;
+}
+
+void Socket::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_       = -1;
+  received_ = 0;
+}
+
+bool Socket::send(nlmsghdr *_message) {
+  _message->nlmsg_seq = ++sequence_;
+  _message->nlmsg_pid = portId_;
+  return sendRaw(_message, _message->nlmsg_len);
+}
+
+bool Socket::send(std::span<Message> _messages, uint32_t &_firstSequence) {
+  _firstSequence = sequence_ + 1;
+  sendBuffer_.clear();
+  for (Message &message : _messages) {
+    nlmsghdr *header  = message.header();
+    header->nlmsg_seq = ++sequence_;
+    header->nlmsg_pid = portId_;
+    // The kernel walks a datagram message by message, each starting at an aligned offset
+    const auto *bytes = reinterpret_cast<const char *>(header);
+    sendBuffer_.insert(sendBuffer_.end(), bytes, bytes + header->nlmsg_len);
+    sendBuffer_.resize(NLMSG_ALIGN(sendBuffer_.size()));
+  }
+  return sendBuffer_.empty() || sendRaw(sendBuffer_.data(), sendBuffer_.size());
+}
+
+bool Socket::sendRaw(const void *_data, std::size_t _size) {
+  sockaddr_nl kernel {};
+  kernel.nl_family = AF_NETLINK;
+  for (;;) {
+    const ssize_t sent = ::sendto(fd_, _data, _size, 0, reinterpret_cast<sockaddr *>(&kernel), sizeof(kernel));
+    if (sent >= 0) return true;
+    if (errno != EINTR) return false;
+  }
+}
+
+ssize_t Socket::receive(bool _wait) {
+  received_ = 0;
+  for (;;) {
+    const ssize_t size = ::recv(fd_, buffer_.data(), buffer_.size(), _wait ? 0 : MSG_DONTWAIT);
+    if (size >= 0) {
+      received_ = std::size_t(size);
+      return size;
+    }
+    if (errno == EINTR) continue;
+    if (!_wait && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    return -1;
+  }
+}
+
+}  // namespace network::netlink
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace network::netlink {
+
+//! Index the attributes of one message by type
+/*!
+    \a _table receives a pointer to every attribute whose type fits in it, pointing straight into
+    the receive buffer; types past the end of the table are skipped. Entries are not cleared first.
+*/
+void parseAttributes(const rtattr *_attribute, std::size_t _length, std::span<const rtattr *> _table);
+
+//! Payload of a fixed-size attribute
+template <typename T>
+T attributeValue(const rtattr *_attribute) {
+  T value {};
+  std::memcpy(&value, RTA_DATA(_attribute), std::min(sizeof(T), std::size_t(RTA_PAYLOAD(_attribute))));
+  return value;
+}
+
+//! Payload of a string attribute, without the terminating null
+inline std::string_view attributeString(const rtattr *_attribute) {
+  const auto *data   = static_cast<const char *>(RTA_DATA(_attribute));
+  const auto payload = std::size_t(RTA_PAYLOAD(_attribute));
+  return {data, strnlen(data, payload)};
+}
+
+//! Request message built in place
+/*!
+    A netlink header, the family header (ifinfomsg, ifaddrmsg, rtmsg, ...) and attributes laid out in
+    one fixed buffer. Attributes that do not fit are dropped and make isValid() false.
+*/
+class Message {
+public:
+  static constexpr std::size_t C_CAPACITY = 1024;
+
+  template <typename Header>
+  Message(uint16_t _type, uint16_t _flags, const Header &_header) noexcept {
+    static_assert(NLMSG_LENGTH(sizeof(Header)) <= C_CAPACITY);
+    header()->nlmsg_len   = NLMSG_LENGTH(sizeof(Header));
+    header()->nlmsg_type  = _type;
+    header()->nlmsg_flags = _flags;
+    std::memcpy(NLMSG_DATA(header()), &_header, sizeof(Header));
+  }
+
+  [[nodiscard]] nlmsghdr *header() noexcept { return reinterpret_cast<nlmsghdr *>(buffer_); }
+  [[nodiscard]] bool isValid() const noexcept { return valid_; }
+
+  //! Append an attribute with \a _size bytes of payload
+  rtattr *addAttribute(uint16_t _type, const void *_data, std::size_t _size) noexcept;
+
+  template <typename T>
+  rtattr *addAttribute(uint16_t _type, const T &_value) noexcept {
+    return addAttribute(_type, &_value, sizeof(T));
+  }
+
+  rtattr *addAttribute(uint16_t _type, std::string_view _value) noexcept;
+
+  //! Open a nested attribute; attributes added until endNested() become its payload
+  rtattr *beginNested(uint16_t _type) noexcept { return addAttribute(_type, nullptr, 0); }
+  void endNested(rtattr *_nested) noexcept;
+
+private:
+  alignas(nlmsghdr) char buffer_[C_CAPACITY] {};
+  bool valid_ {true};
+};
+
+//! Route netlink socket
+/*!
+    Owns the socket and one receive buffer reused by every request, so replies are parsed in place.
+    The buffers are allocated from the memory resource given at construction.
+    Errors are reported by returning false with errno set (to the kernel's error for NLMSG_ERROR replies).
+
+    Not thread-safe.
+*/
+class Socket {
+public:
+  //! Size of the receive buffer, allocated on the first open()
+  static constexpr std::size_t C_BUFFER_SIZE = 64 * 1024;
+
+  explicit Socket(std::pmr::memory_resource *_resource = std::pmr::get_default_resource()) noexcept
+      : buffer_(_resource), sendBuffer_(_resource) {}
+  ~Socket();
+
+  Socket(const Socket &)            = delete;
+  Socket &operator=(const Socket &) = delete;
+  Socket(Socket &&_other) noexcept;
+  Socket &operator=(Socket &&_other) noexcept;
+
+  //! Open the socket and subscribe to the multicast \a _groups (RTMGRP_* bits)
+  bool open(uint32_t _groups = 0);
+  void close();
+  [[nodiscard]] bool isOpen() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+
+  [[nodiscard]] uint32_t portId() const noexcept { return portId_; }
+
+  //! Send a request, filling in its sequence number and port id
+  bool send(nlmsghdr *_message);
+  //! Send several requests in one datagram, numbered consecutively from the returned \a _firstSequence
+  bool send(std::span<Message> _messages, uint32_t &_firstSequence);
+
+  //! Receive one datagram into the internal buffer
+  /*!
+      \return the bytes received, 0 if \a _wait is false and nothing is pending, -1 on error
+  */
+  ssize_t receive(bool _wait = true);
+  [[nodiscard]] std::span<const char> received() const noexcept { return {buffer_.data(), received_}; }
+
+  //! Send \a _message and pass every reply to \a _handler until the request completes
+  /*!
+      Works for dumps (terminated by NLMSG_DONE), for acknowledged requests and for single replies.
+      Multicast notifications arriving meanwhile are dropped.
+      A dump the kernel marks as interrupted (NLM_F_DUMP_INTR) fails with errno EAGAIN once
+      it has been read to the end, so the caller may retry it.
+  */
+  template <typename Handler>
+  bool transact(nlmsghdr *_message, Handler &&_handler);
+
+  //! Dump all objects of \a _type (RTM_GETLINK, RTM_GETADDR, RTM_GETROUTE, ...)
+  /*!
+      \a _header is the family header of the request; with strict checking its fields filter the dump
+      in the kernel (address family, interface index, routing table, ...).
+  */
+  template <typename Header, typename Handler>
+  bool dump(uint16_t _type, const Header &_header, Handler &&_handler) {
+    Message message(_type, NLM_F_REQUEST | NLM_F_DUMP, _header);
+    return transact(message.header(), std::forward<Handler>(_handler));
+  }
+
+  //! Whether the kernel validates dump requests and applies their filters (NETLINK_GET_STRICT_CHK, Linux 4.20)
+  [[nodiscard]] bool isStrict() const noexcept { return strict_; }
+
+private:
+  bool sendRaw(const void *_data, std::size_t _size);
+
+  int fd_ {-1};
+  uint32_t portId_ {0};
+  uint32_t sequence_ {0};
+  bool strict_ {false};
+  std::pmr::vector<char> buffer_;
+  std::size_t received_ {0};
+  std::pmr::vector<char> sendBuffer_;
+};
+
+template <typename Handler>
+bool Socket::transact(nlmsghdr *_message, Handler &&_handler) {
+  if (!send(_message)) return false;
+  const uint32_t sequence = _message->nlmsg_seq;
+  bool interrupted        = false;
+
+  for (;;) {
+    const ssize_t size = receive();
+    if (size < 0) return false;
+
+    auto remaining = static_cast<unsigned>(size);
+    for (auto *header = reinterpret_cast<const nlmsghdr *>(buffer_.data()); NLMSG_OK(header, remaining);
+         header       = NLMSG_NEXT(header, remaining)) {
+      if (header->nlmsg_seq != sequence || header->nlmsg_pid != portId_) continue;
+      if (header->nlmsg_flags & NLM_F_DUMP_INTR) interrupted = true;
+
+      if (header->nlmsg_type == NLMSG_DONE) {
+        if (interrupted) errno = EAGAIN;
+        return !interrupted;
+      }
+      if (header->nlmsg_type == NLMSG_ERROR) {
+        const auto *error = static_cast<const nlmsgerr *>(NLMSG_DATA(header));
+        if (error->error == 0) return true;
+        errno = -error->error;
+        return false;
+      }
+      _handler(*header);
+      if (!(header->nlmsg_flags & NLM_F_MULTI)) return true;
+    }
+  }
+}
+
+}  // namespace network::netlink
@@ -0,0 +1,373 @@
+#include "Network.hpp"
+
+#include <net/if.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include "Endian.hpp"
+
+namespace {
+
+using network::LayerProtocol;
+
+Network::RetCode fromErrno(int _error, Network::Operation::Type _type, uint8_t _family) {
+  switch (_error) {
+    case 0: return Network::RetCode::OK;
+    case EEXIST: return Network::RetCode::ADDRESS_EXISTS;
+    case EADDRNOTAVAIL: return Network::RetCode::ADDRESS_NOT_FOUND;
+    case ENODEV: return Network::RetCode::INVALID_INTERFACE;
+    case EPERM:
+    case EACCES: return Network::RetCode::PERMISSION_DENIED;
+    case ENETUNREACH:
+    case EHOSTUNREACH: return Network::RetCode::INVALID_GATEWAY;
+    case EINVAL:
+      if (_type == Network::Operation::Type::SET_GATEWAY) return Network::RetCode::INVALID_GATEWAY;
+      if (_type == Network::Operation::Type::ADD_ADDRESS) {
+        return _family == AF_INET6 ? Network::RetCode::INVALID_IPV6 : Network::RetCode::INVALID_IPV4;
+      }
+      return Network::RetCode::SYSTEM_ERROR;
+    default: return Network::RetCode::SYSTEM_ERROR;
+  }
+}
+
+int maxPrefixLength(LayerProtocol _protocol) {
+  return _protocol == LayerProtocol::IPv4 ? 32 : _protocol == LayerProtocol::IPv6 ? 128 : -1;
+}
+
+// Address bytes in network order as the kernel expects them: 4 for IPv4, 16 for IPv6
+std::size_t addressBytes(const network::Address &_address, uint8_t *_out) {
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    qToBigEndian(_address.toIPv4Address(), _out);
+    return 4;
+  }
+  std::memcpy(_out, _address.toIPv6Address().c, 16);
+  return 16;
+}
+
+}  // namespace
+
+bool Network::apply(std::span<const Operation> _operations, std::span<RetCode> _results, Mode _mode) {
+  std::fill_n(_results.begin(), _operations.size(), RetCode::SYSTEM_ERROR);
+  if (!socket_.isOpen() && !socket_.open()) return false;
+
+  // One link dump resolves every name and records the state a rollback returns to
+  const bool needNames = std::any_of(_operations.begin(), _operations.end(), [](const Operation &_operation) {
+    return _operation.index == 0;
+  });
+  if ((needNames || _mode == Mode::ALL_OR_NOTHING) && !loadLinks()) return false;
+
+  std::vector<int> indexes(_operations.size(), 0);
+  bool valid = true;
+  for (std::size_t i = 0; i < _operations.size(); ++i) {
+    _results[i] = validate(_operations[i], indexes[i]);
+    valid &= _results[i] == RetCode::OK;
+  }
+  if (!valid && _mode == Mode::ALL_OR_NOTHING) {
+    for (std::size_t i = 0; i < _operations.size(); ++i) {
+      if (_results[i] == RetCode::OK) _results[i] = RetCode::NOT_APPLIED;
+    }
+    return false;
+  }
+
+  // The default routes SET_GATEWAY replaces and the addresses REMOVE_ADDRESS deletes, so a
+  // rollback can put them back as they were; without them the batch is not sent
+  const auto notLoaded = [&](Operation::Type _type) {
+    for (std::size_t i = 0; i < _operations.size(); ++i) {
+      _results[i] = _operations[i].type == _type ? RetCode::SYSTEM_ERROR : RetCode::NOT_APPLIED;
+    }
+    return false;
+  };
+  routes_.clear();
+  addresses_.clear();
+  if (_mode == Mode::ALL_OR_NOTHING) {
+    for (const uint8_t family : {uint8_t(AF_INET), uint8_t(AF_INET6)}) {
+      const bool replaced = std::any_of(_operations.begin(), _operations.end(), [family](const Operation &_operation) {
+        return _operation.type == Operation::Type::SET_GATEWAY &&
+               (_operation.address.getProtocol() == LayerProtocol::IPv4) == (family == AF_INET);
+      });
+      if (replaced && !loadDefaultRoute(family)) return notLoaded(Operation::Type::SET_GATEWAY);
+    }
+    if (!loadAddresses(_operations, indexes)) return notLoaded(Operation::Type::REMOVE_ADDRESS);
+  }
+
+  std::vector<network::netlink::Message> messages;
+  std::vector<std::size_t> sent;  // operation of every message
+  messages.reserve(_operations.size());
+  sent.reserve(_operations.size());
+  for (std::size_t i = 0; i < _operations.size(); ++i) {
+    if (_results[i] != RetCode::OK) continue;
+    encode(_operations[i], indexes[i], false, messages);
+    sent.push_back(i);
+  }
+
+  std::vector<RetCode> acknowledged(messages.size(), RetCode::SYSTEM_ERROR);
+  transmit(messages, acknowledged);
+  bool succeeded = valid;
+  for (std::size_t m = 0; m < sent.size(); ++m) {
+    _results[sent[m]] = acknowledged[m];
+    succeeded &= acknowledged[m] == RetCode::OK;
+  }
+  if (succeeded || _mode != Mode::ALL_OR_NOTHING) return succeeded;
+
+  // Undo in reverse order so e.g. a gateway goes before the address that made it reachable
+  messages.clear();
+  std::vector<std::size_t> undone;
+  for (std::size_t m = sent.size(); m-- > 0;) {
+    if (acknowledged[m] != RetCode::OK) continue;
+    const auto saved = std::find_if(addresses_.begin(), addresses_.end(), [&](const auto &_address) {
+      return _address.first == sent[m];
+    });
+    if (saved != addresses_.end()) {
+      messages.push_back(saved->second);
+    } else {
+      encode(_operations[sent[m]], indexes[sent[m]], true, messages);
+    }
+    undone.push_back(sent[m]);
+  }
+  std::vector<RetCode> reverted(messages.size(), RetCode::SYSTEM_ERROR);
+  transmit(messages, reverted);
+  for (std::size_t m = 0; m < undone.size(); ++m) {
+    // An operation whose undo failed stays applied, and is reported as such
+    if (reverted[m] == RetCode::OK) _results[undone[m]] = RetCode::NOT_APPLIED;
+  }
+  return false;
+}
+
+Network::RetCode Network::setIpV4(std::string_view _interface, std::string_view _ip, int _prefixLength) {
+  network::Address address;
+  if (!address.setAddress(_ip) || address.getProtocol() != LayerProtocol::IPv4) return RetCode::INVALID_IPV4;
+  network::Netmask netmask;
+  netmask.setPrefixLength(LayerProtocol::IPv4, _prefixLength);
+
+  const Operation operations[] = {Operation::linkUp(_interface),
+                                  Operation::addAddress(_interface, address, netmask)};
+  RetCode results[2];
+  apply(operations, results);
+  return results[0] != RetCode::OK ? results[0] : results[1];
+}
+
+bool Network::loadLinks() {
+  names_.clear();
+  flags_.clear();
+
+  ifinfomsg link {};
+  network::netlink::Message request(RTM_GETLINK, NLM_F_REQUEST | NLM_F_DUMP, link);
+  request.addAttribute(IFLA_EXT_MASK, uint32_t(RTEXT_FILTER_SKIP_STATS));
+  const bool loaded = socket_.transact(request.header(), [this](const nlmsghdr &_message) {
+    if (_message.nlmsg_type != RTM_NEWLINK) return;
+    const auto *info                          = static_cast<const ifinfomsg *>(NLMSG_DATA(&_message));
+    const rtattr *attributes[IFLA_IFNAME + 1] = {};
+    network::netlink::parseAttributes(IFLA_RTA(info), IFLA_PAYLOAD(&_message), attributes);
+    if (!attributes[IFLA_IFNAME]) return;
+    names_.emplace_back(network::netlink::attributeString(attributes[IFLA_IFNAME]), info->ifi_index);
+    flags_.emplace_back(info->ifi_index, info->ifi_flags);
+  });
+  // A dump interrupted by a concurrent change is still complete enough to resolve names
+  if (!loaded && errno != EAGAIN) return false;
+
+  std::sort(names_.begin(), names_.end());
+  std::sort(flags_.begin(), flags_.end());
+  return true;
+}
+
+bool Network::loadDefaultRoute(uint8_t _family) {
+  // The route NLM_F_REPLACE matches: main table, no destination, the metric of a route added
+  // without RTA_PRIORITY (0 for IPv4, 1024 for IPv6)
+  const uint32_t metric = _family == AF_INET ? 0 : 1024;
+  rtmsg filter {};
+  filter.rtm_family = _family;
+  bool found        = false;
+  const bool loaded = socket_.dump(RTM_GETROUTE, filter, [&](const nlmsghdr &_message) {
+    const auto *route = static_cast<const rtmsg *>(NLMSG_DATA(&_message));
+    if (found || _message.nlmsg_type != RTM_NEWROUTE || route->rtm_family != _family || route->rtm_dst_len != 0 ||
+        route->rtm_type != RTN_UNICAST) {
+      return;
+    }
+    const rtattr *attributes[RTA_MAX + 1] = {};
+    network::netlink::parseAttributes(RTM_RTA(route), RTM_PAYLOAD(&_message), attributes);
+    const uint32_t table = attributes[RTA_TABLE] ? network::netlink::attributeValue<uint32_t>(attributes[RTA_TABLE])
+                                                 : route->rtm_table;
+    const uint32_t priority =
+        attributes[RTA_PRIORITY] ? network::netlink::attributeValue<uint32_t>(attributes[RTA_PRIORITY]) : 0;
+    if (table != RT_TABLE_MAIN || priority != metric) return;
+
+    // Kernel-reported state (RTNH_F_LINKDOWN, offload flags, cache info) is not part of a request
+    rtmsg header     = *route;
+    header.rtm_flags &= RTNH_F_ONLINK;
+    network::netlink::Message restore(RTM_NEWROUTE, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE, header);
+    for (const int type : {RTA_GATEWAY, RTA_OIF, RTA_PRIORITY, RTA_PREFSRC, RTA_METRICS, RTA_MULTIPATH, RTA_VIA,
+                           RTA_PREF}) {
+      if (!attributes[type]) continue;
+      restore.addAttribute(uint16_t(type), RTA_DATA(attributes[type]), RTA_PAYLOAD(attributes[type]));
+    }
+    if (!restore.isValid()) return;
+    routes_.emplace_back(_family, restore);
+    found = true;
+  });
+  // Without a default route before the batch, undoing SET_GATEWAY deletes the one it added
+  return loaded || found;
+}
+
+bool Network::loadAddresses(std::span<const Operation> _operations, std::span<const int> _indexes) {
+  const bool removes = std::any_of(_operations.begin(), _operations.end(), [](const Operation &_operation) {
+    return _operation.type == Operation::Type::REMOVE_ADDRESS;
+  });
+  if (!removes) return true;
+
+  ifaddrmsg filter {};
+  return socket_.dump(RTM_GETADDR, filter, [&](const nlmsghdr &_message) {
+    if (_message.nlmsg_type != RTM_NEWADDR) return;
+    const auto *info                      = static_cast<const ifaddrmsg *>(NLMSG_DATA(&_message));
+    const rtattr *attributes[IFA_MAX + 1] = {};
+    network::netlink::parseAttributes(IFA_RTA(info), IFA_PAYLOAD(&_message), attributes);
+    const rtattr *local = attributes[IFA_LOCAL] ? attributes[IFA_LOCAL] : attributes[IFA_ADDRESS];
+    if (!local) return;
+
+    for (std::size_t i = 0; i < _operations.size(); ++i) {
+      const Operation &operation = _operations[i];
+      if (operation.type != Operation::Type::REMOVE_ADDRESS || _indexes[i] != int(info->ifa_index) ||
+          operation.netmask.getPrefixLength() != info->ifa_prefixlen) {
+        continue;
+      }
+      uint8_t address[16];
+      const std::size_t size = addressBytes(operation.address, address);
+      if (RTA_PAYLOAD(local) != size || std::memcmp(RTA_DATA(local), address, size) != 0) continue;
+
+      // Kernel-reported state (tentative, deprecated, secondary, permanent) is not part of a request
+      uint32_t flags = attributes[IFA_FLAGS] ? network::netlink::attributeValue<uint32_t>(attributes[IFA_FLAGS])
+                                             : info->ifa_flags;
+      flags &= IFA_F_NODAD | IFA_F_OPTIMISTIC | IFA_F_HOMEADDRESS | IFA_F_MANAGETEMPADDR | IFA_F_NOPREFIXROUTE |
+               IFA_F_MCAUTOJOIN;
+      ifaddrmsg header = *info;
+      header.ifa_flags = uint8_t(flags);
+      network::netlink::Message restore(RTM_NEWADDR, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_EXCL, header);
+      restore.addAttribute(IFA_FLAGS, flags);
+      // IFA_CACHEINFO carries the remaining preferred and valid lifetimes
+      for (const int type : {IFA_LOCAL, IFA_ADDRESS, IFA_BROADCAST, IFA_LABEL, IFA_CACHEINFO, IFA_RT_PRIORITY,
+                             IFA_PROTO}) {
+        if (!attributes[type]) continue;
+        restore.addAttribute(uint16_t(type), RTA_DATA(attributes[type]), RTA_PAYLOAD(attributes[type]));
+      }
+      if (restore.isValid()) addresses_.emplace_back(i, restore);
+    }
+  });
+}
+
+Network::RetCode Network::validate(const Operation &_operation, int &_index) const {
+  _index = _operation.index;
+  if (_index == 0) {
+    const auto it = std::lower_bound(names_.begin(), names_.end(), _operation.name,
+                                     [](const auto &_entry, const std::string &_name) { return _entry.first < _name; });
+    if (it == names_.end() || it->first != _operation.name) return RetCode::INVALID_INTERFACE;
+    _index = it->second;
+  }
+
+  const LayerProtocol protocol = _operation.address.getProtocol();
+  switch (_operation.type) {
+    case Operation::Type::LINK_UP:
+    case Operation::Type::LINK_DOWN: return RetCode::OK;
+    case Operation::Type::ADD_ADDRESS:
+    case Operation::Type::REMOVE_ADDRESS: {
+      if (protocol != LayerProtocol::IPv4 && protocol != LayerProtocol::IPv6) return RetCode::INVALID_ADDRESS;
+      const int length = _operation.netmask.getPrefixLength();
+      if (length < 0 || length > maxPrefixLength(protocol)) return RetCode::INVALID_MASK;
+      return RetCode::OK;
+    }
+    case Operation::Type::SET_GATEWAY:
+      if (protocol != LayerProtocol::IPv4 && protocol != LayerProtocol::IPv6) return RetCode::INVALID_GATEWAY;
+      if (_operation.address.isNull()) return RetCode::INVALID_GATEWAY;
+      return RetCode::OK;
+  }
+  return RetCode::SYSTEM_ERROR;
+}
+
+void Network::encode(const Operation &_operation, int _index, bool _undo,
+    std::vector<network::netlink::Message> &_messages) const {
+  uint8_t address[16];
+  switch (_operation.type) {
+    case Operation::Type::LINK_UP:
+    case Operation::Type::LINK_DOWN: {
+      ifinfomsg link {};
+      link.ifi_index  = _index;
+      link.ifi_change = IFF_UP;
+      link.ifi_flags  = _operation.type == Operation::Type::LINK_UP ? IFF_UP : 0;
+      if (_undo) {
+        const auto it  = std::lower_bound(flags_.begin(), flags_.end(), std::make_pair(_index, 0U));
+        link.ifi_flags = it != flags_.end() && it->first == _index ? it->second & IFF_UP : link.ifi_flags ^ IFF_UP;
+      }
+      _messages.emplace_back(RTM_NEWLINK, NLM_F_REQUEST | NLM_F_ACK, link);
+      return;
+    }
+    case Operation::Type::ADD_ADDRESS:
+    case Operation::Type::REMOVE_ADDRESS: {
+      const bool add = (_operation.type == Operation::Type::ADD_ADDRESS) != _undo;
+      const std::size_t size = addressBytes(_operation.address, address);
+      ifaddrmsg message {};
+      message.ifa_family    = size == 4 ? AF_INET : AF_INET6;
+      message.ifa_prefixlen = uint8_t(_operation.netmask.getPrefixLength());
+      message.ifa_index     = uint32_t(_index);
+      network::netlink::Message &request =
+          add ? _messages.emplace_back(RTM_NEWADDR, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_EXCL, message)
+              : _messages.emplace_back(RTM_DELADDR, NLM_F_REQUEST | NLM_F_ACK, message);
+      request.addAttribute(IFA_LOCAL, address, size);
+      request.addAttribute(IFA_ADDRESS, address, size);
+      return;
+    }
+    case Operation::Type::SET_GATEWAY: {
+      const std::size_t size = addressBytes(_operation.address, address);
+      const auto saved       = std::find_if(routes_.begin(), routes_.end(), [size](const auto &_route) {
+        return _route.first == (size == 4 ? AF_INET : AF_INET6);
+      });
+      if (_undo && saved != routes_.end()) {
+        // Put back the route this one replaced
+        _messages.push_back(saved->second);
+        return;
+      }
+      rtmsg route {};
+      route.rtm_family   = size == 4 ? AF_INET : AF_INET6;
+      route.rtm_table    = RT_TABLE_MAIN;
+      route.rtm_protocol = RTPROT_STATIC;
+      route.rtm_scope    = RT_SCOPE_UNIVERSE;
+      route.rtm_type     = RTN_UNICAST;
+      network::netlink::Message &request =
+          _undo ? _messages.emplace_back(RTM_DELROUTE, NLM_F_REQUEST | NLM_F_ACK, route)
+                : _messages.emplace_back(RTM_NEWROUTE, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE, route);
+      request.addAttribute(RTA_GATEWAY, address, size);
+      request.addAttribute(RTA_OIF, uint32_t(_index));
+      return;
+    }
+  }
+}
+
+bool Network::transmit(std::span<network::netlink::Message> _messages, std::span<RetCode> _results) {
+  for (std::size_t first = 0; first < _messages.size(); first += C_MESSAGES_PER_SEND) {
+    const auto chunk = _messages.subspan(first, std::min(C_MESSAGES_PER_SEND, _messages.size() - first));
+    uint32_t sequence = 0;
+    if (!socket_.send(chunk, sequence)) return false;
+
+    // Every message asked for an ACK, so exactly one NLMSG_ERROR comes back per message
+    std::size_t pending = chunk.size();
+    while (pending != 0) {
+      const ssize_t size = socket_.receive();
+      if (size < 0) return false;
+      auto remaining = static_cast<unsigned>(size);
+      for (auto *header = reinterpret_cast<const nlmsghdr *>(socket_.received().data()); NLMSG_OK(header, remaining);
+           header       = NLMSG_NEXT(header, remaining)) {
+        const uint32_t offset = header->nlmsg_seq - sequence;
+        if (header->nlmsg_type != NLMSG_ERROR || header->nlmsg_pid != socket_.portId() || offset >= chunk.size()) {
+          continue;
+        }
+        const auto *error = static_cast<const nlmsgerr *>(NLMSG_DATA(header));
+        const auto type   = static_cast<uint16_t>(chunk[offset].header()->nlmsg_type);
+        const auto kind   = type == RTM_NEWROUTE || type == RTM_DELROUTE ? Operation::Type::SET_GATEWAY
+                            : type == RTM_NEWADDR                       ? Operation::Type::ADD_ADDRESS
+                                                                        : Operation::Type::LINK_UP;
+        // Every request starts with a family header whose first byte is the address family
+        const auto family        = *static_cast<const uint8_t *>(NLMSG_DATA(chunk[offset].header()));
+        _results[first + offset] = fromErrno(-error->error, kind, family);
+        --pending;
+      }
+    }
+  }
+  return true;
+}
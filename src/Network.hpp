@@ -1,9 +1,104 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Netlink.hpp"
+
+//! Interface configuration over route netlink
+/*!
+    Operations are sent in batches: every operation becomes one rtnetlink message, all messages go
+    to the kernel in as few datagrams as possible over a socket kept open between calls, and each
+    message is acknowledged individually, so apply() reports a result per operation.
+
+    With ALL_OR_NOTHING a failed batch is rolled back: added addresses are removed, removed
+    addresses re-added with the flags, label and lifetimes a dump recorded before the batch, and
+    links returned to their previous state. The default routes a batch may
+    replace are dumped before it is sent, and a replaced one is put back; one that did not exist is
+    removed.
+
+    Not thread-safe.
+*/
 class Network {
 public:
-  enum class RetCode : std::uint8_t { INVALID_IPV4, INVALID_MASK, INVALID_GATEWAY };
+  enum class RetCode : std::uint8_t {
+    INVALID_IPV4,
+    INVALID_MASK,
+    INVALID_GATEWAY,
+    OK,
+    INVALID_INTERFACE,  // no such interface
+    ADDRESS_EXISTS,
+    ADDRESS_NOT_FOUND,
+    PERMISSION_DENIED,  // needs CAP_NET_ADMIN in the interface's network namespace
+    NOT_APPLIED,        // valid, but not sent or rolled back because another operation of the batch failed
+    SYSTEM_ERROR,       // any other kernel or socket error
+    INVALID_IPV6,
+    INVALID_ADDRESS,  // neither IPv4 nor IPv6
+  };
+
+  enum class Mode : std::uint8_t {
+    BEST_EFFORT,     // apply every valid operation, independently of the others
+    ALL_OR_NOTHING,  // validate everything first and undo the batch if any operation fails
+  };
+
+  //! One configuration step; the interface is given by index, or by name if the index is 0
+  struct Operation {
+    enum class Type : std::uint8_t { LINK_UP, LINK_DOWN, ADD_ADDRESS, REMOVE_ADDRESS, SET_GATEWAY };
+
+    static Operation linkUp(std::string_view _interface) { return {Type::LINK_UP, std::string(_interface)}; }
+    static Operation linkDown(std::string_view _interface) { return {Type::LINK_DOWN, std::string(_interface)}; }
+    static Operation addAddress(std::string_view _interface, const network::Address &_address,
+        network::Netmask _netmask) {
+      return {Type::ADD_ADDRESS, std::string(_interface), 0, _address, _netmask};
+    }
+    static Operation removeAddress(std::string_view _interface, const network::Address &_address,
+        network::Netmask _netmask) {
+      return {Type::REMOVE_ADDRESS, std::string(_interface), 0, _address, _netmask};
+    }
+    //! Default route of the address family of \a _gateway through the interface
+    static Operation setGateway(std::string_view _interface, const network::Address &_gateway) {
+      return {Type::SET_GATEWAY, std::string(_interface), 0, _gateway, {}};
+    }
+
+    Type type;
+    std::string name;
+    int index {0};
+    network::Address address {};
+    network::Netmask netmask {};
+  };
+
+  Network() = default;
+
+  //! Apply \a _operations; \a _results receives one code per operation and must be as long
+  /*!
+      \return true if every operation succeeded
+  */
+  bool apply(std::span<const Operation> _operations, std::span<RetCode> _results, Mode _mode = Mode::BEST_EFFORT);
+
+  //! Bring \a _interface up and add \a _ip (dotted quad) with a /\a _prefixLength netmask
+  RetCode setIpV4(std::string_view _interface, std::string_view _ip, int _prefixLength = 32);
 
 private:
+  // Messages per datagram; their acknowledgements must fit in the socket's receive queue
+  static constexpr std::size_t C_MESSAGES_PER_SEND = 128;
+
+  bool loadLinks();
+  // Default route of the main table that SET_GATEWAY replaces, as the message restoring it
+  bool loadDefaultRoute(uint8_t _family);
+  // Addresses REMOVE_ADDRESS operations delete, as the messages adding them back
+  bool loadAddresses(std::span<const Operation> _operations, std::span<const int> _indexes);
+  RetCode validate(const Operation &_operation, int &_index) const;
+  void encode(const Operation &_operation, int _index, bool _undo,
+      std::vector<network::netlink::Message> &_messages) const;
+  bool transmit(std::span<network::netlink::Message> _messages, std::span<RetCode> _results);
+
+  network::netlink::Socket socket_;
+  std::vector<std::pair<std::string, int>> names_;  // sorted by name
+  std::vector<std::pair<int, unsigned>> flags_;     // IFF_* per index before the batch, sorted by index
+  std::vector<std::pair<uint8_t, network::netlink::Message>> routes_;         // per family, before the batch
+  std::vector<std::pair<std::size_t, network::netlink::Message>> addresses_;  // per operation, before the batch
 };
@@ -0,0 +1,209 @@
+#include "NetworkManager.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include "InterfaceLoader.hpp"
+
+namespace network {
+
+namespace {
+
+bool addressLess(const IPv6Address &_a, const IPv6Address &_b) { return std::memcmp(_a.c, _b.c, sizeof(_a.c)) < 0; }
+
+}  // namespace
+
+const Interface *NetworkManager::Snapshot::findByIndex(int _index) const noexcept {
+  const auto it = std::lower_bound(interfaces_.begin(), interfaces_.end(), _index,
+                                   [](const auto &_interface, int _value) { return _interface->getIndex() < _value; });
+  return it != interfaces_.end() && (*it)->getIndex() == _index ? it->get() : nullptr;
+}
+
+const Interface *NetworkManager::Snapshot::findByName(std::string_view _name) const noexcept {
+  for (const auto &interface : interfaces_) {
+    if (interface->getName() == _name) return interface.get();
+  }
+  return nullptr;
+}
+
+const Interface *NetworkManager::Snapshot::owner(const Address &_address) const noexcept {
+  const IPv6Address key = _address.toIPv6Address();
+  const auto before     = [](const Owner &_owner, const IPv6Address &_value) {
+    return addressLess(_owner.address, _value);
+  };
+  const auto it         = std::lower_bound(owners_.begin(), owners_.end(), key, before);
+  return it != owners_.end() && !addressLess(key, it->address) ? it->interface : nullptr;
+}
+
+NetworkManager::NetworkManager() : snapshot_(std::make_unique<const Snapshot>()) {}
+
+NetworkManager::~NetworkManager() { close(); }
+
+bool NetworkManager::open() {
+  close();
+  // Subscribe before loading so nothing between the dump and the first notification is lost;
+  // notifications that repeat what the dump already saw are applied idempotently.
+  if (!events_.open(RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR)) return false;
+  if (!reload()) {
+    events_.close();
+    return false;
+  }
+  processEvents();
+  return true;
+}
+
+void NetworkManager::close() {
+  stop();
+  events_.close();
+}
+
+bool NetworkManager::reload() {
+  std::pmr::vector<Interface> list;
+  InterfaceLoader loader;
+  if (!loader.load(list)) return false;
+
+  interfaces_.clear();
+  for (Interface &interface : list) {
+    const int index = interface.getIndex();
+    interfaces_.emplace(index, std::make_shared<const Interface>(std::move(interface)));
+  }
+  publish();
+  return true;
+}
+
+bool NetworkManager::processEvents() {
+  bool changed = false;
+  for (;;) {
+    const ssize_t size = events_.receive(false);
+    if (size == 0) break;
+    if (size < 0) {
+      // The socket queue overflowed and notifications were dropped: start over from a full dump
+      if (errno == ENOBUFS) {
+        pending_.clear();
+        if (!reload()) return false;
+        changed = false;
+        continue;
+      }
+      return false;
+    }
+
+    auto remaining = static_cast<unsigned>(size);
+    for (auto *header = reinterpret_cast<const nlmsghdr *>(events_.received().data()); NLMSG_OK(header, remaining);
+         header       = NLMSG_NEXT(header, remaining)) {
+      changed |= apply(*header);
+    }
+  }
+  // A few new links are each loaded with dumps filtered to them; more than that (containers
+  // starting in bulk) cost less as one full reload than as a load per link
+  if (pending_.size() > C_LINK_LOADS) {
+    pending_.clear();
+    if (reload()) changed = false;
+  } else if (!pending_.empty()) {
+    changed |= loadPending();
+  }
+  if (changed) publish();
+  return true;
+}
+
+bool NetworkManager::loadPending() {
+  bool changed = false;
+  for (const int index : pending_) {
+    // The link may have been removed again later in the same batch
+    if (!interfaces_.contains(index)) continue;
+    std::pmr::vector<Interface> list;
+    InterfaceLoader loader(index);
+    if (loader.load(list) && list.size() == 1) {
+      interfaces_[index] = std::make_shared<const Interface>(std::move(list.front()));
+      changed            = true;
+    }
+  }
+  pending_.clear();
+  return changed;
+}
+
+bool NetworkManager::apply(const nlmsghdr &_message) {
+  switch (_message.nlmsg_type) {
+    case RTM_NEWLINK: {
+      const auto *info = static_cast<const ifinfomsg *>(NLMSG_DATA(&_message));
+      // Bridge port messages (AF_BRIDGE) also arrive on RTNLGRP_LINK and describe no interface change
+      if (info->ifi_family != AF_UNSPEC) return false;
+      const auto it = interfaces_.find(info->ifi_index);
+      // A link we have not seen may already have addresses: it is loaded whole once the batch is applied
+      if (it == interfaces_.end()) pending_.push_back(info->ifi_index);
+      // Copy on write: the published snapshot keeps the old object
+      auto interface =
+          it != interfaces_.end() ? std::make_shared<Interface>(*it->second) : std::make_shared<Interface>();
+      if (!InterfaceLoader::applyLink(_message, *interface)) return false;
+      interfaces_[info->ifi_index] = std::move(interface);
+      return true;
+    }
+    case RTM_DELLINK: {
+      const auto *info = static_cast<const ifinfomsg *>(NLMSG_DATA(&_message));
+      // An AF_BRIDGE RTM_DELLINK only means the port left its bridge; the interface is still there
+      if (info->ifi_family != AF_UNSPEC) return false;
+      return interfaces_.erase(info->ifi_index) != 0;
+    }
+    case RTM_NEWADDR:
+    case RTM_DELADDR: {
+      const auto *info = static_cast<const ifaddrmsg *>(NLMSG_DATA(&_message));
+      const auto it    = interfaces_.find(int(info->ifa_index));
+      if (it == interfaces_.end()) return false;
+      auto interface = std::make_shared<Interface>(*it->second);
+      InterfaceLoader::applyAddress(_message, *interface);
+      it->second = std::move(interface);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+void NetworkManager::publish() {
+  auto snapshot = std::make_unique<Snapshot>();
+  snapshot->interfaces_.reserve(interfaces_.size());
+  for (const auto &[index, interface] : interfaces_) {
+    snapshot->interfaces_.push_back(interface);
+    for (const Addr4Entry &entry : interface->getEntries4()) {
+      snapshot->owners_.push_back(Snapshot::Owner {Address(entry.ipv4_).toIPv6Address(), interface.get()});
+    }
+    for (const Addr6Entry &entry : interface->getEntries6()) {
+      snapshot->owners_.push_back(Snapshot::Owner {entry.ipv6_, interface.get()});
+    }
+  }
+  std::sort(snapshot->owners_.begin(), snapshot->owners_.end(),
+            [](const Snapshot::Owner &_a, const Snapshot::Owner &_b) { return addressLess(_a.address, _b.address); });
+  snapshot->generation_ = ++generation_;
+  snapshot_.update(std::move(snapshot));
+}
+
+bool NetworkManager::start() {
+  if (!isOpen() || thread_.joinable()) return false;
+  wakeup_ = eventfd(0, EFD_CLOEXEC);
+  if (wakeup_ < 0) return false;
+  thread_ = std::thread(&NetworkManager::run, this);
+  return true;
+}
+
+void NetworkManager::stop() {
+  if (!thread_.joinable()) return;
+  eventfd_write(wakeup_, 1);
+  thread_.join();
+  ::close(wakeup_);
+  wakeup_ = -1;
+}
+
+void NetworkManager::run() {
+  pollfd fds[2] = {{events_.fd(), POLLIN, 0}, {wakeup_, POLLIN, 0}};
+  for (;;) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    if (fds[1].revents & POLLIN) return;
+    if ((fds[0].revents & POLLIN) && !processEvents()) return;
+  }
+}
+
+}  // namespace network
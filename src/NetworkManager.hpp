@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Address.hpp"
+#include "Interface.hpp"
+#include "Netlink.hpp"
+#include "Rcu.hpp"
+
+namespace network {
+
+//! Interface cache kept up to date from netlink notifications
+/*!
+    Subscribes to link and IPv4/IPv6 address notifications and applies them to an in-memory copy
+    of the interface list, so nothing is re-enumerated after the initial load (or after the kernel
+    reports lost notifications, which triggers a full reload).
+
+    Readers call snapshot() and get an immutable Snapshot without blocking behind updates; every
+    batch of notifications publishes a new Snapshot that shares the unchanged interfaces with the
+    previous one. Links first seen in a batch are loaded whole once it is applied, with dumps
+    filtered to each link, or with one full reload when many appear together. Gateways are filled
+    in by these loads only.
+
+    Events are processed either by start(), which runs a background thread, or by calling
+    processEvents() whenever fd() becomes readable. Both must not be used at the same time.
+*/
+class NetworkManager {
+public:
+  //! Immutable view of the interfaces at one point in time
+  class Snapshot {
+  public:
+    //! Interfaces ordered by index
+    [[nodiscard]] const std::vector<std::shared_ptr<const Interface>> &getInterfaces() const noexcept {
+      return interfaces_;
+    }
+    [[nodiscard]] const Interface *findByIndex(int _index) const noexcept;
+    [[nodiscard]] const Interface *findByName(std::string_view _name) const noexcept;
+    //! Interface that has \a _address assigned, or nullptr
+    [[nodiscard]] const Interface *owner(const Address &_address) const noexcept;
+    //! Incremented with every published snapshot
+    [[nodiscard]] uint64_t getGeneration() const noexcept { return generation_; }
+
+  private:
+    friend class NetworkManager;
+
+    struct Owner {
+      IPv6Address address;
+      const Interface *interface;
+    };
+
+    std::vector<std::shared_ptr<const Interface>> interfaces_;
+    std::vector<Owner> owners_;  // sorted by address
+    uint64_t generation_ {0};
+  };
+
+  using ReadGuard = RcuPointer<Snapshot>::ReadGuard;
+
+  NetworkManager();
+  ~NetworkManager();
+
+  NetworkManager(const NetworkManager &)            = delete;
+  NetworkManager &operator=(const NetworkManager &) = delete;
+
+  //! Subscribe to notifications and load the current interfaces
+  bool open();
+  void close();
+  [[nodiscard]] bool isOpen() const noexcept { return events_.isOpen(); }
+  //! Socket to watch for readability when driving processEvents() from an external event loop
+  [[nodiscard]] int fd() const noexcept { return events_.fd(); }
+
+  //! Apply all pending notifications without blocking and publish a snapshot if anything changed
+  bool processEvents();
+
+  //! Process events on a background thread until stop()
+  bool start();
+  void stop();
+
+  //! Current interfaces; never blocks, never null once open() succeeded
+  [[nodiscard]] ReadGuard snapshot() const noexcept { return snapshot_.read(); }
+
+private:
+  static constexpr std::size_t C_LINK_LOADS = 4;
+
+  bool reload();
+  bool apply(const nlmsghdr &_message);
+  //! Load each link first seen in the last batch whole; false if nothing changed
+  bool loadPending();
+  void publish();
+  void run();
+
+  netlink::Socket events_;
+  std::map<int, std::shared_ptr<const Interface>> interfaces_;
+  std::vector<int> pending_;  // links first seen in the current batch
+  RcuPointer<Snapshot> snapshot_;
+  uint64_t generation_ {0};
+  std::thread thread_;
+  int wakeup_ {-1};
+};
+
+}  // namespace network
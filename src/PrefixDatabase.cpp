@@ -0,0 +1,541 @@
+#include "PrefixDatabase.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include "CpuFeatures.hpp"
+#include "Endian.hpp"
+#include "global/Simd.hpp"
+
+namespace network {
+
+namespace {
+
+using detail::Uint128;
+using prefixdb::FileHeader;
+using prefixdb::Section;
+using prefixdb::SectionEntry;
+
+template <typename Key>
+struct KeyTraits;
+
+template <>
+struct KeyTraits<uint32_t> {
+  static constexpr unsigned C_BITS = 32;
+  static constexpr uint32_t C_ONE  = 1;
+  static constexpr uint32_t C_MAX  = ~0U;
+
+  static constexpr uint32_t lowMask(unsigned _bits) { return _bits >= 32 ? ~0U : (1U << _bits) - 1; }
+  static constexpr uint32_t bucket(uint32_t _key) { return _key >> 16U; }
+};
+
+template <>
+struct KeyTraits<Uint128> {
+  static constexpr unsigned C_BITS = 128;
+  static constexpr Uint128 C_ONE   = {0, 1};
+  static constexpr Uint128 C_MAX   = {~0ULL, ~0ULL};
+
+  static constexpr uint64_t lowMask64(unsigned _bits) { return _bits >= 64 ? ~0ULL : (1ULL << _bits) - 1; }
+  static constexpr Uint128 lowMask(unsigned _bits) {
+    return _bits >= 64 ? Uint128 {lowMask64(_bits - 64), ~0ULL} : Uint128 {0, lowMask64(_bits)};
+  }
+  static constexpr uint32_t bucket(Uint128 _key) { return uint32_t(_key.hi >> 48U); }
+};
+
+// Same keys as AddressRangeSet: host order for IPv4, the 16 bytes as one big-endian number for IPv6
+uint32_t key4(const Address &_address) { return _address.toIPv4Address(); }
+
+Uint128 key6(const Address &_address) {
+  const IPv6Address ip6 = _address.toIPv6Address();
+  return {qFromBigEndian<uint64_t>(ip6.c), qFromBigEndian<uint64_t>(ip6.c + 8)};
+}
+
+// CRC-32C (Castagnoli, reflected), the polynomial of the SSE4.2 crc32 instruction
+constexpr uint32_t C_CRC_POLYNOMIAL = 0x82f63b78;
+
+// Slicing-by-8 tables: C_CRC_TABLES[k][b] is the CRC of byte b followed by k zero bytes
+constexpr auto C_CRC_TABLES = [] {
+  std::array<std::array<uint32_t, 256>, 8> tables {};
+  for (uint32_t b = 0; b < 256; ++b) {
+    uint32_t crc = b;
+    for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1U) ^ ((crc & 1U) != 0 ? C_CRC_POLYNOMIAL : 0);
+    tables[0][b] = crc;
+  }
+  for (uint32_t b = 0; b < 256; ++b) {
+    for (std::size_t k = 1; k < 8; ++k) tables[k][b] = (tables[k - 1][b] >> 8U) ^ tables[0][tables[k - 1][b] & 0xffU];
+  }
+  return tables;
+}();
+
+uint32_t crc32cTable(uint32_t _crc, const uint8_t *_data, std::size_t _size) noexcept {
+  const auto &t = C_CRC_TABLES;
+  for (; _size >= 8; _data += 8, _size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, _data, 8);
+    word ^= _crc;
+    _crc = t[7][word & 0xffU] ^ t[6][(word >> 8U) & 0xffU] ^ t[5][(word >> 16U) & 0xffU] ^
+           t[4][(word >> 24U) & 0xffU] ^ t[3][(word >> 32U) & 0xffU] ^ t[2][(word >> 40U) & 0xffU] ^
+           t[1][(word >> 48U) & 0xffU] ^ t[0][word >> 56U];
+  }
+  for (; _size != 0; ++_data, --_size) _crc = (_crc >> 8U) ^ t[0][(_crc ^ *_data) & 0xffU];
+  return _crc;
+}
+
+#if defined(KT_KERNELS_SSE4_2)
+KT_TARGET_SSE4_2 uint32_t crc32cSse42(uint32_t _crc, const uint8_t *_data, std::size_t _size) noexcept {
+  uint64_t crc = _crc;
+  for (; _size >= 8; _data += 8, _size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, _data, 8);
+    crc = _mm_crc32_u64(crc, word);
+  }
+  auto crc32 = uint32_t(crc);
+  for (; _size != 0; ++_data, --_size) crc32 = _mm_crc32_u8(crc32, *_data);
+  return crc32;
+}
+#endif
+
+// Little-endian layout only: files are memory-mapped, not decoded
+constexpr bool C_LITTLE_ENDIAN = std::endian::native == std::endian::little;
+
+uint32_t crc32c(const void *_data, std::size_t _size, uint32_t _crc = 0) noexcept {
+  using Kernel = uint32_t (*)(uint32_t, const uint8_t *, std::size_t) noexcept;
+#if defined(KT_COMPILER_SUPPORTS_SSE4_2)
+  constexpr Kernel kernel = crc32cSse42;
+#elif defined(KT_RUNTIME_DISPATCH)
+  static const Kernel kernel = qResolveKernel<Kernel>(crc32cTable, crc32cSse42, nullptr, nullptr);
+#else
+  constexpr Kernel kernel = crc32cTable;
+#endif
+  return ~kernel(~_crc, static_cast<const uint8_t *>(_data), _size);
+}
+
+// The header and the section table are checksummed together, with the header's checksum zero
+uint32_t headerChecksum(FileHeader _header, std::span<const SectionEntry> _table) noexcept {
+  _header.checksum = 0;
+  return crc32c(_table.data(), _table.size_bytes(), crc32c(&_header, sizeof(_header)));
+}
+
+constexpr std::size_t alignUp(std::size_t _offset) {
+  return (_offset + prefixdb::C_ALIGNMENT - 1) & ~(prefixdb::C_ALIGNMENT - 1);
+}
+
+// Expected size of a section, given the counts of the header, or -1 if any size is allowed
+int64_t expectedSize(Section _section, const FileHeader &_header) {
+  switch (_section) {
+    case Section::INDEX4:
+    case Section::INDEX6: return int64_t(prefixdb::C_INDEX_SIZE * sizeof(uint32_t));
+    case Section::STARTS4:
+    case Section::VALUES4: return int64_t(_header.ranges4 * sizeof(uint32_t));
+    case Section::STARTS6: return int64_t(_header.ranges6 * sizeof(Uint128));
+    case Section::VALUES6: return int64_t(_header.ranges6 * sizeof(uint32_t));
+    case Section::VALUE_OFFSETS: return int64_t((_header.values + 1) * sizeof(uint64_t));
+    default: return -1;
+  }
+}
+
+}  // namespace
+
+/* ------------------------------------------------------------------------------------------ */
+/*                                         Reader                                             */
+/* ------------------------------------------------------------------------------------------ */
+
+struct PrefixDatabase::Mapping {
+  enum State : uint8_t { UNCHECKED, VALID, CORRUPT };
+
+  const uint8_t *base = nullptr;
+  std::size_t size    = 0;
+  FileHeader header {};
+  std::array<std::span<const uint8_t>, prefixdb::C_SECTION_COUNT> sections {};
+  std::array<uint32_t, prefixdb::C_SECTION_COUNT> checksums {};
+  mutable std::array<std::atomic<uint8_t>, prefixdb::C_SECTION_COUNT> states {};
+
+  Mapping()                           = default;
+  Mapping(const Mapping &)            = delete;
+  Mapping &operator=(const Mapping &) = delete;
+  ~Mapping() {
+    if (base != nullptr) ::munmap(const_cast<uint8_t *>(base), size);
+  }
+
+  // Verified data of a section, or nullptr if its checksum does not match. Threads racing on
+  // the first use both compute the checksum and store the same state.
+  template <typename T>
+  const T *section(Section _section) const noexcept {
+    const auto i  = std::size_t(_section);
+    uint8_t state = states[i].load(std::memory_order_acquire);
+    if (state == UNCHECKED) {
+      state = crc32c(sections[i].data(), sections[i].size()) == checksums[i] ? VALID : CORRUPT;
+      states[i].store(state, std::memory_order_release);
+    }
+    return state == VALID ? reinterpret_cast<const T *>(sections[i].data()) : nullptr;
+  }
+
+  // Value id of the range containing _key: the last start <= _key, searched within its bucket
+  template <typename Key>
+  uint32_t find(Key _key, Section _index, Section _starts, Section _values, uint64_t _count) const noexcept {
+    const auto *index  = section<uint32_t>(_index);
+    const auto *starts = section<Key>(_starts);
+    const auto *values = section<uint32_t>(_values);
+    if (index == nullptr || starts == nullptr || values == nullptr) return prefixdb::C_NO_VALUE;
+
+    // Clamped so that a consistent checksum over a bad index cannot read out of bounds
+    const uint32_t bucket = KeyTraits<Key>::bucket(_key);
+    const auto end        = std::size_t(std::min<uint64_t>(index[bucket + 1], _count));
+    const auto begin      = std::size_t(std::min<uint64_t>(index[bucket], end));
+    const Key *next       = std::upper_bound(starts + begin, starts + end, _key);
+    // Before the bucket's first start, the range is the one continuing from the previous bucket
+    return next == starts ? prefixdb::C_NO_VALUE : values[next - starts - 1];
+  }
+
+  std::optional<std::string_view> value(uint32_t _id) const noexcept {
+    if (_id >= header.values) return std::nullopt;
+    const auto *offsets = section<uint64_t>(Section::VALUE_OFFSETS);
+    const auto *data    = section<char>(Section::VALUE_DATA);
+    if (offsets == nullptr || data == nullptr) return std::nullopt;
+    const uint64_t begin = offsets[_id];
+    const uint64_t end   = offsets[_id + 1];
+    if (begin > end || end > sections[std::size_t(Section::VALUE_DATA)].size()) return std::nullopt;
+    return std::string_view(data + begin, end - begin);
+  }
+
+  // Header and section table checks, everything but the section checksums
+  bool validate() {
+    if (size < sizeof(FileHeader)) return false;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, prefixdb::C_MAGIC, sizeof(header.magic)) != 0) return false;
+    if (header.version != prefixdb::C_VERSION || header.byteOrder != prefixdb::C_BYTE_ORDER || !C_LITTLE_ENDIAN) {
+      errno = ENOTSUP;
+      return false;
+    }
+
+    const std::size_t tableEnd = sizeof(FileHeader) + prefixdb::C_SECTION_COUNT * sizeof(SectionEntry);
+    // Counts are bounded by the file size before any size is computed from them
+    if (header.fileSize != size || header.sectionCount != prefixdb::C_SECTION_COUNT || tableEnd > size ||
+        header.ranges4 > size || header.ranges6 > size || header.values >= size) {
+      return false;
+    }
+    std::array<SectionEntry, prefixdb::C_SECTION_COUNT> table {};
+    std::memcpy(table.data(), base + sizeof(FileHeader), sizeof(table));
+    if (headerChecksum(header, table) != header.checksum) {
+      errno = EBADMSG;
+      return false;
+    }
+
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      const SectionEntry &entry = table[i];
+      const int64_t expected    = expectedSize(Section(i), header);
+      if (entry.id != i || entry.offset % prefixdb::C_ALIGNMENT != 0 || entry.offset < tableEnd ||
+          entry.offset > size || entry.size > size - entry.offset ||
+          (expected >= 0 && entry.size != uint64_t(expected))) {
+        return false;
+      }
+      sections[i]  = {base + entry.offset, entry.size};
+      checksums[i] = entry.checksum;
+    }
+    return true;
+  }
+};
+
+PrefixDatabase::PrefixDatabase()                                          = default;
+PrefixDatabase::~PrefixDatabase()                                         = default;
+PrefixDatabase::PrefixDatabase(PrefixDatabase &&_other) noexcept            = default;
+PrefixDatabase &PrefixDatabase::operator=(PrefixDatabase &&_other) noexcept = default;
+
+bool PrefixDatabase::open(const std::string &_path) {
+  close();
+  const int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  struct stat status {};
+  auto mapping = std::make_unique<Mapping>();
+  if (::fstat(fd, &status) < 0) {
+    const int error = errno;
+    ::close(fd);
+    errno = error;
+    return false;
+  }
+  mapping->size = std::size_t(status.st_size);
+  if (mapping->size >= sizeof(FileHeader)) {
+    void *base = ::mmap(nullptr, mapping->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      return false;
+    }
+    mapping->base = static_cast<const uint8_t *>(base);
+  }
+  // The mapping keeps the file referenced
+  ::close(fd);
+
+  errno = EINVAL;
+  if (!mapping->validate()) return false;
+  mapping_ = std::move(mapping);
+  return true;
+}
+
+void PrefixDatabase::close() { mapping_.reset(); }
+
+std::optional<std::string_view> PrefixDatabase::lookup(const Address &_address) const {
+  if (!mapping_) return std::nullopt;
+  const FileHeader &header = mapping_->header;
+  uint32_t id              = prefixdb::C_NO_VALUE;
+  switch (_address.getProtocol()) {
+    case LayerProtocol::IPv4:
+      id = mapping_->find(key4(_address), Section::INDEX4, Section::STARTS4, Section::VALUES4, header.ranges4);
+      break;
+    case LayerProtocol::IPv6:
+      id = mapping_->find(key6(_address), Section::INDEX6, Section::STARTS6, Section::VALUES6, header.ranges6);
+      break;
+    default: return std::nullopt;
+  }
+  return mapping_->value(id);
+}
+
+bool PrefixDatabase::verify() const {
+  if (!mapping_) {
+    errno = EBADF;
+    return false;
+  }
+  for (std::size_t i = 0; i < prefixdb::C_SECTION_COUNT; ++i) mapping_->section<uint8_t>(Section(i));
+  if (!isValid()) {
+    errno = EBADMSG;
+    return false;
+  }
+  return true;
+}
+
+bool PrefixDatabase::isValid() const noexcept {
+  if (!mapping_) return false;
+  return std::none_of(mapping_->states.begin(), mapping_->states.end(),
+                      [](const auto &_state) { return _state.load(std::memory_order_acquire) == Mapping::CORRUPT; });
+}
+
+std::size_t PrefixDatabase::rangeCount() const noexcept {
+  return mapping_ ? std::size_t(mapping_->header.ranges4 + mapping_->header.ranges6) : 0;
+}
+
+std::size_t PrefixDatabase::valueCount() const noexcept { return mapping_ ? std::size_t(mapping_->header.values) : 0; }
+
+/* ------------------------------------------------------------------------------------------ */
+/*                                         Builder                                            */
+/* ------------------------------------------------------------------------------------------ */
+
+namespace {
+
+// Longest-prefix-match ranges of one family: the value of starts[i] holds up to starts[i + 1]
+template <typename Key>
+struct Ranges {
+  std::vector<Key> starts;
+  std::vector<uint32_t> values;
+
+  // A later boundary at the same start replaces the earlier one
+  void boundary(Key _start, uint32_t _value) {
+    if (!starts.empty() && starts.back() == _start) {
+      values.back() = _value;
+    } else {
+      starts.push_back(_start);
+      values.push_back(_value);
+    }
+  }
+};
+
+// Flatten nested prefixes, sorted by first address then length, with a stack of the prefixes
+// enclosing the current position: the innermost one gives the value
+template <typename Key, typename Prefix>
+Ranges<Key> flatten(std::vector<Prefix> _prefixes) {
+  std::stable_sort(_prefixes.begin(), _prefixes.end(), [](const Prefix &_a, const Prefix &_b) {
+    return _a.first != _b.first ? _a.first < _b.first : _a.length < _b.length;
+  });
+
+  struct Enclosing {
+    Key last;
+    uint32_t value;
+  };
+  Ranges<Key> ranges;
+  std::vector<Enclosing> stack;
+  // Close the prefixes ending before _limit, each handing over to the one enclosing it
+  auto closeBefore = [&](const Key *_limit) {
+    while (!stack.empty() && (_limit == nullptr || stack.back().last < *_limit)) {
+      const Key last = stack.back().last;
+      stack.pop_back();
+      // A prefix ending at the last address leaves nothing after it, and neither do the enclosing ones
+      if (last == KeyTraits<Key>::C_MAX) continue;
+      ranges.boundary(last + KeyTraits<Key>::C_ONE, stack.empty() ? prefixdb::C_NO_VALUE : stack.back().value);
+    }
+  };
+
+  for (std::size_t i = 0; i < _prefixes.size(); ++i) {
+    const Prefix &prefix = _prefixes[i];
+    // Of identical prefixes, the last inserted wins
+    if (i + 1 < _prefixes.size() && _prefixes[i + 1].first == prefix.first &&
+        _prefixes[i + 1].length == prefix.length) {
+      continue;
+    }
+    closeBefore(&prefix.first);
+    stack.push_back({prefix.last, prefix.value});
+    ranges.boundary(prefix.first, prefix.value);
+  }
+  closeBefore(nullptr);
+
+  // Merge neighbours with the same value, e.g. a more specific prefix repeating its parent's
+  std::size_t out = 0;
+  for (std::size_t i = 0; i < ranges.starts.size(); ++i) {
+    if (out != 0 && ranges.values[out - 1] == ranges.values[i]) continue;
+    ranges.starts[out]   = ranges.starts[i];
+    ranges.values[out++] = ranges.values[i];
+  }
+  ranges.starts.resize(out);
+  ranges.values.resize(out);
+  return ranges;
+}
+
+template <typename Key>
+std::vector<uint32_t> buildIndex(const std::vector<Key> &_starts) {
+  std::vector<uint32_t> index(prefixdb::C_INDEX_SIZE);
+  std::size_t i = 0;
+  for (std::size_t bucket = 0; bucket < index.size(); ++bucket) {
+    while (i < _starts.size() && KeyTraits<Key>::bucket(_starts[i]) < bucket) ++i;
+    index[bucket] = uint32_t(i);
+  }
+  return index;
+}
+
+bool writeAll(int _fd, const void *_data, std::size_t _size) {
+  const auto *data = static_cast<const uint8_t *>(_data);
+  while (_size != 0) {
+    const ssize_t written = ::write(_fd, data, _size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    _size -= std::size_t(written);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool PrefixDatabaseBuilder::insert(const Address &_address, Netmask _netmask, std::string_view _value) {
+  const int length = _netmask.getPrefixLength();
+  const auto id    = uint32_t(values_.size());
+  switch (_address.getProtocol()) {
+    case LayerProtocol::IPv4: {
+      if (length < 0 || length > 32) return false;
+      const uint32_t host  = KeyTraits<uint32_t>::lowMask(32 - unsigned(length));
+      const uint32_t first = key4(_address) & ~host;
+      prefixes4_.push_back({first, first | host, uint32_t(length), id});
+      break;
+    }
+    case LayerProtocol::IPv6: {
+      if (length < 0 || length > 128) return false;
+      const Uint128 host  = KeyTraits<Uint128>::lowMask(128 - unsigned(length));
+      const Uint128 first = key6(_address) & ~host;
+      prefixes6_.push_back({first, first | host, uint32_t(length), id});
+      break;
+    }
+    default: return false;
+  }
+  // Values are deduplicated by write(), which also drops the unreachable ones
+  values_.emplace_back(_value);
+  return true;
+}
+
+void PrefixDatabaseBuilder::clear() {
+  prefixes4_.clear();
+  prefixes6_.clear();
+  values_.clear();
+}
+
+bool PrefixDatabaseBuilder::write(const std::string &_path) const {
+  Ranges<uint32_t> ranges4 = flatten<uint32_t>(prefixes4_);
+  Ranges<Uint128> ranges6  = flatten<Uint128>(prefixes6_);
+  // Range positions are stored as 32-bit index entries
+  if (ranges4.starts.size() >= prefixdb::C_NO_VALUE || ranges6.starts.size() >= prefixdb::C_NO_VALUE) {
+    errno = EOVERFLOW;
+    return false;
+  }
+
+  // Renumber the values the ranges still reference, storing each distinct one once
+  std::unordered_map<std::string_view, uint32_t> ids;
+  std::vector<uint32_t> remap(values_.size(), prefixdb::C_NO_VALUE);
+  std::vector<uint64_t> offsets {0};
+  std::string data;
+  auto renumber = [&](std::vector<uint32_t> &_values) {
+    for (uint32_t &value : _values) {
+      if (value == prefixdb::C_NO_VALUE) continue;
+      if (remap[value] == prefixdb::C_NO_VALUE) {
+        const auto [it, inserted] = ids.try_emplace(values_[value], uint32_t(ids.size()));
+        if (inserted) {
+          data += values_[value];
+          offsets.push_back(data.size());
+        }
+        remap[value] = it->second;
+      }
+      value = remap[value];
+    }
+  };
+  renumber(ranges4.values);
+  renumber(ranges6.values);
+  const std::vector<uint32_t> index4 = buildIndex(ranges4.starts);
+  const std::vector<uint32_t> index6 = buildIndex(ranges6.starts);
+
+  const std::array<std::span<const std::byte>, prefixdb::C_SECTION_COUNT> sections = {
+      std::as_bytes(std::span(index4)),         std::as_bytes(std::span(ranges4.starts)),
+      std::as_bytes(std::span(ranges4.values)), std::as_bytes(std::span(index6)),
+      std::as_bytes(std::span(ranges6.starts)), std::as_bytes(std::span(ranges6.values)),
+      std::as_bytes(std::span(offsets)),        std::as_bytes(std::span(data)),
+  };
+  std::array<SectionEntry, prefixdb::C_SECTION_COUNT> table {};
+  std::size_t offset = alignUp(sizeof(FileHeader) + sizeof(table));
+  for (std::size_t i = 0; i < sections.size(); ++i) {
+    table[i] = {uint32_t(i), crc32c(sections[i].data(), sections[i].size()), offset, sections[i].size()};
+    offset   = alignUp(offset + sections[i].size());
+  }
+
+  FileHeader header {};
+  std::memcpy(header.magic, prefixdb::C_MAGIC, sizeof(header.magic));
+  header.version      = prefixdb::C_VERSION;
+  header.byteOrder    = prefixdb::C_BYTE_ORDER;
+  header.fileSize     = table.back().offset + table.back().size;
+  header.ranges4      = ranges4.starts.size();
+  header.ranges6      = ranges6.starts.size();
+  header.values       = ids.size();
+  header.sectionCount = prefixdb::C_SECTION_COUNT;
+  header.checksum     = headerChecksum(header, table);
+
+  // Written next to the destination and renamed over it, so readers see the old or the new file
+  std::string temporary = _path + ".XXXXXX";
+  const int fd          = ::mkstemp(temporary.data());
+  if (fd < 0) return false;
+  static constexpr uint8_t C_PADDING[prefixdb::C_ALIGNMENT] = {};
+  bool written = ::fchmod(fd, 0644) == 0 && writeAll(fd, &header, sizeof(header)) &&
+                 writeAll(fd, table.data(), sizeof(table));
+  std::size_t position = sizeof(header) + sizeof(table);
+  for (std::size_t i = 0; written && i < sections.size(); ++i) {
+    written  = writeAll(fd, C_PADDING, table[i].offset - position) &&
+               writeAll(fd, sections[i].data(), sections[i].size());
+    position = table[i].offset + sections[i].size();
+  }
+  written = written && ::fsync(fd) == 0;
+  if (::close(fd) < 0) written = false;
+  if (!written || ::rename(temporary.c_str(), _path.c_str()) < 0) {
+    const int error = errno;
+    ::unlink(temporary.c_str());
+    errno = error;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace network
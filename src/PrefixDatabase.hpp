@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Uint128.hpp"
+
+namespace network {
+
+namespace prefixdb {
+
+/*
+    File layout, version 1. Every integer is little-endian (files are rejected on big-endian
+    hosts) and every section starts on a 64-byte boundary.
+
+    Header            magic, version, byte order mark, file size, counts, CRC-32C of the header
+                      and section table
+    Section table     one SectionEntry per section: id, CRC-32C, offset, size
+    INDEX4            uint32[65537]: first IPv4 range whose start has the given top 16 bits
+    STARTS4           uint32[ranges4]: ascending range starts, host order
+    VALUES4           uint32[ranges4]: value of the range from each start to the next, or C_NO_VALUE
+    INDEX6            uint32[65537]: as INDEX4, over the top 16 bits of the IPv6 address
+    STARTS6           {uint64 hi, uint64 lo}[ranges6]
+    VALUES6           uint32[ranges6]
+    VALUE_OFFSETS     uint64[values + 1]: value i is VALUE_DATA[offsets[i], offsets[i + 1])
+    VALUE_DATA        the distinct values, concatenated
+
+    The ranges are the prefixes flattened by the builder: each address maps to the value of the
+    longest prefix containing it, so a lookup is one binary search within an index bucket.
+*/
+constexpr char C_MAGIC[8]          = {'K', 'T', 'P', 'F', 'X', 'D', 'B', '\n'};
+constexpr uint32_t C_VERSION       = 1;
+constexpr uint32_t C_BYTE_ORDER    = 0x01020304;
+constexpr uint32_t C_NO_VALUE      = ~0U;
+constexpr std::size_t C_INDEX_SIZE = (std::size_t(1) << 16U) + 1;
+constexpr std::size_t C_ALIGNMENT  = 64;
+
+enum class Section : uint32_t { INDEX4, STARTS4, VALUES4, INDEX6, STARTS6, VALUES6, VALUE_OFFSETS, VALUE_DATA, COUNT };
+constexpr std::size_t C_SECTION_COUNT = std::size_t(Section::COUNT);
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t fileSize;
+  uint64_t ranges4;
+  uint64_t ranges6;
+  uint64_t values;
+  uint32_t sectionCount;
+  uint32_t checksum;  // over the header with this field zero, followed by the section table
+  uint8_t reserved[8];
+};
+
+struct SectionEntry {
+  uint32_t id;
+  uint32_t checksum;
+  uint64_t offset;
+  uint64_t size;
+};
+
+static_assert(sizeof(FileHeader) == 64 && sizeof(SectionEntry) == 24, "on-disk layout");
+
+}  // namespace prefixdb
+
+//! Read-only longest-prefix-match database mapped from a file written by PrefixDatabaseBuilder
+/*!
+    open() maps the file (MAP_SHARED, read-only) and checks the header and the section table
+    only: the lookup structures are used in place, so a process can serve lookups right after
+    open() and every process mapping the same file shares its page cache pages.
+
+    Each section's CRC-32C is verified on its first use. A lookup that touches a corrupt section
+    returns no value and isValid() becomes false; verify() checks every section up front.
+
+    Errors are reported by returning false with errno set: EINVAL for a file that is not a
+    database or is truncated, ENOTSUP for another format version or byte order, EBADMSG for a
+    checksum mismatch.
+
+    Lookups are thread-safe. The mapping stays valid if the file is replaced by rename(); to
+    pick up the new file, open a new PrefixDatabase.
+*/
+class PrefixDatabase {
+public:
+  PrefixDatabase();
+  ~PrefixDatabase();
+
+  PrefixDatabase(const PrefixDatabase &)            = delete;
+  PrefixDatabase &operator=(const PrefixDatabase &) = delete;
+  PrefixDatabase(PrefixDatabase &&_other) noexcept;
+  PrefixDatabase &operator=(PrefixDatabase &&_other) noexcept;
+
+  bool open(const std::string &_path);
+  void close();
+  [[nodiscard]] bool isOpen() const noexcept { return mapping_ != nullptr; }
+
+  //! Value of the longest prefix containing \a _address
+  /*!
+      The view points into the mapping and stays valid until close(). As in PrefixTable, the
+      family is taken from Address::getProtocol(); v4-mapped IPv6 addresses use the IPv6 ranges.
+  */
+  [[nodiscard]] std::optional<std::string_view> lookup(const Address &_address) const;
+
+  //! Verify the checksum of every section not checked yet
+  bool verify() const;
+  //! No corrupt section found so far
+  [[nodiscard]] bool isValid() const noexcept;
+
+  [[nodiscard]] std::size_t rangeCount() const noexcept;
+  [[nodiscard]] std::size_t valueCount() const noexcept;
+
+private:
+  struct Mapping;
+  std::unique_ptr<Mapping> mapping_;
+};
+
+//! Writes the files read by PrefixDatabase
+/*!
+    Prefixes are kept in memory until write(), which flattens nested prefixes into disjoint
+    ranges, stores every distinct value once and writes the file under a temporary name before
+    renaming it, so readers never see a partial file.
+*/
+class PrefixDatabaseBuilder {
+public:
+  //! Add a prefix, replacing the value of an identical one. Returns false if the netmask does
+  //! not fit the protocol or the address is neither IPv4 nor IPv6.
+  bool insert(const Address &_address, Netmask _netmask, std::string_view _value);
+  [[nodiscard]] std::size_t size() const noexcept { return prefixes4_.size() + prefixes6_.size(); }
+  void clear();
+
+  //! Write the database to \a _path. Returns false with errno set on failure.
+  bool write(const std::string &_path) const;
+
+private:
+  template <typename Key>
+  struct Prefix {
+    Key first;
+    Key last;
+    uint32_t length;
+    uint32_t value;
+  };
+
+  std::vector<Prefix<uint32_t>> prefixes4_;
+  std::vector<Prefix<detail::Uint128>> prefixes6_;
+  std::vector<std::string> values_;
+};
+
+}  // namespace network
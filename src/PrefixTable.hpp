@@ -0,0 +1,653 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Address.hpp"
+#include "AddressData.hpp"
+#include "Endian.hpp"
+
+namespace network {
+
+//! Longest-prefix-match table
+/*!
+    Maps (Address, Netmask) prefixes to values and answers "which is the most specific
+    prefix containing this address" for IPv4 and IPv6.
+
+    IPv4 uses a DIR-24-8 layout: a 2^24-entry table indexed by the top 24 bits with
+    256-entry extension groups for prefixes longer than /24, so a lookup reads at most
+    two table entries. The 64 MiB first-level table is allocated on the first IPv4 insert.
+
+    IPv6 uses a Poptrie: a 2^16-entry direct-pointing array followed by 6-bit stride nodes
+    whose children and leaves are stored contiguously and indexed by popcount over per-node
+    bitmaps. An update rebuilds the nodes below the deepest node on the prefix's path, appending
+    them to its /16's arrays; the replaced ones are reclaimed by rebuilding the /16 once they
+    outnumber the live ones, so building a table costs about the same per prefix at any size.
+
+    The address family is taken from Address::getProtocol(); v4-mapped IPv6 addresses are
+    looked up in the IPv6 table. Host bits of inserted prefixes are ignored.
+    Up to 2^24 prefixes are supported. Pointers returned by lookups are invalidated by
+    the next modification.
+
+    Not thread-safe for modification; concurrent lookups are safe.
+*/
+template <typename T>
+class PrefixTable {
+public:
+  PrefixTable() = default;
+
+  //! Insert or replace the value of a prefix. Returns false if the netmask does not fit the protocol.
+  bool insert(const Address &_address, Netmask _netmask, T _value);
+  //! Remove a prefix. Returns false if it was not present.
+  bool remove(const Address &_address, Netmask _netmask);
+  //! Exact-match lookup of a prefix
+  [[nodiscard]] const T *find(const Address &_address, Netmask _netmask) const;
+
+  //! Value of the longest prefix containing \a _address, or nullptr
+  [[nodiscard]] const T *lookup(const Address &_address) const {
+    if (_address.getProtocol() == LayerProtocol::IPv4) return lookup4(ipv4Key(_address));
+    if (_address.getProtocol() == LayerProtocol::IPv6) return lookup6(ipv6Key(_address));
+    return nullptr;
+  }
+
+  //! Batched lookup: \a _results[i] receives the match of \a _addresses[i].
+  /*!
+      Addresses are processed in groups whose first-level (and for IPv4 second-level) entries
+      are prefetched before they are resolved, so cache misses of a group overlap.
+      \a _results must be at least as long as \a _addresses.
+  */
+  void lookup(std::span<const Address> _addresses, std::span<const T *> _results) const;
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  void clear();
+
+private:
+  // IPv4 entry: [valid:1][extended:1][depth:6][index:24]
+  static constexpr uint32_t C_V4_VALID       = 1U << 31U;
+  static constexpr uint32_t C_V4_EXTENDED    = 1U << 30U;
+  static constexpr uint32_t C_V4_INDEX       = (1U << 24U) - 1;
+  static constexpr std::size_t C_TBL24_SIZE  = std::size_t(1) << 24U;
+  static constexpr std::size_t C_GROUP_SIZE  = 256;
+  // IPv6 direct-pointing entry: subtree flag | subtree index, else leaf (value index + 1, 0 = no match)
+  static constexpr uint32_t C_V6_SUBTREE     = 1U << 31U;
+  static constexpr unsigned C_V6_DIRECT_BITS = 16;
+  static constexpr unsigned C_V6_STRIDE      = 6;
+  static constexpr std::size_t C_BATCH       = 16;
+
+  struct Node {
+    uint64_t vector;   // slot holds an internal child
+    uint64_t leafvec;  // slot starts a new run of leaves
+    uint32_t base0;    // first leaf
+    uint32_t base1;    // first child
+  };
+
+  struct Subtree {
+    std::vector<Node> nodes;
+    std::vector<uint32_t> leaves;
+    uint32_t rules {0};    // prefixes longer than /16 under it
+    std::size_t dead {0};  // nodes and leaves replaced by updates
+  };
+
+  struct Rule6 {
+    uint64_t hi;
+    uint64_t lo;
+    uint32_t length;
+    uint32_t value;
+  };
+
+  using Key6 = std::tuple<uint64_t, uint64_t, uint32_t>;
+
+  static uint32_t ipv4Key(const Address &_address) {
+    // IPv4 addresses keep their v4-mapped form in the low 32 bits (all zero for 0.0.0.0)
+    return qFromBigEndian<uint32_t>(_address.toIPv6Address().c + 12);
+  }
+
+  static std::pair<uint64_t, uint64_t> ipv6Key(const Address &_address) {
+    const IPv6Address ip6 = _address.toIPv6Address();
+    return {qFromBigEndian<uint64_t>(ip6.c), qFromBigEndian<uint64_t>(ip6.c + 8)};
+  }
+
+  static constexpr uint32_t mask4(uint32_t _ip, unsigned _length) {
+    return _length == 0 ? 0 : _ip & ~((uint64_t(1) << (32 - _length)) - 1);
+  }
+
+  static constexpr std::pair<uint64_t, uint64_t> mask6(uint64_t _hi, uint64_t _lo, unsigned _length) {
+    if (_length == 0) return {0, 0};
+    if (_length == 64) return {_hi, 0};
+    if (_length < 64) return {_hi & ~((uint64_t(1) << (64 - _length)) - 1), 0};
+    return {_hi, _length == 128 ? _lo : _lo & ~((uint64_t(1) << (128 - _length)) - 1)};
+  }
+
+  // 6 address bits starting at bit _offset (from the most significant bit), zero-padded past bit 127
+  static constexpr unsigned bits6(uint64_t _hi, uint64_t _lo, unsigned _offset) {
+    if (_offset <= 58) return unsigned(_hi >> (58 - _offset)) & 63U;
+    if (_offset < 64) return unsigned((_hi << (_offset - 58)) | (_lo >> (122 - _offset))) & 63U;
+    if (_offset <= 122) return unsigned(_lo >> (122 - _offset)) & 63U;
+    return unsigned(_lo << (_offset - 122)) & 63U;
+  }
+
+  static constexpr unsigned depth4(uint32_t _entry) { return (_entry >> 24U) & 63U; }
+
+  const T *lookup4(uint32_t _ip) const {
+    if (tbl24_.empty()) return nullptr;
+    uint32_t entry = tbl24_[_ip >> 8U];
+    if (entry & C_V4_EXTENDED) entry = tbl8_[(std::size_t(entry & C_V4_INDEX) << 8U) | (_ip & 0xffU)];
+    return (entry & C_V4_VALID) ? &values_[entry & C_V4_INDEX] : nullptr;
+  }
+
+  const T *lookup6(std::pair<uint64_t, uint64_t> _key) const {
+    if (direct_.empty()) return nullptr;
+    return resolve6(direct_[_key.first >> (64 - C_V6_DIRECT_BITS)], _key.first, _key.second);
+  }
+
+  const T *resolve6(uint32_t _entry, uint64_t _hi, uint64_t _lo) const {
+    if (!(_entry & C_V6_SUBTREE)) return _entry ? &values_[_entry - 1] : nullptr;
+
+    const Subtree &subtree = subtrees_[_entry & ~C_V6_SUBTREE];
+    const Node *nodes      = subtree.nodes.data();
+    uint32_t index         = 0;
+    for (unsigned offset = C_V6_DIRECT_BITS;; offset += C_V6_STRIDE) {
+      const Node &node   = nodes[index];
+      const uint64_t bit = uint64_t(1) << bits6(_hi, _lo, offset);
+      if (node.vector & bit) {
+        index = node.base1 + unsigned(std::popcount(node.vector & (bit - 1)));
+        continue;
+      }
+      const uint32_t leaf = subtree.leaves[node.base0 + unsigned(std::popcount(node.leafvec & ((bit << 1U) - 1))) - 1];
+      return leaf ? &values_[leaf - 1] : nullptr;
+    }
+  }
+
+  uint32_t allocValue(T &&_value) {
+    if (!freeValues_.empty()) {
+      const uint32_t index = freeValues_.back();
+      freeValues_.pop_back();
+      values_[index] = std::move(_value);
+      return index;
+    }
+    values_.push_back(std::move(_value));
+    return uint32_t(values_.size() - 1);
+  }
+
+  void freeValue(uint32_t _index) {
+    values_[_index] = T {};
+    freeValues_.push_back(_index);
+  }
+
+  bool insert4(uint32_t _prefix, unsigned _length, T &&_value);
+  bool remove4(uint32_t _prefix, unsigned _length);
+  uint32_t allocGroup(uint32_t _fill);
+  bool insert6(uint64_t _hi, uint64_t _lo, unsigned _length, T &&_value);
+  bool remove6(uint64_t _hi, uint64_t _lo, unsigned _length);
+  void rebuildSubtree(uint32_t _top);
+  void updateSubtree(uint32_t _top, uint64_t _hi, uint64_t _lo, unsigned _length);
+  void replaceInherited(uint32_t _top, uint32_t _leaf);
+  std::size_t countBelow(const Subtree &_subtree, uint32_t _node) const;
+  void buildNode(Subtree &_subtree, uint32_t _node, std::span<Rule6> _rules, uint32_t _inherited, unsigned _depth);
+
+  std::vector<T> values_;
+  std::vector<uint32_t> freeValues_;
+  std::size_t size_ {0};
+
+  std::vector<uint32_t> tbl24_;
+  std::vector<uint32_t> tbl8_;
+  std::vector<uint32_t> freeGroups_;
+  std::array<std::unordered_map<uint32_t, uint32_t>, 33> rules4_;
+
+  std::vector<uint32_t> direct_;
+  std::vector<uint32_t> directLeaf_;   // best match of length <= 16, as value index + 1
+  std::vector<uint8_t> directDepth_;
+  std::vector<Subtree> subtrees_;
+  std::vector<uint32_t> freeSubtrees_;
+  std::map<Key6, uint32_t> rules6_;
+};
+
+template <typename T>
+bool PrefixTable<T>::insert(const Address &_address, Netmask _netmask, T _value) {
+  const int length = _netmask.getPrefixLength();
+  if (length < 0) return false;
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    if (length > 32) return false;
+    return insert4(mask4(ipv4Key(_address), unsigned(length)), unsigned(length), std::move(_value));
+  }
+  if (_address.getProtocol() == LayerProtocol::IPv6) {
+    const auto [hi, lo] = ipv6Key(_address);
+    const auto masked   = mask6(hi, lo, unsigned(length));
+    return insert6(masked.first, masked.second, unsigned(length), std::move(_value));
+  }
+  return false;
+}
+
+template <typename T>
+bool PrefixTable<T>::remove(const Address &_address, Netmask _netmask) {
+  const int length = _netmask.getPrefixLength();
+  if (length < 0) return false;
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    if (length > 32) return false;
+    return remove4(mask4(ipv4Key(_address), unsigned(length)), unsigned(length));
+  }
+  if (_address.getProtocol() == LayerProtocol::IPv6) {
+    const auto [hi, lo] = ipv6Key(_address);
+    const auto masked   = mask6(hi, lo, unsigned(length));
+    return remove6(masked.first, masked.second, unsigned(length));
+  }
+  return false;
+}
+
+template <typename T>
+const T *PrefixTable<T>::find(const Address &_address, Netmask _netmask) const {
+  const int length = _netmask.getPrefixLength();
+  if (length < 0) return nullptr;
+  if (_address.getProtocol() == LayerProtocol::IPv4) {
+    if (length > 32) return nullptr;
+    const auto &rules = rules4_[std::size_t(length)];
+    const auto it     = rules.find(mask4(ipv4Key(_address), unsigned(length)));
+    return it == rules.end() ? nullptr : &values_[it->second];
+  }
+  if (_address.getProtocol() == LayerProtocol::IPv6) {
+    const auto [hi, lo] = ipv6Key(_address);
+    const auto masked   = mask6(hi, lo, unsigned(length));
+    const auto it       = rules6_.find(Key6 {masked.first, masked.second, uint32_t(length)});
+    return it == rules6_.end() ? nullptr : &values_[it->second];
+  }
+  return nullptr;
+}
+
+template <typename T>
+void PrefixTable<T>::lookup(std::span<const Address> _addresses, std::span<const T *> _results) const {
+  uint32_t keys4[C_BATCH];
+  uint32_t entries[C_BATCH];
+  std::pair<uint64_t, uint64_t> keys6[C_BATCH];
+  LayerProtocol protocols[C_BATCH];
+
+  for (std::size_t base = 0; base < _addresses.size(); base += C_BATCH) {
+    const std::size_t count = std::min(C_BATCH, _addresses.size() - base);
+
+    // Stage 1: locate and prefetch the first-level entries
+    for (std::size_t i = 0; i < count; ++i) {
+      const Address &address = _addresses[base + i];
+      protocols[i]           = address.getProtocol();
+      if (protocols[i] == LayerProtocol::IPv4 && !tbl24_.empty()) {
+        keys4[i] = ipv4Key(address);
+        __builtin_prefetch(&tbl24_[keys4[i] >> 8U]);
+      } else if (protocols[i] == LayerProtocol::IPv6 && !direct_.empty()) {
+        keys6[i] = ipv6Key(address);
+        __builtin_prefetch(&direct_[keys6[i].first >> (64 - C_V6_DIRECT_BITS)]);
+      } else {
+        protocols[i] = LayerProtocol::UNKNOWN;
+      }
+    }
+
+    // Stage 2: read them and prefetch the second level (IPv4 extension group, IPv6 subtree root)
+    for (std::size_t i = 0; i < count; ++i) {
+      if (protocols[i] == LayerProtocol::IPv4) {
+        entries[i] = tbl24_[keys4[i] >> 8U];
+        if (entries[i] & C_V4_EXTENDED) {
+          __builtin_prefetch(&tbl8_[(std::size_t(entries[i] & C_V4_INDEX) << 8U) | (keys4[i] & 0xffU)]);
+        }
+      } else if (protocols[i] == LayerProtocol::IPv6) {
+        entries[i] = direct_[keys6[i].first >> (64 - C_V6_DIRECT_BITS)];
+        if (entries[i] & C_V6_SUBTREE) __builtin_prefetch(subtrees_[entries[i] & ~C_V6_SUBTREE].nodes.data());
+      }
+    }
+
+    // Stage 3: resolve
+    for (std::size_t i = 0; i < count; ++i) {
+      const T *result = nullptr;
+      if (protocols[i] == LayerProtocol::IPv4) {
+        uint32_t entry = entries[i];
+        if (entry & C_V4_EXTENDED) entry = tbl8_[(std::size_t(entry & C_V4_INDEX) << 8U) | (keys4[i] & 0xffU)];
+        result = (entry & C_V4_VALID) ? &values_[entry & C_V4_INDEX] : nullptr;
+      } else if (protocols[i] == LayerProtocol::IPv6) {
+        result = resolve6(entries[i], keys6[i].first, keys6[i].second);
+      }
+      _results[base + i] = result;
+    }
+  }
+}
+
+template <typename T>
+void PrefixTable<T>::clear() {
+  *this = PrefixTable();
+}
+
+template <typename T>
+uint32_t PrefixTable<T>::allocGroup(uint32_t _fill) {
+  uint32_t group = 0;
+  if (!freeGroups_.empty()) {
+    group = freeGroups_.back();
+    freeGroups_.pop_back();
+  } else {
+    group = uint32_t(tbl8_.size() / C_GROUP_SIZE);
+    tbl8_.resize(tbl8_.size() + C_GROUP_SIZE);
+  }
+  std::fill_n(tbl8_.begin() + std::ptrdiff_t(group * C_GROUP_SIZE), C_GROUP_SIZE, _fill);
+  return group;
+}
+
+template <typename T>
+bool PrefixTable<T>::insert4(uint32_t _prefix, unsigned _length, T &&_value) {
+  auto &rules = rules4_[_length];
+  if (const auto it = rules.find(_prefix); it != rules.end()) {
+    values_[it->second] = std::move(_value);
+    return true;
+  }
+  if (values_.size() - freeValues_.size() > C_V4_INDEX) return false;
+  if (tbl24_.empty()) tbl24_.assign(C_TBL24_SIZE, 0);
+
+  const uint32_t index = allocValue(std::move(_value));
+  rules.emplace(_prefix, index);
+  ++size_;
+
+  const uint32_t entry = C_V4_VALID | (_length << 24U) | index;
+  // An entry is overwritten only by a prefix at least as specific as the one that set it
+  const auto apply = [&](uint32_t &_slot) {
+    if (!(_slot & C_V4_VALID) || depth4(_slot) <= _length) _slot = entry;
+  };
+
+  if (_length <= 24) {
+    const uint32_t first = _prefix >> 8U;
+    const uint32_t count = 1U << (24 - _length);
+    for (uint32_t i = first; i < first + count; ++i) {
+      if (tbl24_[i] & C_V4_EXTENDED) {
+        uint32_t *group = &tbl8_[std::size_t(tbl24_[i] & C_V4_INDEX) << 8U];
+        for (std::size_t j = 0; j < C_GROUP_SIZE; ++j) apply(group[j]);
+      } else {
+        apply(tbl24_[i]);
+      }
+    }
+    return true;
+  }
+
+  uint32_t &slot = tbl24_[_prefix >> 8U];
+  if (!(slot & C_V4_EXTENDED)) slot = C_V4_VALID | C_V4_EXTENDED | allocGroup(slot);
+  uint32_t *group      = &tbl8_[std::size_t(slot & C_V4_INDEX) << 8U];
+  const uint32_t first = _prefix & 0xffU;
+  const uint32_t count = 1U << (32 - _length);
+  for (uint32_t j = first; j < first + count; ++j) apply(group[j]);
+  return true;
+}
+
+template <typename T>
+bool PrefixTable<T>::remove4(uint32_t _prefix, unsigned _length) {
+  auto &rules   = rules4_[_length];
+  const auto it = rules.find(_prefix);
+  if (it == rules.end()) return false;
+  freeValue(it->second);
+  rules.erase(it);
+  --size_;
+
+  // Entries set by the removed prefix fall back to the longest shorter prefix covering it
+  uint32_t replacement = 0;
+  for (unsigned length = _length; length-- > 0;) {
+    const auto &shorter = rules4_[length];
+    if (const auto found = shorter.find(mask4(_prefix, length)); found != shorter.end()) {
+      replacement = C_V4_VALID | (length << 24U) | found->second;
+      break;
+    }
+  }
+  const auto restore = [&](uint32_t &_slot) {
+    if ((_slot & C_V4_VALID) && depth4(_slot) == _length) _slot = replacement;
+  };
+
+  if (_length <= 24) {
+    const uint32_t first = _prefix >> 8U;
+    const uint32_t count = 1U << (24 - _length);
+    for (uint32_t i = first; i < first + count; ++i) {
+      if (tbl24_[i] & C_V4_EXTENDED) {
+        uint32_t *group = &tbl8_[std::size_t(tbl24_[i] & C_V4_INDEX) << 8U];
+        for (std::size_t j = 0; j < C_GROUP_SIZE; ++j) restore(group[j]);
+      } else {
+        restore(tbl24_[i]);
+      }
+    }
+    return true;
+  }
+
+  uint32_t &slot       = tbl24_[_prefix >> 8U];
+  const uint32_t index = slot & C_V4_INDEX;
+  uint32_t *group      = &tbl8_[std::size_t(index) << 8U];
+  const uint32_t first = _prefix & 0xffU;
+  const uint32_t count = 1U << (32 - _length);
+  for (uint32_t j = first; j < first + count; ++j) restore(group[j]);
+
+  // Collapse the group once no prefix longer than /24 is left in it
+  if (std::all_of(group, group + C_GROUP_SIZE, [&](uint32_t _entry) { return _entry == group[0]; })) {
+    slot = group[0];
+    freeGroups_.push_back(index);
+  }
+  return true;
+}
+
+template <typename T>
+bool PrefixTable<T>::insert6(uint64_t _hi, uint64_t _lo, unsigned _length, T &&_value) {
+  const Key6 key {_hi, _lo, _length};
+  if (const auto it = rules6_.find(key); it != rules6_.end()) {
+    values_[it->second] = std::move(_value);
+    return true;
+  }
+  if (values_.size() - freeValues_.size() > C_V4_INDEX) return false;
+  if (direct_.empty()) {
+    direct_.assign(std::size_t(1) << C_V6_DIRECT_BITS, 0);
+    directLeaf_.assign(direct_.size(), 0);
+    directDepth_.assign(direct_.size(), 0);
+  }
+
+  const uint32_t index = allocValue(std::move(_value));
+  rules6_.emplace(key, index);
+  ++size_;
+
+  const auto top = uint32_t(_hi >> (64 - C_V6_DIRECT_BITS));
+  if (_length > C_V6_DIRECT_BITS) {
+    if (direct_[top] & C_V6_SUBTREE) {
+      ++subtrees_[direct_[top] & ~C_V6_SUBTREE].rules;
+      updateSubtree(top, _hi, _lo, _length);
+    } else {
+      rebuildSubtree(top);
+    }
+    return true;
+  }
+
+  const uint32_t count = 1U << (C_V6_DIRECT_BITS - _length);
+  for (uint32_t i = top; i < top + count; ++i) {
+    if (directLeaf_[i] && directDepth_[i] > _length) continue;
+    replaceInherited(i, index + 1);
+    directDepth_[i] = uint8_t(_length);
+  }
+  return true;
+}
+
+template <typename T>
+bool PrefixTable<T>::remove6(uint64_t _hi, uint64_t _lo, unsigned _length) {
+  const auto it = rules6_.find(Key6 {_hi, _lo, _length});
+  if (it == rules6_.end()) return false;
+  const uint32_t index = it->second;
+  freeValue(index);
+  rules6_.erase(it);
+  --size_;
+
+  const auto top = uint32_t(_hi >> (64 - C_V6_DIRECT_BITS));
+  if (_length > C_V6_DIRECT_BITS) {
+    if (--subtrees_[direct_[top] & ~C_V6_SUBTREE].rules == 0) {
+      rebuildSubtree(top);
+    } else {
+      updateSubtree(top, _hi, _lo, _length);
+    }
+    return true;
+  }
+
+  uint32_t replacement = 0;
+  uint8_t depth        = 0;
+  for (unsigned length = _length; length-- > 0;) {
+    const auto masked = mask6(_hi, _lo, length);
+    if (const auto found = rules6_.find(Key6 {masked.first, masked.second, length}); found != rules6_.end()) {
+      replacement = found->second + 1;
+      depth       = uint8_t(length);
+      break;
+    }
+  }
+
+  const uint32_t count = 1U << (C_V6_DIRECT_BITS - _length);
+  for (uint32_t i = top; i < top + count; ++i) {
+    if (directLeaf_[i] != index + 1) continue;
+    replaceInherited(i, replacement);
+    directDepth_[i] = depth;
+  }
+  return true;
+}
+
+template <typename T>
+void PrefixTable<T>::replaceInherited(uint32_t _top, uint32_t _leaf) {
+  const uint32_t previous = std::exchange(directLeaf_[_top], _leaf);
+  if (!(direct_[_top] & C_V6_SUBTREE)) {
+    direct_[_top] = _leaf;
+    return;
+  }
+  // Only the /16's own match is inherited into its subtree, and it is more specific than any
+  // other prefix of /16 or shorter covering it, so its leaves are exactly the ones to replace
+  auto &leaves = subtrees_[direct_[_top] & ~C_V6_SUBTREE].leaves;
+  std::replace(leaves.begin(), leaves.end(), previous, _leaf);
+}
+
+template <typename T>
+void PrefixTable<T>::rebuildSubtree(uint32_t _top) {
+  const uint64_t first = uint64_t(_top) << (64 - C_V6_DIRECT_BITS);
+  std::vector<Rule6> rules;
+  for (auto it = rules6_.lower_bound(Key6 {first, 0, C_V6_DIRECT_BITS + 1}); it != rules6_.end(); ++it) {
+    const auto &[hi, lo, length] = it->first;
+    if ((hi >> (64 - C_V6_DIRECT_BITS)) != _top) break;
+    if (length > C_V6_DIRECT_BITS) rules.push_back(Rule6 {hi, lo, length, it->second});
+  }
+
+  uint32_t &entry = direct_[_top];
+  if (rules.empty()) {
+    if (entry & C_V6_SUBTREE) {
+      subtrees_[entry & ~C_V6_SUBTREE] = Subtree {};
+      freeSubtrees_.push_back(entry & ~C_V6_SUBTREE);
+    }
+    entry = directLeaf_[_top];
+    return;
+  }
+
+  uint32_t index = 0;
+  if (entry & C_V6_SUBTREE) {
+    index = entry & ~C_V6_SUBTREE;
+  } else if (!freeSubtrees_.empty()) {
+    index = freeSubtrees_.back();
+    freeSubtrees_.pop_back();
+  } else {
+    index = uint32_t(subtrees_.size());
+    subtrees_.emplace_back();
+  }
+
+  Subtree subtree;
+  subtree.nodes.resize(1);
+  subtree.rules = uint32_t(rules.size());
+  buildNode(subtree, 0, rules, directLeaf_[_top], C_V6_DIRECT_BITS);
+  subtree.nodes.shrink_to_fit();
+  subtree.leaves.shrink_to_fit();
+  subtrees_[index] = std::move(subtree);
+  entry            = C_V6_SUBTREE | index;
+}
+
+template <typename T>
+void PrefixTable<T>::updateSubtree(uint32_t _top, uint64_t _hi, uint64_t _lo, unsigned _length) {
+  Subtree &subtree = subtrees_[direct_[_top] & ~C_V6_SUBTREE];
+
+  // The prefix changes the node it ends in, or the deepest one on its path if that is missing
+  uint32_t node  = 0;
+  unsigned depth = C_V6_DIRECT_BITS;
+  while (_length > depth + C_V6_STRIDE) {
+    const Node &current = subtree.nodes[node];
+    const uint64_t bit  = uint64_t(1) << bits6(_hi, _lo, depth);
+    if (!(current.vector & bit)) break;
+    node = current.base1 + unsigned(std::popcount(current.vector & (bit - 1)));
+    depth += C_V6_STRIDE;
+  }
+
+  const auto [hi, lo] = mask6(_hi, _lo, depth);
+  std::vector<Rule6> rules;
+  for (auto it = rules6_.lower_bound(Key6 {hi, lo, 0}); it != rules6_.end(); ++it) {
+    const auto &[ruleHi, ruleLo, length] = it->first;
+    if (mask6(ruleHi, ruleLo, depth) != std::pair {hi, lo}) break;
+    if (length > depth) rules.push_back(Rule6 {ruleHi, ruleLo, length, it->second});
+  }
+
+  uint32_t inherited = directLeaf_[_top];
+  for (unsigned length = depth; length > C_V6_DIRECT_BITS; --length) {
+    const auto masked = mask6(hi, lo, length);
+    if (const auto found = rules6_.find(Key6 {masked.first, masked.second, length}); found != rules6_.end()) {
+      inherited = found->second + 1;
+      break;
+    }
+  }
+
+  // The node keeps its place in its parent's children; what was below it is rebuilt at the end
+  subtree.dead += countBelow(subtree, node);
+  buildNode(subtree, node, rules, inherited, depth);
+  if (subtree.dead * 2 > subtree.nodes.size() + subtree.leaves.size()) rebuildSubtree(_top);
+}
+
+template <typename T>
+std::size_t PrefixTable<T>::countBelow(const Subtree &_subtree, uint32_t _node) const {
+  const Node &node  = _subtree.nodes[_node];
+  std::size_t count = std::size_t(std::popcount(node.leafvec));
+  for (uint32_t child = 0; child < unsigned(std::popcount(node.vector)); ++child) {
+    count += 1 + countBelow(_subtree, node.base1 + child);
+  }
+  return count;
+}
+
+template <typename T>
+void PrefixTable<T>::buildNode(
+    Subtree &_subtree, uint32_t _node, std::span<Rule6> _rules, uint32_t _inherited, unsigned _depth) {
+  const unsigned next = _depth + C_V6_STRIDE;
+  // Rules ending inside this node come first (shortest first, so longer ones override),
+  // rules continuing below keep their address order and are grouped by slot.
+  const auto split = std::stable_partition(
+      _rules.begin(), _rules.end(), [&](const Rule6 &_rule) { return _rule.length <= next; });
+  std::stable_sort(_rules.begin(), split, [](const Rule6 &_a, const Rule6 &_b) { return _a.length < _b.length; });
+
+  uint32_t slots[64];
+  std::fill_n(slots, 64, _inherited);
+  for (auto rule = _rules.begin(); rule != split; ++rule) {
+    const unsigned first = bits6(rule->hi, rule->lo, _depth);
+    std::fill_n(slots + first, 1U << (next - rule->length), rule->value + 1);
+  }
+
+  uint64_t vector = 0;
+  for (auto rule = split; rule != _rules.end(); ++rule) vector |= uint64_t(1) << bits6(rule->hi, rule->lo, _depth);
+
+  uint64_t leafvec = 0;
+  const auto base0 = uint32_t(_subtree.leaves.size());
+  for (unsigned slot = 0; slot < 64; ++slot) {
+    if (vector & (uint64_t(1) << slot)) continue;
+    if (slot == 0 || (vector & (uint64_t(1) << (slot - 1))) || slots[slot] != slots[slot - 1]) {
+      leafvec |= uint64_t(1) << slot;
+      _subtree.leaves.push_back(slots[slot]);
+    }
+  }
+
+  const auto base1 = uint32_t(_subtree.nodes.size());
+  _subtree.nodes.resize(_subtree.nodes.size() + std::size_t(std::popcount(vector)));
+  _subtree.nodes[_node] = Node {vector, leafvec, base0, base1};
+
+  uint32_t child = base1;
+  for (auto begin = split; begin != _rules.end(); ++child) {
+    const unsigned slot = bits6(begin->hi, begin->lo, _depth);
+    const auto end      = std::find_if(
+        begin, _rules.end(), [&](const Rule6 &_rule) { return bits6(_rule.hi, _rule.lo, _depth) != slot; });
+    buildNode(_subtree, child, std::span<Rule6>(begin, end), slots[slot], next);
+    begin = end;
+  }
+}
+
+}  // namespace network
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+namespace network {
+
+//! Pointer to an immutable value that readers access without locks (read-copy-update)
+/*!
+    Readers pin the current value with read(); the returned guard keeps it alive and never blocks,
+    allocates or takes a lock. Writers build a new value and publish it with update(), which waits
+    until no reader can still see the previous one and then destroys it.
+
+    Readers are tracked with per-slot counters in two phases (sleepable RCU): a reader counts itself
+    in the current phase before loading the pointer, and a writer flips the phase twice, waiting for
+    the previous one to drain each time. Threads are spread over the slots by id, so readers on
+    different cores rarely share a cache line.
+
+    Read-side sections should be short: update() spins (yielding) until they end.
+*/
+template <typename T>
+class RcuPointer {
+public:
+  class ReadGuard {
+  public:
+    ReadGuard(const ReadGuard &)            = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+    ~ReadGuard() { counter_->fetch_sub(1, std::memory_order_release); }
+
+    [[nodiscard]] const T *get() const noexcept { return value_; }
+    const T *operator->() const noexcept { return value_; }
+    const T &operator*() const noexcept { return *value_; }
+    explicit operator bool() const noexcept { return value_ != nullptr; }
+
+  private:
+    friend class RcuPointer;
+    ReadGuard(std::atomic<int64_t> *_counter, const T *_value) : counter_(_counter), value_(_value) {}
+
+    std::atomic<int64_t> *counter_;
+    const T *value_;
+  };
+
+  RcuPointer() = default;
+  explicit RcuPointer(std::unique_ptr<const T> _value) : value_(_value.release()) {}
+  ~RcuPointer() { delete value_.load(std::memory_order_relaxed); }
+
+  RcuPointer(const RcuPointer &)            = delete;
+  RcuPointer &operator=(const RcuPointer &) = delete;
+
+  //! Pin the current value for the lifetime of the guard
+  [[nodiscard]] ReadGuard read() const noexcept {
+    const unsigned phase          = phase_.load(std::memory_order_seq_cst);
+    std::atomic<int64_t> *counter = &slots_[slotIndex()].counters[phase];
+    counter->fetch_add(1, std::memory_order_seq_cst);
+    return ReadGuard(counter, value_.load(std::memory_order_seq_cst));
+  }
+
+  //! Publish \a _value and destroy the previous one once no reader holds it
+  void update(std::unique_ptr<const T> _value) {
+    const std::lock_guard<std::mutex> lock(writer_);
+    const T *previous = value_.exchange(_value.release(), std::memory_order_seq_cst);
+    synchronize();
+    delete previous;
+  }
+
+  //! Wait until every read-side section that started before the call has ended
+  void synchronize() {
+    // A reader may have loaded the phase before an earlier flip and counted itself late, so both
+    // phases are drained.
+    for (int round = 0; round < 2; ++round) {
+      const unsigned phase = phase_.load(std::memory_order_relaxed);
+      phase_.store(phase ^ 1U, std::memory_order_seq_cst);
+      while (readers(phase) != 0) std::this_thread::yield();
+    }
+  }
+
+private:
+  static constexpr std::size_t C_SLOTS = 64;
+
+  struct alignas(64) Slot {
+    std::atomic<int64_t> counters[2] {};
+  };
+
+  static std::size_t slotIndex() noexcept {
+    static thread_local const std::size_t index = std::hash<std::thread::id> {}(std::this_thread::get_id()) % C_SLOTS;
+    return index;
+  }
+
+  int64_t readers(unsigned _phase) const noexcept {
+    int64_t total = 0;
+    for (const Slot &slot : slots_) total += slot.counters[_phase].load(std::memory_order_seq_cst);
+    return total;
+  }
+
+  std::atomic<const T *> value_ {nullptr};
+  std::atomic<unsigned> phase_ {0};
+  mutable std::array<Slot, C_SLOTS> slots_ {};
+  std::mutex writer_;
+};
+
+}  // namespace network
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+
+namespace network::detail {
+
+//! Unsigned 128-bit integer, most significant half first so the default ordering is numeric
+struct Uint128 {
+  uint64_t hi;
+  uint64_t lo;
+
+  friend constexpr bool operator==(const Uint128 &, const Uint128 &)  = default;
+  friend constexpr auto operator<=>(const Uint128 &, const Uint128 &) = default;
+  friend constexpr Uint128 operator|(Uint128 _a, Uint128 _b) { return {_a.hi | _b.hi, _a.lo | _b.lo}; }
+  friend constexpr Uint128 operator&(Uint128 _a, Uint128 _b) { return {_a.hi & _b.hi, _a.lo & _b.lo}; }
+  friend constexpr Uint128 operator~(Uint128 _a) { return {~_a.hi, ~_a.lo}; }
+  friend constexpr Uint128 operator+(Uint128 _a, Uint128 _b) {
+    const uint64_t lo = _a.lo + _b.lo;
+    return {_a.hi + _b.hi + (lo < _a.lo ? 1U : 0U), lo};
+  }
+  friend constexpr Uint128 operator-(Uint128 _a, Uint128 _b) {
+    return {_a.hi - _b.hi - (_a.lo < _b.lo ? 1U : 0U), _a.lo - _b.lo};
+  }
+};
+
+}  // namespace network::detail
@@ -56,6 +56,7 @@
   #endif
 
   #define Q_FUNC_INFO           __PRETTY_FUNCTION__
+  #define Q_ALWAYS_INLINE       inline __attribute__((always_inline))
   #define Q_TYPEOF(expr)        __typeof__(expr)
   #define Q_DECL_DEPRECATED     __attribute__((__deprecated__))
   #define Q_DECL_UNUSED         __attribute__((__unused__))
@@ -398,3 +399,13 @@
 #    endif
 #  endif /* __cplusplus */
 #endif // defined(Q_CC_MSVC) && !defined(Q_CC_CLANG)
+
+#ifndef Q_ALWAYS_INLINE
+  #define Q_ALWAYS_INLINE inline
+#endif
+#ifndef Q_LIKELY
+  #define Q_LIKELY(x) (x)
+#endif
+#ifndef Q_UNLIKELY
+  #define Q_UNLIKELY(x) (x)
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <bit>
+#include "CompilerDetection.hpp"
 
 /**
 	little = __ORDER_LITTLE_ENDIAN__,
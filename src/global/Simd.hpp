@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ProcessorDetection.hpp"
+
+/*
+    This file sets KT_COMPILER_SUPPORTS_{FEATURE} for every SIMD extension the
+    compiler has been told it may use (-msse4.1, -mavx2, -march=..., or the
+    baseline of the target), and includes the matching intrinsics headers.
+
+    Kernels pick their implementation with these macros; code that is not
+    covered falls back to the scalar path.
+
+    With GCC or Clang on x86 it also sets KT_RUNTIME_DISPATCH (unless
+    KT_NO_RUNTIME_DISPATCH is defined): kernels are then additionally built for
+    the SSE4.2, AVX2 and AVX-512 levels with KT_TARGET_{LEVEL} function
+    attributes, and the variant for the running CPU is picked through
+    qResolveKernel() (CpuFeatures.hpp). KT_KERNELS_{LEVEL} is set for every
+    level whose kernels can be built, either way.
+*/
+
+#if defined(K_PROCESSOR_X86_64) || defined(K_PROCESSOR_X86_32)
+  #if defined(__SSE2__) || defined(K_PROCESSOR_X86_64)
+    #define KT_COMPILER_SUPPORTS_SSE2
+    #include <emmintrin.h>
+  #endif
+  #if defined(__SSSE3__)
+    #define KT_COMPILER_SUPPORTS_SSSE3
+    #include <tmmintrin.h>
+  #endif
+  #if defined(__SSE4_1__)
+    #define KT_COMPILER_SUPPORTS_SSE4_1
+    #include <smmintrin.h>
+  #endif
+  #if defined(__SSE4_2__)
+    #define KT_COMPILER_SUPPORTS_SSE4_2
+    #include <nmmintrin.h>
+  #endif
+  #if defined(__AVX2__)
+    #define KT_COMPILER_SUPPORTS_AVX2
+    #include <immintrin.h>
+  #endif
+  #if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512DQ__) && defined(__AVX512VL__)
+    #define KT_COMPILER_SUPPORTS_AVX512
+  #endif
+
+  #if defined(__GNUC__) && !defined(KT_NO_RUNTIME_DISPATCH)
+    #define KT_RUNTIME_DISPATCH
+    #include <immintrin.h>
+  #endif
+#elif defined(K_PROCESSOR_ARM_64) || defined(__ARM_NEON)
+  #define KT_COMPILER_SUPPORTS_NEON
+  #include <arm_neon.h>
+#endif
+
+#if defined(KT_RUNTIME_DISPATCH)
+  #define KT_TARGET_SSE4_2 __attribute__((target("popcnt,sse4.2")))
+  #define KT_TARGET_AVX2   __attribute__((target("popcnt,avx2,bmi,bmi2")))
+  #define KT_TARGET_AVX512 __attribute__((target("popcnt,avx2,bmi,bmi2,avx512f,avx512bw,avx512dq,avx512vl")))
+  // Inlines the whole call tree into a KT_TARGET_* entry point, so shared code is compiled for its level
+  #define KT_FLATTEN __attribute__((flatten))
+#else
+  #define KT_TARGET_SSE4_2
+  #define KT_TARGET_AVX2
+  #define KT_TARGET_AVX512
+  #define KT_FLATTEN
+#endif
+
+#if defined(KT_RUNTIME_DISPATCH) || defined(KT_COMPILER_SUPPORTS_SSE4_2)
+  #define KT_KERNELS_SSE4_2
+#endif
+#if defined(KT_RUNTIME_DISPATCH) || defined(KT_COMPILER_SUPPORTS_AVX2)
+  #define KT_KERNELS_AVX2
+#endif
+#if defined(KT_RUNTIME_DISPATCH) || defined(KT_COMPILER_SUPPORTS_AVX512)
+  #define KT_KERNELS_AVX512
+#endif
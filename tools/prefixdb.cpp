@@ -0,0 +1,121 @@
+// Builds and queries PrefixDatabase files
+//
+//   prefixdb build <prefixes.txt> <output.db>   one "address/length value" per line, '#' comments
+//   prefixdb lookup <database.db> <address>...
+//   prefixdb verify <database.db>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "Address.hpp"
+#include "PrefixDatabase.hpp"
+
+namespace {
+
+using network::Address;
+using network::Netmask;
+using network::PrefixDatabase;
+using network::PrefixDatabaseBuilder;
+
+int usage() {
+  std::cerr << "usage: prefixdb build <prefixes.txt> <output.db>\n"
+               "       prefixdb lookup <database.db> <address>...\n"
+               "       prefixdb verify <database.db>\n";
+  return 2;
+}
+
+int fail(std::string_view _what, const std::string &_path) {
+  std::cerr << "prefixdb: " << _what << ' ' << _path << ": " << std::strerror(errno) << '\n';
+  return 1;
+}
+
+std::string_view trim(std::string_view _text) {
+  const std::size_t first = _text.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) return {};
+  return _text.substr(first, _text.find_last_not_of(" \t\r") - first + 1);
+}
+
+// "address/length value", the value being the rest of the line
+bool parseLine(std::string_view _line, PrefixDatabaseBuilder &_builder) {
+  const std::size_t space = _line.find_first_of(" \t");
+  const std::size_t slash = _line.substr(0, space).find('/');
+  if (space == std::string_view::npos || slash == std::string_view::npos) return false;
+
+  Address address;
+  int length = -1;
+  const std::string_view digits = _line.substr(slash + 1, space - slash - 1);
+  const auto [end, error]       = std::from_chars(digits.data(), digits.data() + digits.size(), length);
+  if (!address.setAddress(_line.substr(0, slash)) || error != std::errc() || end != digits.data() + digits.size()) {
+    return false;
+  }
+  Netmask netmask;
+  netmask.setPrefixLength(address.getProtocol(), length);
+  return _builder.insert(address, netmask, trim(_line.substr(space)));
+}
+
+int build(const std::string &_input, const std::string &_output) {
+  std::ifstream input(_input);
+  if (!input) return fail("cannot read", _input);
+
+  PrefixDatabaseBuilder builder;
+  std::string line;
+  for (std::size_t number = 1; std::getline(input, line); ++number) {
+    const std::string_view text = trim(std::string_view(line).substr(0, line.find('#')));
+    if (text.empty()) continue;
+    if (!parseLine(text, builder)) {
+      std::cerr << "prefixdb: " << _input << ':' << number << ": invalid prefix line\n";
+      return 1;
+    }
+  }
+  if (!builder.write(_output)) return fail("cannot write", _output);
+
+  PrefixDatabase database;
+  if (!database.open(_output)) return fail("cannot open", _output);
+  std::cout << builder.size() << " prefixes, " << database.rangeCount() << " ranges, " << database.valueCount()
+            << " distinct values\n";
+  return 0;
+}
+
+int lookup(const std::string &_path, char **_addresses, int _count) {
+  PrefixDatabase database;
+  if (!database.open(_path)) return fail("cannot open", _path);
+  int status = 0;
+  for (int i = 0; i < _count; ++i) {
+    Address address;
+    if (!address.setAddress(_addresses[i])) {
+      std::cerr << "prefixdb: invalid address " << _addresses[i] << '\n';
+      status = 1;
+      continue;
+    }
+    const auto value = database.lookup(address);
+    std::cout << _addresses[i] << ' ' << (value ? *value : "-") << '\n';
+  }
+  if (!database.isValid()) {
+    errno = EBADMSG;
+    return fail("corrupt", _path);
+  }
+  return status;
+}
+
+int verify(const std::string &_path) {
+  PrefixDatabase database;
+  if (!database.open(_path)) return fail("cannot open", _path);
+  if (!database.verify()) return fail("corrupt", _path);
+  std::cout << _path << ": " << database.rangeCount() << " ranges, " << database.valueCount() << " values, ok\n";
+  return 0;
+}
+
+}  // namespace
+
+int main(int _argc, char **_argv) {
+  if (_argc < 3) return usage();
+  const std::string_view command = _argv[1];
+  if (command == "build" && _argc == 4) return build(_argv[2], _argv[3]);
+  if (command == "lookup" && _argc >= 4) return lookup(_argv[2], _argv + 3, _argc - 3);
+  if (command == "verify" && _argc == 3) return verify(_argv[2]);
+  return usage();
+}